@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+package tech.rollw.player.audio.tag
+
+import android.graphics.Bitmap
+import android.os.Bundle
+import android.os.ParcelFileDescriptor
+import android.util.Log
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import androidx.test.platform.app.InstrumentationRegistry
+import org.junit.AfterClass
+import org.junit.BeforeClass
+import org.junit.Test
+import org.junit.runner.RunWith
+import tech.rollw.player.audio.AudioFormatType
+import tech.rollw.player.util.ImageUtils
+import java.io.ByteArrayOutputStream
+import java.io.File
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Cost of the tag natives per call, on the device it runs on.
+ *
+ * Reports the mean time of every call as instrumentation status and
+ * logs it, there are no thresholds as they depend on the device:
+ *
+ * ```
+ * ./gradlew connectedAndroidTest \
+ *     -Pandroid.testInstrumentationRunnerArguments.class=tech.rollw.player.audio.tag.NativeLibAudioTagBenchmark
+ * ```
+ *
+ * @author RollW
+ */
+@RunWith(AndroidJUnit4::class)
+class NativeLibAudioTagBenchmark {
+    @Test
+    fun openAndClose() = measure("open_close", OPEN_ITERATIONS) {
+        openTag().close()
+    }
+
+    @Test
+    fun scanTrack() = measure("scan_track", OPEN_ITERATIONS) {
+        openTag().use { tag ->
+            SCAN_FIELDS.forEach { tag.getTagField(it) }
+            tag.getAudioProperties()
+            tag.getArtwork(includeData = false)
+        }
+    }
+
+    @Test
+    fun getTagField() = openTag().use { tag ->
+        measure("get_tag_field", CALL_ITERATIONS) {
+            tag.getTagField(AudioTagField.TITLE)
+        }
+    }
+
+    @Test
+    fun getArtworkWithoutData() = openTag().use { tag ->
+        measure("get_artwork_info", CALL_ITERATIONS) {
+            tag.getArtwork(includeData = false)
+        }
+    }
+
+    @Test
+    fun getArtwork() = openTag().use { tag ->
+        measure("get_artwork", CALL_ITERATIONS) {
+            tag.getArtwork(includeData = true)
+        }
+    }
+
+    @Test
+    fun getArtworkTargetSize() = measure("artwork_target_size", CALL_ITERATIONS) {
+        ImageUtils.getArtworkTargetSize(artwork, 512, 256 * 1024)
+    }
+
+    private inline fun measure(name: String, iterations: Int, block: () -> Unit) {
+        repeat(iterations / 10) { block() }
+        val start = System.nanoTime()
+        repeat(iterations) { block() }
+        val nanos = (System.nanoTime() - start) / iterations
+
+        Log.i(TAG, "$name: $nanos ns per call")
+        InstrumentationRegistry.getInstrumentation().sendStatus(0, Bundle().apply {
+            putLong("${name}_ns", nanos)
+        })
+    }
+
+    companion object {
+        private const val TAG = "TagBenchmark"
+
+        private const val OPEN_ITERATIONS = 2_000
+        private const val CALL_ITERATIONS = 20_000
+
+        private val SCAN_FIELDS = listOf(
+            AudioTagField.TITLE, AudioTagField.ARTIST, AudioTagField.ALBUM,
+            AudioTagField.ALBUM_ARTIST, AudioTagField.TRACK_NUMBER,
+            AudioTagField.DISC_NUMBER, AudioTagField.DATE, AudioTagField.GENRE
+        )
+
+        private lateinit var file: File
+        private lateinit var artwork: ByteArray
+
+        @JvmStatic
+        @BeforeClass
+        fun createFile() {
+            val context = InstrumentationRegistry.getInstrumentation().targetContext
+            file = File(context.cacheDir, "tag_benchmark.wav")
+            file.writeBytes(silentWav(seconds = 1))
+            artwork = jpeg(size = 600)
+
+            openTag(readonly = false).use { tag ->
+                tag.setTagField(AudioTagField.TITLE, "Symphony No. 9 in D minor, Op. 125")
+                tag.setTagField(AudioTagField.ARTIST, "Berliner Philharmoniker")
+                tag.setTagField(AudioTagField.ALBUM, "Beethoven: Symphony No. 9")
+                tag.setTagField(AudioTagField.ALBUM_ARTIST, "Herbert von Karajan")
+                tag.setTagField(AudioTagField.TRACK_NUMBER, "4")
+                tag.setTagField(AudioTagField.DATE, "1963")
+                tag.setArtwork(artwork)
+                tag.save()
+            }
+        }
+
+        @JvmStatic
+        @AfterClass
+        fun deleteFile() {
+            file.delete()
+        }
+
+        private fun openTag(readonly: Boolean = true): NativeLibAudioTag {
+            val mode = if (readonly) ParcelFileDescriptor.MODE_READ_ONLY
+            else ParcelFileDescriptor.MODE_READ_WRITE
+            val fd = ParcelFileDescriptor.open(file, mode).detachFd()
+            return NativeLibAudioTag(fd, AudioFormatType.WAV, readonly, windowed = readonly)
+        }
+
+        private fun silentWav(seconds: Int): ByteArray {
+            val dataSize = 44100 * 4 * seconds
+            return ByteBuffer.allocate(44 + dataSize).order(ByteOrder.LITTLE_ENDIAN).apply {
+                put("RIFF".toByteArray()).putInt(36 + dataSize).put("WAVE".toByteArray())
+                put("fmt ".toByteArray()).putInt(16)
+                putShort(1).putShort(2).putInt(44100).putInt(44100 * 4)
+                putShort(4).putShort(16)
+                put("data".toByteArray()).putInt(dataSize)
+            }.array()
+        }
+
+        private fun jpeg(size: Int): ByteArray {
+            val bitmap = Bitmap.createBitmap(size, size, Bitmap.Config.ARGB_8888)
+            bitmap.eraseColor(0xFF3366CC.toInt())
+            return ByteArrayOutputStream().use {
+                bitmap.compress(Bitmap.CompressFormat.JPEG, 90, it)
+                it.toByteArray()
+            }.also { bitmap.recycle() }
+        }
+    }
+}
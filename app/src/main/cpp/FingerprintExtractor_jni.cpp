@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <jni.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "logging.h"
+#include "jni_support.h"
+
+#include <tags/tags.h>
+#include <audio/fingerprint.h>
+#include <decoder/decoder_factory.h>
+
+using namespace SoundSource;
+using namespace SoundSource::Audio;
+using namespace SoundSource::Decoder;
+
+extern "C"
+JNIEXPORT jbyteArray JNICALL
+Java_tech_rollw_player_audio_analysis_FingerprintExtractor_extractFingerprint(JNIEnv *env,
+                                                                              jobject thiz,
+                                                                              jlong accessorRef,
+                                                                              jint maxSeconds) {
+    auto *accessor = (AudioTagAccessor *) accessorRef;
+    if (accessor == nullptr) {
+        Jni::throwAccessorNull(env);
+        return nullptr;
+    }
+
+    std::unique_ptr<AudioDecoder> decoder = openDecoder(*accessor);
+    if (decoder == nullptr) {
+        LOGD("Cannot decode audio of accessor*(=%ld)", (long) accessorRef);
+        return nullptr;
+    }
+
+    FingerprintBuilder builder(decoder->channels(), decoder->sampleRate(), maxSeconds);
+    const int32_t frames = 4096;
+    std::vector<float> buffer((size_t) frames * decoder->channels());
+    int32_t read;
+    while ((read = decoder->read(buffer.data(), frames)) > 0) {
+        if (!builder.process(buffer.data(), read)) {
+            break;
+        }
+    }
+    if (read < 0) {
+        LOGD("Decode error of accessor*(=%ld)", (long) accessorRef);
+        return nullptr;
+    }
+
+    std::vector<uint8_t> data = builder.serialize();
+    jbyteArray array = env->NewByteArray((jsize) data.size());
+    env->SetByteArrayRegion(array, 0, (jsize) data.size(), (const jbyte *) data.data());
+    return array;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_tech_rollw_player_audio_analysis_FingerprintExtractor_createIndex(JNIEnv *env, jobject thiz) {
+    return (jlong) new FingerprintIndex();
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_tech_rollw_player_audio_analysis_FingerprintExtractor_releaseIndex(JNIEnv *env, jobject thiz,
+                                                                        jlong indexRef) {
+    delete (FingerprintIndex *) indexRef;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_tech_rollw_player_audio_analysis_FingerprintExtractor_addFingerprint(JNIEnv *env,
+                                                                          jobject thiz,
+                                                                          jlong indexRef,
+                                                                          jlong id,
+                                                                          jlong durationMs,
+                                                                          jbyteArray data) {
+    auto *index = (FingerprintIndex *) indexRef;
+    if (index == nullptr) {
+        return false;
+    }
+    jsize size = env->GetArrayLength(data);
+    std::vector<uint8_t> bytes((size_t) size);
+    env->GetByteArrayRegion(data, 0, size, (jbyte *) bytes.data());
+    std::vector<uint32_t> fingerprint;
+    if (!FingerprintBuilder::deserialize(bytes.data(), bytes.size(), fingerprint)) {
+        return false;
+    }
+    index->add(id, durationMs, std::move(fingerprint));
+    return true;
+}
+
+extern "C"
+JNIEXPORT jobjectArray JNICALL
+Java_tech_rollw_player_audio_analysis_FingerprintExtractor_findDuplicates(JNIEnv *env,
+                                                                          jobject thiz,
+                                                                          jlong indexRef,
+                                                                          jfloat maxBitErrorRate) {
+    const Jni::Bindings &jni = Jni::bindings();
+    auto *index = (FingerprintIndex *) indexRef;
+    if (index == nullptr) {
+        return env->NewObjectArray(0, jni.duplicateMatch, nullptr);
+    }
+    auto threads = (int32_t) std::min(std::thread::hardware_concurrency(), 4u);
+    std::vector<DuplicateMatch> matches = index->findDuplicates(maxBitErrorRate, threads);
+
+    jobjectArray array = env->NewObjectArray((jsize) matches.size(), jni.duplicateMatch, nullptr);
+    for (size_t i = 0; i < matches.size(); i++) {
+        const DuplicateMatch &match = matches[i];
+        jobject object = env->NewObject(jni.duplicateMatch, jni.duplicateMatchInit,
+                                        (jlong) match.id, (jlong) match.duplicateId,
+                                        (jfloat) match.similarity);
+        env->SetObjectArrayElement(array, (jsize) i, object);
+        env->DeleteLocalRef(object);
+    }
+    return array;
+}
@@ -14,7 +14,6 @@
  * limitations under the License.
  */
 
-#include <iostream>
 #include <jni.h>
 #include <string>
 #include <unistd.h>
@@ -25,60 +24,123 @@
 #include <android/bitmap.h>
 
 #include "logging.h"
+#include "jni_support.h"
 #include "image/image.h"
+#include "image/scale.h"
 
+using namespace SoundSource;
 using namespace SoundSource::Image;
 
-extern "C"
-JNIEXPORT jintArray JNICALL
-Java_tech_rollw_player_util_ImageUtils_blurPixels(
-        JNIEnv *env, jobject thiz, jintArray image,
-        jint w, jint h, jint radius) {
-    jint *pixels;
-    pixels = (env)->GetIntArrayElements(image, nullptr);
-    if (pixels == nullptr) {
-        LOGD("Input pixels is null.");
-        return nullptr;
+namespace {
+    jintArray blurPixels(JNIEnv *env, jobject thiz, jintArray image,
+                         jint w, jint h, jint radius) {
+        Jni::IntArrayElements pixels(env, image);
+        if (!pixels) {
+            LOGD("Input pixels is null.");
+            return nullptr;
+        }
+
+        // TODO: blur and return values
+        return env->NewIntArray(0);
     }
 
-    // TODO: blur and return values
-    return env->NewIntArray(0);
-}
+    void blurBitmap(JNIEnv *env, jobject thiz, jobject bitmap, jint radius) {
+        AndroidBitmapInfo info;
+        void *pixels;
 
-extern "C"
-JNIEXPORT void JNICALL
-Java_tech_rollw_player_util_ImageUtils_blurBitmap(
-        JNIEnv *env, jobject thiz,
-        jobject bitmap, jint radius) {
-    AndroidBitmapInfo info;
-    void *pixels;
-
-    // Get image Info
-    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) {
-        LOGD("AndroidBitmap_getInfo failed!");
-        return;
-    }
+        // Get image Info
+        if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) {
+            LOGD("AndroidBitmap_getInfo failed!");
+            return;
+        }
+
+        // Check image
+        if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888 &&
+            info.format != ANDROID_BITMAP_FORMAT_RGB_565) {
+            LOGD("Only support ANDROID_BITMAP_FORMAT_RGBA_8888 and ANDROID_BITMAP_FORMAT_RGB_565");
+            return;
+        }
+
+        // Lock all image pixels
+        if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS) {
+            LOGD("AndroidBitmap_lockPixels failed!");
+            return;
+        }
+        int h = info.height;
+        int w = info.width;
 
-    // Check image
-    if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888 &&
-        info.format != ANDROID_BITMAP_FORMAT_RGB_565) {
-        LOGD("Only support ANDROID_BITMAP_FORMAT_RGBA_8888 and ANDROID_BITMAP_FORMAT_RGB_565");
-        return;
+        if (info.format == ANDROID_BITMAP_FORMAT_RGBA_8888) {
+            pixels = ImageProcessor::BlurArgb8888((int32_t *) (pixels), w, h, radius);
+        } else if (info.format == ANDROID_BITMAP_FORMAT_RGB_565) {
+            pixels = ImageProcessor::BlurRgb565((int16_t *) (pixels), w, h, radius);
+        }
+
+        AndroidBitmap_unlockPixels(env, bitmap);
     }
 
-    // Lock all image pixels
-    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS) {
-        LOGD("AndroidBitmap_lockPixels failed!");
-        return;
+    jintArray getArtworkTargetSize(JNIEnv *env, jobject thiz, jbyteArray image,
+                                   jint maxDimension, jlong maxBytes) {
+        Jni::ByteArrayElements data(env, image);
+        if (!data) {
+            return nullptr;
+        }
+        ImageInfo info = getImageInfo(data.data(), data.size());
+        ImageSize target = artworkTargetSize(info, data.size(), maxDimension, maxBytes);
+        if (target.width <= 0 || target.height <= 0) {
+            return nullptr;
+        }
+        jint size[2] = {(jint) target.width, (jint) target.height};
+        jintArray array = env->NewIntArray(2);
+        if (array != nullptr) {
+            env->SetIntArrayRegion(array, 0, 2, size);
+        }
+        return array;
     }
-    int h = info.height;
-    int w = info.width;
 
-    if (info.format == ANDROID_BITMAP_FORMAT_RGBA_8888) {
-        pixels = ImageProcessor::BlurArgb8888((int32_t *) (pixels), w, h, radius);
-    } else if (info.format == ANDROID_BITMAP_FORMAT_RGB_565) {
-        pixels = ImageProcessor::BlurRgb565((int16_t *) (pixels), w, h, radius);
+    jboolean scaleBitmap(JNIEnv *env, jobject thiz, jobject source, jobject target) {
+        AndroidBitmapInfo sourceInfo;
+        AndroidBitmapInfo targetInfo;
+        if (AndroidBitmap_getInfo(env, source, &sourceInfo) != ANDROID_BITMAP_RESULT_SUCCESS ||
+            AndroidBitmap_getInfo(env, target, &targetInfo) != ANDROID_BITMAP_RESULT_SUCCESS) {
+            LOGD("AndroidBitmap_getInfo failed!");
+            return false;
+        }
+        if (sourceInfo.format != ANDROID_BITMAP_FORMAT_RGBA_8888 ||
+            targetInfo.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+            LOGD("Only support ANDROID_BITMAP_FORMAT_RGBA_8888");
+            return false;
+        }
+
+        void *sourcePixels;
+        void *targetPixels;
+        if (AndroidBitmap_lockPixels(env, source, &sourcePixels) != ANDROID_BITMAP_RESULT_SUCCESS) {
+            LOGD("AndroidBitmap_lockPixels failed!");
+            return false;
+        }
+        if (AndroidBitmap_lockPixels(env, target, &targetPixels) != ANDROID_BITMAP_RESULT_SUCCESS) {
+            LOGD("AndroidBitmap_lockPixels failed!");
+            AndroidBitmap_unlockPixels(env, source);
+            return false;
+        }
+        resizeRgba8888((const uint8_t *) sourcePixels,
+                       (int32_t) sourceInfo.width, (int32_t) sourceInfo.height, sourceInfo.stride,
+                       (uint8_t *) targetPixels,
+                       (int32_t) targetInfo.width, (int32_t) targetInfo.height, targetInfo.stride);
+        AndroidBitmap_unlockPixels(env, target);
+        AndroidBitmap_unlockPixels(env, source);
+        return true;
     }
 
-    AndroidBitmap_unlockPixels(env, bitmap);
+    const JNINativeMethod kMethods[] = {
+            {"blurPixels",           "([IIII)[I",                    (void *) blurPixels},
+            {"blurBitmap",           "(Landroid/graphics/Bitmap;I)V", (void *) blurBitmap},
+            {"getArtworkTargetSize", "([BIJ)[I",                     (void *) getArtworkTargetSize},
+            {"scaleBitmap",          "(Landroid/graphics/Bitmap;Landroid/graphics/Bitmap;)Z",
+                                                                     (void *) scaleBitmap},
+    };
+}
+
+bool SoundSource::Jni::registerImageUtils(JNIEnv *env) {
+    return registerNatives(env, "tech/rollw/player/util/ImageUtils",
+                           kMethods, sizeof(kMethods) / sizeof(kMethods[0]));
 }
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <jni.h>
+#include <vector>
+
+#include "logging.h"
+#include "jni_support.h"
+
+#include <tags/tags.h>
+#include <audio/loudness.h>
+#include <decoder/decoder_factory.h>
+
+using namespace SoundSource;
+using namespace SoundSource::Audio;
+using namespace SoundSource::Decoder;
+
+static jobject newLoudness(JNIEnv *env, double integrated, float truePeak) {
+    if (integrated == LOUDNESS_SILENCE) {
+        return nullptr;
+    }
+    const Jni::Bindings &jni = Jni::bindings();
+    return env->NewObject(jni.loudness, jni.loudnessInit,
+                          (jdouble) integrated, (jdouble) truePeak);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_tech_rollw_player_audio_analysis_LoudnessAnalyzer_createAlbum(JNIEnv *env, jobject thiz) {
+    return (jlong) new AlbumLoudness();
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_tech_rollw_player_audio_analysis_LoudnessAnalyzer_releaseAlbum(JNIEnv *env, jobject thiz,
+                                                                    jlong albumRef) {
+    delete (AlbumLoudness *) albumRef;
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_tech_rollw_player_audio_analysis_LoudnessAnalyzer_getAlbumLoudness(JNIEnv *env,
+                                                                        jobject thiz,
+                                                                        jlong albumRef) {
+    auto *album = (AlbumLoudness *) albumRef;
+    if (album == nullptr) {
+        return nullptr;
+    }
+    return newLoudness(env, album->integratedLoudness(), album->truePeak());
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_tech_rollw_player_audio_analysis_LoudnessAnalyzer_analyzeTrack(JNIEnv *env,
+                                                                    jobject thiz,
+                                                                    jlong accessorRef,
+                                                                    jlong albumRef) {
+    auto *accessor = (AudioTagAccessor *) accessorRef;
+    if (accessor == nullptr) {
+        Jni::throwAccessorNull(env);
+        return nullptr;
+    }
+
+    std::unique_ptr<AudioDecoder> decoder = openDecoder(*accessor);
+    if (decoder == nullptr) {
+        LOGD("Cannot decode audio of accessor*(=%ld)", (long) accessorRef);
+        return nullptr;
+    }
+
+    LoudnessMeter meter(decoder->channels(), decoder->sampleRate());
+    const int32_t frames = 4096;
+    std::vector<float> buffer((size_t) frames * decoder->channels());
+    int32_t read;
+    while ((read = decoder->read(buffer.data(), frames)) > 0) {
+        meter.process(buffer.data(), read);
+    }
+    if (read < 0) {
+        LOGD("Decode error of accessor*(=%ld)", (long) accessorRef);
+        return nullptr;
+    }
+
+    auto *album = (AlbumLoudness *) albumRef;
+    if (album != nullptr) {
+        album->add(meter);
+    }
+    return newLoudness(env, meter.integratedLoudness(), meter.truePeak());
+}
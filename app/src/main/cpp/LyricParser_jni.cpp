@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <jni.h>
+#include <string>
+#include <vector>
+
+#include "logging.h"
+#include "jni_support.h"
+
+#include "taglib/taglib/tag.h"
+
+#include <tags/tags.h>
+#include <tags/lyric.h>
+#include <tags/embedded_lyric.h>
+
+using namespace SoundSource;
+
+namespace {
+    /**
+     * Decode UTF-8 into UTF-16, invalid sequences become U+FFFD.
+     */
+    void appendUtf16(std::string_view utf8, std::u16string &out) {
+        const auto *p = (const uint8_t *) utf8.data();
+        const uint8_t *end = p + utf8.size();
+        while (p < end) {
+            uint32_t c = *p;
+            int32_t extra;
+            if (c < 0x80) {
+                out.push_back((char16_t) c);
+                p++;
+                continue;
+            } else if ((c & 0xE0) == 0xC0) {
+                extra = 1;
+                c &= 0x1F;
+            } else if ((c & 0xF0) == 0xE0) {
+                extra = 2;
+                c &= 0x0F;
+            } else if ((c & 0xF8) == 0xF0) {
+                extra = 3;
+                c &= 0x07;
+            } else {
+                out.push_back(u'\uFFFD');
+                p++;
+                continue;
+            }
+            if (end - p <= extra) {
+                out.push_back(u'\uFFFD');
+                break;
+            }
+            bool valid = true;
+            for (int32_t i = 1; i <= extra; i++) {
+                if ((p[i] & 0xC0) != 0x80) {
+                    valid = false;
+                    break;
+                }
+                c = (c << 6) | (p[i] & 0x3F);
+            }
+            if (!valid || c > 0x10FFFF) {
+                out.push_back(u'\uFFFD');
+                p++;
+                continue;
+            }
+            p += extra + 1;
+            if (c >= 0x10000) {
+                c -= 0x10000;
+                out.push_back((char16_t) (0xD800 + (c >> 10)));
+                out.push_back((char16_t) (0xDC00 + (c & 0x3FF)));
+            } else {
+                out.push_back((char16_t) c);
+            }
+        }
+    }
+
+    jstring toJString(JNIEnv *env, std::string_view utf8, std::u16string &buffer) {
+        buffer.clear();
+        appendUtf16(utf8, buffer);
+        return env->NewString((const jchar *) buffer.data(), (jsize) buffer.size());
+    }
+
+    jobjectArray toStringArray(JNIEnv *env, jsize size) {
+        return env->NewObjectArray(size, Jni::bindings().string, nullptr);
+    }
+
+    /**
+     * Hand a timeline over as LyricTimeline: flat arrays, one string per
+     * line, word positions as UTF-16 offsets into the text of their line.
+     */
+    jobject toLyricTimeline(JNIEnv *env, const LyricTimeline &timeline) {
+        const std::vector<LyricLine> &lines = timeline.lines();
+        const std::vector<LyricWord> &words = timeline.words();
+        const auto lineCount = (jsize) lines.size();
+        const auto wordCount = (jsize) words.size();
+
+        std::vector<jlong> timestamps(lines.size());
+        std::vector<jint> firstWords(lines.size());
+        std::vector<jint> wordCounts(lines.size());
+        std::vector<jlong> wordTimestamps(words.size());
+        std::vector<jint> wordOffsets(words.size());
+        jobjectArray texts = toStringArray(env, lineCount);
+
+        std::u16string buffer;
+        for (jsize i = 0; i < lineCount; i++) {
+            const LyricLine &line = lines[i];
+            timestamps[i] = line.timestamp;
+            firstWords[i] = (jint) line.firstWord;
+            wordCounts[i] = (jint) line.wordCount;
+
+            buffer.clear();
+            uint32_t cursor = line.start;
+            for (uint32_t w = line.firstWord; w < line.firstWord + line.wordCount; w++) {
+                const LyricWord &word = words[w];
+                appendUtf16(timeline.textOf(cursor, word.start - cursor), buffer);
+                cursor = word.start;
+                wordTimestamps[w] = word.timestamp;
+                wordOffsets[w] = (jint) buffer.size();
+            }
+            appendUtf16(timeline.textOf(cursor, line.start + line.length - cursor), buffer);
+            jstring text = env->NewString((const jchar *) buffer.data(), (jsize) buffer.size());
+            env->SetObjectArrayElement(texts, i, text);
+            env->DeleteLocalRef(text);
+        }
+
+        const auto &tagList = timeline.tags();
+        jobjectArray tags = toStringArray(env, (jsize) tagList.size() * 2);
+        for (size_t i = 0; i < tagList.size(); i++) {
+            jstring id = toJString(env, tagList[i].first, buffer);
+            jstring value = toJString(env, tagList[i].second, buffer);
+            env->SetObjectArrayElement(tags, (jsize) (i * 2), id);
+            env->SetObjectArrayElement(tags, (jsize) (i * 2 + 1), value);
+            env->DeleteLocalRef(id);
+            env->DeleteLocalRef(value);
+        }
+
+        jlongArray jTimestamps = env->NewLongArray(lineCount);
+        env->SetLongArrayRegion(jTimestamps, 0, lineCount, timestamps.data());
+        jintArray jFirstWords = env->NewIntArray(lineCount);
+        env->SetIntArrayRegion(jFirstWords, 0, lineCount, firstWords.data());
+        jintArray jWordCounts = env->NewIntArray(lineCount);
+        env->SetIntArrayRegion(jWordCounts, 0, lineCount, wordCounts.data());
+        jlongArray jWordTimestamps = env->NewLongArray(wordCount);
+        env->SetLongArrayRegion(jWordTimestamps, 0, wordCount, wordTimestamps.data());
+        jintArray jWordOffsets = env->NewIntArray(wordCount);
+        env->SetIntArrayRegion(jWordOffsets, 0, wordCount, wordOffsets.data());
+
+        const Jni::Bindings &bindings = Jni::bindings();
+        return env->NewObject(bindings.lyricTimeline, bindings.lyricTimelineInit,
+                              jTimestamps, texts, jFirstWords, jWordCounts,
+                              jWordTimestamps, jWordOffsets, tags, (jlong) timeline.offset());
+    }
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_tech_rollw_player_audio_tag_NativeLyricParser_parseLyric(JNIEnv *env,
+                                                              jobject thiz,
+                                                              jstring lyric) {
+    const char *chars = env->GetStringUTFChars(lyric, nullptr);
+    if (chars == nullptr) {
+        return nullptr;
+    }
+    LyricTimeline timeline = LyricTimeline::parse(chars);
+    env->ReleaseStringUTFChars(lyric, chars);
+    return toLyricTimeline(env, timeline);
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_tech_rollw_player_audio_tag_NativeLyricParser_readLyric(JNIEnv *env,
+                                                             jobject thiz,
+                                                             jlong accessorRef) {
+    auto *accessor = (AudioTagAccessor *) accessorRef;
+    if (accessor == nullptr) {
+        Jni::throwAccessorNull(env);
+        return nullptr;
+    }
+    if (accessor->tag() == nullptr) {
+        return nullptr;
+    }
+    LyricTimeline timeline = readEmbeddedLyric(accessor->fileRef()->file());
+    if (timeline.empty()) {
+        return nullptr;
+    }
+    return toLyricTimeline(env, timeline);
+}
@@ -14,11 +14,14 @@
  * limitations under the License.
  */
 
-#include <iostream>
+
 #include <jni.h>
 #include <string>
 
 #include "logging.h"
+#include "jni_support.h"
+#include "metrics.h"
+#include "trace.h"
 
 #include "taglib/taglib/tag.h"
 #include "taglib/taglib/flac/flacfile.h"
@@ -34,286 +37,259 @@ using namespace std;
 using namespace TagLib;
 using namespace SoundSource;
 
-void throwAccessorNullException(JNIEnv *env) {
-    env->ThrowNew(env->FindClass("java/lang/NullPointerException"), "accessor is null");
-}
-
-jstring toJString(JNIEnv *env, String string) {
-    auto cString = string.toCString(true);
-    if (cString == nullptr) {
-        return nullptr;
+namespace {
+    jstring toJString(JNIEnv *env, const String &string) {
+        auto cString = string.toCString(true);
+        if (cString == nullptr) {
+            return nullptr;
+        }
+        return env->NewStringUTF(cString);
     }
-    return env->NewStringUTF(cString);
-}
 
-extern "C"
-JNIEXPORT jlong JNICALL
-Java_tech_rollw_player_audio_tag_NativeLibAudioTag_openFile(JNIEnv *env, jobject thiz,
-                                                            jint file_descriptor,
-                                                            jboolean jreadonly) {
-    bool readonly = jreadonly;
-    AudioTagAccessor *accessor = new AudioTagAccessor(file_descriptor, readonly);
-    if (accessor->isNull()) {
-        env->ThrowNew(
-                env->FindClass("java/io/IOException"),
-                "Cannot open native TagAccessor with given file descriptor."
-        );
-        return 0;
+    jbyteArray toJByteArray(JNIEnv *env, const ByteVector &byteVector) {
+        if (byteVector.isEmpty()) {
+            return nullptr;
+        }
+        auto size = byteVector.size();
+        jbyteArray jbytes = env->NewByteArray(size);
+        env->SetByteArrayRegion(jbytes, 0, size, (jbyte *) byteVector.data());
+        return jbytes;
     }
-    return (jlong) accessor;
-}
 
-extern "C"
-JNIEXPORT void JNICALL
-Java_tech_rollw_player_audio_tag_NativeLibAudioTag_closeFile(JNIEnv *env,
-                                                             jobject thiz,
-                                                             jlong accessorRef) {
-    AudioTagAccessor *accessor = (AudioTagAccessor *) accessorRef;
-    if (accessor == nullptr) {
-        throwAccessorNullException(env);
-        return;
+    jlong openFile(JNIEnv *env, jobject thiz,
+                   jint file_descriptor,
+                   jboolean jreadonly,
+                   jboolean windowed,
+                   jint formatType) {
+        bool readonly = jreadonly;
+        TagStream streamType = windowed ? TagStream::WINDOWED : TagStream::FILE;
+        AudioTagAccessor *accessor = new AudioTagAccessor(file_descriptor, readonly, streamType,
+                                                          formatType);
+        if (accessor->isNull()) {
+            delete accessor;
+            env->ThrowNew(
+                    Jni::bindings().ioException,
+                    "Cannot open native TagAccessor with given file descriptor."
+            );
+            return 0;
+        }
+        return (jlong) accessor;
     }
 
-    accessor->close();
-    delete accessor;
-}
+    void closeFile(JNIEnv *env, jobject thiz, jlong accessorRef) {
+        AudioTagAccessor *accessor = (AudioTagAccessor *) accessorRef;
+        if (accessor == nullptr) {
+            Jni::throwAccessorNull(env);
+            return;
+        }
 
-extern "C"
-JNIEXPORT jstring JNICALL
-Java_tech_rollw_player_audio_tag_NativeLibAudioTag_getTagField(JNIEnv *env,
-                                                               jobject thiz,
-                                                               jlong accessorRef,
-                                                               jstring jTagField) {
-    AudioTagAccessor *accessor = (AudioTagAccessor *) accessorRef;
-    if (accessor == nullptr) {
-        throwAccessorNullException(env);
-        return nullptr;
+        accessor->close();
+        delete accessor;
     }
-    Tag *t = accessor->tag();
-    auto fieldName = env->GetStringUTFChars(jTagField, 0);
 
-    if (t == nullptr) {
-        LOGD("Tag is null of accessor*(=%ld), field=%s", accessorRef, fieldName);
-        return nullptr;
+    jstring getTagField(JNIEnv *env, jobject thiz, jlong accessorRef, jstring jTagField) {
+        AudioTagAccessor *accessor = (AudioTagAccessor *) accessorRef;
+        if (accessor == nullptr) {
+            Jni::throwAccessorNull(env);
+            return nullptr;
+        }
+        Jni::StringChars fieldName(env, jTagField);
+        if (!fieldName) {
+            return nullptr;
+        }
+        Tag *t = accessor->tag();
+        if (t == nullptr) {
+            LOGD("Tag is null of accessor*(=%ld), field=%s", accessorRef, fieldName.get());
+            return nullptr;
+        }
+
+        Trace::Section section("Tag::properties");
+        Metrics::Timer timer(Metrics::Histogram::PARSE_TIME, accessor->formatType());
+        PropertyMap propertyMap = t->properties();
+        timer.stop();
+        section.end();
+        String tagField(fieldName.get());
+
+        auto field = propertyMap[tagField];
+        if (field.isEmpty()) {
+            return nullptr;
+        }
+        return toJString(env, field.front());
     }
 
-    PropertyMap propertyMap = t->properties();
-    String tagField(fieldName);
-
-    auto field = propertyMap[tagField];
-    if (field.isEmpty()) {
-        return nullptr;
-    }
-    auto cString = field.front().toCString(true);
-    return env->NewStringUTF(cString);
-}
+    jobject getArtwork(JNIEnv *env, jobject thiz, jlong accessorRef, jboolean includeData) {
+        TRACE_SECTION("getArtwork");
+        // FIXME: cannot read picture from some flac files
+        AudioTagAccessor *accessor = (AudioTagAccessor *) accessorRef;
+        if (accessor == nullptr) {
+            Jni::throwAccessorNull(env);
+            return nullptr;
+        }
+        Metrics::Timer timer(Metrics::Histogram::ARTWORK_TIME, accessor->formatType());
 
-jbyteArray toJByteArray(JNIEnv *env, const ByteVector &byteVector) {
-    if (byteVector.isEmpty()) {
-        return nullptr;
-    }
-    auto size = byteVector.size();
-    jbyteArray jbytes = env->NewByteArray(size);
-    env->SetByteArrayRegion(jbytes, 0, size, (jbyte *) byteVector.data());
-    return jbytes;
-}
-
-extern "C"
-JNIEXPORT jobject JNICALL
-Java_tech_rollw_player_audio_tag_NativeLibAudioTag_getArtwork(JNIEnv *env,
-                                                              jobject thiz,
-                                                              jlong accessorRef,
-                                                              jboolean includeData) {
-    // FIXME: cannot read picture from some flac files
-    AudioTagAccessor *accessor = (AudioTagAccessor *) accessorRef;
-    if (accessor == nullptr) {
-        throwAccessorNullException(env);
-        return nullptr;
-    }
-
-    File *f = accessor->fileRef()->file();
-    const List<VariantMap> &pictures = f->complexProperties("PICTURE");
-    if (pictures.isEmpty()) {
-        return nullptr;
-    }
+        File *f = accessor->fileRef()->file();
+        const List<VariantMap> &pictures = f->complexProperties("PICTURE");
+        if (pictures.isEmpty()) {
+            return nullptr;
+        }
+
+        auto map = pictures.front();
+        if (map.isEmpty()) {
+            return nullptr;
+        }
+
+        auto description = toJString(env, map["description"].toString());
+        auto type = toJString(env, map["pictureType"].toString());
+
+        ByteVector byteVector = map["data"].toByteVector();
+        const void *imageRaw = byteVector.data();
+        Metrics::add(Metrics::Counter::ARTWORK_READ, accessor->formatType());
+        Metrics::record(Metrics::Histogram::ARTWORK_SIZE, accessor->formatType(),
+                        byteVector.size());
+
+        Image::ImageInfo imageInfo = Image::getImageInfo(
+                imageRaw, byteVector.size()
+        );
 
-    auto map = pictures.front();
-    if (map.isEmpty()) {
-        return nullptr;
+        jbyteArray jbytesData = nullptr;
+
+        if (includeData) {
+            jbytesData = toJByteArray(env, byteVector);
+        }
+
+        const Jni::Bindings &bindings = Jni::bindings();
+        auto mimeType = env->NewStringUTF(imageInfo.mimetype());
+        return env->NewObject(
+                bindings.nativeArtwork, bindings.nativeArtworkInit,
+                mimeType, jbytesData,
+                (jint) imageInfo.size().width,
+                (jint) imageInfo.size().height,
+                (jlong) byteVector.size(),
+                description, type
+        );
     }
 
-    auto description = toJString(env, map["description"].toString());
-    auto type = toJString(env, map["pictureType"].toString());
-
-    ByteVector byteVector = map["data"].toByteVector();
-    const void *imageRaw = byteVector.data();
-
-    Image::ImageInfo imageInfo = Image::getImageInfo(
-            imageRaw, byteVector.size()
-    );
-
-    jbyteArray jbytesData = nullptr;
-
-    if (includeData) {
-        jbytesData = toJByteArray(env, byteVector);
+    void setTagField(JNIEnv *env, jobject thiz, jlong accessorRef,
+                     jstring tag_field, jstring value) {
+        AudioTagAccessor *accessor = (AudioTagAccessor *) accessorRef;
+        if (accessor == nullptr) {
+            Jni::throwAccessorNull(env);
+            return;
+        }
+        Jni::StringChars fieldName(env, tag_field);
+        Jni::StringChars fieldValue(env, value);
+        if (!fieldName || !fieldValue) {
+            return;
+        }
+        accessor->edit().setField(String(fieldName.get(), String::UTF8),
+                                  String(fieldValue.get(), String::UTF8));
     }
 
-    jclass artworkClass = env->FindClass(
-            "tech/rollw/player/audio/tag/NativeLibAudioTag$NativeArtwork");
-
-    jmethodID constructor = env->GetMethodID(
-            artworkClass,
-            "<init>", "(Ljava/lang/String;[BIIJLjava/lang/String;Ljava/lang/String;)V"
-    );
-
-    auto mimeType = env->NewStringUTF(imageInfo.mimetype());
-    return env->NewObject(
-            artworkClass, constructor,
-            mimeType, jbytesData,
-            (jint) imageInfo.size().width,
-            (jint) imageInfo.size().height,
-            (jlong) byteVector.size(),
-            description, type
-    );
-}
-
-extern "C"
-JNIEXPORT void JNICALL
-Java_tech_rollw_player_audio_tag_NativeLibAudioTag_setTagField(JNIEnv *env, jobject thiz,
-                                                               jlong accessorRef,
-                                                               jstring tag_field,
-                                                               jstring value) {
-    AudioTagAccessor *accessor = (AudioTagAccessor *) accessorRef;
-    if (accessor == nullptr) {
-        throwAccessorNullException(env);
-        return;
+    void setArtwork(JNIEnv *env, jobject thiz, jlong accessorRef, jbyteArray artwork) {
+        AudioTagAccessor *accessor = (AudioTagAccessor *) accessorRef;
+        if (accessor == nullptr) {
+            Jni::throwAccessorNull(env);
+            return;
+        }
+        Jni::ByteArrayElements data(env, artwork);
+        if (!data) {
+            return;
+        }
+        accessor->edit().setArtwork(ByteVector((const char *) data.data(), data.size()));
     }
-    auto fieldName = env->GetStringUTFChars(tag_field, 0);
-    auto fieldValue = env->GetStringUTFChars(value, 0);
-
-    Tag *tag = accessor->tag();
-    PropertyMap propertyMap = tag->properties();
-    propertyMap[fieldName] = String(fieldValue);
-}
 
-extern "C"
-JNIEXPORT void JNICALL
-Java_tech_rollw_player_audio_tag_NativeLibAudioTag_setArtwork(JNIEnv *env,
-                                                              jobject thiz,
-                                                              jlong accessorRef,
-                                                              jbyteArray artwork) {
-    AudioTagAccessor *accessor = (AudioTagAccessor *) accessorRef;
-    if (accessor == nullptr) {
-        throwAccessorNullException(env);
-        return;
+    void saveFile(JNIEnv *env, jobject thiz, jlong accessorRef) {
+        AudioTagAccessor *accessor = (AudioTagAccessor *) accessorRef;
+        if (accessor == nullptr) {
+            Jni::throwAccessorNull(env);
+            return;
+        }
+        if (!accessor->save()) {
+            env->ThrowNew(Jni::bindings().ioException, "Cannot save tags of the file.");
+        }
     }
-    File *f = accessor->fileRef()->file();
-    jbyte *data = env->GetByteArrayElements(artwork, nullptr);
-    auto size = env->GetArrayLength(artwork);
-    ByteVector byteVector((const char *) data, size);
-
-    f->setComplexProperties("PICTURE", List<VariantMap>{
-            VariantMap{
-                    {"data",        byteVector},
-                    {"pictureType", "Front Cover"}
-            }
-    });
-}
 
-extern "C"
-JNIEXPORT void JNICALL
-Java_tech_rollw_player_audio_tag_NativeLibAudioTag_saveFile(JNIEnv *env,
-                                                            jobject thiz,
-                                                            jlong accessorRef) {
-    AudioTagAccessor *accessor = (AudioTagAccessor *) accessorRef;
-    if (accessor == nullptr) {
-        throwAccessorNullException(env);
-        return;
+    void deleteTagField(JNIEnv *env, jobject thiz, jlong accessorRef, jstring tag_field) {
+        AudioTagAccessor *accessor = (AudioTagAccessor *) accessorRef;
+        if (accessor == nullptr) {
+            Jni::throwAccessorNull(env);
+            return;
+        }
+        Jni::StringChars chars(env, tag_field);
+        if (!chars) {
+            return;
+        }
+        string fieldName = chars.get();
+        if (fieldName.empty()) {
+            return;
+        }
+        if (fieldName == "PICTURE") {
+            accessor->edit().deleteArtwork();
+            return;
+        }
+        accessor->edit().deleteField(String(fieldName, String::UTF8));
     }
-    File *f = accessor->fileRef()->file();
-    f->save();
-}
 
-extern "C"
-JNIEXPORT void JNICALL
-Java_tech_rollw_player_audio_tag_NativeLibAudioTag_deleteTagField(JNIEnv *env,
-                                                                  jobject thiz,
-                                                                  jlong accessorRef,
-                                                                  jstring tag_field) {
-    AudioTagAccessor *accessor = (AudioTagAccessor *) accessorRef;
-    if (accessor == nullptr) {
-        throwAccessorNullException(env);
-        return;
-    }
-    string fieldName = env->GetStringUTFChars(tag_field, 0);
-    if (fieldName.empty()) {
-        return;
-    }
-    if (fieldName == "PICTURE") {
-        File *f = accessor->fileRef()->file();
-        f->setComplexProperties("PICTURE", {});
-        return;
+    jlong lastModified(JNIEnv *env, jobject thiz, jlong accessorRef) {
+        AudioTagAccessor *accessor = (AudioTagAccessor *) accessorRef;
+        if (accessor == nullptr) {
+            Jni::throwAccessorNull(env);
+            return 0;
+        }
+        return accessor->lastModified();
     }
 
-    Tag *tag = accessor->tag();
-    PropertyMap propertyMap = tag->properties();
-    propertyMap.erase(fieldName);
-}
+    jlong getSize(JNIEnv *env, jobject thiz, jlong accessorRef) {
+        AudioTagAccessor *accessor = (AudioTagAccessor *) accessorRef;
+        if (accessor == nullptr) {
+            Jni::throwAccessorNull(env);
+            return -1;
+        }
 
-extern "C"
-JNIEXPORT jlong JNICALL
-Java_tech_rollw_player_audio_tag_NativeLibAudioTag_lastModified(JNIEnv *env,
-                                                                jobject thiz,
-                                                                jlong accessorRef) {
-    AudioTagAccessor *accessor = (AudioTagAccessor *) accessorRef;
-    if (accessor == nullptr) {
-        throwAccessorNullException(env);
-        return 0;
+        return accessor->size();
     }
-    return accessor->lastModified();
-}
 
-
-extern "C"
-JNIEXPORT jlong JNICALL
-Java_tech_rollw_player_audio_tag_NativeLibAudioTag_getSize(JNIEnv *env, jobject thiz,
-                                                           jlong accessorRef) {
-    AudioTagAccessor *accessor = (AudioTagAccessor *) accessorRef;
-    if (accessor == nullptr) {
-        throwAccessorNullException(env);
-        return -1;
+    jobject getAudioProperties(JNIEnv *env, jobject thiz, jlong accessorRef) {
+        AudioTagAccessor *accessor = (AudioTagAccessor *) accessorRef;
+        if (accessor == nullptr) {
+            Jni::throwAccessorNull(env);
+            return nullptr;
+        }
+
+        FileRef *ref = accessor->fileRef();
+        AudioProperties *properties = ref->audioProperties();
+
+        const Jni::Bindings &bindings = Jni::bindings();
+        return env->NewObject(
+                bindings.audioProperties, bindings.audioPropertiesInit,
+                properties->channels(),
+                properties->bitrate(),
+                accessor->bitDepth(),
+                properties->sampleRate(),
+                (jlong) properties->lengthInMilliseconds()
+        );
     }
 
-    return accessor->size();
+    const JNINativeMethod kMethods[] = {
+            {"openFile",           "(IZZI)J",                   (void *) openFile},
+            {"closeFile",          "(J)V",                     (void *) closeFile},
+            {"getTagField",        "(JLjava/lang/String;)Ljava/lang/String;",
+                                                               (void *) getTagField},
+            {"getArtwork",         "(JZ)Ltech/rollw/player/audio/tag/NativeLibAudioTag$NativeArtwork;",
+                                                               (void *) getArtwork},
+            {"setTagField",        "(JLjava/lang/String;Ljava/lang/String;)V",
+                                                               (void *) setTagField},
+            {"deleteTagField",     "(JLjava/lang/String;)V",   (void *) deleteTagField},
+            {"setArtwork",         "(J[B)V",                   (void *) setArtwork},
+            {"saveFile",           "(J)V",                     (void *) saveFile},
+            {"getAudioProperties", "(J)Ltech/rollw/player/audio/tag/AudioProperties;",
+                                                               (void *) getAudioProperties},
+            {"lastModified",       "(J)J",                     (void *) lastModified},
+            {"getSize",            "(J)J",                     (void *) getSize},
+    };
 }
 
-extern "C"
-JNIEXPORT jobject JNICALL
-Java_tech_rollw_player_audio_tag_NativeLibAudioTag_getAudioProperties(JNIEnv *env,
-                                                                      jobject thiz,
-                                                                      jlong accessorRef) {
-    AudioTagAccessor *accessor = (AudioTagAccessor *) accessorRef;
-    if (accessor == nullptr) {
-        throwAccessorNullException(env);
-        return nullptr;
-    }
-
-    FileRef *ref = accessor->fileRef();
-    AudioProperties *properties = ref->audioProperties();
-
-    jclass propertiesClass = env->FindClass(
-            "tech/rollw/player/audio/tag/AudioProperties"
-    );
-    jmethodID constructor = env->GetMethodID(
-            propertiesClass,
-            "<init>", "(IIIIJ)V");
-
-    return env->NewObject(
-            propertiesClass, constructor,
-            properties->channels(),
-            properties->bitrate(),
-            accessor->bitDepth(),
-            properties->sampleRate(),
-            (jlong) properties->lengthInMilliseconds()
-    );
+bool SoundSource::Jni::registerNativeLibAudioTag(JNIEnv *env) {
+    return registerNatives(env, "tech/rollw/player/audio/tag/NativeLibAudioTag",
+                           kMethods, sizeof(kMethods) / sizeof(kMethods[0]));
 }
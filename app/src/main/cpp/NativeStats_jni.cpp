@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <jni.h>
+#include <vector>
+
+#include "metrics.h"
+
+using namespace SoundSource;
+
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_tech_rollw_player_util_NativeStats_snapshotStats(JNIEnv *env, jobject thiz) {
+    std::vector<int64_t> values = Metrics::snapshot();
+    jlongArray array = env->NewLongArray((jsize) values.size());
+    if (array == nullptr) {
+        return nullptr;
+    }
+    env->SetLongArrayRegion(array, 0, (jsize) values.size(), (const jlong *) values.data());
+    return array;
+}
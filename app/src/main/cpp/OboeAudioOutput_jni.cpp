@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <jni.h>
+
+#include "logging.h"
+#include "jni_support.h"
+
+#include <audio/oboe_output.h>
+
+using namespace SoundSource;
+using namespace SoundSource::Audio;
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_tech_rollw_player_audio_player_OboeAudioOutput_createOutput(JNIEnv *env,
+                                                                 jobject thiz,
+                                                                 jint channels,
+                                                                 jint sampleRate,
+                                                                 jboolean floatEncoding,
+                                                                 jboolean lowLatency) {
+    auto *output = new OboeOutput(channels, sampleRate, floatEncoding, lowLatency);
+    if (!output->isValid()) {
+        delete output;
+        return 0;
+    }
+    return (jlong) output;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_tech_rollw_player_audio_player_OboeAudioOutput_releaseOutput(JNIEnv *env,
+                                                                  jobject thiz,
+                                                                  jlong outputRef) {
+    delete (OboeOutput *) outputRef;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_tech_rollw_player_audio_player_OboeAudioOutput_write(JNIEnv *env,
+                                                          jobject thiz,
+                                                          jlong outputRef,
+                                                          jobject buffer,
+                                                          jint offset,
+                                                          jint frames) {
+    auto *output = (OboeOutput *) outputRef;
+    if (output == nullptr) {
+        return 0;
+    }
+    auto *data = (uint8_t *) env->GetDirectBufferAddress(buffer);
+    if (data == nullptr) {
+        LOGD("OboeAudioOutput: buffer is not direct.");
+        return 0;
+    }
+    return output->write(data + offset, frames);
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_tech_rollw_player_audio_player_OboeAudioOutput_start(JNIEnv *env,
+                                                          jobject thiz,
+                                                          jlong outputRef) {
+    auto *output = (OboeOutput *) outputRef;
+    if (output == nullptr) {
+        return false;
+    }
+    return output->start();
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_tech_rollw_player_audio_player_OboeAudioOutput_pause(JNIEnv *env,
+                                                          jobject thiz,
+                                                          jlong outputRef) {
+    auto *output = (OboeOutput *) outputRef;
+    if (output == nullptr) {
+        return false;
+    }
+    return output->pause();
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_tech_rollw_player_audio_player_OboeAudioOutput_flush(JNIEnv *env,
+                                                          jobject thiz,
+                                                          jlong outputRef) {
+    auto *output = (OboeOutput *) outputRef;
+    if (output == nullptr) {
+        return;
+    }
+    output->flush();
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_tech_rollw_player_audio_player_OboeAudioOutput_getQueuedFrames(JNIEnv *env,
+                                                                    jobject thiz,
+                                                                    jlong outputRef) {
+    auto *output = (OboeOutput *) outputRef;
+    if (output == nullptr) {
+        return 0;
+    }
+    return output->queuedFrames();
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_tech_rollw_player_audio_player_OboeAudioOutput_getPlayedFrames(JNIEnv *env,
+                                                                    jobject thiz,
+                                                                    jlong outputRef) {
+    auto *output = (OboeOutput *) outputRef;
+    if (output == nullptr) {
+        return 0;
+    }
+    return output->playedFrames();
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_tech_rollw_player_audio_player_OboeAudioOutput_getStats(JNIEnv *env,
+                                                             jobject thiz,
+                                                             jlong outputRef) {
+    auto *output = (OboeOutput *) outputRef;
+    if (output == nullptr) {
+        return nullptr;
+    }
+    OutputStats stats = output->stats();
+    jintArray histogram = env->NewIntArray(OUTPUT_HISTOGRAM_BUCKETS);
+    env->SetIntArrayRegion(histogram, 0, OUTPUT_HISTOGRAM_BUCKETS,
+                           (const jint *) stats.callbackHistogram.data());
+
+    const Jni::Bindings &jni = Jni::bindings();
+    return env->NewObject(jni.outputStats, jni.outputStatsInit,
+                          (jlong) stats.framesWritten, (jlong) stats.framesPlayed,
+                          (jint) stats.xRunCount, (jint) stats.starvedCount,
+                          (jint) stats.bufferSizeFrames, (jint) stats.bufferCapacityFrames,
+                          (jint) stats.framesPerBurst, (jint) stats.sampleRate,
+                          (jdouble) stats.latencyMillis, histogram);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_tech_rollw_player_audio_player_OboeAudioOutput_setVolume(JNIEnv *env,
+                                                              jobject thiz,
+                                                              jlong outputRef,
+                                                              jfloat volume) {
+    auto *output = (OboeOutput *) outputRef;
+    if (output == nullptr) {
+        return;
+    }
+    output->setVolume(volume);
+}
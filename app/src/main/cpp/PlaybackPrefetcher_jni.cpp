@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <jni.h>
+#include <vector>
+
+#include "logging.h"
+#include "jni_support.h"
+
+#include <decoder/prefetch_cache.h>
+
+using namespace SoundSource;
+using namespace SoundSource::Decoder;
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_tech_rollw_player_audio_player_PlaybackPrefetcher_createCache(JNIEnv *env,
+                                                                   jobject thiz,
+                                                                   jlong budgetBytes) {
+    return (jlong) new PrefetchCache(budgetBytes);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_tech_rollw_player_audio_player_PlaybackPrefetcher_releaseCache(JNIEnv *env,
+                                                                    jobject thiz,
+                                                                    jlong cacheRef) {
+    delete (PrefetchCache *) cacheRef;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_tech_rollw_player_audio_player_PlaybackPrefetcher_setQueue(JNIEnv *env,
+                                                                jobject thiz,
+                                                                jlong cacheRef,
+                                                                jlongArray keys) {
+    auto *cache = (PrefetchCache *) cacheRef;
+    if (cache == nullptr) {
+        return;
+    }
+    jsize count = env->GetArrayLength(keys);
+    std::vector<int64_t> queue((size_t) count);
+    env->GetLongArrayRegion(keys, 0, count, (jlong *) queue.data());
+    cache->setQueue(queue.data(), count);
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_tech_rollw_player_audio_player_PlaybackPrefetcher_prefetch(JNIEnv *env,
+                                                                jobject thiz,
+                                                                jlong cacheRef,
+                                                                jlong key,
+                                                                jint fileDescriptor,
+                                                                jint headMillis) {
+    auto *cache = (PrefetchCache *) cacheRef;
+    if (cache == nullptr) {
+        return false;
+    }
+    return cache->prefetch(key, fileDescriptor, headMillis);
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_tech_rollw_player_audio_player_PlaybackPrefetcher_take(JNIEnv *env,
+                                                            jobject thiz,
+                                                            jlong cacheRef,
+                                                            jlong key) {
+    auto *cache = (PrefetchCache *) cacheRef;
+    if (cache == nullptr) {
+        return -1;
+    }
+    std::unique_ptr<PrefetchEntry> entry = cache->take(key);
+    if (entry == nullptr) {
+        return -1;
+    }
+    jlong openNanos = entry->openNanos;
+    LOGD("PlaybackPrefetcher: took %lld, %d frames decoded ahead",
+         (long long) key, entry->headFrames);
+    cache->recycle(std::move(entry));
+    return openNanos;
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_tech_rollw_player_audio_player_PlaybackPrefetcher_getStats(JNIEnv *env,
+                                                                jobject thiz,
+                                                                jlong cacheRef) {
+    auto *cache = (PrefetchCache *) cacheRef;
+    if (cache == nullptr) {
+        return nullptr;
+    }
+    PrefetchStats stats = cache->stats();
+    const Jni::Bindings &jni = Jni::bindings();
+    return env->NewObject(jni.prefetchStats, jni.prefetchStatsInit,
+                          (jlong) stats.hits, (jlong) stats.misses, (jlong) stats.evictions,
+                          (jint) stats.entries, (jlong) stats.bytes,
+                          (jlong) stats.meanSavedNanos);
+}
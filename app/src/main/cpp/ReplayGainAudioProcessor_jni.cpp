@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <jni.h>
+
+#include "logging.h"
+
+#include <audio/gain.h>
+
+using namespace SoundSource::Audio;
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_tech_rollw_player_audio_player_ReplayGainAudioProcessor_createProcessor(JNIEnv *env,
+                                                                             jobject thiz,
+                                                                             jint channels,
+                                                                             jint sampleRate) {
+    return (jlong) new GainProcessor(channels, sampleRate);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_tech_rollw_player_audio_player_ReplayGainAudioProcessor_releaseProcessor(JNIEnv *env,
+                                                                              jobject thiz,
+                                                                              jlong processorRef) {
+    delete (GainProcessor *) processorRef;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_tech_rollw_player_audio_player_ReplayGainAudioProcessor_setGain(JNIEnv *env,
+                                                                     jobject thiz,
+                                                                     jlong processorRef,
+                                                                     jfloat gainDb) {
+    auto *processor = (GainProcessor *) processorRef;
+    if (processor == nullptr) {
+        return;
+    }
+    processor->setGain(gainDb);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_tech_rollw_player_audio_player_ReplayGainAudioProcessor_resetProcessor(JNIEnv *env,
+                                                                            jobject thiz,
+                                                                            jlong processorRef) {
+    auto *processor = (GainProcessor *) processorRef;
+    if (processor == nullptr) {
+        return;
+    }
+    processor->reset();
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_tech_rollw_player_audio_player_ReplayGainAudioProcessor_getLatencyFrames(JNIEnv *env,
+                                                                              jobject thiz,
+                                                                              jlong processorRef) {
+    auto *processor = (GainProcessor *) processorRef;
+    if (processor == nullptr) {
+        return 0;
+    }
+    return processor->latencyFrames();
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_tech_rollw_player_audio_player_ReplayGainAudioProcessor_process(JNIEnv *env,
+                                                                     jobject thiz,
+                                                                     jlong processorRef,
+                                                                     jobject buffer,
+                                                                     jint frames,
+                                                                     jboolean floatEncoding) {
+    auto *processor = (GainProcessor *) processorRef;
+    if (processor == nullptr) {
+        return;
+    }
+    void *data = env->GetDirectBufferAddress(buffer);
+    if (data == nullptr) {
+        LOGD("ReplayGainAudioProcessor: buffer is not direct.");
+        return;
+    }
+    if (floatEncoding) {
+        processor->process((float *) data, frames);
+    } else {
+        processor->process((int16_t *) data, frames);
+    }
+}
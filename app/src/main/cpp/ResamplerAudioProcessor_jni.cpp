@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <jni.h>
+
+#include "logging.h"
+
+#include <audio/resampler.h>
+
+using namespace SoundSource::Audio;
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_tech_rollw_player_audio_player_ResamplerAudioProcessor_createResampler(JNIEnv *env,
+                                                                            jobject thiz,
+                                                                            jint channels,
+                                                                            jint inputRate,
+                                                                            jint outputRate,
+                                                                            jint quality) {
+    auto *resampler = new Resampler(channels, inputRate, outputRate,
+                                    (ResamplerQuality) quality);
+    if (!resampler->isValid()) {
+        delete resampler;
+        return 0;
+    }
+    return (jlong) resampler;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_tech_rollw_player_audio_player_ResamplerAudioProcessor_releaseResampler(JNIEnv *env,
+                                                                             jobject thiz,
+                                                                             jlong resamplerRef) {
+    delete (Resampler *) resamplerRef;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_tech_rollw_player_audio_player_ResamplerAudioProcessor_isSupported(JNIEnv *env,
+                                                                        jobject thiz,
+                                                                        jint inputRate,
+                                                                        jint outputRate) {
+    return FilterBank::obtain(inputRate, outputRate, ResamplerQuality::LOW) != nullptr;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_tech_rollw_player_audio_player_ResamplerAudioProcessor_getMaxOutputFrames(JNIEnv *env,
+                                                                               jobject thiz,
+                                                                               jlong resamplerRef,
+                                                                               jint frames) {
+    auto *resampler = (Resampler *) resamplerRef;
+    if (resampler == nullptr) {
+        return 0;
+    }
+    return resampler->maxOutputFrames(frames);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_tech_rollw_player_audio_player_ResamplerAudioProcessor_getDelayFrames(JNIEnv *env,
+                                                                           jobject thiz,
+                                                                           jlong resamplerRef) {
+    auto *resampler = (Resampler *) resamplerRef;
+    if (resampler == nullptr) {
+        return 0;
+    }
+    return resampler->delayFrames();
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_tech_rollw_player_audio_player_ResamplerAudioProcessor_process(JNIEnv *env,
+                                                                    jobject thiz,
+                                                                    jlong resamplerRef,
+                                                                    jobject input,
+                                                                    jint inputOffset,
+                                                                    jint frames,
+                                                                    jobject output,
+                                                                    jboolean floatEncoding) {
+    auto *resampler = (Resampler *) resamplerRef;
+    if (resampler == nullptr) {
+        return 0;
+    }
+    auto *in = (uint8_t *) env->GetDirectBufferAddress(input);
+    void *out = env->GetDirectBufferAddress(output);
+    if (in == nullptr || out == nullptr) {
+        LOGD("ResamplerAudioProcessor: buffer is not direct.");
+        return 0;
+    }
+    if (env->GetDirectBufferCapacity(output) <
+        (jlong) resampler->maxOutputFrames(frames) * resampler->channels() *
+        (floatEncoding ? sizeof(float) : sizeof(int16_t))) {
+        LOGD("ResamplerAudioProcessor: output buffer too small.");
+        return 0;
+    }
+    if (floatEncoding) {
+        return resampler->process((const float *) (in + inputOffset), frames, (float *) out);
+    }
+    return resampler->process((const int16_t *) (in + inputOffset), frames, (int16_t *) out);
+}
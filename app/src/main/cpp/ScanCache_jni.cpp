@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <jni.h>
+#include <string>
+#include <vector>
+
+#include "logging.h"
+#include "jni_support.h"
+
+#include "taglib/taglib/fileref.h"
+
+#include <tags/tags.h>
+#include <tags/scan_cache.h>
+
+using namespace SoundSource;
+
+namespace {
+    std::string toString(JNIEnv *env, jstring string) {
+        Jni::StringChars chars(env, string);
+        return chars ? std::string(chars.get()) : std::string();
+    }
+
+    std::vector<std::string> toStrings(JNIEnv *env, jobjectArray array) {
+        jsize count = env->GetArrayLength(array);
+        std::vector<std::string> strings;
+        strings.reserve((size_t) count);
+        for (jsize i = 0; i < count; i++) {
+            auto string = (jstring) env->GetObjectArrayElement(array, i);
+            strings.push_back(toString(env, string));
+            env->DeleteLocalRef(string);
+        }
+        return strings;
+    }
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_tech_rollw_player_audio_tag_ScanCache_openCache(JNIEnv *env,
+                                                     jobject thiz,
+                                                     jstring path,
+                                                     jobjectArray fieldKeys) {
+    auto *cache = new ScanCache(toString(env, path), toStrings(env, fieldKeys));
+    LOGD("ScanCache: opened with %zu entries", cache->size());
+    return (jlong) cache;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_tech_rollw_player_audio_tag_ScanCache_releaseCache(JNIEnv *env,
+                                                        jobject thiz,
+                                                        jlong cacheRef) {
+    delete (ScanCache *) cacheRef;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_tech_rollw_player_audio_tag_ScanCache_createWriter(JNIEnv *env,
+                                                        jobject thiz,
+                                                        jobjectArray fieldKeys,
+                                                        jlong tableRef) {
+    auto *table = (StringTable *) tableRef;
+    if (table == nullptr) {
+        return 0;
+    }
+    return (jlong) new ScanCacheWriter(toStrings(env, fieldKeys), *table);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_tech_rollw_player_audio_tag_ScanCache_releaseWriter(JNIEnv *env,
+                                                         jobject thiz,
+                                                         jlong writerRef) {
+    delete (ScanCacheWriter *) writerRef;
+}
+
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_tech_rollw_player_audio_tag_ScanCache_validate(JNIEnv *env,
+                                                    jobject thiz,
+                                                    jlong cacheRef,
+                                                    jobjectArray identifiers,
+                                                    jintArray fileDescriptors) {
+    auto *cache = (ScanCache *) cacheRef;
+    jsize count = env->GetArrayLength(identifiers);
+    if (cache == nullptr || env->GetArrayLength(fileDescriptors) != count) {
+        return nullptr;
+    }
+    std::vector<std::string> names = toStrings(env, identifiers);
+    std::vector<std::string_view> views(names.begin(), names.end());
+    std::vector<int32_t> descriptors((size_t) count);
+    env->GetIntArrayRegion(fileDescriptors, 0, count, (jint *) descriptors.data());
+
+    std::vector<int64_t> lastModified((size_t) count);
+    cache->validate(views.data(), descriptors.data(), (size_t) count, lastModified.data());
+
+    jlongArray result = env->NewLongArray(count);
+    env->SetLongArrayRegion(result, 0, count, (const jlong *) lastModified.data());
+    return result;
+}
+
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_tech_rollw_player_audio_tag_ScanCache_validateStats(JNIEnv *env,
+                                                         jobject thiz,
+                                                         jlong cacheRef,
+                                                         jobjectArray identifiers,
+                                                         jlongArray sizes,
+                                                         jlongArray lastModified) {
+    auto *cache = (ScanCache *) cacheRef;
+    jsize count = env->GetArrayLength(identifiers);
+    if (cache == nullptr || env->GetArrayLength(sizes) != count ||
+        env->GetArrayLength(lastModified) != count) {
+        return nullptr;
+    }
+    std::vector<std::string> names = toStrings(env, identifiers);
+    std::vector<std::string_view> views(names.begin(), names.end());
+    std::vector<int64_t> sizeValues((size_t) count);
+    std::vector<int64_t> modified((size_t) count);
+    env->GetLongArrayRegion(sizes, 0, count, (jlong *) sizeValues.data());
+    env->GetLongArrayRegion(lastModified, 0, count, (jlong *) modified.data());
+
+    std::vector<int64_t> unchanged((size_t) count);
+    cache->validate(views.data(), sizeValues.data(), modified.data(), (size_t) count,
+                    unchanged.data());
+
+    jlongArray result = env->NewLongArray(count);
+    env->SetLongArrayRegion(result, 0, count, (const jlong *) unchanged.data());
+    return result;
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_tech_rollw_player_audio_tag_ScanCache_readEntry(JNIEnv *env,
+                                                     jobject thiz,
+                                                     jlong cacheRef,
+                                                     jlong tableRef,
+                                                     jstring jIdentifier) {
+    auto *cache = (ScanCache *) cacheRef;
+    auto *table = (StringTable *) tableRef;
+    if (cache == nullptr || table == nullptr) {
+        return nullptr;
+    }
+    int32_t index = cache->find(toString(env, jIdentifier));
+    if (index < 0) {
+        return nullptr;
+    }
+    const ScanCacheEntry &entry = cache->entry(index);
+
+    // the values join the strings of the session, which
+    // hands each over once
+    std::vector<uint32_t> ids(cache->fieldCount());
+    for (size_t i = 0; i < ids.size(); i++) {
+        const char *value = cache->value(index, i);
+        ids[i] = value == nullptr ? StringTable::kNoString : table->intern(value);
+    }
+    jintArray values = env->NewIntArray((jsize) ids.size());
+    env->SetIntArrayRegion(values, 0, (jsize) ids.size(), (const jint *) ids.data());
+
+    const Jni::Bindings &jni = Jni::bindings();
+    jobject properties = env->NewObject(jni.audioProperties, jni.audioPropertiesInit,
+                                        (jint) entry.channels, (jint) entry.bitRate,
+                                        (jint) entry.bitDepth, (jint) entry.sampleRate,
+                                        (jlong) entry.durationMs);
+
+    return env->NewObject(jni.scanCacheEntry, jni.scanCacheEntryInit, values, properties,
+                          (jlong) entry.size, (jlong) entry.lastModified);
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_tech_rollw_player_audio_tag_ScanCache_put(JNIEnv *env,
+                                               jobject thiz,
+                                               jlong writerRef,
+                                               jstring jIdentifier,
+                                               jlong accessorRef,
+                                               jintArray valueIds) {
+    auto *writer = (ScanCacheWriter *) writerRef;
+    auto *accessor = (AudioTagAccessor *) accessorRef;
+    if (writer == nullptr || accessor == nullptr ||
+        env->GetArrayLength(valueIds) != (jsize) writer->keys().size()) {
+        return false;
+    }
+    TagLib::AudioProperties *audioProperties = accessor->fileRef()->audioProperties();
+    if (audioProperties == nullptr) {
+        return false;
+    }
+    ScanCacheProperties properties;
+    properties.channels = audioProperties->channels();
+    properties.bitRate = audioProperties->bitrate();
+    properties.bitDepth = accessor->bitDepth();
+    properties.sampleRate = audioProperties->sampleRate();
+    properties.durationMs = audioProperties->lengthInMilliseconds();
+
+    std::vector<uint32_t> values(writer->keys().size());
+    env->GetIntArrayRegion(valueIds, 0, (jsize) values.size(), (jint *) values.data());
+    writer->put(toString(env, jIdentifier), accessor->size(), accessor->lastModified(),
+                properties, values.data());
+    return true;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_tech_rollw_player_audio_tag_ScanCache_keep(JNIEnv *env,
+                                                jobject thiz,
+                                                jlong writerRef,
+                                                jlong cacheRef,
+                                                jstring jIdentifier) {
+    auto *writer = (ScanCacheWriter *) writerRef;
+    auto *cache = (ScanCache *) cacheRef;
+    if (writer == nullptr || cache == nullptr) {
+        return false;
+    }
+    return writer->keep(*cache, toString(env, jIdentifier));
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_tech_rollw_player_audio_tag_ScanCache_write(JNIEnv *env,
+                                                 jobject thiz,
+                                                 jlong writerRef,
+                                                 jstring path) {
+    auto *writer = (ScanCacheWriter *) writerRef;
+    if (writer == nullptr) {
+        return false;
+    }
+    bool written = writer->write(toString(env, path));
+    LOGD("ScanCache: wrote %zu entries, success=%d", writer->size(), written);
+    return written;
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <jni.h>
+#include <string>
+#include <vector>
+
+#include "logging.h"
+#include "jni_support.h"
+#include "metrics.h"
+#include "trace.h"
+
+#include "taglib/taglib/tag.h"
+#include "taglib/taglib/fileref.h"
+#include "tpropertymap.h"
+
+#include <tags/tags.h>
+#include <tags/string_table.h>
+
+using namespace SoundSource;
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_tech_rollw_player_audio_tag_ScanStringTable_createTable(JNIEnv *env,
+                                                             jobject thiz) {
+    return (jlong) new StringTable();
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_tech_rollw_player_audio_tag_ScanStringTable_releaseTable(JNIEnv *env,
+                                                              jobject thiz,
+                                                              jlong tableRef) {
+    delete (StringTable *) tableRef;
+}
+
+extern "C"
+JNIEXPORT jintArray JNICALL
+Java_tech_rollw_player_audio_tag_ScanStringTable_intern(JNIEnv *env,
+                                                        jobject thiz,
+                                                        jlong tableRef,
+                                                        jobjectArray values) {
+    auto *table = (StringTable *) tableRef;
+    if (table == nullptr) {
+        return nullptr;
+    }
+    jsize count = env->GetArrayLength(values);
+    std::vector<uint32_t> ids((size_t) count);
+    for (jsize i = 0; i < count; i++) {
+        auto value = (jstring) env->GetObjectArrayElement(values, i);
+        const char *chars = env->GetStringUTFChars(value, nullptr);
+        ids[i] = table->intern(chars == nullptr ? "" : chars);
+        if (chars != nullptr) {
+            env->ReleaseStringUTFChars(value, chars);
+        }
+        env->DeleteLocalRef(value);
+    }
+    jintArray result = env->NewIntArray(count);
+    env->SetIntArrayRegion(result, 0, count, (const jint *) ids.data());
+    return result;
+}
+
+extern "C"
+JNIEXPORT jintArray JNICALL
+Java_tech_rollw_player_audio_tag_ScanStringTable_readFields(JNIEnv *env,
+                                                            jobject thiz,
+                                                            jlong tableRef,
+                                                            jlong accessorRef,
+                                                            jintArray keyIds) {
+    auto *table = (StringTable *) tableRef;
+    auto *accessor = (AudioTagAccessor *) accessorRef;
+    if (table == nullptr || accessor == nullptr) {
+        return nullptr;
+    }
+    jsize count = env->GetArrayLength(keyIds);
+    std::vector<uint32_t> ids((size_t) count);
+    env->GetIntArrayRegion(keyIds, 0, count, (jint *) ids.data());
+
+    // one property map for all fields, instead of one per field
+    TagLib::Tag *tag = accessor->tag();
+    TagLib::PropertyMap propertyMap;
+    if (tag != nullptr) {
+        TRACE_SECTION("Tag::properties");
+        Metrics::Timer timer(Metrics::Histogram::PARSE_TIME, accessor->formatType());
+        propertyMap = tag->properties();
+    }
+    for (uint32_t &id: ids) {
+        const std::string &key = table->get(id);
+        auto it = propertyMap.find(TagLib::String(key, TagLib::String::UTF8));
+        if (it == propertyMap.end() || it->second.isEmpty()) {
+            id = StringTable::kNoString;
+            continue;
+        }
+        id = table->intern(it->second.front().to8Bit(true));
+    }
+    jintArray result = env->NewIntArray(count);
+    env->SetIntArrayRegion(result, 0, count, (const jint *) ids.data());
+    return result;
+}
+
+extern "C"
+JNIEXPORT jobjectArray JNICALL
+Java_tech_rollw_player_audio_tag_ScanStringTable_strings(JNIEnv *env,
+                                                         jobject thiz,
+                                                         jlong tableRef,
+                                                         jint from) {
+    auto *table = (StringTable *) tableRef;
+    if (table == nullptr || from < 0) {
+        return nullptr;
+    }
+    std::vector<std::string_view> strings;
+    table->copy((uint32_t) from, strings);
+
+    auto result = env->NewObjectArray((jsize) strings.size(), Jni::bindings().string, nullptr);
+    for (size_t i = 0; i < strings.size(); i++) {
+        // views of the table are NUL terminated std::strings
+        jstring string = env->NewStringUTF(strings[i].data());
+        env->SetObjectArrayElement(result, (jsize) i, string);
+        env->DeleteLocalRef(string);
+    }
+    return result;
+}
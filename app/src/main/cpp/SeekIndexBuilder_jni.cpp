@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <jni.h>
+
+#include "logging.h"
+#include "jni_support.h"
+
+#include <tags/tags.h>
+#include <decoder/seek_index.h>
+
+#include "flacfile.h"
+#include "mpegfile.h"
+
+using namespace SoundSource;
+using namespace SoundSource::Decoder;
+
+extern "C"
+JNIEXPORT jbyteArray JNICALL
+Java_tech_rollw_player_audio_analysis_SeekIndexBuilder_buildSeekIndex(JNIEnv *env,
+                                                                      jobject thiz,
+                                                                      jlong accessorRef,
+                                                                      jint intervalMs) {
+    auto *accessor = (AudioTagAccessor *) accessorRef;
+    if (accessor == nullptr) {
+        Jni::throwAccessorNull(env);
+        return nullptr;
+    }
+    if (accessor->isNull()) {
+        return nullptr;
+    }
+
+    TagLib::File *file = accessor->fileRef()->file();
+    int32_t fd = accessor->getFileDescriptor();
+    std::unique_ptr<SeekIndex> index;
+    if (dynamic_cast<TagLib::FLAC::File *>(file) != nullptr) {
+        index = SeekIndex::buildFlac(fd, intervalMs);
+    } else if (dynamic_cast<TagLib::MPEG::File *>(file) != nullptr) {
+        index = SeekIndex::buildMpeg(fd, intervalMs);
+    }
+    if (index == nullptr) {
+        return nullptr;
+    }
+
+    std::vector<uint8_t> data = index->serialize();
+    jbyteArray array = env->NewByteArray((jsize) data.size());
+    env->SetByteArrayRegion(array, 0, (jsize) data.size(), (const jbyte *) data.data());
+    return array;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <jni.h>
+
+#include "logging.h"
+#include "jni_support.h"
+
+#include <audio/spectrum.h>
+
+using namespace SoundSource;
+using namespace SoundSource::Audio;
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_tech_rollw_player_audio_player_SpectrumAnalyzer_createAnalyzer(JNIEnv *env,
+                                                                    jobject thiz,
+                                                                    jint fftSize,
+                                                                    jint bandCount) {
+    if (fftSize < 8 || (fftSize & (fftSize - 1)) != 0) {
+        env->ThrowNew(Jni::bindings().illegalArgumentException,
+                      "fftSize must be a power of two of at least 8");
+        return 0;
+    }
+    return (jlong) new SpectrumAnalyzer(fftSize, bandCount);
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_tech_rollw_player_audio_player_SpectrumAnalyzer_getBandCount(JNIEnv *env,
+                                                                  jobject thiz,
+                                                                  jlong analyzerRef) {
+    auto *analyzer = (SpectrumAnalyzer *) analyzerRef;
+    if (analyzer == nullptr) {
+        return 0;
+    }
+    return analyzer->bandCount();
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_tech_rollw_player_audio_player_SpectrumAnalyzer_configure(JNIEnv *env,
+                                                               jobject thiz,
+                                                               jlong analyzerRef,
+                                                               jint channels,
+                                                               jint sampleRate) {
+    auto *analyzer = (SpectrumAnalyzer *) analyzerRef;
+    if (analyzer == nullptr) {
+        return;
+    }
+    analyzer->configure(channels, sampleRate);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_tech_rollw_player_audio_player_SpectrumAnalyzer_process(JNIEnv *env,
+                                                             jobject thiz,
+                                                             jlong analyzerRef,
+                                                             jobject buffer,
+                                                             jint offset,
+                                                             jint frames,
+                                                             jboolean floatEncoding) {
+    auto *analyzer = (SpectrumAnalyzer *) analyzerRef;
+    if (analyzer == nullptr) {
+        return;
+    }
+    auto *data = (uint8_t *) env->GetDirectBufferAddress(buffer);
+    if (data == nullptr) {
+        LOGD("SpectrumAnalyzer: buffer is not direct.");
+        return;
+    }
+    if (floatEncoding) {
+        analyzer->process((const float *) (data + offset), frames);
+    } else {
+        analyzer->process((const int16_t *) (data + offset), frames);
+    }
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_tech_rollw_player_audio_player_SpectrumAnalyzer_readBands(JNIEnv *env,
+                                                               jobject thiz,
+                                                               jlong analyzerRef,
+                                                               jfloatArray bands) {
+    auto *analyzer = (SpectrumAnalyzer *) analyzerRef;
+    if (analyzer == nullptr) {
+        return false;
+    }
+    if (env->GetArrayLength(bands) < analyzer->bandCount()) {
+        env->ThrowNew(Jni::bindings().illegalArgumentException,
+                      "bands is shorter than bandCount");
+        return false;
+    }
+    // the array is small, a critical section avoids a copy
+    auto *levels = (float *) env->GetPrimitiveArrayCritical(bands, nullptr);
+    if (levels == nullptr) {
+        return false;
+    }
+    bool fresh = analyzer->read(levels);
+    env->ReleasePrimitiveArrayCritical(bands, levels, 0);
+    return fresh;
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <jni.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "jni_support.h"
+
+#include "tpropertymap.h"
+
+#include <tags/tag_batch.h>
+
+using namespace SoundSource;
+using namespace TagLib;
+
+namespace {
+    /**
+     * Owns the descriptors passed in and closes them when leaving the
+     * scope, unless they were handed over with release().
+     */
+    class FileDescriptors {
+    public:
+        explicit FileDescriptors(std::vector<int32_t> fds) : fds(std::move(fds)) {}
+
+        ~FileDescriptors() {
+            for (int32_t fd: fds) {
+                ::close(fd);
+            }
+        }
+
+        FileDescriptors(const FileDescriptors &) = delete;
+
+        FileDescriptors &operator=(const FileDescriptors &) = delete;
+
+        const std::vector<int32_t> &get() const {
+            return fds;
+        }
+
+        std::vector<int32_t> release() {
+            return std::exchange(fds, {});
+        }
+
+    private:
+        std::vector<int32_t> fds;
+    };
+
+    std::vector<int32_t> readFileDescriptors(JNIEnv *env, jintArray array) {
+        Jni::IntArrayElements elements(env, array);
+        if (!elements) {
+            return {};
+        }
+        return std::vector<int32_t>(elements.data(), elements.data() + elements.size());
+    }
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_tech_rollw_player_audio_tag_TagBatchEditor_applyBatch(JNIEnv *env,
+                                                           jobject thiz,
+                                                           jintArray fileDescriptors,
+                                                           jintArray formats,
+                                                           jobjectArray fields,
+                                                           jobjectArray values,
+                                                           jbyteArray artwork,
+                                                           jboolean deleteArtwork,
+                                                           jint concurrency,
+                                                           jobject callback) {
+    // owned before anything is checked, every return closes them
+    FileDescriptors fds(readFileDescriptors(env, fileDescriptors));
+    std::vector<TagBatchFile> files;
+    {
+        Jni::IntArrayElements formatTypes(env, formats);
+        if (!formatTypes || fds.get().size() != formatTypes.size()) {
+            env->ThrowNew(Jni::bindings().illegalArgumentException,
+                          "File descriptors and formats differ in length.");
+            return 0;
+        }
+        for (size_t i = 0; i < fds.get().size(); i++) {
+            files.push_back({fds.get()[i], formatTypes.data()[i]});
+        }
+    }
+
+    TagEdit edit;
+    jsize fieldCount = env->GetArrayLength(fields);
+    for (jsize i = 0; i < fieldCount; i++) {
+        auto name = (jstring) env->GetObjectArrayElement(fields, i);
+        auto value = (jstring) env->GetObjectArrayElement(values, i);
+        {
+            // released before the references they were read from
+            Jni::StringChars nameChars(env, name);
+            Jni::StringChars valueChars(env, value);
+            if (nameChars) {
+                if (valueChars) {
+                    edit.setField(String(nameChars.get(), String::UTF8),
+                                  String(valueChars.get(), String::UTF8));
+                } else {
+                    edit.deleteField(String(nameChars.get(), String::UTF8));
+                }
+            }
+        }
+        env->DeleteLocalRef(name);
+        if (value != nullptr) {
+            env->DeleteLocalRef(value);
+        }
+    }
+    if (deleteArtwork) {
+        edit.deleteArtwork();
+    } else if (artwork != nullptr) {
+        // the only copy, every file references it
+        Jni::ByteArrayElements data(env, artwork);
+        if (data) {
+            edit.setArtwork(ByteVector((const char *) data.data(), (unsigned int) data.size()));
+        }
+    }
+
+    jclass callbackClass = env->GetObjectClass(callback);
+    jmethodID onFileDone = env->GetMethodID(callbackClass, "onFileDone", "(II)V");
+    env->DeleteLocalRef(callbackClass);
+    if (onFileDone == nullptr) {
+        return 0;
+    }
+    // the job closes them from here on
+    fds.release();
+    // the workers never call into Java, the callback runs on this thread
+    return runTagBatch(files, edit, concurrency, [&](size_t index, TagBatchResult result) {
+        env->CallVoidMethod(callback, onFileDone, (jint) index, (jint) result);
+        return !env->ExceptionCheck();
+    });
+}
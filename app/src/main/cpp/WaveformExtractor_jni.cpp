@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <jni.h>
+#include <vector>
+
+#include "logging.h"
+#include "jni_support.h"
+
+#include <tags/tags.h>
+#include <audio/waveform.h>
+#include <decoder/decoder_factory.h>
+
+using namespace SoundSource;
+using namespace SoundSource::Audio;
+using namespace SoundSource::Decoder;
+
+extern "C"
+JNIEXPORT jbyteArray JNICALL
+Java_tech_rollw_player_audio_analysis_WaveformExtractor_extractWaveform(JNIEnv *env,
+                                                                        jobject thiz,
+                                                                        jlong accessorRef,
+                                                                        jint bucketCount) {
+    auto *accessor = (AudioTagAccessor *) accessorRef;
+    if (accessor == nullptr) {
+        Jni::throwAccessorNull(env);
+        return nullptr;
+    }
+
+    std::unique_ptr<AudioDecoder> decoder = openDecoder(*accessor);
+    if (decoder == nullptr) {
+        LOGD("Cannot decode audio of accessor*(=%ld)", (long) accessorRef);
+        return nullptr;
+    }
+
+    WaveformBuilder builder(decoder->channels(), decoder->sampleRate(), bucketCount);
+    const int32_t frames = 4096;
+    std::vector<float> buffer((size_t) frames * decoder->channels());
+    int32_t read;
+    while ((read = decoder->read(buffer.data(), frames)) > 0) {
+        builder.process(buffer.data(), read);
+    }
+    if (read < 0) {
+        LOGD("Decode error of accessor*(=%ld)", (long) accessorRef);
+        return nullptr;
+    }
+    builder.finish();
+
+    std::vector<uint8_t> data = builder.serialize();
+    jbyteArray array = env->NewByteArray((jsize) data.size());
+    env->SetByteArrayRegion(array, 0, (jsize) data.size(), (const jbyte *) data.data());
+    return array;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "buffer_controller.h"
+
+#include <algorithm>
+
+namespace SoundSource::Audio {
+    BufferSizeController::BufferSizeController(int32_t framesPerBurst, int32_t capacityFrames,
+                                               int32_t initialFrames, int64_t stablePeriodNanos)
+            : burst(std::max(framesPerBurst, 1)),
+              maxSize(std::max(capacityFrames / std::max(framesPerBurst, 1), 1) *
+                      std::max(framesPerBurst, 1)),
+              stablePeriod(stablePeriodNanos),
+              minSize(std::min(kMinBursts * std::max(framesPerBurst, 1), maxSize)) {
+        floor = minSize;
+        int32_t bursts = (std::max(initialFrames, 0) + burst - 1) / burst;
+        size = std::clamp(bursts * burst, floor, maxSize);
+    }
+
+    int32_t BufferSizeController::update(int32_t xRunCount, int64_t nowNanos) {
+        if (!started) {
+            reset(xRunCount, nowNanos);
+            return size;
+        }
+        if (xRunCount > lastXRunCount) {
+            lastXRunCount = xRunCount;
+            if (nowNanos - lastShrinkNanos < stablePeriod) {
+                // the shrink caused it, never go below the old size again
+                floor = std::min(size + burst, maxSize);
+            }
+            // one burst per update, the underruns of a single stall
+            // are counted as they drain
+            size = std::min(std::max(size + burst, floor), maxSize);
+            lastChangeNanos = nowNanos;
+            return size;
+        }
+        // the count goes back to zero when the stream restarts
+        lastXRunCount = xRunCount;
+        if (floor > minSize && size - burst < floor &&
+            nowNanos - lastChangeNanos >= kFloorPeriods * stablePeriod) {
+            floor -= burst;
+        }
+        if (nowNanos - lastChangeNanos >= stablePeriod && size - burst >= floor) {
+            size -= burst;
+            lastChangeNanos = nowNanos;
+            lastShrinkNanos = nowNanos;
+        }
+        return size;
+    }
+
+    int32_t BufferSizeController::bufferSize() const {
+        return size;
+    }
+
+    void BufferSizeController::reset(int32_t xRunCount, int64_t nowNanos) {
+        started = true;
+        lastXRunCount = xRunCount;
+        lastChangeNanos = nowNanos;
+        lastShrinkNanos = nowNanos - stablePeriod;
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_BUFFER_CONTROLLER_H
+#define SOUNDSOURCE_BUFFER_CONTROLLER_H
+
+#include <sys/types.h>
+#include <cstdint>
+
+namespace SoundSource::Audio {
+    /**
+     * Tunes the buffer size of an output stream in whole bursts from
+     * its underrun count.
+     *
+     * A new underrun grows the buffer by one burst. After a stable
+     * period without underruns the buffer shrinks by one burst to win
+     * back latency; if an underrun follows a shrink within a stable
+     * period, the size before the shrink becomes the floor, so the
+     * controller does not oscillate around a size that is too small.
+     * The floor itself comes down a burst at a time after several
+     * stable periods, when the load that raised it is gone.
+     *
+     * Holds no clock or stream of its own, the caller passes both in,
+     * which keeps it deterministic.
+     */
+    class BufferSizeController {
+    public:
+        /**
+         * @param initialFrames the size to start with, rounded up to
+         * whole bursts.
+         */
+        BufferSizeController(int32_t framesPerBurst, int32_t capacityFrames,
+                             int32_t initialFrames, int64_t stablePeriodNanos);
+
+        /**
+         * Feed the current underrun count of the stream.
+         *
+         * @return the buffer size to use, in frames.
+         */
+        int32_t update(int32_t xRunCount, int64_t nowNanos);
+
+        int32_t bufferSize() const;
+
+        /**
+         * Start over from the current size, after the stream was
+         * restarted and its underrun count reset.
+         */
+        void reset(int32_t xRunCount, int64_t nowNanos);
+
+    private:
+        static constexpr int32_t kMinBursts = 2;
+        // stable periods before the floor is lowered
+        static constexpr int32_t kFloorPeriods = 6;
+
+        const int32_t burst;
+        const int32_t maxSize;
+        const int64_t stablePeriod;
+        const int32_t minSize;
+        int32_t size;
+        int32_t floor;
+        int32_t lastXRunCount = 0;
+        int64_t lastChangeNanos = 0;
+        int64_t lastShrinkNanos = 0;
+        bool started = false;
+    };
+}
+
+#endif //SOUNDSOURCE_BUFFER_CONTROLLER_H
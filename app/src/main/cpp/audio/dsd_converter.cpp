@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "dsd_converter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "resampler.h"
+#include "simd.h"
+
+namespace SoundSource::Audio {
+    namespace {
+        constexpr int32_t kDsd64Rate44 = 44100 * 64;
+        constexpr int32_t kDsd64Rate48 = 48000 * 64;
+        // DSD noise rises to near full scale at the top of the band
+        constexpr double kAttenuation = 120;
+        // flat band relative to the PCM rate, 22.05 kHz at 88.2 kHz
+        constexpr double kPassband = 0.25;
+
+        /**
+         * @return the Kaiser filter length for the transition width
+         * relative to the sample rate.
+         */
+        int32_t tapsFor(double transition) {
+            return (int32_t) std::ceil((kAttenuation - 7.95) / (14.36 * transition)) + 1;
+        }
+
+        /**
+         * @return the stopband edge of a stage, where aliases would fold
+         * back into the output band. The last stage stops at Nyquist.
+         */
+        double stopbandOf(double outputRate, double pcmRate) {
+            return outputRate <= pcmRate ? pcmRate / 2 : outputRate - pcmRate / 2;
+        }
+
+        inline float dot(const float *a, const float *b, int32_t n) {
+            Simd::float4 acc0 = Simd::zero();
+            Simd::float4 acc1 = Simd::zero();
+            int32_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                acc0 = Simd::madd(Simd::load(a + i), Simd::load(b + i), acc0);
+                acc1 = Simd::madd(Simd::load(a + i + 4), Simd::load(b + i + 4), acc1);
+            }
+            if (i < n) {
+                acc0 = Simd::madd(Simd::load(a + i), Simd::load(b + i), acc0);
+            }
+            return Simd::hadd(Simd::add(acc0, acc1));
+        }
+    }
+
+    int32_t DsdConverter::defaultPcmRate(int32_t dsdRate) {
+        for (int32_t base: {kDsd64Rate44, kDsd64Rate48}) {
+            if (dsdRate == base || dsdRate == base * 2 || dsdRate == base * 4) {
+                return base / 32;
+            }
+        }
+        return 0;
+    }
+
+    DsdConverter::DsdConverter(int32_t channels, int32_t dsdRate, int32_t pcmRate,
+                               bool lsbFirst) {
+        channelCount = std::max(channels, 1);
+        if (dsdRate <= 0 || pcmRate <= 0 || dsdRate % pcmRate != 0) {
+            return;
+        }
+        decimationFactor = dsdRate / pcmRate;
+        if (decimationFactor < 8 || decimationFactor > 1024 ||
+            (decimationFactor & (decimationFactor - 1)) != 0) {
+            return;
+        }
+        outputRate = pcmRate;
+        const double pass = kPassband * pcmRate;
+
+        // byte stage, taps rounded up to whole bytes; DSD128 and up
+        // decimate further in it, which costs fewer lookups than
+        // running the float stages at the higher rates
+        byteStep = std::max(decimationFactor / 32, 1);
+        double rate = dsdRate;
+        double stop = stopbandOf(rate / 8 / byteStep, pcmRate);
+        byteTaps = (tapsFor((stop - pass) / rate) + 7) / 8;
+        std::vector<double> h = kaiserLowPass(byteTaps * 8, (pass + stop) / 2 / rate,
+                                              kAttenuation);
+        tables.resize((size_t) byteTaps * 256);
+        for (int32_t k = 0; k < byteTaps; k++) {
+            for (int32_t value = 0; value < 256; value++) {
+                double sum = 0;
+                for (int32_t b = 0; b < 8; b++) {
+                    // bit b of the byte is sample 8 * n + b of the window,
+                    // which the newest byte ends with
+                    int32_t bit = lsbFirst ? (value >> b) & 1 : (value >> (7 - b)) & 1;
+                    double tap = h[(size_t) k * 8 + 7 - b];
+                    sum += bit ? tap : -tap;
+                }
+                tables[(size_t) k * 256 + value] = (float) sum;
+            }
+        }
+
+        rate /= 8 * byteStep;
+        while (rate > pcmRate) {
+            stop = stopbandOf(rate / 2, pcmRate);
+            int32_t taps = (tapsFor((stop - pass) / rate) + 3) & ~3;
+            std::vector<double> lowPass = kaiserLowPass(taps, (pass + stop) / 2 / rate,
+                                                        kAttenuation);
+            Stage stage{taps, std::vector<float>((size_t) taps)};
+            for (int32_t m = 0; m < taps; m++) {
+                stage.coefficients[m] = (float) lowPass[taps - 1 - m];
+            }
+            stages.push_back(std::move(stage));
+            rate /= 2;
+        }
+
+        states.resize(channelCount);
+        for (ChannelState &state: states) {
+            state.bytes.resize((size_t) byteTaps - 1 + kMaxChunk);
+            state.histories.resize(stages.size());
+            state.historySizes.resize(stages.size());
+            for (size_t s = 0; s < stages.size(); s++) {
+                state.histories[s].resize((size_t) stages[s].taps - 1 + kMaxChunk);
+            }
+        }
+        for (auto &buffer: scratch) {
+            buffer.resize(kMaxChunk);
+        }
+        valid = true;
+        reset();
+    }
+
+    bool DsdConverter::isValid() const {
+        return valid;
+    }
+
+    int32_t DsdConverter::channels() const {
+        return channelCount;
+    }
+
+    int32_t DsdConverter::pcmRate() const {
+        return outputRate;
+    }
+
+    int32_t DsdConverter::decimation() const {
+        return decimationFactor;
+    }
+
+    int32_t DsdConverter::maxOutputFrames(int32_t bytes) const {
+        if (!valid) {
+            return 0;
+        }
+        return (int32_t) ((int64_t) bytes * 8 / decimationFactor) + 2;
+    }
+
+    int32_t DsdConverter::delayBytes() const {
+        if (!valid) {
+            return 0;
+        }
+        int32_t bytes = byteTaps / 2;
+        int32_t bytesPerSample = byteStep;
+        for (const Stage &stage: stages) {
+            bytes += stage.taps / 2 * bytesPerSample;
+            bytesPerSample *= 2;
+        }
+        return bytes + decimationFactor / 8;
+    }
+
+    void DsdConverter::reset() {
+        // half a filter of silence centres the first output on the
+        // first input, as the resampler does
+        for (ChannelState &state: states) {
+            std::fill(state.bytes.begin(), state.bytes.end(), kSilence);
+            for (size_t s = 0; s < stages.size(); s++) {
+                std::fill(state.histories[s].begin(), state.histories[s].end(), 0.0f);
+                state.historySizes[s] = stages[s].taps / 2;
+            }
+        }
+        byteHistorySize = byteTaps / 2;
+    }
+
+    int32_t DsdConverter::process(const uint8_t *in, int32_t bytes, float *out) {
+        if (!valid) {
+            return 0;
+        }
+        const int32_t c = channelCount;
+        int32_t written = 0;
+        while (bytes > 0) {
+            int32_t count = std::min(bytes, kMaxChunk);
+            int32_t produced = 0;
+            for (int32_t ch = 0; ch < c; ch++) {
+                uint8_t *b = states[ch].bytes.data() + byteHistorySize;
+                for (int32_t i = 0; i < count; i++) {
+                    b[i] = in[(size_t) i * c + ch];
+                }
+                produced = processChannel(ch, count, out + (size_t) written * c);
+            }
+            advanceBytes(count);
+            written += produced;
+            in += (size_t) count * c;
+            bytes -= count;
+        }
+        return written;
+    }
+
+    int32_t DsdConverter::processPlanar(const uint8_t *const *planes, int32_t bytes, float *out) {
+        if (!valid) {
+            return 0;
+        }
+        const int32_t c = channelCount;
+        int32_t written = 0;
+        int32_t offset = 0;
+        while (offset < bytes) {
+            int32_t count = std::min(bytes - offset, kMaxChunk);
+            int32_t produced = 0;
+            for (int32_t ch = 0; ch < c; ch++) {
+                std::memcpy(states[ch].bytes.data() + byteHistorySize, planes[ch] + offset,
+                            (size_t) count);
+                produced = processChannel(ch, count, out + (size_t) written * c);
+            }
+            advanceBytes(count);
+            written += produced;
+            offset += count;
+        }
+        return written;
+    }
+
+    void DsdConverter::advanceBytes(int32_t count) {
+        // drop the bytes before the next window, the same for every channel
+        const int32_t available = byteHistorySize + count;
+        int32_t windows = std::max((available - byteTaps) / byteStep + 1, 0);
+        int32_t index = windows * byteStep;
+        for (ChannelState &state: states) {
+            std::memmove(state.bytes.data(), state.bytes.data() + index,
+                         (size_t) (available - index));
+        }
+        byteHistorySize = available - index;
+    }
+
+    int32_t DsdConverter::processChannel(int32_t channel, int32_t bytes, float *out) {
+        ChannelState &state = states[channel];
+        const int32_t available = byteHistorySize + bytes;
+
+        // byte stage, output n ends with byte n * byteStep + byteTaps - 1
+        float *samples = scratch[0].data();
+        int32_t count = std::max((available - byteTaps) / byteStep + 1, 0);
+        const uint8_t *b = state.bytes.data() + byteTaps - 1;
+        for (int32_t n = 0; n < count; n++, b += byteStep) {
+            const float *table = tables.data();
+            float sum = 0;
+            for (int32_t k = 0; k < byteTaps; k++) {
+                sum += table[b[-k]];
+                table += 256;
+            }
+            samples[n] = sum;
+        }
+
+        for (size_t s = 0; s < stages.size(); s++) {
+            const Stage &stage = stages[s];
+            float *h = state.histories[s].data();
+            int32_t size = state.historySizes[s];
+            std::memcpy(h + size, samples, (size_t) count * sizeof(float));
+            size += count;
+
+            float *next = scratch[(s + 1) & 1].data();
+            int32_t produced = 0;
+            int32_t index = 0;
+            for (; index + stage.taps <= size; index += 2) {
+                next[produced++] = dot(h + index, stage.coefficients.data(), stage.taps);
+            }
+            std::memmove(h, h + index, (size_t) (size - index) * sizeof(float));
+            state.historySizes[s] = size - index;
+            samples = next;
+            count = produced;
+        }
+
+        const int32_t c = channelCount;
+        for (int32_t i = 0; i < count; i++) {
+            out[(size_t) i * c + channel] = samples[i];
+        }
+        return count;
+    }
+}
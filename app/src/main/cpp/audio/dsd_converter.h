@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_DSD_CONVERTER_H
+#define SOUNDSOURCE_DSD_CONVERTER_H
+
+#include <sys/types.h>
+#include <cstdint>
+#include <vector>
+
+namespace SoundSource::Audio {
+    /**
+     * Streaming 1-bit DSD to float PCM converter for DSD64, DSD128 and
+     * DSD256 in either the 44.1 kHz or the 48 kHz family.
+     *
+     * The first stage filters 8 DSD samples at a time: every byte of
+     * its window indexes a 256 entry table holding the sum of the
+     * eight taps it covers, signed by its bits, so an output costs one
+     * lookup and one add per byte. It decimates to four times the PCM
+     * rate (by 8 for DSD64, 16 for DSD128, 32 for DSD256). FIR stages
+     * then halve the rate until the PCM rate is reached, each designed
+     * to keep aliases out of the output band and the last one removing
+     * most of the shaped DSD noise above a quarter of the PCM rate.
+     *
+     * A bit value of 1 maps to +1, so a 0 dB SACD signal (50 %
+     * modulation) comes out at -6 dBFS, leaving room for the overs
+     * DSD allows. The output is aligned with the input (no leading
+     * delay); the filter tail is pushed out by delayBytes() bytes of
+     * DSD silence per channel at end of stream.
+     */
+    class DsdConverter {
+    public:
+        /**
+         * Idle pattern of DSD, filters to zero.
+         */
+        static constexpr uint8_t kSilence = 0x69;
+
+        /**
+         * @return twice the base rate of the DSD rate family (88.2 kHz
+         * or 96 kHz), or 0 if the DSD rate is not supported.
+         */
+        static int32_t defaultPcmRate(int32_t dsdRate);
+
+        /**
+         * @param dsdRate DSD samples per second per channel.
+         * @param pcmRate the output rate, dsdRate divided by a power
+         * of two from 8 to 1024.
+         * @param lsbFirst whether the first sample of every byte is its
+         * least significant bit (DSF), or the most significant one
+         * (DSDIFF).
+         */
+        DsdConverter(int32_t channels, int32_t dsdRate, int32_t pcmRate, bool lsbFirst);
+
+        /**
+         * @return false if the rates are not supported.
+         */
+        bool isValid() const;
+
+        int32_t channels() const;
+
+        int32_t pcmRate() const;
+
+        /**
+         * @return DSD samples per PCM frame.
+         */
+        int32_t decimation() const;
+
+        /**
+         * @return the maximum frames a call outputs for the given
+         * bytes per channel.
+         */
+        int32_t maxOutputFrames(int32_t bytes) const;
+
+        /**
+         * Convert byte interleaved DSD (one byte of every channel in
+         * turn, as DSDIFF stores it).
+         *
+         * @param bytes bytes per channel.
+         * @param out receives at least maxOutputFrames(bytes) frames of
+         * interleaved samples.
+         * @return the frames written to out.
+         */
+        int32_t process(const uint8_t *in, int32_t bytes, float *out);
+
+        /**
+         * Convert one block of bytes per channel (as DSF stores it).
+         */
+        int32_t processPlanar(const uint8_t *const *planes, int32_t bytes, float *out);
+
+        /**
+         * @return bytes of silence per channel that flush the filter tail.
+         */
+        int32_t delayBytes() const;
+
+        /**
+         * Drop the filter history.
+         */
+        void reset();
+
+    private:
+        static constexpr int32_t kMaxChunk = 4096;
+
+        struct Stage {
+            int32_t taps;
+            // reversed, padded to a multiple of four
+            std::vector<float> coefficients;
+        };
+
+        struct ChannelState {
+            // up to byteTaps - 1 bytes of history plus kMaxChunk
+            std::vector<uint8_t> bytes;
+            // per stage: taps - 1 samples of history plus its input
+            std::vector<std::vector<float>> histories;
+            std::vector<int32_t> historySizes;
+        };
+
+        int32_t channelCount;
+        int32_t outputRate = 0;
+        int32_t decimationFactor = 0;
+        bool valid = false;
+
+        // the byte stage, byteTaps tables of 256 partial sums
+        int32_t byteTaps = 0;
+        std::vector<float> tables;
+        // bytes the byte stage advances per output
+        int32_t byteStep = 1;
+        // bytes of history, the same for every channel
+        int32_t byteHistorySize = 0;
+        std::vector<Stage> stages;
+
+        std::vector<ChannelState> states;
+        std::vector<float> scratch[2];
+
+        /**
+         * Filter the bytes copied behind the history of the channel.
+         *
+         * @param out interleaved output of every channel.
+         */
+        int32_t processChannel(int32_t channel, int32_t bytes, float *out);
+
+        void advanceBytes(int32_t count);
+    };
+}
+
+#endif //SOUNDSOURCE_DSD_CONVERTER_H
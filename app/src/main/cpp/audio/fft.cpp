@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "fft.h"
+
+#include <cmath>
+
+namespace SoundSource::Audio {
+    namespace {
+        inline void twiddle(int32_t k, int32_t length, float &re, float &im) {
+            double angle = -2.0 * M_PI * k / length;
+            re = (float) std::cos(angle);
+            im = (float) std::sin(angle);
+        }
+
+        inline void cmul(Simd::float4 re, Simd::float4 im, Simd::float4 wr, Simd::float4 wi,
+                         float *outRe, float *outIm) {
+            Simd::store(outRe, Simd::sub(Simd::mul(re, wr), Simd::mul(im, wi)));
+            Simd::store(outIm, Simd::madd(re, wi, Simd::mul(im, wr)));
+        }
+    }
+
+    RealFft::RealFft(int32_t size) {
+        n = size;
+        half = size / 2;
+        int32_t length = half;
+        int32_t stride = 1;
+        while (length > 1) {
+            Stage stage{};
+            stage.radix = length % 4 == 0 ? 4 : 2;
+            stage.length = length;
+            stage.stride = stride;
+            const int32_t m = length / stage.radix;
+            stage.w1Re.resize(m);
+            stage.w1Im.resize(m);
+            if (stage.radix == 4) {
+                stage.w2Re.resize(m);
+                stage.w2Im.resize(m);
+                stage.w3Re.resize(m);
+                stage.w3Im.resize(m);
+            }
+            for (int32_t p = 0; p < m; p++) {
+                twiddle(p, length, stage.w1Re[p], stage.w1Im[p]);
+                if (stage.radix == 4) {
+                    twiddle(2 * p, length, stage.w2Re[p], stage.w2Im[p]);
+                    twiddle(3 * p, length, stage.w3Re[p], stage.w3Im[p]);
+                }
+            }
+            stages.push_back(std::move(stage));
+            length /= stages.back().radix;
+            stride *= stages.back().radix;
+        }
+
+        splitRe.resize(half);
+        splitIm.resize(half);
+        for (int32_t k = 0; k < half; k++) {
+            twiddle(k, n, splitRe[k], splitIm[k]);
+        }
+        for (int32_t i = 0; i < 2; i++) {
+            bufferRe[i].resize(half);
+            bufferIm[i].resize(half);
+        }
+    }
+
+    int32_t RealFft::size() const {
+        return n;
+    }
+
+    void RealFft::radix4(const Stage &stage, const float *xr, const float *xi,
+                         float *yr, float *yi) {
+        const int32_t s = stage.stride;
+        const int32_t m = stage.length / 4;
+        for (int32_t p = 0; p < m; p++) {
+            const int32_t a = s * p, b = s * (p + m), c = s * (p + 2 * m), d = s * (p + 3 * m);
+            const int32_t y0 = s * 4 * p, y1 = y0 + s, y2 = y1 + s, y3 = y2 + s;
+            int32_t q = 0;
+            if (s >= 4) {
+                const Simd::float4 w1r = Simd::set1(stage.w1Re[p]), w1i = Simd::set1(stage.w1Im[p]);
+                const Simd::float4 w2r = Simd::set1(stage.w2Re[p]), w2i = Simd::set1(stage.w2Im[p]);
+                const Simd::float4 w3r = Simd::set1(stage.w3Re[p]), w3i = Simd::set1(stage.w3Im[p]);
+                for (; q < s; q += 4) {
+                    Simd::float4 ar = Simd::load(xr + a + q), ai = Simd::load(xi + a + q);
+                    Simd::float4 br = Simd::load(xr + b + q), bi = Simd::load(xi + b + q);
+                    Simd::float4 cr = Simd::load(xr + c + q), ci = Simd::load(xi + c + q);
+                    Simd::float4 dr = Simd::load(xr + d + q), di = Simd::load(xi + d + q);
+
+                    Simd::float4 apcR = Simd::add(ar, cr), apcI = Simd::add(ai, ci);
+                    Simd::float4 amcR = Simd::sub(ar, cr), amcI = Simd::sub(ai, ci);
+                    Simd::float4 bpdR = Simd::add(br, dr), bpdI = Simd::add(bi, di);
+                    Simd::float4 bmdR = Simd::sub(br, dr), bmdI = Simd::sub(bi, di);
+
+                    Simd::store(yr + y0 + q, Simd::add(apcR, bpdR));
+                    Simd::store(yi + y0 + q, Simd::add(apcI, bpdI));
+                    // (a - c) -+ j (b - d)
+                    cmul(Simd::add(amcR, bmdI), Simd::sub(amcI, bmdR), w1r, w1i,
+                         yr + y1 + q, yi + y1 + q);
+                    cmul(Simd::sub(apcR, bpdR), Simd::sub(apcI, bpdI), w2r, w2i,
+                         yr + y2 + q, yi + y2 + q);
+                    cmul(Simd::sub(amcR, bmdI), Simd::add(amcI, bmdR), w3r, w3i,
+                         yr + y3 + q, yi + y3 + q);
+                }
+                continue;
+            }
+            const float w1r = stage.w1Re[p], w1i = stage.w1Im[p];
+            const float w2r = stage.w2Re[p], w2i = stage.w2Im[p];
+            const float w3r = stage.w3Re[p], w3i = stage.w3Im[p];
+            for (; q < s; q++) {
+                float apcR = xr[a + q] + xr[c + q], apcI = xi[a + q] + xi[c + q];
+                float amcR = xr[a + q] - xr[c + q], amcI = xi[a + q] - xi[c + q];
+                float bpdR = xr[b + q] + xr[d + q], bpdI = xi[b + q] + xi[d + q];
+                float bmdR = xr[b + q] - xr[d + q], bmdI = xi[b + q] - xi[d + q];
+
+                yr[y0 + q] = apcR + bpdR;
+                yi[y0 + q] = apcI + bpdI;
+                float tr = amcR + bmdI, ti = amcI - bmdR;
+                yr[y1 + q] = tr * w1r - ti * w1i;
+                yi[y1 + q] = tr * w1i + ti * w1r;
+                tr = apcR - bpdR, ti = apcI - bpdI;
+                yr[y2 + q] = tr * w2r - ti * w2i;
+                yi[y2 + q] = tr * w2i + ti * w2r;
+                tr = amcR - bmdI, ti = amcI + bmdR;
+                yr[y3 + q] = tr * w3r - ti * w3i;
+                yi[y3 + q] = tr * w3i + ti * w3r;
+            }
+        }
+    }
+
+    void RealFft::radix2(const Stage &stage, const float *xr, const float *xi,
+                         float *yr, float *yi) {
+        const int32_t s = stage.stride;
+        const int32_t m = stage.length / 2;
+        for (int32_t p = 0; p < m; p++) {
+            const int32_t a = s * p, b = s * (p + m);
+            const int32_t y0 = s * 2 * p, y1 = y0 + s;
+            const float wr = stage.w1Re[p], wi = stage.w1Im[p];
+            int32_t q = 0;
+            if (s >= 4) {
+                const Simd::float4 vwr = Simd::set1(wr), vwi = Simd::set1(wi);
+                for (; q < s; q += 4) {
+                    Simd::float4 ar = Simd::load(xr + a + q), ai = Simd::load(xi + a + q);
+                    Simd::float4 br = Simd::load(xr + b + q), bi = Simd::load(xi + b + q);
+                    Simd::store(yr + y0 + q, Simd::add(ar, br));
+                    Simd::store(yi + y0 + q, Simd::add(ai, bi));
+                    cmul(Simd::sub(ar, br), Simd::sub(ai, bi), vwr, vwi,
+                         yr + y1 + q, yi + y1 + q);
+                }
+                continue;
+            }
+            for (; q < s; q++) {
+                float tr = xr[a + q] - xr[b + q], ti = xi[a + q] - xi[b + q];
+                yr[y0 + q] = xr[a + q] + xr[b + q];
+                yi[y0 + q] = xi[a + q] + xi[b + q];
+                yr[y1 + q] = tr * wr - ti * wi;
+                yi[y1 + q] = tr * wi + ti * wr;
+            }
+        }
+    }
+
+    void RealFft::forward(const float *in, float *re, float *im) {
+        // pack even samples as real and odd samples as imaginary parts
+        float *xr = bufferRe[0].data(), *xi = bufferIm[0].data();
+        float *yr = bufferRe[1].data(), *yi = bufferIm[1].data();
+        for (int32_t k = 0; k < half; k++) {
+            xr[k] = in[2 * k];
+            xi[k] = in[2 * k + 1];
+        }
+
+        for (const Stage &stage: stages) {
+            if (stage.radix == 4) {
+                radix4(stage, xr, xi, yr, yi);
+            } else {
+                radix2(stage, xr, xi, yr, yi);
+            }
+            std::swap(xr, yr);
+            std::swap(xi, yi);
+        }
+
+        // X[k] = E[k] + w^k O[k], with E and O the transforms of the even
+        // and odd samples recovered from Z[k] and conj(Z[half - k])
+        re[0] = xr[0] + xi[0];
+        im[0] = 0;
+        re[half] = xr[0] - xi[0];
+        im[half] = 0;
+        for (int32_t k = 1; k < half; k++) {
+            const float zr = xr[k], zi = xi[k];
+            const float cr = xr[half - k], ci = -xi[half - k];
+            const float er = 0.5f * (zr + cr), ei = 0.5f * (zi + ci);
+            // O = (Z - conj) / 2i
+            const float or_ = 0.5f * (zi - ci), oi = -0.5f * (zr - cr);
+            const float wr = splitRe[k], wi = splitIm[k];
+            re[k] = er + or_ * wr - oi * wi;
+            im[k] = ei + or_ * wi + oi * wr;
+        }
+    }
+}
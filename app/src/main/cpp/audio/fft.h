@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_FFT_H
+#define SOUNDSOURCE_FFT_H
+
+#include <sys/types.h>
+#include <cstdint>
+#include <vector>
+
+#include "simd.h"
+
+namespace SoundSource::Audio {
+    /**
+     * Forward FFT of real input.
+     *
+     * The input is packed into a complex sequence of half the size, which
+     * is transformed by a Stockham autosort FFT: radix-4 stages and a
+     * final radix-2 stage for odd powers of two, so no bit reversal pass
+     * is needed. Butterflies work on split real/imaginary arrays and are
+     * vectorized across the stride. Twiddles are computed once per size.
+     */
+    class RealFft {
+    public:
+        /**
+         * @param size transform size, a power of two of at least 8.
+         */
+        explicit RealFft(int32_t size);
+
+        int32_t size() const;
+
+        /**
+         * Transform size real samples into the size / 2 + 1 bins from
+         * DC to Nyquist. Unnormalized: a full scale sine at a bin
+         * centre has magnitude size / 2.
+         */
+        void forward(const float *in, float *re, float *im);
+
+    private:
+        struct Stage {
+            int32_t radix;
+            // length of the sub transforms and their stride
+            int32_t length;
+            int32_t stride;
+            // w^p, w^2p, w^3p for p < length / radix
+            std::vector<float> w1Re, w1Im, w2Re, w2Im, w3Re, w3Im;
+        };
+
+        int32_t n;
+        int32_t half;
+        std::vector<Stage> stages;
+        // e^(-2 pi i k / n) for splitting the packed transform
+        std::vector<float> splitRe, splitIm;
+        std::vector<float> bufferRe[2], bufferIm[2];
+
+        static void radix4(const Stage &stage, const float *xr, const float *xi,
+                           float *yr, float *yi);
+
+        static void radix2(const Stage &stage, const float *xr, const float *xi,
+                           float *yr, float *yi);
+    };
+}
+
+#endif //SOUNDSOURCE_FFT_H
@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "fingerprint.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <thread>
+
+namespace SoundSource::Audio {
+    namespace {
+        constexpr uint8_t kVersion = 1;
+        constexpr size_t kHeaderSize = 12;
+
+        constexpr double kLowestPitch = 28.0;
+        constexpr double kHighestPitch = 3520.0;
+        constexpr float kSilence = 1e-10f;
+
+        // ~2 s of encoder delay or leading silence either way
+        constexpr int32_t kMaxShift = 16;
+        // ~10 s
+        constexpr int32_t kMinOverlap = 80;
+        // a wrong shift errs in about 0.3 - 0.5 of the bits, a right one
+        // of a duplicate in 0.05 - 0.15, 128 bits tell them apart
+        constexpr int32_t kShiftFrames = 4;
+        // 512 bits, the error rate of unrelated audio is 0.5 +- 0.02
+        constexpr int32_t kQuickFrames = 16;
+        constexpr float kQuickMargin = 0.1f;
+        constexpr int64_t kMaxDurationDeltaMs = 3000;
+        // sum over the 18 profile bits
+        constexpr float kMaxProfileDistance = 0.5f;
+
+        inline int64_t countErrors(const uint32_t *a, const uint32_t *b, int32_t length) {
+            int64_t errors = 0;
+            int32_t i = 0;
+            for (; i + 2 <= length; i += 2) {
+                uint64_t x, y;
+                std::memcpy(&x, a + i, sizeof(x));
+                std::memcpy(&y, b + i, sizeof(y));
+                errors += __builtin_popcountll(x ^ y);
+            }
+            if (i < length) {
+                errors += __builtin_popcount(a[i] ^ b[i]);
+            }
+            return errors;
+        }
+
+        /**
+         * @return the bit error rate at the best shift, or 1 if the
+         * fingerprints are too short or clearly different.
+         */
+        float compare(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b,
+                      float maxBitErrorRate) {
+            const auto na = (int32_t) a.size();
+            const auto nb = (int32_t) b.size();
+            const int32_t shortest = std::min(na, nb);
+            if (shortest < kMinOverlap) {
+                return 1;
+            }
+            // find the shift on a short window a quarter into the track,
+            // past intros of silence that match at any shift
+            const int32_t anchor = std::min(std::max(kMaxShift, shortest / 4),
+                                            shortest - kQuickFrames - kMaxShift);
+            int64_t fewest = INT64_MAX;
+            int32_t bestShift = 0;
+            for (int32_t shift = -kMaxShift; shift <= kMaxShift; shift++) {
+                int64_t errors = countErrors(a.data() + anchor, b.data() + anchor + shift,
+                                             kShiftFrames);
+                if (errors < fewest) {
+                    fewest = errors;
+                    bestShift = shift;
+                }
+            }
+            int64_t quickErrors = countErrors(a.data() + anchor, b.data() + anchor + bestShift,
+                                              kQuickFrames);
+            if ((float) quickErrors / (kQuickFrames * 32.0f) > maxBitErrorRate + kQuickMargin) {
+                return 1;
+            }
+            int32_t start = std::max(0, -bestShift);
+            int32_t length = std::min(na, nb - bestShift) - start;
+            int64_t errors = countErrors(a.data() + start, b.data() + start + bestShift, length);
+            return (float) errors / ((float) length * 32.0f);
+        }
+
+        inline void putLe32(std::vector<uint8_t> &out, uint32_t value) {
+            for (int32_t i = 0; i < 4; i++) {
+                out.push_back((uint8_t) (value >> (8 * i)));
+            }
+        }
+
+        inline uint32_t getLe32(const uint8_t *p) {
+            return (uint32_t) p[0] | (uint32_t) p[1] << 8 |
+                   (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+        }
+    }
+
+    FingerprintBuilder::FingerprintBuilder(int32_t channels, int32_t sampleRate,
+                                           int32_t maxSeconds)
+            : resampler(channels, sampleRate, kRate), fft(kFrameSize) {
+        remaining = (int64_t) std::max(maxSeconds, 0) * std::max(sampleRate, 0);
+        if (!resampler.isValid()) {
+            remaining = 0;
+        }
+
+        window.resize(kFrameSize);
+        for (int32_t i = 0; i < kFrameSize; i++) {
+            window[i] = (float) (0.5 - 0.5 * std::cos(2 * M_PI * i / kFrameSize));
+        }
+        pitchClasses.resize(kFrameSize / 2 + 1);
+        for (int32_t k = 0; k <= kFrameSize / 2; k++) {
+            double frequency = (double) k * kRate / kFrameSize;
+            if (frequency < kLowestPitch || frequency > kHighestPitch) {
+                pitchClasses[k] = -1;
+                continue;
+            }
+            auto note = (int32_t) std::lround(12 * std::log2(frequency / 440.0) + 69);
+            pitchClasses[k] = (int8_t) (note % 12);
+        }
+        history.resize(kFrameSize);
+        frame.resize(kFrameSize);
+        re.resize(kFrameSize / 2 + 1);
+        im.resize(kFrameSize / 2 + 1);
+    }
+
+    bool FingerprintBuilder::process(const float *samples, int32_t frames) {
+        auto count = (int32_t) std::min<int64_t>(frames, remaining);
+        if (count <= 0) {
+            return false;
+        }
+        resampler.process(samples, count, [this](const float *mono, int32_t n) {
+            push(mono, n);
+        });
+        remaining -= count;
+        return remaining > 0;
+    }
+
+    void FingerprintBuilder::push(const float *samples, int32_t count) {
+        while (count > 0) {
+            int32_t n = std::min(count, kFrameSize - historySize);
+            std::memcpy(history.data() + historySize, samples, (size_t) n * sizeof(float));
+            historySize += n;
+            samples += n;
+            count -= n;
+            if (historySize == kFrameSize) {
+                analyze();
+                std::memmove(history.data(), history.data() + kHop,
+                             (size_t) (kFrameSize - kHop) * sizeof(float));
+                historySize = kFrameSize - kHop;
+            }
+        }
+    }
+
+    void FingerprintBuilder::analyze() {
+        for (int32_t i = 0; i < kFrameSize; i += 4) {
+            Simd::store(&frame[i], Simd::mul(Simd::load(&history[i]), Simd::load(&window[i])));
+        }
+        fft.forward(frame.data(), re.data(), im.data());
+
+        std::array<float, 12> chroma{};
+        for (int32_t k = 0; k <= kFrameSize / 2; k++) {
+            int8_t pitchClass = pitchClasses[k];
+            if (pitchClass >= 0) {
+                chroma[pitchClass] += re[k] * re[k] + im[k] * im[k];
+            }
+        }
+        float energy = 0;
+        for (float v: chroma) {
+            energy += v;
+        }
+        if (energy > kSilence) {
+            for (float &v: chroma) {
+                v /= energy;
+            }
+        } else {
+            chroma.fill(0);
+        }
+        energy = std::log10(energy + kSilence);
+
+        if (frameCount > 0) {
+            uint32_t bits = 0;
+            for (int32_t i = 0; i < 12; i++) {
+                bits |= (uint32_t) (chroma[i] > previousChroma[i]) << i;
+                bits |= (uint32_t) (chroma[i] > chroma[(i + 1) % 12]) << (12 + i);
+            }
+            for (int32_t i = 0; i < 6; i++) {
+                bits |= (uint32_t) (chroma[i] > chroma[i + 6]) << (24 + i);
+            }
+            bits |= (uint32_t) (energy > previousEnergy[0]) << 30;
+            bits |= (uint32_t) (energy > previousEnergy[1]) << 31;
+            subFingerprints.push_back(bits);
+        }
+        previousChroma = chroma;
+        previousEnergy[1] = previousEnergy[0];
+        previousEnergy[0] = energy;
+        frameCount++;
+    }
+
+    const std::vector<uint32_t> &FingerprintBuilder::fingerprint() const {
+        return subFingerprints;
+    }
+
+    std::vector<uint8_t> FingerprintBuilder::serialize() const {
+        std::vector<uint8_t> out;
+        out.reserve(kHeaderSize + subFingerprints.size() * 4);
+        for (char c: {'S', 'S', 'F', 'P'}) {
+            out.push_back((uint8_t) c);
+        }
+        out.push_back(kVersion);
+        out.push_back(0);
+        out.push_back(0);
+        out.push_back(0);
+        putLe32(out, (uint32_t) subFingerprints.size());
+        for (uint32_t bits: subFingerprints) {
+            putLe32(out, bits);
+        }
+        return out;
+    }
+
+    bool FingerprintBuilder::deserialize(const uint8_t *data, size_t size,
+                                         std::vector<uint32_t> &out) {
+        if (size < kHeaderSize || std::memcmp(data, "SSFP", 4) != 0 || data[4] != kVersion) {
+            return false;
+        }
+        uint32_t count = getLe32(data + 8);
+        if ((size - kHeaderSize) / 4 != count || (size - kHeaderSize) % 4 != 0) {
+            return false;
+        }
+        out.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            out[i] = getLe32(data + kHeaderSize + (size_t) i * 4);
+        }
+        return true;
+    }
+
+    void FingerprintIndex::add(int64_t id, int64_t durationMs, std::vector<uint32_t> fingerprint) {
+        if (fingerprint.size() < (size_t) kMinOverlap) {
+            return;
+        }
+        std::array<float, kProfileBits> profile{};
+        for (uint32_t bits: fingerprint) {
+            for (int32_t b = 0; b < kProfileBits; b++) {
+                profile[b] += (float) ((bits >> (kProfileShift + b)) & 1);
+            }
+        }
+        for (float &share: profile) {
+            share /= (float) fingerprint.size();
+        }
+        entries.push_back({id, durationMs, std::move(fingerprint), profile});
+    }
+
+    size_t FingerprintIndex::size() const {
+        return entries.size();
+    }
+
+    std::vector<DuplicateMatch> FingerprintIndex::findDuplicates(float maxBitErrorRate,
+                                                                 int32_t threads) const {
+        std::vector<size_t> order(entries.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+            return entries[a].durationMs < entries[b].durationMs;
+        });
+
+        std::atomic<size_t> next{0};
+        std::vector<std::vector<DuplicateMatch>> results((size_t) std::max(threads, 1));
+        auto work = [&](std::vector<DuplicateMatch> &matches) {
+            size_t i;
+            while ((i = next.fetch_add(1, std::memory_order_relaxed)) < order.size()) {
+                const Entry &a = entries[order[i]];
+                for (size_t j = i + 1; j < order.size(); j++) {
+                    const Entry &b = entries[order[j]];
+                    if (b.durationMs - a.durationMs > kMaxDurationDeltaMs) {
+                        break;
+                    }
+                    float distance = 0;
+                    for (int32_t k = 0; k < kProfileBits; k++) {
+                        distance += std::fabs(a.profile[k] - b.profile[k]);
+                    }
+                    if (distance > kMaxProfileDistance) {
+                        continue;
+                    }
+                    float rate = compare(a.fingerprint, b.fingerprint, maxBitErrorRate);
+                    if (rate <= maxBitErrorRate) {
+                        matches.push_back({a.id, b.id, 1 - rate});
+                    }
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t t = 1; t < results.size(); t++) {
+            workers.emplace_back(work, std::ref(results[t]));
+        }
+        work(results[0]);
+        for (std::thread &worker: workers) {
+            worker.join();
+        }
+
+        std::vector<DuplicateMatch> matches;
+        for (auto &result: results) {
+            matches.insert(matches.end(), result.begin(), result.end());
+        }
+        return matches;
+    }
+}
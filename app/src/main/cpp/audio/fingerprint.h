@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_FINGERPRINT_H
+#define SOUNDSOURCE_FINGERPRINT_H
+
+#include <sys/types.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "fft.h"
+#include "resampler.h"
+
+namespace SoundSource::Audio {
+    /**
+     * Chroma based acoustic fingerprint, one 32-bit sub-fingerprint per
+     * analysis frame (about 8 per second).
+     *
+     * The audio is downmixed and resampled to 11025 Hz, 4096 sample Hann
+     * windows with 2/3 overlap are folded into 12 pitch classes
+     * (28 Hz - 3.5 kHz) and every frame is described by the signs of
+     * differences between its chroma bins and those of the previous
+     * frame, which survive re-encoding, resampling and gain changes.
+     */
+    class FingerprintBuilder {
+    public:
+        FingerprintBuilder(int32_t channels, int32_t sampleRate, int32_t maxSeconds);
+
+        /**
+         * Process interleaved float samples.
+         *
+         * @return false once maxSeconds of audio were processed, further
+         * samples are ignored.
+         */
+        bool process(const float *samples, int32_t frames);
+
+        const std::vector<uint32_t> &fingerprint() const;
+
+        /**
+         * Serialize the fingerprint:
+         *
+         * <pre>
+         * "SSFP" | version u8 | reserved u24 | count u32 | count * u32
+         * </pre>
+         *
+         * Integers are little endian.
+         */
+        std::vector<uint8_t> serialize() const;
+
+        /**
+         * Read a serialized fingerprint.
+         *
+         * @return false if the data is not a valid fingerprint.
+         */
+        static bool deserialize(const uint8_t *data, size_t size, std::vector<uint32_t> &out);
+
+    private:
+        static constexpr int32_t kRate = 11025;
+        static constexpr int32_t kFrameSize = 4096;
+        static constexpr int32_t kHop = kFrameSize / 3;
+
+        int64_t remaining;
+        MonoResampler resampler;
+        RealFft fft;
+
+        std::vector<float> window;
+        // pitch class of every bin, -1 outside the analysed range
+        std::vector<int8_t> pitchClasses;
+        std::vector<float> history;
+        int32_t historySize = 0;
+        std::vector<float> frame, re, im;
+
+        std::array<float, 12> previousChroma{};
+        float previousEnergy[2]{};
+        int32_t frameCount = 0;
+        std::vector<uint32_t> subFingerprints;
+
+        void push(const float *samples, int32_t count);
+
+        void analyze();
+    };
+
+    struct DuplicateMatch {
+        int64_t id;
+        int64_t duplicateId;
+        /**
+         * 1 minus the bit error rate at the best alignment.
+         */
+        float similarity;
+    };
+
+    /**
+     * Finds fingerprints of the same recording.
+     *
+     * Only fingerprints of tracks with similar durations, and similar
+     * shares of set pitch relation bits (which depend on the key and
+     * the harmonic content, but not on time shifts), are compared.
+     * A comparison tries small time shifts (encoder delays, leading
+     * silence) and counts differing bits of the overlap 64 bits at a
+     * time with popcount, after a quick reject on a short prefix.
+     */
+    class FingerprintIndex {
+    public:
+        void add(int64_t id, int64_t durationMs, std::vector<uint32_t> fingerprint);
+
+        /**
+         * Compare the fingerprints on up to threads threads.
+         *
+         * @param maxBitErrorRate the highest share of differing bits for
+         * a match, random audio differs in about half of the bits.
+         */
+        std::vector<DuplicateMatch> findDuplicates(float maxBitErrorRate, int32_t threads) const;
+
+        size_t size() const;
+
+    private:
+        // bits 12 - 29 compare chroma bins of the same frame
+        static constexpr int32_t kProfileBits = 18;
+        static constexpr int32_t kProfileShift = 12;
+
+        struct Entry {
+            int64_t id;
+            int64_t durationMs;
+            std::vector<uint32_t> fingerprint;
+            std::array<float, kProfileBits> profile;
+        };
+
+        std::vector<Entry> entries;
+    };
+}
+
+#endif //SOUNDSOURCE_FINGERPRINT_H
@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace SoundSource::Audio {
+    namespace {
+        constexpr float kLookaheadSeconds = 0.004f;
+        constexpr float kReleaseSeconds = 0.08f;
+        constexpr float kMinimumPeak = 1e-12f;
+    }
+
+    GainProcessor::GainProcessor(int32_t channels, int32_t sampleRate, float ceiling) {
+        channelCount = std::max(channels, 1);
+        this->ceiling = ceiling;
+        // the interpolator needs 3 frames of history behind the first
+        // detected frame, which a look-ahead of 4 frames leaves room for
+        lookahead = std::max((int32_t) ((float) sampleRate * kLookaheadSeconds), 4);
+        delay = lookahead + kInterpolationTaps - 1;
+        releaseCoefficient = std::exp(-1.0f / (kReleaseSeconds * (float) std::max(sampleRate, 1)));
+
+        // windowed sinc at the half-sample offsets, normalized to unity DC gain
+        float sum = 0;
+        for (int32_t k = 0; k < kInterpolationTaps; k++) {
+            double x = k + 0.5;
+            double window = std::cos(M_PI * x / (2.0 * kInterpolationTaps));
+            interpolation[k] = (float) (std::sin(M_PI * x) / (M_PI * x) * window * window);
+            sum += 2 * interpolation[k];
+        }
+        for (float &c: interpolation) {
+            c /= sum;
+        }
+
+        delayLine.resize((size_t) (delay + kMaxChunk) * channelCount);
+        midpoints.resize((size_t) kMaxChunk * channelCount);
+        required.resize(lookahead - 1 + kMaxChunk);
+        prefix.resize(required.size());
+        suffix.resize(required.size());
+        window.resize(lookahead);
+        scratch.resize((size_t) kMaxChunk * channelCount);
+        reset();
+    }
+
+    void GainProcessor::setGain(float gainDb) {
+        targetGain = std::pow(10.0f, gainDb / 20.0f);
+    }
+
+    void GainProcessor::reset() {
+        std::fill(delayLine.begin(), delayLine.end(), 0.0f);
+        std::fill(required.begin(), required.end(), 1.0f);
+        std::fill(window.begin(), window.end(), 1.0f);
+        windowSum = lookahead;
+        windowPosition = 0;
+        released = 1.0f;
+        currentGain = targetGain;
+    }
+
+    int32_t GainProcessor::latencyFrames() const {
+        return delay;
+    }
+
+    int32_t GainProcessor::channels() const {
+        return channelCount;
+    }
+
+    void GainProcessor::process(float *samples, int32_t frames) {
+        while (frames > 0) {
+            int32_t count = std::min(frames, kMaxChunk);
+            processChunk(samples, count);
+            samples += (size_t) count * channelCount;
+            frames -= count;
+        }
+    }
+
+    void GainProcessor::process(int16_t *samples, int32_t frames) {
+        const Simd::float4 scale = Simd::set1(1.0f / 32768.0f);
+        while (frames > 0) {
+            int32_t count = std::min(frames, kMaxChunk);
+            int32_t n = count * channelCount;
+            for (int32_t i = 0; i < n; i++) {
+                scratch[i] = samples[i];
+            }
+            int32_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                Simd::store(&scratch[i], Simd::mul(Simd::load(&scratch[i]), scale));
+            }
+            for (; i < n; i++) {
+                scratch[i] *= 1.0f / 32768.0f;
+            }
+
+            processChunk(scratch.data(), count);
+
+            for (i = 0; i < n; i++) {
+                float v = std::clamp(scratch[i] * 32768.0f, -32768.0f, 32767.0f);
+                samples[i] = (int16_t) std::lrintf(v);
+            }
+            samples += n;
+            frames -= count;
+        }
+    }
+
+    void GainProcessor::processChunk(float *samples, int32_t frames) {
+        const int32_t c = channelCount;
+        float *line = delayLine.data();
+
+        // 1. gain, ramped linearly to the target over this chunk
+        float *in = line + (size_t) delay * c;
+        float step = (targetGain - currentGain) / (float) frames;
+        for (int32_t i = 0; i < frames; i++) {
+            float gain = currentGain + step * (float) (i + 1);
+            for (int32_t ch = 0; ch < c; ch++) {
+                in[i * c + ch] = samples[i * c + ch] * gain;
+            }
+        }
+        currentGain = targetGain;
+
+        // 2. peaks of the frames whose interpolation window is complete,
+        // that is the frames lookahead - 1 behind the delay line head
+        const int32_t first = lookahead - 1;
+        const float *x = line + (size_t) first * c;
+        const int32_t n = frames * c;
+        int32_t j = 0;
+        for (; j + 4 <= n; j += 4) {
+            Simd::float4 acc = Simd::zero();
+            for (int32_t k = 0; k < kInterpolationTaps; k++) {
+                Simd::float4 pair = Simd::add(Simd::load(x + j - k * c),
+                                              Simd::load(x + j + (k + 1) * c));
+                acc = Simd::madd(Simd::set1(interpolation[k]), pair, acc);
+            }
+            Simd::float4 peak = Simd::max(Simd::abs(acc), Simd::abs(Simd::load(x + j)));
+            Simd::store(&midpoints[j], peak);
+        }
+        for (; j < n; j++) {
+            float acc = 0;
+            for (int32_t k = 0; k < kInterpolationTaps; k++) {
+                acc += interpolation[k] * (x[j - k * c] + x[j + (k + 1) * c]);
+            }
+            midpoints[j] = std::max(std::fabs(acc), std::fabs(x[j]));
+        }
+
+        // gained frames only, the peaks of the unchanged audio are the
+        // ones it was mastered with
+        const bool unity = step == 0.0f && currentGain == 1.0f;
+        const float limit = unity ? HUGE_VALF : ceiling;
+        float *req = required.data() + first;
+        for (int32_t i = 0; i < frames; i++) {
+            float peak = kMinimumPeak;
+            for (int32_t ch = 0; ch < c; ch++) {
+                peak = std::max(peak, midpoints[i * c + ch]);
+            }
+            req[i] = std::min(1.0f, limit / peak);
+        }
+
+        // 3. minimum over the look-ahead window, van Herk/Gil-Werman
+        const int32_t total = first + frames;
+        for (int32_t block = 0; block < total; block += lookahead) {
+            int32_t end = std::min(block + lookahead, total);
+            float m = 1.0f;
+            for (int32_t i = block; i < end; i++) {
+                m = std::min(m, required[i]);
+                prefix[i] = m;
+            }
+            m = 1.0f;
+            for (int32_t i = end - 1; i >= block; i--) {
+                m = std::min(m, required[i]);
+                suffix[i] = m;
+            }
+        }
+
+        // 4. release, box filter and output of the delayed frames
+        const float release = releaseCoefficient;
+        const double scale = 1.0 / lookahead;
+        for (int32_t i = 0; i < frames; i++) {
+            float hold = std::min(suffix[i], prefix[i + lookahead - 1]);
+            released = std::min(hold, released * release + (1.0f - release));
+
+            windowSum += released - window[windowPosition];
+            window[windowPosition] = released;
+            int32_t next = windowPosition + 1;
+            windowPosition = next == lookahead ? 0 : next;
+
+            auto gain = (float) (windowSum * scale);
+            for (int32_t ch = 0; ch < c; ch++) {
+                samples[i * c + ch] = line[i * c + ch] * gain;
+            }
+        }
+
+        // 5. keep the history for the next chunk
+        std::memmove(line, line + (size_t) frames * c, (size_t) delay * c * sizeof(float));
+        std::memmove(required.data(), required.data() + frames, first * sizeof(float));
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOUNDSOURCE_GAIN_H
+#define SOUNDSOURCE_GAIN_H
+
+#include <sys/types.h>
+#include <vector>
+
+#include "simd.h"
+
+namespace SoundSource::Audio {
+    /**
+     * Applies a (ReplayGain) gain to float PCM and keeps the result under
+     * the ceiling with a look-ahead peak limiter.
+     *
+     * The limiter estimates inter-sample peaks with a half-band 2x
+     * interpolator, takes the minimum required gain over the look-ahead
+     * window and smooths it with a box filter of the same length, which
+     * guarantees the gain has fully ramped down by the time a peak leaves
+     * the delay line. There is no data-dependent branch on the sample path.
+     *
+     * Output is delayed by latencyFrames(), at most 5 ms. At unity gain
+     * the limiter holds off, so the delayed output is the exact input and
+     * the processor can stay in a stream whose gain changes midway.
+     */
+    class GainProcessor {
+    public:
+        /**
+         * @param ceiling peak ceiling as linear amplitude, 0.891 is -1 dBTP.
+         */
+        GainProcessor(int32_t channels, int32_t sampleRate, float ceiling = 0.891f);
+
+        /**
+         * Set the gain in dB, ramped over the next processed block.
+         */
+        void setGain(float gainDb);
+
+        /**
+         * Process interleaved samples in place. The output is the input
+         * delayed by latencyFrames().
+         */
+        void process(float *samples, int32_t frames);
+
+        /**
+         * Process 16-bit samples in place.
+         */
+        void process(int16_t *samples, int32_t frames);
+
+        /**
+         * Drop all buffered samples and the limiter state.
+         */
+        void reset();
+
+        int32_t latencyFrames() const;
+
+        int32_t channels() const;
+
+    private:
+        static constexpr int32_t kMaxChunk = 256;
+        static constexpr int32_t kInterpolationTaps = 4;
+
+        int32_t channelCount;
+        int32_t lookahead;
+        int32_t delay;
+
+        float ceiling;
+        float currentGain = 1.0f;
+        float targetGain = 1.0f;
+        float releaseCoefficient;
+        float interpolation[kInterpolationTaps]{};
+
+        // gained input, delay frames of history then kMaxChunk frames
+        std::vector<float> delayLine;
+        // required gains, lookahead - 1 of history then kMaxChunk
+        std::vector<float> required;
+        std::vector<float> prefix;
+        std::vector<float> suffix;
+        std::vector<float> midpoints;
+        // released hold values inside the box filter window
+        std::vector<float> window;
+        int32_t windowPosition = 0;
+        double windowSum = 0;
+        float released = 1.0f;
+
+        std::vector<float> scratch;
+
+        void processChunk(float *samples, int32_t frames);
+    };
+}
+
+#endif //SOUNDSOURCE_GAIN_H
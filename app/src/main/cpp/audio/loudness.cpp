@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "loudness.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace SoundSource::Audio {
+    namespace {
+        constexpr double kAbsoluteGate = -70.0;
+        constexpr double kRelativeGate = -10.0;
+        constexpr double kHistogramStep = 0.1;
+
+        inline double energyToLoudness(double energy) {
+            return -0.691 + 10.0 * std::log10(energy);
+        }
+
+        inline double loudnessToEnergy(double loudness) {
+            return std::pow(10.0, (loudness + 0.691) / 10.0);
+        }
+
+        /**
+         * Zero the lanes that decayed far below any audible level, before
+         * the recursion of a silent channel reaches denormals, which are
+         * slow on most cores.
+         */
+        Simd::float4 flushDecayed(Simd::float4 value) {
+            float lanes[4];
+            Simd::store(lanes, value);
+            for (float &lane: lanes) {
+                if (std::fabs(lane) < 1e-15f) {
+                    lane = 0.0f;
+                }
+            }
+            return Simd::load(lanes);
+        }
+    }
+
+    void LoudnessHistogram::add(double blockEnergy) {
+        if (blockEnergy <= 0) {
+            return;
+        }
+        double loudness = energyToLoudness(blockEnergy);
+        if (loudness < kAbsoluteGate) {
+            return;
+        }
+        auto index = (int32_t) ((loudness - kAbsoluteGate) / kHistogramStep);
+        index = std::min(index, kBins - 1);
+        counts[index]++;
+        energies[index] += blockEnergy;
+        total++;
+    }
+
+    void LoudnessHistogram::merge(const LoudnessHistogram &other) {
+        for (int32_t i = 0; i < kBins; i++) {
+            counts[i] += other.counts[i];
+            energies[i] += other.energies[i];
+        }
+        total += other.total;
+    }
+
+    double LoudnessHistogram::integratedLoudness() const {
+        if (total == 0) {
+            return LOUDNESS_SILENCE;
+        }
+        double sum = 0;
+        for (int32_t i = 0; i < kBins; i++) {
+            sum += energies[i];
+        }
+        double gate = energyToLoudness(sum / (double) total) + kRelativeGate;
+        // the bin containing the relative gate is kept, as libebur128 does
+        auto start = (int32_t) ((gate - kAbsoluteGate) / kHistogramStep);
+        start = std::clamp(start, 0, kBins - 1);
+
+        double gatedSum = 0;
+        uint64_t gatedCount = 0;
+        for (int32_t i = start; i < kBins; i++) {
+            gatedSum += energies[i];
+            gatedCount += counts[i];
+        }
+        if (gatedCount == 0) {
+            return LOUDNESS_SILENCE;
+        }
+        return energyToLoudness(gatedSum / (double) gatedCount);
+    }
+
+    bool LoudnessHistogram::isEmpty() const {
+        return total == 0;
+    }
+
+    LoudnessMeter::LoudnessMeter(int32_t channels, int32_t sampleRate) {
+        channelCount = std::max(channels, 1);
+        rate = std::max(sampleRate, 1);
+        oversampling = rate < 96000 ? 4 : (rate < 192000 ? 2 : 1);
+        subBlockFrames = std::max(rate / 10, 1);
+
+        states.resize(channelCount);
+        if (channelCount == 6) {
+            // 5.1 in WAVE order: L R C LFE Ls Rs
+            states[3].weight = 0.0f;
+            states[4].weight = 1.41f;
+            states[5].weight = 1.41f;
+        }
+        buffer.assign((size_t) channelCount * (kHistory + kChunkFrames), 0.0f);
+
+        int32_t groups = (channelCount + 3) / 4;
+        laneStates.resize(groups);
+        for (int32_t g = 0; g < groups; g++) {
+            float weights[4]{};
+            for (int32_t lane = 0; lane < 4 && g * 4 + lane < channelCount; lane++) {
+                weights[lane] = states[g * 4 + lane].weight;
+            }
+            LaneState &state = laneStates[g];
+            state.s1 = state.s2 = state.t1 = state.t2 = Simd::zero();
+            state.weights = Simd::load(weights);
+        }
+        lanes.assign((size_t) groups * kChunkFrames * 4, 0.0f);
+        initFilters();
+    }
+
+    void LoudnessMeter::initFilters() {
+        // K-weighting, the pre-filter and RLB filter of BS.1770 re-derived
+        // for any sample rate (coefficients as in libebur128).
+        double f0 = 1681.974450955533;
+        double gain = 3.999843853973347;
+        double q = 0.7071752369554196;
+
+        Biquad s{};
+        double k = std::tan(M_PI * f0 / rate);
+        double vh = std::pow(10.0, gain / 20.0);
+        double vb = std::pow(vh, 0.4996667741545416);
+        double a0 = 1.0 + k / q + k * k;
+        s.b0 = (vh + vb * k / q + k * k) / a0;
+        s.b1 = 2.0 * (k * k - vh) / a0;
+        s.b2 = (vh - vb * k / q + k * k) / a0;
+        s.a1 = 2.0 * (k * k - 1.0) / a0;
+        s.a2 = (1.0 - k / q + k * k) / a0;
+
+        Biquad h{};
+        f0 = 38.13547087602444;
+        q = 0.5003270373238773;
+        k = std::tan(M_PI * f0 / rate);
+        a0 = 1.0 + k / q + k * k;
+        h.b0 = 1.0;
+        h.b1 = -2.0;
+        h.b2 = 1.0;
+        h.a1 = 2.0 * (k * k - 1.0) / a0;
+        h.a2 = (1.0 - k / q + k * k) / a0;
+
+        auto toLanes = [](const Biquad &biquad) {
+            return LaneBiquad{Simd::set1((float) biquad.b0), Simd::set1((float) biquad.b1),
+                              Simd::set1((float) biquad.b2), Simd::set1((float) biquad.a1),
+                              Simd::set1((float) biquad.a2)};
+        };
+        shelf = toLanes(s);
+        highPass = toLanes(h);
+
+        // Windowed-sinc interpolator of kTaps * oversampling taps, stored
+        // tap-major with one phase per lane so a single broadcast-multiply
+        // yields all interpolated points between two input samples.
+        std::array<std::array<float, 4>, kTaps> taps{};
+        int32_t length = kTaps * oversampling;
+        double center = (length - 1) / 2.0;
+        for (int32_t phase = 0; phase < oversampling; phase++) {
+            double sum = 0;
+            std::array<double, kTaps> h{};
+            for (int32_t t = 0; t < kTaps; t++) {
+                int32_t m = phase + t * oversampling;
+                double x = (m - center) / oversampling;
+                double sinc = x == 0 ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+                double window = 0.42 - 0.5 * std::cos(2 * M_PI * (m + 0.5) / length) +
+                                0.08 * std::cos(4 * M_PI * (m + 0.5) / length);
+                h[t] = sinc * window;
+                sum += h[t];
+            }
+            for (int32_t t = 0; t < kTaps; t++) {
+                taps[t][phase] = (float) (h[t] / sum);
+            }
+        }
+        for (int32_t t = 0; t < kTaps; t++) {
+            peakCoefficients[t] = Simd::load(taps[t].data());
+        }
+    }
+
+    void LoudnessMeter::process(const float *samples, int32_t frames) {
+        const int32_t stride = kHistory + kChunkFrames;
+        while (frames > 0) {
+            int32_t count = std::min(frames, kChunkFrames);
+            count = std::min(count, subBlockFrames - subBlockFill);
+
+            for (int32_t c = 0; c < channelCount; c++) {
+                float *channel = buffer.data() + (size_t) c * stride;
+                float *in = channel + kHistory;
+                float *lane = lanes.data() + (size_t) (c / 4) * kChunkFrames * 4 + c % 4;
+                const float *src = samples + c;
+                for (int32_t i = 0; i < count; i++) {
+                    in[i] = src[(size_t) i * channelCount];
+                    lane[(size_t) i * 4] = in[i];
+                }
+
+                scanPeak(states[c], channel, count);
+                std::memmove(channel, in + count - kHistory, kHistory * sizeof(float));
+            }
+            for (size_t g = 0; g < laneStates.size(); g++) {
+                subBlockEnergy += filter(laneStates[g], lanes.data() + g * kChunkFrames * 4,
+                                         count);
+            }
+
+            samples += (size_t) count * channelCount;
+            frames -= count;
+            subBlockFill += count;
+            if (subBlockFill == subBlockFrames) {
+                finishSubBlock();
+            }
+        }
+    }
+
+    double LoudnessMeter::filter(LaneState &state, const float *in, int32_t count) const {
+        const LaneBiquad s = shelf;
+        const LaneBiquad h = highPass;
+        Simd::float4 s1 = state.s1, s2 = state.s2, t1 = state.t1, t2 = state.t2;
+        Simd::float4 sum = Simd::zero();
+        for (int32_t i = 0; i < count; i++) {
+            Simd::float4 x = Simd::load(in + (size_t) i * 4);
+            Simd::float4 y = Simd::madd(s.b0, x, s1);
+            s1 = Simd::sub(Simd::madd(s.b1, x, s2), Simd::mul(s.a1, y));
+            s2 = Simd::sub(Simd::mul(s.b2, x), Simd::mul(s.a2, y));
+
+            Simd::float4 z = Simd::add(y, t1);
+            t1 = Simd::sub(Simd::sub(t2, Simd::add(y, y)), Simd::mul(h.a1, z));
+            t2 = Simd::sub(y, Simd::mul(h.a2, z));
+            sum = Simd::madd(z, z, sum);
+        }
+        state.s1 = flushDecayed(s1);
+        state.s2 = flushDecayed(s2);
+        state.t1 = flushDecayed(t1);
+        state.t2 = flushDecayed(t2);
+        return Simd::hadd(Simd::mul(sum, state.weights));
+    }
+
+    void LoudnessMeter::scanPeak(ChannelState &state, const float *in, int32_t count) const {
+        // in points at the history, samples start at in + kHistory
+        Simd::float4 peak = Simd::zero();
+        if (oversampling == 1) {
+            const float *x = in + kHistory;
+            int32_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                peak = Simd::max(peak, Simd::abs(Simd::load(x + i)));
+            }
+            float tail = Simd::hmax(peak);
+            for (; i < count; i++) {
+                tail = std::max(tail, std::fabs(x[i]));
+            }
+            state.peak = std::max(state.peak, tail);
+            return;
+        }
+
+        for (int32_t i = 0; i < count; i++) {
+            const float *x = in + kHistory + i;
+            Simd::float4 acc = Simd::zero();
+            for (int32_t t = 0; t < kTaps; t++) {
+                acc = Simd::madd(peakCoefficients[t], Simd::set1(x[-t]), acc);
+            }
+            peak = Simd::max(peak, Simd::abs(acc));
+        }
+        state.peak = std::max(state.peak, Simd::hmax(peak));
+    }
+
+    void LoudnessMeter::finishSubBlock() {
+        subBlocks[subBlockCount % 4] = subBlockEnergy / subBlockFrames;
+        subBlockCount++;
+        subBlockEnergy = 0;
+        subBlockFill = 0;
+        if (subBlockCount < 4) {
+            return;
+        }
+        double blockEnergy = (subBlocks[0] + subBlocks[1] + subBlocks[2] + subBlocks[3]) / 4.0;
+        gatedBlocks.add(blockEnergy);
+    }
+
+    double LoudnessMeter::integratedLoudness() const {
+        return gatedBlocks.integratedLoudness();
+    }
+
+    float LoudnessMeter::truePeak() const {
+        float peak = 0.0f;
+        for (const ChannelState &state: states) {
+            peak = std::max(peak, state.peak);
+        }
+        return peak;
+    }
+
+    const LoudnessHistogram &LoudnessMeter::histogram() const {
+        return gatedBlocks;
+    }
+
+    int32_t LoudnessMeter::channels() const {
+        return channelCount;
+    }
+
+    int32_t LoudnessMeter::sampleRate() const {
+        return rate;
+    }
+
+    void AlbumLoudness::add(const LoudnessMeter &meter) {
+        std::lock_guard<std::mutex> guard(lock);
+        histogram.merge(meter.histogram());
+        peak = std::max(peak, meter.truePeak());
+    }
+
+    double AlbumLoudness::integratedLoudness() {
+        std::lock_guard<std::mutex> guard(lock);
+        return histogram.integratedLoudness();
+    }
+
+    float AlbumLoudness::truePeak() {
+        std::lock_guard<std::mutex> guard(lock);
+        return peak;
+    }
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOUNDSOURCE_LOUDNESS_H
+#define SOUNDSOURCE_LOUDNESS_H
+
+#include <sys/types.h>
+#include <array>
+#include <mutex>
+#include <vector>
+
+#include "simd.h"
+
+namespace SoundSource::Audio {
+    /**
+     * Loudness that all blocks were gated out, or nothing was measured.
+     */
+    constexpr double LOUDNESS_SILENCE = -HUGE_VAL;
+
+    /**
+     * ReplayGain 2.0 reference loudness in LUFS.
+     */
+    constexpr double REPLAY_GAIN_REFERENCE = -18.0;
+
+    /**
+     * Histogram of the 400 ms gating block energies that passed the
+     * absolute gate (-70 LUFS), in 0.1 LU bins.
+     *
+     * The histogram keeps the exact energy sum of every bin, so merging
+     * the histograms of several tracks yields the album loudness without
+     * keeping the blocks around.
+     */
+    class LoudnessHistogram {
+    public:
+        void add(double blockEnergy);
+
+        void merge(const LoudnessHistogram &other);
+
+        /**
+         * @return the gated integrated loudness in LUFS, or
+         * LOUDNESS_SILENCE if there is no block above the absolute gate.
+         */
+        double integratedLoudness() const;
+
+        bool isEmpty() const;
+
+    private:
+        static constexpr int32_t kBins = 1000;
+
+        std::array<uint32_t, kBins> counts{};
+        std::array<double, kBins> energies{};
+        uint64_t total = 0;
+    };
+
+    /**
+     * ITU-R BS.1770-4 / EBU R128 loudness meter.
+     *
+     * Feeds interleaved float PCM through the K-weighting filter, gates
+     * the 400 ms blocks (75% overlap) and tracks the true peak with a
+     * polyphase oversampling filter.
+     *
+     * The K-weighting filters up to four channels at once, one per lane.
+     */
+    class LoudnessMeter {
+    public:
+        LoudnessMeter(int32_t channels, int32_t sampleRate);
+
+        /**
+         * Process interleaved float samples in range [-1, 1].
+         */
+        void process(const float *samples, int32_t frames);
+
+        /**
+         * @return integrated loudness in LUFS.
+         */
+        double integratedLoudness() const;
+
+        /**
+         * @return true peak as linear amplitude, 1.0 means 0 dBTP.
+         */
+        float truePeak() const;
+
+        const LoudnessHistogram &histogram() const;
+
+        int32_t channels() const;
+
+        int32_t sampleRate() const;
+
+    private:
+        static constexpr int32_t kTaps = 12;
+        static constexpr int32_t kHistory = kTaps - 1;
+        static constexpr int32_t kChunkFrames = 1024;
+
+        struct Biquad {
+            double b0, b1, b2, a1, a2;
+        };
+
+        /**
+         * The coefficients of a Biquad in every lane. The high pass
+         * numerator is 1, -2, 1 and left out.
+         */
+        struct LaneBiquad {
+            Simd::float4 b0, b1, b2, a1, a2;
+        };
+
+        struct ChannelState {
+            float weight = 1.0f;
+            float peak = 0.0f;
+        };
+
+        /**
+         * The K-weighting of four channels, one per lane, the lanes past
+         * the last channel stay silent.
+         */
+        struct LaneState {
+            Simd::float4 s1, s2, t1, t2;
+            Simd::float4 weights;
+        };
+
+        int32_t channelCount;
+        int32_t rate;
+        int32_t oversampling;
+
+        LaneBiquad shelf{};
+        LaneBiquad highPass{};
+        Simd::float4 peakCoefficients[kTaps]{};
+
+        std::vector<ChannelState> states;
+        std::vector<LaneState> laneStates;
+        // per channel: kHistory samples followed by kChunkFrames samples
+        std::vector<float> buffer;
+        // per four channels: kChunkFrames frames of four lanes
+        std::vector<float> lanes;
+
+        int32_t subBlockFrames;
+        int32_t subBlockFill = 0;
+        double subBlockEnergy = 0;
+        std::array<double, 4> subBlocks{};
+        int64_t subBlockCount = 0;
+
+        LoudnessHistogram gatedBlocks;
+
+        void initFilters();
+
+        /**
+         * @return the K-weighted energy of the lanes, summed over the
+         * frames and weighted by channel.
+         */
+        double filter(LaneState &state, const float *in, int32_t count) const;
+
+        void scanPeak(ChannelState &state, const float *in, int32_t count) const;
+
+        void finishSubBlock();
+    };
+
+    /**
+     * Accumulates the loudness of the tracks of one album. Thread-safe,
+     * tracks may be added from any scan thread.
+     */
+    class AlbumLoudness {
+    public:
+        void add(const LoudnessMeter &meter);
+
+        double integratedLoudness();
+
+        float truePeak();
+
+    private:
+        std::mutex lock;
+        LoudnessHistogram histogram;
+        float peak = 0.0f;
+    };
+}
+
+#endif //SOUNDSOURCE_LOUDNESS_H
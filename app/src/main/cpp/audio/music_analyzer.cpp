@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "music_analyzer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace SoundSource::Audio {
+    namespace {
+        constexpr double kSlowestTempo = 60.0;
+        constexpr double kFastestTempo = 200.0;
+        // centre and width in octaves of the tempo prior
+        constexpr double kPreferredTempo = 120.0;
+        constexpr double kTempoSpread = 1.0;
+        constexpr float kCompression = 100.0f;
+        constexpr double kMinTempoSeconds = 5.0;
+        // seconds around each onset to take the local mean of
+        constexpr double kMeanSeconds = 0.25;
+
+        constexpr double kLowestKeyPitch = 55.0;
+        constexpr double kHighestKeyPitch = 1760.0;
+        constexpr double kSilence = 1e-6;
+
+        // C major and C minor, Krumhansl & Kessler (1982)
+        constexpr std::array<double, 12> kMajorProfile{
+                6.35, 2.23, 3.48, 2.33, 4.38, 4.09, 2.52, 5.19, 2.39, 3.66, 2.29, 2.88};
+        constexpr std::array<double, 12> kMinorProfile{
+                6.33, 2.68, 3.52, 5.38, 2.60, 3.53, 2.54, 4.75, 3.98, 2.69, 3.34, 3.17};
+
+        std::vector<float> hannWindow(int32_t size) {
+            std::vector<float> window((size_t) size);
+            for (int32_t i = 0; i < size; i++) {
+                window[i] = (float) (0.5 - 0.5 * std::cos(2 * M_PI * i / size));
+            }
+            return window;
+        }
+
+        inline void applyWindow(const float *in, const float *window, float *out, int32_t n) {
+            for (int32_t i = 0; i < n; i += 4) {
+                Simd::store(out + i, Simd::mul(Simd::load(in + i), Simd::load(window + i)));
+            }
+        }
+
+        inline float dot(const float *a, const float *b, int32_t n) {
+            Simd::float4 acc0 = Simd::zero();
+            Simd::float4 acc1 = Simd::zero();
+            int32_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                acc0 = Simd::madd(Simd::load(a + i), Simd::load(b + i), acc0);
+                acc1 = Simd::madd(Simd::load(a + i + 4), Simd::load(b + i + 4), acc1);
+            }
+            float sum = Simd::hadd(Simd::add(acc0, acc1));
+            for (; i < n; i++) {
+                sum += a[i] * b[i];
+            }
+            return sum;
+        }
+
+        /**
+         * Slide a frame over the stream, calling analyze() on every
+         * full frame.
+         */
+        template<typename Analyze>
+        void pushFrames(std::vector<float> &history, int32_t &historySize,
+                        int32_t frameSize, int32_t hop,
+                        const float *samples, int32_t count, Analyze &&analyze) {
+            while (count > 0) {
+                int32_t n = std::min(count, frameSize - historySize);
+                std::memcpy(history.data() + historySize, samples, (size_t) n * sizeof(float));
+                historySize += n;
+                samples += n;
+                count -= n;
+                if (historySize == frameSize) {
+                    analyze();
+                    std::memmove(history.data(), history.data() + hop,
+                                 (size_t) (frameSize - hop) * sizeof(float));
+                    historySize = frameSize - hop;
+                }
+            }
+        }
+
+        double correlation(const std::array<double, 12> &chroma,
+                           const std::array<double, 12> &profile, int32_t tonic) {
+            double meanChroma = 0, meanProfile = 0;
+            for (int32_t i = 0; i < 12; i++) {
+                meanChroma += chroma[i];
+                meanProfile += profile[i];
+            }
+            meanChroma /= 12;
+            meanProfile /= 12;
+            double xy = 0, xx = 0, yy = 0;
+            for (int32_t i = 0; i < 12; i++) {
+                double x = chroma[(i + tonic) % 12] - meanChroma;
+                double y = profile[i] - meanProfile;
+                xy += x * y;
+                xx += x * x;
+                yy += y * y;
+            }
+            if (xx <= 0 || yy <= 0) {
+                return 0;
+            }
+            return xy / std::sqrt(xx * yy);
+        }
+    }
+
+    TempoEstimator::TempoEstimator(int32_t sampleRate) : fft(kFrameSize) {
+        framesPerSecond = (double) std::max(sampleRate, 1) / kHop;
+        window = hannWindow(kFrameSize);
+        history.resize(kFrameSize);
+        frame.resize(kFrameSize);
+        re.resize(kFrameSize / 2 + 1);
+        im.resize(kFrameSize / 2 + 1);
+        // padded to whole vectors, the padding stays zero
+        const size_t bins = (kFrameSize / 2 + 1 + 3) & ~3;
+        spectrum.resize(bins);
+        previousSpectrum.resize(bins);
+    }
+
+    void TempoEstimator::process(const float *samples, int32_t count) {
+        pushFrames(history, historySize, kFrameSize, kHop, samples, count,
+                   [this] { analyze(); });
+    }
+
+    void TempoEstimator::analyze() {
+        applyWindow(history.data(), window.data(), frame.data(), kFrameSize);
+        fft.forward(frame.data(), re.data(), im.data());
+        for (int32_t k = 0; k <= kFrameSize / 2; k++) {
+            spectrum[k] = std::log1p(kCompression * std::sqrt(re[k] * re[k] + im[k] * im[k]));
+        }
+
+        const auto bins = (int32_t) spectrum.size();
+        Simd::float4 flux = Simd::zero();
+        for (int32_t k = 0; k < bins; k += 4) {
+            Simd::float4 rise = Simd::sub(Simd::load(&spectrum[k]),
+                                          Simd::load(&previousSpectrum[k]));
+            flux = Simd::add(flux, Simd::max(rise, Simd::zero()));
+        }
+        // the first frame rises from silence
+        onsets.push_back(onsets.empty() ? 0.0f : Simd::hadd(flux));
+        spectrum.swap(previousSpectrum);
+    }
+
+    double TempoEstimator::estimate(float *confidence) const {
+        if (confidence != nullptr) {
+            *confidence = 0;
+        }
+        const auto minLag = (int32_t) std::floor(framesPerSecond * 60 / kFastestTempo);
+        const auto maxLag = (int32_t) std::ceil(framesPerSecond * 60 / kSlowestTempo);
+        const auto n = (int32_t) onsets.size();
+        if (n < std::max(4 * maxLag, (int32_t) (kMinTempoSeconds * framesPerSecond))) {
+            return 0;
+        }
+
+        // keep the onsets that stand out of their neighbourhood
+        const auto radius = (int32_t) std::lround(kMeanSeconds * framesPerSecond / 2);
+        std::vector<double> prefix((size_t) n + 1);
+        for (int32_t i = 0; i < n; i++) {
+            prefix[i + 1] = prefix[i] + onsets[i];
+        }
+        std::vector<float> envelope((size_t) n);
+        for (int32_t i = 0; i < n; i++) {
+            int32_t from = std::max(0, i - radius);
+            int32_t to = std::min(n, i + radius + 1);
+            double mean = (prefix[to] - prefix[from]) / (to - from);
+            envelope[i] = std::max(0.0f, (float) (onsets[i] - mean));
+        }
+
+        // every lag is normalized by its overlap
+        const int32_t lags = 2 * maxLag + 2;
+        std::vector<double> autocorrelation((size_t) lags);
+        for (int32_t lag = 0; lag < lags; lag++) {
+            autocorrelation[lag] = dot(envelope.data(), envelope.data() + lag, n - lag) /
+                                   (double) (n - lag);
+        }
+        if (autocorrelation[0] <= 0) {
+            return 0;
+        }
+
+        std::vector<double> scores((size_t) maxLag + 2);
+        int32_t best = -1;
+        for (int32_t lag = minLag - 1; lag <= maxLag + 1; lag++) {
+            double tempo = framesPerSecond * 60 / lag;
+            double octaves = std::log2(tempo / kPreferredTempo) / kTempoSpread;
+            double prior = std::exp(-0.5 * octaves * octaves);
+            // the bar reinforces the beat, and a beat that splits in two
+            // wins over three off-beat onsets in a row
+            double half = 0.5 * (autocorrelation[lag / 2] + autocorrelation[(lag + 1) / 2]);
+            scores[lag] = prior * (autocorrelation[lag] + 0.5 * autocorrelation[2 * lag] +
+                                   0.5 * half);
+            if (lag >= minLag && lag <= maxLag && (best < 0 || scores[lag] > scores[best])) {
+                best = lag;
+            }
+        }
+
+        double lag = best;
+        double previous = scores[best - 1], current = scores[best], next = scores[best + 1];
+        double curvature = previous - 2 * current + next;
+        if (curvature < 0) {
+            lag += std::clamp(0.5 * (previous - next) / curvature, -0.5, 0.5);
+        }
+        if (confidence != nullptr) {
+            *confidence = (float) std::clamp(autocorrelation[best] / autocorrelation[0],
+                                             0.0, 1.0);
+        }
+        return framesPerSecond * 60 / lag;
+    }
+
+    KeyEstimator::KeyEstimator(int32_t sampleRate) : fft(kFrameSize) {
+        window = hannWindow(kFrameSize);
+        pitchClasses.resize(kFrameSize / 2 + 1);
+        for (int32_t k = 0; k <= kFrameSize / 2; k++) {
+            double frequency = (double) k * sampleRate / kFrameSize;
+            if (frequency < kLowestKeyPitch || frequency > kHighestKeyPitch) {
+                pitchClasses[k] = -1;
+                continue;
+            }
+            auto note = (int32_t) std::lround(12 * std::log2(frequency / 440.0) + 69);
+            pitchClasses[k] = (int8_t) (note % 12);
+        }
+        history.resize(kFrameSize);
+        frame.resize(kFrameSize);
+        re.resize(kFrameSize / 2 + 1);
+        im.resize(kFrameSize / 2 + 1);
+    }
+
+    void KeyEstimator::process(const float *samples, int32_t count) {
+        pushFrames(history, historySize, kFrameSize, kHop, samples, count,
+                   [this] { analyze(); });
+    }
+
+    void KeyEstimator::analyze() {
+        applyWindow(history.data(), window.data(), frame.data(), kFrameSize);
+        fft.forward(frame.data(), re.data(), im.data());
+        // magnitudes rather than power, so a few loud partials do not
+        // outweigh the harmony
+        for (int32_t k = 0; k <= kFrameSize / 2; k++) {
+            int8_t pitchClass = pitchClasses[k];
+            if (pitchClass >= 0) {
+                chroma[pitchClass] += std::sqrt(re[k] * re[k] + im[k] * im[k]);
+            }
+        }
+    }
+
+    int32_t KeyEstimator::estimate(float *confidence) const {
+        if (confidence != nullptr) {
+            *confidence = 0;
+        }
+        double total = 0;
+        for (double v: chroma) {
+            total += v;
+        }
+        if (total < kSilence) {
+            return MUSIC_KEY_UNKNOWN;
+        }
+        int32_t key = MUSIC_KEY_UNKNOWN;
+        double best = 0;
+        for (int32_t tonic = 0; tonic < 12; tonic++) {
+            double major = correlation(chroma, kMajorProfile, tonic);
+            double minor = correlation(chroma, kMinorProfile, tonic);
+            if (major > best) {
+                best = major;
+                key = tonic;
+            }
+            if (minor > best) {
+                best = minor;
+                key = 12 + tonic;
+            }
+        }
+        if (confidence != nullptr) {
+            *confidence = (float) best;
+        }
+        return key;
+    }
+
+    MusicAnalyzer::MusicAnalyzer(int32_t channels, int32_t sampleRate, int32_t maxSeconds)
+            : resampler(channels, sampleRate, kRate),
+              tempoEstimator(kRate),
+              keyEstimator(kRate) {
+        remaining = (int64_t) std::max(maxSeconds, 0) * std::max(sampleRate, 0);
+        if (!resampler.isValid()) {
+            remaining = 0;
+        }
+    }
+
+    bool MusicAnalyzer::process(const float *samples, int32_t frames) {
+        auto count = (int32_t) std::min<int64_t>(frames, remaining);
+        if (count <= 0) {
+            return false;
+        }
+        resampler.process(samples, count, [this](const float *mono, int32_t n) {
+            tempoEstimator.process(mono, n);
+            keyEstimator.process(mono, n);
+        });
+        remaining -= count;
+        return remaining > 0;
+    }
+
+    const TempoEstimator &MusicAnalyzer::tempo() const {
+        return tempoEstimator;
+    }
+
+    const KeyEstimator &MusicAnalyzer::key() const {
+        return keyEstimator;
+    }
+}
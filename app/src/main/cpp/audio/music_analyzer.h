@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_MUSIC_ANALYZER_H
+#define SOUNDSOURCE_MUSIC_ANALYZER_H
+
+#include <sys/types.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "fft.h"
+#include "resampler.h"
+
+namespace SoundSource::Audio {
+    constexpr int32_t MUSIC_KEY_UNKNOWN = -1;
+
+    /**
+     * Estimates the tempo from the periodicity of note onsets.
+     *
+     * Onsets are the positive spectral flux of log compressed 1024 point
+     * spectra every 128 samples, the tempo is the autocorrelation peak of
+     * the onset envelope in 60 - 200 BPM, weighted towards 120 BPM to
+     * settle octave errors.
+     */
+    class TempoEstimator {
+    public:
+        explicit TempoEstimator(int32_t sampleRate);
+
+        /**
+         * Process mono samples.
+         */
+        void process(const float *samples, int32_t count);
+
+        /**
+         * @param confidence receives the normalized autocorrelation at
+         * the tempo, 0 - 1.
+         * @return the tempo in BPM, or 0 if there is not enough audio.
+         */
+        double estimate(float *confidence = nullptr) const;
+
+    private:
+        static constexpr int32_t kFrameSize = 1024;
+        static constexpr int32_t kHop = 128;
+
+        double framesPerSecond;
+        RealFft fft;
+        std::vector<float> window;
+        std::vector<float> history;
+        int32_t historySize = 0;
+        std::vector<float> frame, re, im;
+        std::vector<float> spectrum, previousSpectrum;
+        std::vector<float> onsets;
+
+        void analyze();
+    };
+
+    /**
+     * Estimates the key by correlating the chroma of the whole audio
+     * with the Krumhansl-Kessler major and minor key profiles.
+     */
+    class KeyEstimator {
+    public:
+        explicit KeyEstimator(int32_t sampleRate);
+
+        /**
+         * Process mono samples.
+         */
+        void process(const float *samples, int32_t count);
+
+        /**
+         * @param confidence receives the correlation with the key
+         * profile, -1 - 1.
+         * @return 0 - 11 for C - B major, 12 - 23 for C - B minor, or
+         * MUSIC_KEY_UNKNOWN if there is no tonal content.
+         */
+        int32_t estimate(float *confidence = nullptr) const;
+
+    private:
+        static constexpr int32_t kFrameSize = 4096;
+        static constexpr int32_t kHop = kFrameSize / 2;
+
+        RealFft fft;
+        std::vector<float> window;
+        // pitch class of every bin, -1 outside the analysed range
+        std::vector<int8_t> pitchClasses;
+        std::vector<float> history;
+        int32_t historySize = 0;
+        std::vector<float> frame, re, im;
+        std::array<double, 12> chroma{};
+
+        void analyze();
+    };
+
+    /**
+     * Tempo and key analysis of interleaved audio.
+     *
+     * The audio is downmixed and resampled to 11025 Hz, which keeps the
+     * fundamentals and the attack of most instruments at a quarter of
+     * the work of the source rate.
+     */
+    class MusicAnalyzer {
+    public:
+        MusicAnalyzer(int32_t channels, int32_t sampleRate, int32_t maxSeconds);
+
+        /**
+         * Process interleaved float samples.
+         *
+         * @return false once maxSeconds of audio were processed, further
+         * samples are ignored.
+         */
+        bool process(const float *samples, int32_t frames);
+
+        const TempoEstimator &tempo() const;
+
+        const KeyEstimator &key() const;
+
+    private:
+        static constexpr int32_t kRate = 11025;
+
+        int64_t remaining;
+        MonoResampler resampler;
+        TempoEstimator tempoEstimator;
+        KeyEstimator keyEstimator;
+    };
+}
+
+#endif //SOUNDSOURCE_MUSIC_ANALYZER_H
@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "oboe_output.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+
+#include "logging.h"
+#include "simd.h"
+
+namespace SoundSource::Audio {
+    namespace {
+        inline int64_t monotonicNanos() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        inline int32_t histogramBucket(int64_t micros) {
+            int32_t bucket = 0;
+            while (micros > 0 && bucket < OUTPUT_HISTOGRAM_BUCKETS - 1) {
+                micros >>= 1;
+                bucket++;
+            }
+            return bucket;
+        }
+    }
+
+    OboeOutput::OboeOutput(int32_t channels, int32_t sampleRate, bool floatEncoding,
+                           bool lowLatency)
+            : channelCount(std::max(channels, 1)),
+              rate(sampleRate),
+              floatSamples(floatEncoding),
+              lowLatencyMode(lowLatency),
+              bytesPerFrame(std::max(channels, 1) *
+                            (floatEncoding ? (int32_t) sizeof(float) : (int32_t) sizeof(int16_t))),
+              ring(kRingFrames, bytesPerFrame) {
+        std::lock_guard<std::mutex> guard(lock);
+        openStream();
+    }
+
+    OboeOutput::~OboeOutput() {
+        std::lock_guard<std::mutex> guard(lock);
+        if (stream != nullptr) {
+            stream->stop();
+            stream->close();
+        }
+    }
+
+    bool OboeOutput::openStream() {
+        oboe::AudioStreamBuilder builder;
+        builder.setDirection(oboe::Direction::Output)
+                ->setPerformanceMode(lowLatencyMode
+                                     ? oboe::PerformanceMode::LowLatency
+                                     : oboe::PerformanceMode::None)
+                ->setSharingMode(oboe::SharingMode::Shared)
+                ->setFormat(floatSamples ? oboe::AudioFormat::Float : oboe::AudioFormat::I16)
+                ->setFormatConversionAllowed(true)
+                ->setChannelCount(channelCount)
+                ->setChannelConversionAllowed(true)
+                ->setSampleRate(rate)
+                // the audio is resampled to the device rate before, this
+                // only covers a device change
+                ->setSampleRateConversionQuality(oboe::SampleRateConversionQuality::Medium)
+                ->setUsage(oboe::Usage::Media)
+                ->setContentType(oboe::ContentType::Music)
+                ->setDataCallback(this)
+                ->setErrorCallback(this);
+        closedXRuns += xRuns.exchange(0, std::memory_order_relaxed);
+        oboe::Result result = builder.openStream(stream);
+        if (result != oboe::Result::OK) {
+            LOGE("OboeOutput: cannot open stream, %s", oboe::convertToText(result));
+            stream = nullptr;
+            return false;
+        }
+        const int32_t burst = stream->getFramesPerBurst();
+        controller = std::make_unique<BufferSizeController>(
+                burst, stream->getBufferCapacityInFrames(),
+                stream->getBufferSizeInFrames(), kStablePeriodNanos);
+        auto applied = stream->setBufferSizeInFrames(controller->bufferSize());
+        bufferSize.store(applied ? applied.value() : stream->getBufferSizeInFrames(),
+                         std::memory_order_relaxed);
+        LOGD("OboeOutput: opened stream, %s, burst %d, buffer %d/%d",
+             oboe::convertToText(stream->getAudioApi()), burst,
+             bufferSize.load(std::memory_order_relaxed), stream->getBufferCapacityInFrames());
+        return true;
+    }
+
+    bool OboeOutput::isValid() const {
+        return stream != nullptr;
+    }
+
+    int32_t OboeOutput::write(const void *data, int32_t frames) {
+        int32_t written = ring.write(data, frames);
+        framesWritten.fetch_add(written, std::memory_order_relaxed);
+        return written;
+    }
+
+    bool OboeOutput::start() {
+        std::lock_guard<std::mutex> guard(lock);
+        playing = true;
+        if (stream == nullptr) {
+            return false;
+        }
+        return stream->requestStart() == oboe::Result::OK;
+    }
+
+    bool OboeOutput::pause() {
+        std::lock_guard<std::mutex> guard(lock);
+        playing = false;
+        if (stream == nullptr) {
+            return false;
+        }
+        return stream->requestPause() == oboe::Result::OK;
+    }
+
+    void OboeOutput::setVolume(float volume) {
+        gain.store(std::clamp(volume, 0.0f, 1.0f), std::memory_order_relaxed);
+    }
+
+    void OboeOutput::flush() {
+        std::lock_guard<std::mutex> guard(lock);
+        ring.discard();
+        lastPlayedFrames = 0;
+        if (stream != nullptr && !playing) {
+            // frames already in the device, only possible when paused
+            stream->requestFlush();
+        }
+    }
+
+    int32_t OboeOutput::queuedFrames() const {
+        return ring.readable();
+    }
+
+    int64_t OboeOutput::playedFrames() {
+        std::lock_guard<std::mutex> guard(lock);
+        if (stream == nullptr || !playing) {
+            return lastPlayedFrames;
+        }
+        int64_t read = ring.readSinceDiscard();
+        int64_t latency = bufferSize.load(std::memory_order_relaxed);
+        auto timestamp = stream->getTimestamp(CLOCK_MONOTONIC);
+        if (timestamp) {
+            int64_t elapsed = monotonicNanos() - timestamp.value().timestamp;
+            int64_t presented = timestamp.value().position +
+                                elapsed * stream->getSampleRate() / 1'000'000'000LL;
+            latency = std::clamp<int64_t>(stream->getFramesWritten() - presented, 0,
+                                          stream->getBufferCapacityInFrames());
+        }
+        latency = std::max<int64_t>(0, latency - trailingSilence.load(std::memory_order_relaxed));
+        // never goes back, the timestamp jitters by a few frames
+        lastPlayedFrames = std::max(lastPlayedFrames, read - latency);
+        return lastPlayedFrames;
+    }
+
+    OutputStats OboeOutput::stats() {
+        OutputStats stats{};
+        stats.framesWritten = framesWritten.load(std::memory_order_relaxed);
+        stats.framesPlayed = playedFrames();
+        stats.starvedCount = starved.load(std::memory_order_relaxed);
+        stats.bufferSizeFrames = bufferSize.load(std::memory_order_relaxed);
+        for (int32_t i = 0; i < OUTPUT_HISTOGRAM_BUCKETS; i++) {
+            stats.callbackHistogram[i] = histogram[i].load(std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        stats.xRunCount = closedXRuns + xRuns.load(std::memory_order_relaxed);
+        if (stream != nullptr) {
+            stats.bufferCapacityFrames = stream->getBufferCapacityInFrames();
+            stats.framesPerBurst = stream->getFramesPerBurst();
+            stats.sampleRate = stream->getSampleRate();
+            auto latency = stream->calculateLatencyMillis();
+            stats.latencyMillis = latency ? latency.value() : 0;
+        }
+        return stats;
+    }
+
+    oboe::DataCallbackResult OboeOutput::onAudioReady(oboe::AudioStream *audioStream,
+                                                      void *audioData, int32_t numFrames) {
+        const int64_t start = monotonicNanos();
+        int32_t read = ring.read(audioData, numFrames);
+        if (read < numFrames) {
+            std::memset((uint8_t *) audioData + (size_t) read * bytesPerFrame, 0,
+                        (size_t) (numFrames - read) * bytesPerFrame);
+            // count the start of a gap, not every silent callback of a pause
+            if (lastCallbackFull) {
+                starved.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        lastCallbackFull = read == numFrames;
+        if (read > 0) {
+            trailingSilence.store(numFrames - read, std::memory_order_relaxed);
+        } else {
+            trailingSilence.fetch_add(numFrames, std::memory_order_relaxed);
+        }
+
+        const float volume = gain.load(std::memory_order_relaxed);
+        if (volume != 1.0f) {
+            const int32_t samples = read * channelCount;
+            if (floatSamples) {
+                Simd::float4 v = Simd::set1(volume);
+                auto *out = (float *) audioData;
+                int32_t i = 0;
+                for (; i + 4 <= samples; i += 4) {
+                    Simd::store(out + i, Simd::mul(Simd::load(out + i), v));
+                }
+                for (; i < samples; i++) {
+                    out[i] *= volume;
+                }
+            } else {
+                auto *out = (int16_t *) audioData;
+                for (int32_t i = 0; i < samples; i++) {
+                    out[i] = (int16_t) std::lrintf(out[i] * volume);
+                }
+            }
+        }
+
+        auto xRunCount = audioStream->getXRunCount();
+        if (xRunCount) {
+            xRuns.store(xRunCount.value(), std::memory_order_relaxed);
+            int32_t size = controller->update(xRunCount.value(), start);
+            if (size != bufferSize.load(std::memory_order_relaxed)) {
+                auto applied = audioStream->setBufferSizeInFrames(size);
+                if (applied) {
+                    bufferSize.store(applied.value(), std::memory_order_relaxed);
+                }
+            }
+        }
+
+        int64_t micros = (monotonicNanos() - start) / 1000;
+        histogram[histogramBucket(micros)].fetch_add(1, std::memory_order_relaxed);
+        return oboe::DataCallbackResult::Continue;
+    }
+
+    void OboeOutput::onErrorAfterClose(oboe::AudioStream *audioStream, oboe::Result error) {
+        if (error != oboe::Result::ErrorDisconnected) {
+            LOGE("OboeOutput: stream closed, %s", oboe::convertToText(error));
+            return;
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        if (!openStream()) {
+            return;
+        }
+        if (playing) {
+            stream->requestStart();
+        }
+    }
+}
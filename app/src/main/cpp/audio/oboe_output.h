@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_OBOE_OUTPUT_H
+#define SOUNDSOURCE_OBOE_OUTPUT_H
+
+#include <sys/types.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include <oboe/Oboe.h>
+
+#include "buffer_controller.h"
+#include "ring_buffer.h"
+
+namespace SoundSource::Audio {
+    /**
+     * Buckets of the callback duration histogram, bucket i counts
+     * callbacks of [2^(i-1), 2^i) microseconds, the last one everything
+     * longer.
+     */
+    constexpr int32_t OUTPUT_HISTOGRAM_BUCKETS = 16;
+
+    struct OutputStats {
+        int64_t framesWritten;
+        int64_t framesPlayed;
+        int32_t xRunCount;
+        // callbacks that found less than a burst in the ring
+        int32_t starvedCount;
+        int32_t bufferSizeFrames;
+        int32_t bufferCapacityFrames;
+        int32_t framesPerBurst;
+        int32_t sampleRate;
+        double latencyMillis;
+        std::array<int32_t, OUTPUT_HISTOGRAM_BUCKETS> callbackHistogram;
+    };
+
+    /**
+     * PCM output through an Oboe stream.
+     *
+     * The writer queues interleaved frames into a ring buffer without
+     * blocking, the stream callback drains it and tunes the buffer size
+     * of the stream with a BufferSizeController. A disconnected stream,
+     * such as after unplugging headphones, is reopened on the new
+     * default device.
+     */
+    class OboeOutput : public oboe::AudioStreamDataCallback,
+                       public oboe::AudioStreamErrorCallback {
+    public:
+        /**
+         * @param lowLatency open a low latency stream with small bursts,
+         * instead of the larger buffers of a regular stream.
+         */
+        OboeOutput(int32_t channels, int32_t sampleRate, bool floatEncoding,
+                   bool lowLatency);
+
+        ~OboeOutput() override;
+
+        /**
+         * @return false if the stream cannot be opened.
+         */
+        bool isValid() const;
+
+        /**
+         * Queue interleaved frames, never blocks.
+         *
+         * @return the frames queued, less than frames if the ring is full.
+         */
+        int32_t write(const void *data, int32_t frames);
+
+        bool start();
+
+        bool pause();
+
+        /**
+         * Set the linear gain applied to the output.
+         */
+        void setVolume(float volume);
+
+        /**
+         * Drop the queued frames and restart the played frame count.
+         */
+        void flush();
+
+        /**
+         * @return frames queued and not yet read by the stream.
+         */
+        int32_t queuedFrames() const;
+
+        /**
+         * @return frames played since the last flush, estimated from the
+         * presentation timestamp of the stream.
+         */
+        int64_t playedFrames();
+
+        OutputStats stats();
+
+        oboe::DataCallbackResult onAudioReady(oboe::AudioStream *stream, void *audioData,
+                                              int32_t numFrames) override;
+
+        void onErrorAfterClose(oboe::AudioStream *stream, oboe::Result error) override;
+
+    private:
+        // about 340 ms at 48 kHz
+        static constexpr int32_t kRingFrames = 16384;
+        static constexpr int64_t kStablePeriodNanos = 10'000'000'000LL;
+
+        const int32_t channelCount;
+        const int32_t rate;
+        const bool floatSamples;
+        const bool lowLatencyMode;
+        const int32_t bytesPerFrame;
+
+        std::mutex lock;
+        std::shared_ptr<oboe::AudioStream> stream;
+        std::unique_ptr<BufferSizeController> controller;
+        bool playing = false;
+
+        RingBuffer ring;
+
+        int64_t lastPlayedFrames = 0;
+        std::atomic<int64_t> framesWritten{0};
+        std::atomic<float> gain{1.0f};
+
+        // written by the callback
+        bool lastCallbackFull = false;
+        // silence written since the last frame from the ring, which
+        // pushes the frames of the ring out of the device
+        std::atomic<int64_t> trailingSilence{0};
+        // underruns of the current stream, plus those of closed ones
+        std::atomic<int32_t> xRuns{0};
+        int32_t closedXRuns = 0;
+        std::atomic<int32_t> starved{0};
+        std::atomic<int32_t> bufferSize{0};
+        std::array<std::atomic<int32_t>, OUTPUT_HISTOGRAM_BUCKETS> histogram{};
+
+        bool openStream();
+    };
+}
+
+#endif //SOUNDSOURCE_OBOE_OUTPUT_H
@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <tuple>
+
+namespace SoundSource::Audio {
+    namespace {
+        // 44.1k <-> 48k needs 160 phases, 8k -> 44.1k needs 441
+        constexpr int32_t kMaxPhases = 1024;
+
+        struct QualityPreset {
+            int32_t taps;
+            double attenuation;
+        };
+
+        QualityPreset presetOf(ResamplerQuality quality) {
+            switch (quality) {
+                case ResamplerQuality::LOW:
+                    return {24, 60};
+                case ResamplerQuality::MEDIUM:
+                    return {64, 80};
+                case ResamplerQuality::HIGH:
+                default:
+                    return {128, 100};
+            }
+        }
+
+        double besselI0(double x) {
+            double sum = 1, term = 1;
+            double q = x * x / 4;
+            for (int k = 1; k < 64 && term > sum * 1e-12; k++) {
+                term *= q / ((double) k * k);
+                sum += term;
+            }
+            return sum;
+        }
+
+        double kaiserBeta(double attenuation) {
+            if (attenuation > 50) {
+                return 0.1102 * (attenuation - 8.7);
+            }
+            if (attenuation >= 21) {
+                return 0.5842 * std::pow(attenuation - 21, 0.4) + 0.07886 * (attenuation - 21);
+            }
+            return 0;
+        }
+
+        std::shared_ptr<const FilterBank> design(int32_t up, int32_t down,
+                                                 ResamplerQuality quality) {
+            QualityPreset preset = presetOf(quality);
+            // the preset length is counted in periods of the lower rate,
+            // decimation stretches it over more input samples
+            int32_t taps = preset.taps;
+            if (down > up) {
+                taps = (int32_t) std::ceil((double) preset.taps * down / up);
+            }
+            taps = (taps + 3) & ~3;
+
+            // transition width relative to the lower Nyquist frequency,
+            // centred so the stopband starts at Nyquist
+            double transition = 2 * (preset.attenuation - 7.95) / (14.36 * preset.taps);
+            double cutoff = (1 - transition / 2) / (2.0 * std::max(up, down));
+
+            // one short of the up * taps slots of the phases, an odd
+            // length puts the centre on a sample so no phase lags the
+            // input by a fraction of a sample; the last slot stays zero
+            const int32_t length = up * taps;
+            std::vector<double> prototype = kaiserLowPass(length - 1, cutoff, preset.attenuation);
+            prototype.push_back(0);
+
+            auto bank = std::make_shared<FilterBank>();
+            bank->upFactor = up;
+            bank->downFactor = down;
+            bank->taps = taps;
+            bank->coefficients.resize((size_t) length);
+            // every phase sums to unity DC gain
+            double scale = up;
+            for (int32_t p = 0; p < up; p++) {
+                float *phase = bank->coefficients.data() + (size_t) p * taps;
+                for (int32_t m = 0; m < taps; m++) {
+                    phase[m] = (float) (prototype[p + (size_t) (taps - 1 - m) * up] * scale);
+                }
+            }
+            return bank;
+        }
+
+        inline float dot(const float *a, const float *b, int32_t n) {
+            Simd::float4 acc0 = Simd::zero();
+            Simd::float4 acc1 = Simd::zero();
+            int32_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                acc0 = Simd::madd(Simd::load(a + i), Simd::load(b + i), acc0);
+                acc1 = Simd::madd(Simd::load(a + i + 4), Simd::load(b + i + 4), acc1);
+            }
+            if (i < n) {
+                acc0 = Simd::madd(Simd::load(a + i), Simd::load(b + i), acc0);
+            }
+            return Simd::hadd(Simd::add(acc0, acc1));
+        }
+    }
+
+    std::vector<double> kaiserLowPass(int32_t length, double cutoff, double attenuation) {
+        const double beta = kaiserBeta(attenuation);
+        const double i0Beta = besselI0(beta);
+        const double centre = (length - 1) / 2.0;
+        std::vector<double> taps((size_t) std::max(length, 0));
+        double sum = 0;
+        for (int32_t j = 0; j < length; j++) {
+            double t = j - centre;
+            double x = 2 * cutoff * t;
+            double sinc = t == 0 ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+            double r = t / (centre + 0.5);
+            double window = besselI0(beta * std::sqrt(std::max(0.0, 1 - r * r))) / i0Beta;
+            taps[j] = sinc * window;
+            sum += taps[j];
+        }
+        for (double &tap: taps) {
+            tap /= sum;
+        }
+        return taps;
+    }
+
+    std::shared_ptr<const FilterBank> FilterBank::obtain(int32_t inputRate, int32_t outputRate,
+                                                         ResamplerQuality quality) {
+        if (inputRate <= 0 || outputRate <= 0) {
+            return nullptr;
+        }
+        int32_t divisor = std::gcd(inputRate, outputRate);
+        int32_t up = outputRate / divisor;
+        int32_t down = inputRate / divisor;
+        if (up > kMaxPhases) {
+            return nullptr;
+        }
+
+        static std::mutex lock;
+        static std::map<std::tuple<int32_t, int32_t, ResamplerQuality>,
+                std::shared_ptr<const FilterBank>> banks;
+
+        std::lock_guard<std::mutex> guard(lock);
+        auto key = std::make_tuple(up, down, quality);
+        auto it = banks.find(key);
+        if (it != banks.end()) {
+            return it->second;
+        }
+        auto bank = design(up, down, quality);
+        banks.emplace(key, bank);
+        return bank;
+    }
+
+    Resampler::Resampler(int32_t channels, int32_t inputRate, int32_t outputRate,
+                         ResamplerQuality quality) {
+        channelCount = std::max(channels, 1);
+        bank = FilterBank::obtain(inputRate, outputRate, quality);
+        if (bank == nullptr) {
+            return;
+        }
+        history.resize(channelCount);
+        for (auto &h: history) {
+            h.resize((size_t) bank->taps - 1 + kMaxChunk);
+        }
+        scratchIn.resize((size_t) kMaxChunk * channelCount);
+        scratchOut.resize((size_t) maxOutputFrames(kMaxChunk) * channelCount);
+        reset();
+    }
+
+    bool Resampler::isValid() const {
+        return bank != nullptr;
+    }
+
+    int32_t Resampler::maxOutputFrames(int32_t inputFrames) const {
+        if (bank == nullptr) {
+            return 0;
+        }
+        return (int32_t) ((int64_t) inputFrames * bank->upFactor / bank->downFactor) + 2;
+    }
+
+    void Resampler::reset() {
+        if (bank == nullptr) {
+            return;
+        }
+        // half a filter of silence and the last phase centre the first
+        // output on the first input
+        historySize = bank->taps / 2;
+        for (auto &h: history) {
+            std::fill(h.begin(), h.end(), 0.0f);
+        }
+        phase = bank->upFactor - 1;
+    }
+
+    int32_t Resampler::delayFrames() const {
+        return bank == nullptr ? 0 : bank->taps / 2;
+    }
+
+    int32_t Resampler::channels() const {
+        return channelCount;
+    }
+
+    int32_t Resampler::process(const float *in, int32_t frames, float *out) {
+        if (bank == nullptr) {
+            return 0;
+        }
+        int32_t written = 0;
+        while (frames > 0) {
+            int32_t count = std::min(frames, kMaxChunk);
+            written += processChunk(in, count, out + (size_t) written * channelCount);
+            in += (size_t) count * channelCount;
+            frames -= count;
+        }
+        return written;
+    }
+
+    int32_t Resampler::process(const int16_t *in, int32_t frames, int16_t *out) {
+        if (bank == nullptr) {
+            return 0;
+        }
+        int32_t written = 0;
+        while (frames > 0) {
+            int32_t count = std::min(frames, kMaxChunk);
+            int32_t n = count * channelCount;
+            for (int32_t i = 0; i < n; i++) {
+                scratchIn[i] = in[i] * (1.0f / 32768.0f);
+            }
+            int32_t produced = processChunk(scratchIn.data(), count, scratchOut.data());
+            int16_t *o = out + (size_t) written * channelCount;
+            for (int32_t i = 0; i < produced * channelCount; i++) {
+                float v = std::clamp(scratchOut[i] * 32768.0f, -32768.0f, 32767.0f);
+                o[i] = (int16_t) std::lrintf(v);
+            }
+            written += produced;
+            in += n;
+            frames -= count;
+        }
+        return written;
+    }
+
+    int32_t Resampler::processChunk(const float *in, int32_t frames, float *out) {
+        const int32_t c = channelCount;
+        const int32_t up = bank->upFactor;
+        const int32_t down = bank->downFactor;
+        const int32_t taps = bank->taps;
+        const float *coefficients = bank->coefficients.data();
+        const int32_t available = historySize + frames;
+
+        int32_t produced = 0;
+        int32_t index = 0;
+        int32_t nextPhase = phase;
+        for (int32_t ch = 0; ch < c; ch++) {
+            float *h = history[ch].data();
+            for (int32_t i = 0; i < frames; i++) {
+                h[historySize + i] = in[i * c + ch];
+            }
+
+            // the phase walk is the same for every channel
+            int32_t p = phase;
+            index = 0;
+            produced = 0;
+            while (index + taps <= available) {
+                out[produced * c + ch] = dot(h + index, coefficients + (size_t) p * taps, taps);
+                produced++;
+                p += down;
+                index += p / up;
+                p %= up;
+            }
+            nextPhase = p;
+        }
+
+        const int32_t remaining = available - index;
+        for (auto &h: history) {
+            std::memmove(h.data(), h.data() + index, (size_t) remaining * sizeof(float));
+        }
+        historySize = remaining;
+        phase = nextPhase;
+        return produced;
+    }
+
+    MonoResampler::MonoResampler(int32_t channels, int32_t inputRate, int32_t outputRate) {
+        channelCount = std::max(channels, 1);
+        mono.resize(kMaxChunk);
+        if (inputRate == outputRate) {
+            return;
+        }
+        // analysis needs no more than a short filter
+        resampler = std::make_unique<Resampler>(1, inputRate, outputRate, ResamplerQuality::LOW);
+        valid = resampler->isValid();
+        if (valid) {
+            resampled.resize(resampler->maxOutputFrames(kMaxChunk));
+        }
+    }
+
+    bool MonoResampler::isValid() const {
+        return valid;
+    }
+}
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOUNDSOURCE_RESAMPLER_H
+#define SOUNDSOURCE_RESAMPLER_H
+
+#include <sys/types.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "simd.h"
+
+namespace SoundSource::Audio {
+    /**
+     * Filter quality of the resampler. Every preset puts the stopband
+     * edge at the lower Nyquist frequency; higher presets use longer
+     * filters for a wider passband and deeper stopband.
+     *
+     * Values match ResamplerQuality on the Kotlin side.
+     */
+    enum class ResamplerQuality : int32_t {
+        /**
+         * 24 taps, 60 dB stopband, passband to about 0.70 Nyquist.
+         */
+        LOW = 0,
+
+        /**
+         * 64 taps, 80 dB stopband, passband to about 0.84 Nyquist.
+         */
+        MEDIUM = 1,
+
+        /**
+         * 128 taps, 100 dB stopband, passband to about 0.90 Nyquist.
+         */
+        HIGH = 2,
+    };
+
+    /**
+     * Design a linear phase Kaiser windowed sinc low-pass filter with
+     * unity DC gain.
+     *
+     * @param cutoff the -6 dB frequency relative to the sample rate.
+     * @param attenuation the stopband attenuation in dB.
+     */
+    std::vector<double> kaiserLowPass(int32_t length, double cutoff, double attenuation);
+
+    /**
+     * Polyphase decomposition of a Kaiser windowed sinc low-pass filter
+     * for the rational ratio upFactor / downFactor.
+     *
+     * Each phase stores its taps reversed and padded to a multiple of
+     * four, so a phase is a plain dot product with the input history.
+     * Banks are immutable and shared by every resampler with the same
+     * ratio and quality.
+     */
+    struct FilterBank {
+        int32_t upFactor;
+        int32_t downFactor;
+        int32_t taps;
+        // upFactor phases of taps coefficients each
+        std::vector<float> coefficients;
+
+        /**
+         * Get the bank of the given ratio, designing it on first use.
+         *
+         * @return the bank, or nullptr if the reduced ratio needs more
+         * phases than supported.
+         */
+        static std::shared_ptr<const FilterBank> obtain(int32_t inputRate, int32_t outputRate,
+                                                        ResamplerQuality quality);
+    };
+
+    /**
+     * Streaming polyphase FIR sample rate converter for interleaved
+     * float PCM.
+     *
+     * Input is accepted in blocks of any size, the filter history is kept
+     * between calls. The output is aligned with the input (no leading
+     * delay); the last delayFrames() input frames of the filter tail are
+     * pushed out by feeding that many frames of silence at end of stream.
+     */
+    class Resampler {
+    public:
+        Resampler(int32_t channels, int32_t inputRate, int32_t outputRate,
+                  ResamplerQuality quality = ResamplerQuality::HIGH);
+
+        /**
+         * @return false if the ratio is not supported.
+         */
+        bool isValid() const;
+
+        /**
+         * @return the maximum frames process() outputs for the given
+         * input frames.
+         */
+        int32_t maxOutputFrames(int32_t inputFrames) const;
+
+        /**
+         * Resample interleaved samples.
+         *
+         * @param out receives at least maxOutputFrames(frames) frames.
+         * @return the frames written to out.
+         */
+        int32_t process(const float *in, int32_t frames, float *out);
+
+        /**
+         * Resample 16-bit samples.
+         */
+        int32_t process(const int16_t *in, int32_t frames, int16_t *out);
+
+        /**
+         * Drop the filter history.
+         */
+        void reset();
+
+        /**
+         * @return input frames of silence that flush the filter tail.
+         */
+        int32_t delayFrames() const;
+
+        int32_t channels() const;
+
+    private:
+        static constexpr int32_t kMaxChunk = 1024;
+
+        int32_t channelCount;
+        std::shared_ptr<const FilterBank> bank;
+
+        // per channel history: taps - 1 frames plus kMaxChunk
+        std::vector<std::vector<float>> history;
+        int32_t historySize = 0;
+        int32_t phase = 0;
+
+        std::vector<float> scratchIn;
+        std::vector<float> scratchOut;
+
+        int32_t processChunk(const float *in, int32_t frames, float *out);
+    };
+
+    /**
+     * Downmixes interleaved audio to mono and resamples it, for the
+     * analysis stages that work at a fixed low sample rate.
+     */
+    class MonoResampler {
+    public:
+        MonoResampler(int32_t channels, int32_t inputRate, int32_t outputRate);
+
+        /**
+         * @return false if the ratio is not supported.
+         */
+        bool isValid() const;
+
+        /**
+         * Downmix and resample interleaved samples, handing the mono
+         * output to sink(const float *samples, int32_t count) in chunks.
+         */
+        template<typename Sink>
+        void process(const float *in, int32_t frames, Sink &&sink) {
+            const int32_t c = channelCount;
+            const float scale = 1.0f / (float) c;
+            while (frames > 0) {
+                int32_t count = std::min(frames, kMaxChunk);
+                for (int32_t i = 0; i < count; i++) {
+                    float sum = 0;
+                    for (int32_t ch = 0; ch < c; ch++) {
+                        sum += in[i * c + ch];
+                    }
+                    mono[i] = sum * scale;
+                }
+                if (resampler != nullptr) {
+                    int32_t produced = resampler->process(mono.data(), count, resampled.data());
+                    sink((const float *) resampled.data(), produced);
+                } else {
+                    sink((const float *) mono.data(), count);
+                }
+                in += (size_t) count * c;
+                frames -= count;
+            }
+        }
+
+    private:
+        static constexpr int32_t kMaxChunk = 1024;
+
+        int32_t channelCount;
+        bool valid = true;
+        std::unique_ptr<Resampler> resampler;
+        std::vector<float> mono;
+        std::vector<float> resampled;
+    };
+}
+
+#endif //SOUNDSOURCE_RESAMPLER_H
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_RING_BUFFER_H
+#define SOUNDSOURCE_RING_BUFFER_H
+
+#include <sys/types.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace SoundSource::Audio {
+    /**
+     * Lock-free single producer, single consumer ring buffer of audio
+     * frames.
+     *
+     * Read and write positions count frames since creation and never
+     * wrap, so the writer can drop everything written so far with
+     * discard() while the reader is running: the reader skips to the
+     * discard position on its next read.
+     *
+     * Positions are 64-bit and need the platform to have lock-free
+     * 64-bit atomics, which all Android ABIs do.
+     */
+    class RingBuffer {
+    public:
+        /**
+         * @param capacityFrames rounded up to a power of two.
+         */
+        RingBuffer(int32_t capacityFrames, int32_t bytesPerFrame)
+                : frameBytes(std::max(bytesPerFrame, 1)) {
+            int32_t capacity = 1;
+            while (capacity < capacityFrames) {
+                capacity <<= 1;
+            }
+            mask = capacity - 1;
+            data.resize((size_t) capacity * frameBytes);
+        }
+
+        int32_t capacity() const {
+            return mask + 1;
+        }
+
+        /**
+         * @return frames the writer can write without overwriting.
+         */
+        int32_t writable() const {
+            // discarded frames are free once the reader skipped them, it
+            // may still be copying them
+            uint64_t read = readPosition.load(std::memory_order_acquire);
+            return capacity() - (int32_t) (writePosition.load(std::memory_order_relaxed) - read);
+        }
+
+        /**
+         * @return frames the reader can read.
+         */
+        int32_t readable() const {
+            uint64_t read = std::max(readPosition.load(std::memory_order_relaxed),
+                                     discardPosition.load(std::memory_order_acquire));
+            return (int32_t) (writePosition.load(std::memory_order_acquire) - read);
+        }
+
+        /**
+         * Write up to frames frames, writer thread only.
+         *
+         * @return the frames written.
+         */
+        int32_t write(const void *in, int32_t frames) {
+            const int32_t count = std::min(frames, writable());
+            if (count <= 0) {
+                return 0;
+            }
+            const uint64_t position = writePosition.load(std::memory_order_relaxed);
+            copyIn((const uint8_t *) in, position, count);
+            writePosition.store(position + count, std::memory_order_release);
+            return count;
+        }
+
+        /**
+         * Read up to frames frames, reader thread only.
+         *
+         * @return the frames read.
+         */
+        int32_t read(void *out, int32_t frames) {
+            uint64_t position = readPosition.load(std::memory_order_relaxed);
+            const uint64_t discard = discardPosition.load(std::memory_order_acquire);
+            if (discard > position) {
+                position = discard;
+            }
+            const uint64_t end = writePosition.load(std::memory_order_acquire);
+            const auto count = (int32_t) std::min<uint64_t>(frames, end - position);
+            if (count > 0) {
+                copyOut((uint8_t *) out, position, count);
+            }
+            readPosition.store(position + count, std::memory_order_release);
+            return count;
+        }
+
+        /**
+         * @return frames read since the last discard(), any thread.
+         */
+        int64_t readSinceDiscard() const {
+            uint64_t read = readPosition.load(std::memory_order_acquire);
+            uint64_t discard = discardPosition.load(std::memory_order_acquire);
+            return read > discard ? (int64_t) (read - discard) : 0;
+        }
+
+        /**
+         * Drop all frames written so far, writer thread only.
+         */
+        void discard() {
+            discardPosition.store(writePosition.load(std::memory_order_relaxed),
+                                  std::memory_order_release);
+        }
+
+    private:
+        const int32_t frameBytes;
+        int32_t mask;
+        std::vector<uint8_t> data;
+
+        alignas(64) std::atomic<uint64_t> writePosition{0};
+        alignas(64) std::atomic<uint64_t> readPosition{0};
+        alignas(64) std::atomic<uint64_t> discardPosition{0};
+
+        void copyIn(const uint8_t *in, uint64_t position, int32_t count) {
+            const auto offset = (int32_t) (position & mask);
+            const int32_t first = std::min(count, capacity() - offset);
+            std::memcpy(data.data() + (size_t) offset * frameBytes, in,
+                        (size_t) first * frameBytes);
+            std::memcpy(data.data(), in + (size_t) first * frameBytes,
+                        (size_t) (count - first) * frameBytes);
+        }
+
+        void copyOut(uint8_t *out, uint64_t position, int32_t count) const {
+            const auto offset = (int32_t) (position & mask);
+            const int32_t first = std::min(count, capacity() - offset);
+            std::memcpy(out, data.data() + (size_t) offset * frameBytes,
+                        (size_t) first * frameBytes);
+            std::memcpy(out + (size_t) first * frameBytes, data.data(),
+                        (size_t) (count - first) * frameBytes);
+        }
+    };
+}
+
+#endif //SOUNDSOURCE_RING_BUFFER_H
@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOUNDSOURCE_SIMD_H
+#define SOUNDSOURCE_SIMD_H
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SOUNDSOURCE_SIMD_NEON 1
+
+#include <arm_neon.h>
+
+#elif defined(__SSE2__) || defined(_M_X64)
+#define SOUNDSOURCE_SIMD_SSE 1
+
+#include <emmintrin.h>
+
+#endif
+
+/**
+ * A minimal 4-lane float vector abstraction over NEON and SSE, with a
+ * scalar fallback, covering every ABI the app is built for.
+ */
+namespace SoundSource::Audio::Simd {
+#if defined(SOUNDSOURCE_SIMD_NEON)
+    using float4 = float32x4_t;
+
+    inline float4 load(const float *p) { return vld1q_f32(p); }
+
+    inline void store(float *p, float4 v) { vst1q_f32(p, v); }
+
+    inline float4 set1(float v) { return vdupq_n_f32(v); }
+
+    inline float4 zero() { return vdupq_n_f32(0.0f); }
+
+    inline float4 add(float4 a, float4 b) { return vaddq_f32(a, b); }
+
+    inline float4 sub(float4 a, float4 b) { return vsubq_f32(a, b); }
+
+    inline float4 mul(float4 a, float4 b) { return vmulq_f32(a, b); }
+
+    /**
+     * @return a * b + c
+     */
+    inline float4 madd(float4 a, float4 b, float4 c) { return vmlaq_f32(c, a, b); }
+
+    inline float4 min(float4 a, float4 b) { return vminq_f32(a, b); }
+
+    inline float4 max(float4 a, float4 b) { return vmaxq_f32(a, b); }
+
+    inline float4 abs(float4 a) { return vabsq_f32(a); }
+
+    inline float hmax(float4 v) {
+        float32x2_t m = vpmax_f32(vget_low_f32(v), vget_high_f32(v));
+        m = vpmax_f32(m, m);
+        return vget_lane_f32(m, 0);
+    }
+
+    inline float hmin(float4 v) {
+        float32x2_t m = vpmin_f32(vget_low_f32(v), vget_high_f32(v));
+        m = vpmin_f32(m, m);
+        return vget_lane_f32(m, 0);
+    }
+
+    inline float hadd(float4 v) {
+        float32x2_t s = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+        s = vpadd_f32(s, s);
+        return vget_lane_f32(s, 0);
+    }
+
+#elif defined(SOUNDSOURCE_SIMD_SSE)
+    using float4 = __m128;
+
+    inline float4 load(const float *p) { return _mm_loadu_ps(p); }
+
+    inline void store(float *p, float4 v) { _mm_storeu_ps(p, v); }
+
+    inline float4 set1(float v) { return _mm_set1_ps(v); }
+
+    inline float4 zero() { return _mm_setzero_ps(); }
+
+    inline float4 add(float4 a, float4 b) { return _mm_add_ps(a, b); }
+
+    inline float4 sub(float4 a, float4 b) { return _mm_sub_ps(a, b); }
+
+    inline float4 mul(float4 a, float4 b) { return _mm_mul_ps(a, b); }
+
+    /**
+     * @return a * b + c
+     */
+    inline float4 madd(float4 a, float4 b, float4 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+
+    inline float4 min(float4 a, float4 b) { return _mm_min_ps(a, b); }
+
+    inline float4 max(float4 a, float4 b) { return _mm_max_ps(a, b); }
+
+    inline float4 abs(float4 a) {
+        return _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)));
+    }
+
+    inline float hmax(float4 v) {
+        float4 m = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(m);
+    }
+
+    inline float hmin(float4 v) {
+        float4 m = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(m);
+    }
+
+    inline float hadd(float4 v) {
+        float4 s = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        s = _mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(s);
+    }
+
+#else
+    struct float4 {
+        float v[4];
+    };
+
+    inline float4 load(const float *p) { return {{p[0], p[1], p[2], p[3]}}; }
+
+    inline void store(float *p, float4 a) {
+        p[0] = a.v[0];
+        p[1] = a.v[1];
+        p[2] = a.v[2];
+        p[3] = a.v[3];
+    }
+
+    inline float4 set1(float v) { return {{v, v, v, v}}; }
+
+    inline float4 zero() { return set1(0.0f); }
+
+#define SOUNDSOURCE_SIMD_LANEWISE(expr) \
+        float4 r; for (int i = 0; i < 4; i++) { r.v[i] = (expr); } return r
+
+    inline float4 add(float4 a, float4 b) { SOUNDSOURCE_SIMD_LANEWISE(a.v[i] + b.v[i]); }
+
+    inline float4 sub(float4 a, float4 b) { SOUNDSOURCE_SIMD_LANEWISE(a.v[i] - b.v[i]); }
+
+    inline float4 mul(float4 a, float4 b) { SOUNDSOURCE_SIMD_LANEWISE(a.v[i] * b.v[i]); }
+
+    /**
+     * @return a * b + c
+     */
+    inline float4 madd(float4 a, float4 b, float4 c) {
+        SOUNDSOURCE_SIMD_LANEWISE(a.v[i] * b.v[i] + c.v[i]);
+    }
+
+    inline float4 min(float4 a, float4 b) {
+        SOUNDSOURCE_SIMD_LANEWISE(a.v[i] < b.v[i] ? a.v[i] : b.v[i]);
+    }
+
+    inline float4 max(float4 a, float4 b) {
+        SOUNDSOURCE_SIMD_LANEWISE(a.v[i] > b.v[i] ? a.v[i] : b.v[i]);
+    }
+
+    inline float4 abs(float4 a) { SOUNDSOURCE_SIMD_LANEWISE(std::fabs(a.v[i])); }
+
+#undef SOUNDSOURCE_SIMD_LANEWISE
+
+    inline float hmax(float4 a) {
+        float m = a.v[0] > a.v[1] ? a.v[0] : a.v[1];
+        float n = a.v[2] > a.v[3] ? a.v[2] : a.v[3];
+        return m > n ? m : n;
+    }
+
+    inline float hmin(float4 a) {
+        float m = a.v[0] < a.v[1] ? a.v[0] : a.v[1];
+        float n = a.v[2] < a.v[3] ? a.v[2] : a.v[3];
+        return m < n ? m : n;
+    }
+
+    inline float hadd(float4 a) { return (a.v[0] + a.v[1]) + (a.v[2] + a.v[3]); }
+
+#endif
+}
+
+#endif //SOUNDSOURCE_SIMD_H
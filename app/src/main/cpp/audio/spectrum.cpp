@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "spectrum.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace SoundSource::Audio {
+    namespace {
+        constexpr double kLowestFrequency = 20.0;
+        constexpr double kHighestFrequency = 20000.0;
+        constexpr float kMinimumPower = 1e-20f;
+    }
+
+    SpectrumAnalyzer::SpectrumAnalyzer(int32_t fftSize, int32_t bandCount)
+            : fft(fftSize),
+              bands(std::clamp(bandCount, 1, fftSize / 4)),
+              output(std::vector<float>((size_t) bands, SPECTRUM_FLOOR_DB)) {
+        // periodic Hann, scaled by 4 / N so a full scale sine at a bin
+        // centre has magnitude 1 after the coherent gain of 0.5
+        window.resize(fftSize);
+        for (int32_t i = 0; i < fftSize; i++) {
+            window[i] = (float) ((0.5 - 0.5 * std::cos(2 * M_PI * i / fftSize)) * 4.0 / fftSize);
+        }
+        history.resize(fftSize);
+        frame.resize(fftSize);
+        const size_t bins = ((size_t) fftSize / 2 + 1 + 3) & ~(size_t) 3;
+        re.resize(bins);
+        im.resize(bins);
+        power.resize(bins);
+        bandEdges.resize((size_t) bands + 1);
+        scratch.resize(kMaxChunk);
+    }
+
+    void SpectrumAnalyzer::configure(int32_t channels, int32_t sampleRate) {
+        const int32_t n = fft.size();
+        channelCount = std::max(channels, 1);
+        hop = sampleRate > 0 ? std::clamp(sampleRate / kFramesPerSecond, 1, n) : 0;
+        std::fill(history.begin(), history.end(), 0.0f);
+        historyPosition = 0;
+        sinceAnalysis = 0;
+        if (sampleRate <= 0) {
+            return;
+        }
+
+        const double binWidth = (double) sampleRate / n;
+        const double high = std::min(kHighestFrequency, sampleRate / 2.0);
+        const double ratio = high / kLowestFrequency;
+        for (int32_t b = 0; b <= bands; b++) {
+            double frequency = kLowestFrequency * std::pow(ratio, (double) b / bands);
+            bandEdges[b] = std::clamp((int32_t) std::lround(frequency / binWidth), 1, n / 2);
+        }
+        // a band narrower than a bin still reads the closest one
+        for (int32_t b = 0; b < bands; b++) {
+            bandEdges[b + 1] = std::max(bandEdges[b + 1], bandEdges[b] + 1);
+        }
+        for (int32_t b = bands; b > 0; b--) {
+            bandEdges[b] = std::min(bandEdges[b], n / 2 + 1 - (bands - b));
+            bandEdges[b - 1] = std::min(bandEdges[b - 1], bandEdges[b] - 1);
+        }
+    }
+
+    void SpectrumAnalyzer::process(const float *samples, int32_t frames) {
+        if (hop == 0) {
+            return;
+        }
+        const int32_t c = channelCount;
+        const float scale = 1.0f / (float) c;
+        while (frames > 0) {
+            int32_t count = std::min(frames, kMaxChunk);
+            if (c == 1) {
+                push(samples, count);
+            } else {
+                for (int32_t i = 0; i < count; i++) {
+                    float sum = 0;
+                    for (int32_t ch = 0; ch < c; ch++) {
+                        sum += samples[i * c + ch];
+                    }
+                    scratch[i] = sum * scale;
+                }
+                push(scratch.data(), count);
+            }
+            samples += (size_t) count * c;
+            frames -= count;
+        }
+    }
+
+    void SpectrumAnalyzer::process(const int16_t *samples, int32_t frames) {
+        if (hop == 0) {
+            return;
+        }
+        const int32_t c = channelCount;
+        const float scale = 1.0f / (32768.0f * (float) c);
+        while (frames > 0) {
+            int32_t count = std::min(frames, kMaxChunk);
+            for (int32_t i = 0; i < count; i++) {
+                int32_t sum = 0;
+                for (int32_t ch = 0; ch < c; ch++) {
+                    sum += samples[i * c + ch];
+                }
+                scratch[i] = (float) sum * scale;
+            }
+            push(scratch.data(), count);
+            samples += (size_t) count * c;
+            frames -= count;
+        }
+    }
+
+    void SpectrumAnalyzer::push(const float *mono, int32_t frames) {
+        const int32_t n = fft.size();
+        while (frames > 0) {
+            int32_t count = std::min({frames, hop - sinceAnalysis, n - historyPosition});
+            std::memcpy(history.data() + historyPosition, mono, (size_t) count * sizeof(float));
+            historyPosition = (historyPosition + count) % n;
+            sinceAnalysis += count;
+            mono += count;
+            frames -= count;
+            if (sinceAnalysis == hop) {
+                sinceAnalysis = 0;
+                analyze();
+            }
+        }
+    }
+
+    void SpectrumAnalyzer::analyze() {
+        const int32_t n = fft.size();
+        // oldest frame first
+        const int32_t tail = n - historyPosition;
+        std::memcpy(frame.data(), history.data() + historyPosition, (size_t) tail * sizeof(float));
+        std::memcpy(frame.data() + tail, history.data(), (size_t) historyPosition * sizeof(float));
+        for (int32_t i = 0; i < n; i += 4) {
+            Simd::store(&frame[i], Simd::mul(Simd::load(&frame[i]), Simd::load(&window[i])));
+        }
+
+        fft.forward(frame.data(), re.data(), im.data());
+
+        const auto bins = (int32_t) power.size();
+        for (int32_t k = 0; k < bins; k += 4) {
+            Simd::float4 r = Simd::load(&re[k]);
+            Simd::float4 i = Simd::load(&im[k]);
+            Simd::store(&power[k], Simd::madd(r, r, Simd::mul(i, i)));
+        }
+
+        std::vector<float> &levels = output.writeBuffer();
+        for (int32_t b = 0; b < bands; b++) {
+            float peak = kMinimumPower;
+            for (int32_t k = bandEdges[b]; k < bandEdges[b + 1]; k++) {
+                peak = std::max(peak, power[k]);
+            }
+            levels[b] = std::max(10.0f * std::log10(peak), SPECTRUM_FLOOR_DB);
+        }
+        output.publish();
+    }
+
+    bool SpectrumAnalyzer::read(float *levels) {
+        bool fresh = output.update();
+        const std::vector<float> &latest = output.readBuffer();
+        std::memcpy(levels, latest.data(), latest.size() * sizeof(float));
+        return fresh;
+    }
+
+    int32_t SpectrumAnalyzer::bandCount() const {
+        return bands;
+    }
+
+    int32_t SpectrumAnalyzer::fftSize() const {
+        return fft.size();
+    }
+}
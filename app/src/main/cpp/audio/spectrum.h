@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_SPECTRUM_H
+#define SOUNDSOURCE_SPECTRUM_H
+
+#include <sys/types.h>
+#include <cstdint>
+#include <vector>
+
+#include "fft.h"
+#include "triple_buffer.h"
+
+namespace SoundSource::Audio {
+    /**
+     * Lowest level reported for a band, in dBFS.
+     */
+    constexpr float SPECTRUM_FLOOR_DB = -96.0f;
+
+    /**
+     * Spectrum analyser tap on the playback path.
+     *
+     * The playback thread feeds it interleaved PCM, which is downmixed
+     * into a window of fftSize frames. About 60 times a second the window
+     * is Hann weighted, transformed and folded into bandCount bands
+     * spaced logarithmically from 20 Hz to 20 kHz (or Nyquist). A band
+     * holds the level of its strongest bin in dBFS, a full scale sine
+     * reads 0 dB.
+     *
+     * The bands are handed over through a triple buffer, so the reader
+     * never blocks the playback thread and the other way around.
+     */
+    class SpectrumAnalyzer {
+    public:
+        /**
+         * @param fftSize a power of two of at least 8.
+         */
+        SpectrumAnalyzer(int32_t fftSize, int32_t bandCount);
+
+        /**
+         * Set the format of the following samples and drop the
+         * buffered ones, playback thread only.
+         */
+        void configure(int32_t channels, int32_t sampleRate);
+
+        /**
+         * Process interleaved float samples, playback thread only.
+         */
+        void process(const float *samples, int32_t frames);
+
+        /**
+         * Process interleaved 16-bit samples, playback thread only.
+         */
+        void process(const int16_t *samples, int32_t frames);
+
+        /**
+         * Copy the latest bands, from a single reader thread.
+         *
+         * @param bands receives bandCount() levels in dBFS.
+         * @return true if the bands changed since the last read.
+         */
+        bool read(float *bands);
+
+        int32_t bandCount() const;
+
+        int32_t fftSize() const;
+
+    private:
+        static constexpr int32_t kFramesPerSecond = 60;
+        static constexpr int32_t kMaxChunk = 1024;
+
+        RealFft fft;
+        int32_t bands;
+        int32_t channelCount = 0;
+        int32_t hop = 0;
+
+        std::vector<float> window;
+        // downmixed input, a ring of fftSize frames
+        std::vector<float> history;
+        int32_t historyPosition = 0;
+        int32_t sinceAnalysis = 0;
+
+        // first bin of every band, bands + 1 edges
+        std::vector<int32_t> bandEdges;
+        std::vector<float> frame;
+        std::vector<float> re, im, power;
+        std::vector<float> scratch;
+
+        TripleBuffer<std::vector<float>> output;
+
+        void push(const float *mono, int32_t frames);
+
+        void analyze();
+    };
+}
+
+#endif //SOUNDSOURCE_SPECTRUM_H
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_TRIPLE_BUFFER_H
+#define SOUNDSOURCE_TRIPLE_BUFFER_H
+
+#include <sys/types.h>
+#include <atomic>
+#include <cstdint>
+
+namespace SoundSource::Audio {
+    /**
+     * Lock-free single producer, single consumer triple buffer.
+     *
+     * The writer fills its back slot and publishes it by swapping it
+     * with the middle slot; the reader swaps the middle slot with its
+     * front slot when a newer one was published. Neither side ever
+     * waits, the reader just sees the latest complete value and
+     * intermediate values may be skipped.
+     */
+    template<typename T>
+    class TripleBuffer {
+    public:
+        TripleBuffer() = default;
+
+        explicit TripleBuffer(const T &initial) {
+            for (Slot &slot: slots) {
+                slot.value = initial;
+            }
+        }
+
+        /**
+         * @return the slot to fill, writer thread only.
+         */
+        T &writeBuffer() {
+            return slots[back].value;
+        }
+
+        /**
+         * Publish the filled slot, writer thread only.
+         */
+        void publish() {
+            uint8_t previous = state.exchange(back | kFresh, std::memory_order_acq_rel);
+            back = previous & kIndexMask;
+        }
+
+        /**
+         * Take the latest published value if there is a newer one,
+         * reader thread only.
+         *
+         * @return true if readBuffer() changed.
+         */
+        bool update() {
+            if ((state.load(std::memory_order_relaxed) & kFresh) == 0) {
+                return false;
+            }
+            uint8_t previous = state.exchange(front, std::memory_order_acq_rel);
+            front = previous & kIndexMask;
+            return true;
+        }
+
+        /**
+         * @return the value taken by the last update(), reader thread only.
+         */
+        const T &readBuffer() const {
+            return slots[front].value;
+        }
+
+    private:
+        static constexpr uint8_t kIndexMask = 0x3;
+        static constexpr uint8_t kFresh = 0x4;
+
+        // keeps the writer and the reader off each other's cache lines
+        struct alignas(64) Slot {
+            T value{};
+        };
+
+        Slot slots[3];
+        // index of the middle slot, and whether it is unread
+        std::atomic<uint8_t> state{1};
+        alignas(64) uint8_t back = 0;
+        alignas(64) uint8_t front = 2;
+    };
+}
+
+#endif //SOUNDSOURCE_TRIPLE_BUFFER_H
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "waveform.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace SoundSource::Audio {
+    namespace {
+        constexpr uint8_t kVersion = 1;
+        constexpr size_t kHeaderSize = 24;
+
+        inline void putLe(std::vector<uint8_t> &out, uint64_t value, int32_t bytes) {
+            for (int32_t i = 0; i < bytes; i++) {
+                out.push_back((uint8_t) (value >> (8 * i)));
+            }
+        }
+
+        inline WaveformBucket emptyBucket() {
+            return {std::numeric_limits<float>::infinity(),
+                    -std::numeric_limits<float>::infinity(), 0, 0};
+        }
+
+        inline void mergeInto(WaveformBucket &to, const WaveformBucket &from) {
+            to.min = std::min(to.min, from.min);
+            to.max = std::max(to.max, from.max);
+            to.sumSquares += from.sumSquares;
+            to.samples += from.samples;
+        }
+    }
+
+    WaveformBuilder::WaveformBuilder(int32_t channels, int32_t sampleRate, int32_t bucketCount) {
+        channelCount = std::max(channels, 1);
+        rate = sampleRate;
+        targetCount = std::max(bucketCount, 1);
+        bucketList.reserve((size_t) targetCount * 2);
+    }
+
+    void WaveformBuilder::process(const float *samples, int32_t frames) {
+        while (frames > 0) {
+            if (bucketList.empty() || openFrames == framesPerBucket) {
+                if (bucketList.size() == (size_t) targetCount * 2) {
+                    mergePairs();
+                }
+                bucketList.push_back(emptyBucket());
+                openFrames = 0;
+            }
+            auto count = (int32_t) std::min<int64_t>(frames, framesPerBucket - openFrames);
+            accumulate(samples, count);
+            openFrames += count;
+            frameCount += count;
+            samples += (size_t) count * channelCount;
+            frames -= count;
+        }
+    }
+
+    void WaveformBuilder::accumulate(const float *samples, int32_t frames) {
+        WaveformBucket &bucket = bucketList.back();
+        const int32_t n = frames * channelCount;
+        int32_t i = 0;
+        if (n >= 4) {
+            Simd::float4 lo = Simd::set1(bucket.min);
+            Simd::float4 hi = Simd::set1(bucket.max);
+            Simd::float4 squares = Simd::zero();
+            for (; i + 4 <= n; i += 4) {
+                Simd::float4 x = Simd::load(samples + i);
+                lo = Simd::min(lo, x);
+                hi = Simd::max(hi, x);
+                squares = Simd::madd(x, x, squares);
+            }
+            bucket.min = Simd::hmin(lo);
+            bucket.max = Simd::hmax(hi);
+            bucket.sumSquares += Simd::hadd(squares);
+        }
+        for (; i < n; i++) {
+            float x = samples[i];
+            bucket.min = std::min(bucket.min, x);
+            bucket.max = std::max(bucket.max, x);
+            bucket.sumSquares += x * x;
+        }
+        bucket.samples += n;
+    }
+
+    void WaveformBuilder::mergePairs() {
+        const size_t half = bucketList.size() / 2;
+        for (size_t i = 0; i < half; i++) {
+            WaveformBucket merged = bucketList[2 * i];
+            mergeInto(merged, bucketList[2 * i + 1]);
+            bucketList[i] = merged;
+        }
+        bucketList.resize(half);
+        framesPerBucket *= 2;
+    }
+
+    void WaveformBuilder::finish() {
+        if (finished) {
+            return;
+        }
+        finished = true;
+        const size_t size = bucketList.size();
+        if (size <= (size_t) targetCount) {
+            return;
+        }
+        // size is at most twice the target, every bucket takes one or two
+        std::vector<WaveformBucket> folded((size_t) targetCount, emptyBucket());
+        for (size_t j = 0; j < folded.size(); j++) {
+            size_t begin = j * size / targetCount;
+            size_t end = (j + 1) * size / targetCount;
+            for (size_t k = begin; k < end; k++) {
+                mergeInto(folded[j], bucketList[k]);
+            }
+        }
+        bucketList = std::move(folded);
+    }
+
+    std::vector<uint8_t> WaveformBuilder::serialize() const {
+        std::vector<uint8_t> out;
+        out.reserve(kHeaderSize + bucketList.size() * 3);
+        for (char c: {'S', 'S', 'W', 'F'}) {
+            out.push_back((uint8_t) c);
+        }
+        out.push_back(kVersion);
+        out.push_back((uint8_t) std::min(channelCount, 255));
+        putLe(out, 0, 2);
+        putLe(out, (uint32_t) rate, 4);
+        putLe(out, (uint64_t) frameCount, 8);
+        putLe(out, (uint32_t) bucketList.size(), 4);
+
+        for (const WaveformBucket &bucket: bucketList) {
+            if (bucket.samples == 0) {
+                out.insert(out.end(), {0, 0, 0});
+                continue;
+            }
+            float min = std::clamp(bucket.min, -1.0f, 1.0f);
+            float max = std::clamp(bucket.max, -1.0f, 1.0f);
+            double rms = std::sqrt(bucket.sumSquares / (double) bucket.samples);
+            out.push_back((uint8_t) (int8_t) std::lrintf(min * 127.0f));
+            out.push_back((uint8_t) (int8_t) std::lrintf(max * 127.0f));
+            out.push_back((uint8_t) std::lrint(std::min(rms, 1.0) * 255.0));
+        }
+        return out;
+    }
+
+    const std::vector<WaveformBucket> &WaveformBuilder::buckets() const {
+        return bucketList;
+    }
+
+    int64_t WaveformBuilder::totalFrames() const {
+        return frameCount;
+    }
+}
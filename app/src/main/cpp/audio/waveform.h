@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_WAVEFORM_H
+#define SOUNDSOURCE_WAVEFORM_H
+
+#include <sys/types.h>
+#include <cstdint>
+#include <vector>
+
+#include "simd.h"
+
+namespace SoundSource::Audio {
+    /**
+     * Peak summary of a span of samples, over all channels.
+     */
+    struct WaveformBucket {
+        float min;
+        float max;
+        double sumSquares;
+        int64_t samples;
+    };
+
+    /**
+     * Builds a fixed size peak overview of a stream of unknown length
+     * in a single pass.
+     *
+     * Buckets start one frame wide. Whenever twice the requested count
+     * is filled, neighbouring buckets are merged in pairs and the width
+     * doubles, so memory stays bounded and every bucket covers the same
+     * number of frames. finish() then folds the kept buckets down to
+     * the requested count.
+     */
+    class WaveformBuilder {
+    public:
+        WaveformBuilder(int32_t channels, int32_t sampleRate, int32_t bucketCount);
+
+        /**
+         * Process interleaved float samples in range [-1, 1].
+         */
+        void process(const float *samples, int32_t frames);
+
+        /**
+         * Close the last bucket and fold the buckets to the requested
+         * count. Streams shorter than the count keep one bucket per frame.
+         */
+        void finish();
+
+        /**
+         * Serialize the overview, 3 bytes per bucket:
+         *
+         * <pre>
+         * "SSWF" | version u8 | channels u8 | reserved u16
+         * | sample rate u32 | total frames u64 | bucket count u32
+         * | bucket count * (min s8, max s8, rms u8)
+         * </pre>
+         *
+         * Integers are little endian. Peaks are scaled by 127, the RMS
+         * by 255.
+         */
+        std::vector<uint8_t> serialize() const;
+
+        const std::vector<WaveformBucket> &buckets() const;
+
+        int64_t totalFrames() const;
+
+    private:
+        int32_t channelCount;
+        int32_t rate;
+        int32_t targetCount;
+
+        std::vector<WaveformBucket> bucketList;
+        int64_t framesPerBucket = 1;
+        // frames already in the last, open bucket
+        int64_t openFrames = 0;
+        int64_t frameCount = 0;
+        bool finished = false;
+
+        void accumulate(const float *samples, int32_t frames);
+
+        void mergePairs();
+    };
+}
+
+#endif //SOUNDSOURCE_WAVEFORM_H
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bit_reader.h"
+
+namespace SoundSource::Decoder {
+    BitReader::BitReader(FileReader &reader) : reader(reader) {
+    }
+
+    void BitReader::refill() {
+        size_t available = reader.available();
+        if (available < 8) {
+            available = reader.fill(8);
+        }
+        const uint8_t *p = reader.data();
+        if (available >= 8) {
+            uint64_t value = 0;
+            for (int32_t i = 0; i < 8; i++) {
+                value = value << 8 | p[i];
+            }
+            // the bits below the valid ones are the true stream bits,
+            // so or-ing them in again is harmless
+            cache |= value >> bits;
+            int32_t bytes = (63 - bits) >> 3;
+            reader.advance(bytes);
+            bits += bytes * 8;
+            return;
+        }
+        size_t i = 0;
+        while (bits <= 55 && i < available) {
+            cache |= (uint64_t) p[i++] << (56 - bits);
+            bits += 8;
+        }
+        reader.advance(i);
+    }
+
+    void BitReader::alignToByte() {
+        int32_t drop = bits & 7;
+        cache <<= drop;
+        bits -= drop;
+    }
+
+    void BitReader::reset() {
+        cache = 0;
+        bits = 0;
+        exhausted = false;
+    }
+
+    void BitReader::sync() {
+        alignToByte();
+        reader.seek(reader.position() - bits / 8);
+        cache = 0;
+        bits = 0;
+    }
+
+    int64_t BitReader::position() const {
+        return reader.position() - (bits + 7) / 8;
+    }
+
+    bool BitReader::isExhausted() const {
+        return exhausted;
+    }
+
+    void BitReader::clearExhausted() {
+        exhausted = false;
+    }
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOUNDSOURCE_BIT_READER_H
+#define SOUNDSOURCE_BIT_READER_H
+
+#include <sys/types.h>
+#include <cstdint>
+
+#include "file_reader.h"
+
+namespace SoundSource::Decoder {
+    /**
+     * MSB-first bit reader on top of a FileReader, with a 64-bit cache
+     * refilled eight bytes at a time.
+     *
+     * Reading past the end of file yields zero bits and sets the
+     * exhausted flag, callers check it once per frame instead of on
+     * every read.
+     */
+    class BitReader {
+    public:
+        explicit BitReader(FileReader &reader);
+
+        /**
+         * Read n bits, n in [0, 32].
+         */
+        inline uint32_t readBits(int32_t n) {
+            if (n == 0) {
+                return 0;
+            }
+            if (bits < n) {
+                refill();
+                if (bits < n) {
+                    exhausted = true;
+                    bits = 0;
+                    cache = 0;
+                    return 0;
+                }
+            }
+            auto value = (uint32_t) (cache >> (64 - n));
+            cache <<= n;
+            bits -= n;
+            return value;
+        }
+
+        /**
+         * Read n bits as a two's complement signed value.
+         */
+        inline int32_t readSigned(int32_t n) {
+            if (n == 0) {
+                return 0;
+            }
+            uint32_t value = readBits(n);
+            uint32_t sign = 1u << (n - 1);
+            return (int32_t) ((value ^ sign) - sign);
+        }
+
+        /**
+         * @return the count of zero bits before the next one bit, which
+         * is consumed too.
+         */
+        inline uint32_t readUnary() {
+            uint32_t zeros = 0;
+            while (true) {
+                if (bits == 0) {
+                    refill();
+                    if (bits == 0) {
+                        exhausted = true;
+                        return zeros;
+                    }
+                }
+                int32_t leading = cache == 0 ? 64 : __builtin_clzll(cache);
+                if (leading < bits) {
+                    zeros += leading;
+                    cache <<= leading + 1;
+                    bits -= leading + 1;
+                    return zeros;
+                }
+                zeros += bits;
+                cache <<= bits;
+                bits = 0;
+            }
+        }
+
+        /**
+         * Read a Rice coded signed value.
+         */
+        inline int32_t readRice(int32_t parameter) {
+            uint32_t value = (readUnary() << parameter) | readBits(parameter);
+            return (int32_t) (value >> 1) ^ -(int32_t) (value & 1);
+        }
+
+        void alignToByte();
+
+        /**
+         * Drop the cached bits and continue at the reader's position, after
+         * the reader was moved.
+         */
+        void reset();
+
+        /**
+         * Hand the unread cached bytes back to the reader, so it can be
+         * read directly. Must be byte aligned.
+         */
+        void sync();
+
+        /**
+         * @return the file offset of the next unread bit, rounded down.
+         */
+        int64_t position() const;
+
+        bool isExhausted() const;
+
+        void clearExhausted();
+
+    private:
+        FileReader &reader;
+        uint64_t cache = 0;
+        // valid bits at the top of cache, at most 63
+        int32_t bits = 0;
+        bool exhausted = false;
+
+        void refill();
+    };
+}
+
+#endif //SOUNDSOURCE_BIT_READER_H
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOUNDSOURCE_DECODER_H
+#define SOUNDSOURCE_DECODER_H
+
+#include <sys/types.h>
+#include <cstdint>
+
+namespace SoundSource::Decoder {
+    /**
+     * Decodes an audio stream into interleaved float PCM in range [-1, 1].
+     */
+    class AudioDecoder {
+    public:
+        virtual ~AudioDecoder() = default;
+
+        /**
+         * Prepare the decoder, after which channels() and sampleRate()
+         * are valid.
+         *
+         * @return false if the stream cannot be decoded.
+         */
+        virtual bool open() = 0;
+
+        virtual int32_t channels() const = 0;
+
+        virtual int32_t sampleRate() const = 0;
+
+        /**
+         * Decode up to frames frames into out, which must hold
+         * frames * channels() samples.
+         *
+         * @return the count of frames decoded, 0 at the end of stream,
+         * or -1 on decode error.
+         */
+        virtual int32_t read(float *out, int32_t frames) = 0;
+
+        /**
+         * Continue decoding at the given sample frame.
+         *
+         * @return false if seeking is not supported or the frame is
+         * out of range, the position is then unspecified.
+         */
+        virtual bool seek(int64_t) {
+            return false;
+        }
+    };
+}
+
+#endif //SOUNDSOURCE_DECODER_H
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "decoder_factory.h"
+
+#include "flacfile.h"
+#include "wavfile.h"
+#include "aifffile.h"
+#include "dsffile.h"
+#include "dsdifffile.h"
+
+#include "flac_decoder.h"
+#include "pcm_decoder.h"
+#include "dsd_decoder.h"
+#include "media_decoder.h"
+
+namespace SoundSource::Decoder {
+    namespace {
+        std::unique_ptr<AudioDecoder> openLossless(AudioTagAccessor &accessor) {
+            if (accessor.isNull()) {
+                return nullptr;
+            }
+            TagLib::File *file = accessor.fileRef()->file();
+            int32_t fd = accessor.getFileDescriptor();
+            std::unique_ptr<AudioDecoder> decoder;
+            if (dynamic_cast<TagLib::FLAC::File *>(file) != nullptr) {
+                decoder = std::make_unique<FlacDecoder>(fd);
+            } else if (dynamic_cast<TagLib::RIFF::WAV::File *>(file) != nullptr ||
+                       dynamic_cast<TagLib::RIFF::AIFF::File *>(file) != nullptr) {
+                decoder = std::make_unique<PcmDecoder>(fd);
+            } else if (dynamic_cast<TagLib::DSF::File *>(file) != nullptr ||
+                       dynamic_cast<TagLib::DSDIFF::File *>(file) != nullptr) {
+                decoder = std::make_unique<DsdDecoder>(fd);
+            }
+            if (decoder == nullptr || !decoder->open()) {
+                return nullptr;
+            }
+            return decoder;
+        }
+    }
+
+    std::unique_ptr<AudioDecoder> openDecoder(AudioTagAccessor &accessor) {
+        std::unique_ptr<AudioDecoder> decoder = openLossless(accessor);
+        if (decoder != nullptr) {
+            return decoder;
+        }
+        decoder = std::make_unique<MediaDecoder>(accessor.getFileDescriptor());
+        if (!decoder->open()) {
+            return nullptr;
+        }
+        return decoder;
+    }
+}
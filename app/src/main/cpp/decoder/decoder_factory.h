@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOUNDSOURCE_DECODER_FACTORY_H
+#define SOUNDSOURCE_DECODER_FACTORY_H
+
+#include <memory>
+
+#include <tags/tags.h>
+
+#include "decoder.h"
+
+namespace SoundSource::Decoder {
+    /**
+     * Create and open a decoder for the file of the accessor.
+     *
+     * FLAC, WAV, AIFF and DSD (DSF, DSDIFF) files, as detected by TagLib
+     * when the accessor was opened, are decoded natively through the
+     * accessor's file descriptor; everything else, or a lossless file
+     * the native decoders reject, goes through MediaDecoder.
+     *
+     * @return the opened decoder, or nullptr if the file cannot be decoded.
+     */
+    std::unique_ptr<AudioDecoder> openDecoder(AudioTagAccessor &accessor);
+}
+
+#endif //SOUNDSOURCE_DECODER_FACTORY_H
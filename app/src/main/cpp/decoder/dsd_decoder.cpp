@@ -0,0 +1,305 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "dsd_decoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "logging.h"
+
+namespace SoundSource::Decoder {
+    namespace {
+        constexpr uint32_t DSF_FORMAT_RAW = 0;
+
+        inline uint32_t le32(const uint8_t *p) {
+            return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t) p[3] << 24;
+        }
+
+        inline uint64_t le64(const uint8_t *p) {
+            return le32(p) | (uint64_t) le32(p + 4) << 32;
+        }
+
+        inline uint32_t be32(const uint8_t *p) {
+            return (uint32_t) p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+        }
+
+        inline uint64_t be64(const uint8_t *p) {
+            return (uint64_t) be32(p) << 32 | be32(p + 4);
+        }
+
+        inline uint16_t be16(const uint8_t *p) {
+            return p[0] << 8 | p[1];
+        }
+    }
+
+    DsdDecoder::DsdDecoder(int32_t fileDescriptor) : reader(fileDescriptor) {
+    }
+
+    bool DsdDecoder::open() {
+        uint8_t header[16];
+        if (!reader.read(header, 16)) {
+            return false;
+        }
+        if (memcmp(header, "DSD ", 4) == 0) {
+            dsf = true;
+            // rest of the DSD chunk: file size and metadata pointer
+            reader.skip((int64_t) le64(header + 4) - 16);
+            return openDsf() && validate();
+        }
+        if (memcmp(header, "FRM8", 4) == 0 && memcmp(header + 12, "DSD ", 4) == 0) {
+            return openDsdiff() && validate();
+        }
+        return false;
+    }
+
+    bool DsdDecoder::openDsf() {
+        bool format = false;
+        uint8_t chunk[12];
+        while (reader.read(chunk, 12)) {
+            uint64_t size = le64(chunk + 4);
+            if (size < 12) {
+                return false;
+            }
+            if (memcmp(chunk, "fmt ", 4) == 0) {
+                uint8_t fmt[40];
+                if (size < 12 + sizeof(fmt) || !reader.read(fmt, sizeof(fmt))) {
+                    return false;
+                }
+                reader.skip((int64_t) (size - 12 - sizeof(fmt)));
+                if (le32(fmt + 4) != DSF_FORMAT_RAW) {
+                    LOGD("DsdDecoder: unsupported DSF format %u", le32(fmt + 4));
+                    return false;
+                }
+                channelCount = (int32_t) le32(fmt + 12);
+                rate = (int32_t) le32(fmt + 16);
+                // 1 for LSB first, 8 for MSB first
+                lsbFirst = le32(fmt + 20) == 1;
+                sampleBytes = (int64_t) (le64(fmt + 24) / 8);
+                blockSize = (int32_t) le32(fmt + 32);
+                format = true;
+                continue;
+            }
+            if (memcmp(chunk, "data", 4) == 0) {
+                if (!format || blockSize <= 0) {
+                    return false;
+                }
+                dataOffset = reader.position();
+                // whole block groups the file holds
+                int64_t groupBytes = (int64_t) blockSize * std::max(channelCount, 1);
+                int64_t end = std::min(dataOffset + (int64_t) size - 12, reader.size());
+                int64_t groups = (end - dataOffset + groupBytes - 1) / groupBytes;
+                sampleBytes = std::min(sampleBytes, groups * blockSize);
+                return true;
+            }
+            reader.skip((int64_t) size - 12);
+        }
+        return false;
+    }
+
+    bool DsdDecoder::openDsdiff() {
+        lsbFirst = false;
+        bool compressed = false;
+        uint8_t chunk[12];
+        while (reader.read(chunk, 12)) {
+            uint64_t size = be64(chunk + 4);
+            int64_t end = reader.position() + (int64_t) size + (int64_t) (size & 1);
+            if (memcmp(chunk, "PROP", 4) == 0) {
+                uint8_t type[4];
+                if (size < 4 || !reader.read(type, 4) || memcmp(type, "SND ", 4) != 0) {
+                    return false;
+                }
+                uint8_t property[12];
+                while (reader.position() + 12 <= end && reader.read(property, 12)) {
+                    uint64_t propertySize = be64(property + 4);
+                    int64_t next = reader.position() + (int64_t) propertySize +
+                                   (int64_t) (propertySize & 1);
+                    uint8_t value[4];
+                    size_t length = std::min<size_t>(propertySize, sizeof(value));
+                    if (!reader.read(value, length)) {
+                        return false;
+                    }
+                    if (memcmp(property, "FS  ", 4) == 0 && length == 4) {
+                        rate = (int32_t) be32(value);
+                    } else if (memcmp(property, "CHNL", 4) == 0 && length >= 2) {
+                        channelCount = be16(value);
+                    } else if (memcmp(property, "CMPR", 4) == 0 && length == 4) {
+                        compressed = memcmp(value, "DSD ", 4) != 0;
+                    }
+                    reader.seek(next);
+                }
+                reader.seek(end);
+                continue;
+            }
+            if (memcmp(chunk, "DSD ", 4) == 0) {
+                if (channelCount <= 0) {
+                    return false;
+                }
+                dataOffset = reader.position();
+                int64_t dataEnd = std::min(dataOffset + (int64_t) size, reader.size());
+                sampleBytes = (dataEnd - dataOffset) / channelCount;
+                return true;
+            }
+            if (memcmp(chunk, "DST ", 4) == 0 || compressed) {
+                LOGD("DsdDecoder: DST compressed DSDIFF is not supported");
+                return false;
+            }
+            reader.seek(end);
+        }
+        return false;
+    }
+
+    bool DsdDecoder::validate() {
+        if (channelCount <= 0 || channelCount > kMaxChannels || sampleBytes <= 0) {
+            return false;
+        }
+        int32_t pcmRate = Audio::DsdConverter::defaultPcmRate(rate);
+        if (pcmRate == 0) {
+            LOGD("DsdDecoder: unsupported DSD rate %d", rate);
+            return false;
+        }
+        converter = std::make_unique<Audio::DsdConverter>(channelCount, rate, pcmRate, lsbFirst);
+        if (!converter->isValid()) {
+            return false;
+        }
+        int32_t maxBytes = std::max({blockSize, kChunkBytes, converter->delayBytes()});
+        pending.resize((size_t) converter->maxOutputFrames(maxBytes) * channelCount);
+        silence.assign((size_t) converter->delayBytes() * channelCount,
+                       Audio::DsdConverter::kSilence);
+        return true;
+    }
+
+    int32_t DsdDecoder::channels() const {
+        return channelCount;
+    }
+
+    int32_t DsdDecoder::sampleRate() const {
+        return converter == nullptr ? 0 : converter->pcmRate();
+    }
+
+    int32_t DsdDecoder::dsdRate() const {
+        return rate;
+    }
+
+    int64_t DsdDecoder::totalFrames() const {
+        if (converter == nullptr) {
+            return 0;
+        }
+        return sampleBytes * 8 / converter->decimation();
+    }
+
+    bool DsdDecoder::seek(int64_t frame) {
+        if (converter == nullptr || frame < 0 || frame > totalFrames()) {
+            return false;
+        }
+        // start early enough for the filters to settle on real data,
+        // at a byte that begins a frame
+        const int32_t frameBytes = converter->decimation() / 8;
+        int64_t preroll = std::min<int64_t>(
+                frame, (2 * converter->delayBytes() + frameBytes - 1) / frameBytes);
+        converter->reset();
+        bytePosition = (frame - preroll) * frameBytes;
+        framePosition = frame;
+        discardFrames = preroll;
+        flushed = false;
+        pendingOffset = 0;
+        pendingFrames = 0;
+        return true;
+    }
+
+    bool DsdDecoder::convertNext() {
+        pendingOffset = 0;
+        pendingFrames = 0;
+        if (bytePosition < sampleBytes) {
+            if (dsf) {
+                // block groups hold blockSize bytes of every channel in turn
+                const int64_t groupBytes = (int64_t) blockSize * channelCount;
+                int64_t group = bytePosition / blockSize;
+                auto offset = (int32_t) (bytePosition % blockSize);
+                reader.seek(dataOffset + group * groupBytes);
+                size_t available = reader.fill((size_t) groupBytes);
+                // the last group may be cut short after the last channel's data
+                auto count = (int32_t) std::min<int64_t>(blockSize - offset,
+                                                         sampleBytes - bytePosition);
+                if (available < (size_t) (groupBytes - blockSize + offset + count)) {
+                    LOGD("DsdDecoder: truncated DSF data");
+                    sampleBytes = bytePosition;
+                    return convertNext();
+                }
+                const uint8_t *planes[kMaxChannels];
+                for (int32_t ch = 0; ch < channelCount; ch++) {
+                    planes[ch] = reader.data() + (size_t) ch * blockSize + offset;
+                }
+                pendingFrames = converter->processPlanar(planes, count, pending.data());
+                bytePosition += count;
+            } else {
+                reader.seek(dataOffset + bytePosition * channelCount);
+                auto wanted = (int32_t) std::min<int64_t>(kChunkBytes, sampleBytes - bytePosition);
+                size_t available = reader.fill((size_t) wanted * channelCount);
+                auto count = (int32_t) std::min<size_t>(wanted, available / channelCount);
+                if (count == 0) {
+                    LOGD("DsdDecoder: truncated DSDIFF data");
+                    sampleBytes = bytePosition;
+                    return convertNext();
+                }
+                pendingFrames = converter->process(reader.data(), count, pending.data());
+                bytePosition += count;
+            }
+            return true;
+        }
+        if (!flushed) {
+            flushed = true;
+            pendingFrames = converter->process(silence.data(), converter->delayBytes(),
+                                               pending.data());
+            return true;
+        }
+        return false;
+    }
+
+    int32_t DsdDecoder::read(float *out, int32_t frames) {
+        if (converter == nullptr) {
+            return -1;
+        }
+        const int64_t total = totalFrames();
+        int32_t written = 0;
+        while (written < frames && framePosition < total) {
+            if (pendingOffset == pendingFrames) {
+                if (!convertNext()) {
+                    break;
+                }
+                continue;
+            }
+            if (discardFrames > 0) {
+                auto count = (int32_t) std::min<int64_t>(discardFrames,
+                                                         pendingFrames - pendingOffset);
+                pendingOffset += count;
+                discardFrames -= count;
+                continue;
+            }
+            auto count = (int32_t) std::min<int64_t>(
+                    {(int64_t) frames - written, pendingFrames - pendingOffset,
+                     total - framePosition});
+            memcpy(out + (size_t) written * channelCount,
+                   pending.data() + (size_t) pendingOffset * channelCount,
+                   (size_t) count * channelCount * sizeof(float));
+            pendingOffset += count;
+            framePosition += count;
+            written += count;
+        }
+        return written;
+    }
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_DSD_DECODER_H
+#define SOUNDSOURCE_DSD_DECODER_H
+
+#include <memory>
+#include <vector>
+
+#include "decoder.h"
+#include "dsd_converter.h"
+#include "file_reader.h"
+
+namespace SoundSource::Decoder {
+    /**
+     * Reads uncompressed DSD from DSF and DSDIFF files straight from
+     * the file descriptor and converts it to PCM at 88.2 kHz (96 kHz
+     * for the 48 kHz family), one DSF block group or DSDIFF chunk of
+     * bytes at a time. The descriptor is not owned.
+     *
+     * Supports DSD64, DSD128 and DSD256 with up to 8 channels;
+     * DST compressed DSDIFF is not supported.
+     */
+    class DsdDecoder : public AudioDecoder {
+    public:
+        explicit DsdDecoder(int32_t fileDescriptor);
+
+        bool open() override;
+
+        int32_t channels() const override;
+
+        int32_t sampleRate() const override;
+
+        int32_t read(float *out, int32_t frames) override;
+
+        bool seek(int64_t frame) override;
+
+        /**
+         * @return DSD samples per second per channel.
+         */
+        int32_t dsdRate() const;
+
+        int64_t totalFrames() const;
+
+    private:
+        static constexpr int32_t kMaxChannels = 8;
+        // bytes per channel converted at a time from DSDIFF
+        static constexpr int32_t kChunkBytes = 4096;
+
+        FileReader reader;
+
+        bool dsf = false;
+        int32_t channelCount = 0;
+        int32_t rate = 0;
+        bool lsbFirst = false;
+        // DSF block size per channel
+        int32_t blockSize = 0;
+
+        int64_t dataOffset = 0;
+        // bytes per channel
+        int64_t sampleBytes = 0;
+
+        std::unique_ptr<Audio::DsdConverter> converter;
+
+        // position in bytes per channel
+        int64_t bytePosition = 0;
+        // output position in frames
+        int64_t framePosition = 0;
+        int64_t discardFrames = 0;
+        bool flushed = false;
+
+        std::vector<float> pending;
+        int32_t pendingOffset = 0;
+        int32_t pendingFrames = 0;
+        std::vector<uint8_t> silence;
+
+        bool openDsf();
+
+        bool openDsdiff();
+
+        bool validate();
+
+        /**
+         * Convert the next block into pending.
+         *
+         * @return false at the end of stream.
+         */
+        bool convertNext();
+    };
+}
+
+#endif //SOUNDSOURCE_DSD_DECODER_H
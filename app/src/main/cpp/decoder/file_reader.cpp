@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "file_reader.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace SoundSource::Decoder {
+    FileReader::FileReader(int32_t fileDescriptor, size_t windowSize) {
+        this->fileDescriptor = fileDescriptor;
+        struct stat st;
+        fileSize = fstat(fileDescriptor, &st) == 0 ? st.st_size : -1;
+        window.resize(windowSize);
+        posix_fadvise(fileDescriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    int64_t FileReader::size() const {
+        return fileSize;
+    }
+
+    int64_t FileReader::position() const {
+        return windowOffset + (int64_t) start;
+    }
+
+    void FileReader::seek(int64_t offset) {
+        if (offset >= windowOffset && offset <= windowOffset + (int64_t) end) {
+            start = (size_t) (offset - windowOffset);
+            return;
+        }
+        windowOffset = offset;
+        start = 0;
+        end = 0;
+    }
+
+    size_t FileReader::fill(size_t bytes) {
+        if (end - start >= bytes) {
+            return end - start;
+        }
+        if (bytes > window.size()) {
+            window.resize(bytes);
+        }
+        // keep the unread bytes, then read as much as the window holds
+        size_t unread = end - start;
+        std::memmove(window.data(), window.data() + start, unread);
+        windowOffset += (int64_t) start;
+        start = 0;
+        end = unread;
+        while (end < bytes) {
+            ssize_t n = pread(fileDescriptor, window.data() + end, window.size() - end,
+                              windowOffset + (int64_t) end);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            end += (size_t) n;
+        }
+        return end;
+    }
+
+    const uint8_t *FileReader::data() const {
+        return window.data() + start;
+    }
+
+    size_t FileReader::available() const {
+        return end - start;
+    }
+
+    void FileReader::advance(size_t bytes) {
+        start += std::min(bytes, end - start);
+    }
+
+    void FileReader::skip(int64_t bytes) {
+        if (bytes <= (int64_t) (end - start)) {
+            start += (size_t) bytes;
+            return;
+        }
+        seek(position() + bytes);
+    }
+
+    bool FileReader::read(void *out, size_t bytes) {
+        if (fill(bytes) < bytes) {
+            return false;
+        }
+        std::memcpy(out, data(), bytes);
+        advance(bytes);
+        return true;
+    }
+}
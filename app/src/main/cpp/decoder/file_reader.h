@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOUNDSOURCE_FILE_READER_H
+#define SOUNDSOURCE_FILE_READER_H
+
+#include <sys/types.h>
+#include <cstdint>
+#include <vector>
+
+namespace SoundSource::Decoder {
+    /**
+     * Sequential reader over a file descriptor with a large read window.
+     *
+     * Reads with pread() so the file offset of the descriptor, which
+     * TagLib's FileStream relies on, is never moved. The descriptor is
+     * not owned.
+     */
+    class FileReader {
+    public:
+        static constexpr size_t kDefaultWindow = 256 * 1024;
+
+        explicit FileReader(int32_t fileDescriptor, size_t windowSize = kDefaultWindow);
+
+        /**
+         * @return the file size, or -1 if it cannot be stat'ed.
+         */
+        int64_t size() const;
+
+        /**
+         * @return the file offset of data().
+         */
+        int64_t position() const;
+
+        /**
+         * Move to the given file offset, dropping the window if the
+         * offset is outside of it.
+         */
+        void seek(int64_t offset);
+
+        /**
+         * Make at least bytes bytes available at the current position,
+         * growing the window if needed. Reads as much as the window holds.
+         *
+         * @return the bytes available, less than requested only at the
+         * end of file or on read error.
+         */
+        size_t fill(size_t bytes);
+
+        /**
+         * @return the buffered bytes at the current position.
+         */
+        const uint8_t *data() const;
+
+        size_t available() const;
+
+        /**
+         * Consume bytes, which must not exceed available().
+         */
+        void advance(size_t bytes);
+
+        /**
+         * Consume bytes past the window, seeking if needed.
+         */
+        void skip(int64_t bytes);
+
+        /**
+         * Copy the next bytes out.
+         *
+         * @return false if the file ends before.
+         */
+        bool read(void *out, size_t bytes);
+
+    private:
+        int32_t fileDescriptor;
+        int64_t fileSize;
+
+        std::vector<uint8_t> window;
+        // file offset of window[0]
+        int64_t windowOffset = 0;
+        size_t start = 0;
+        size_t end = 0;
+    };
+}
+
+#endif //SOUNDSOURCE_FILE_READER_H
@@ -0,0 +1,481 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flac_decoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "logging.h"
+
+namespace SoundSource::Decoder {
+    namespace {
+        constexpr int32_t kMaxBitDepth = 24;
+
+        enum ChannelAssignment {
+            LEFT_SIDE = 8,
+            RIGHT_SIDE = 9,
+            MID_SIDE = 10,
+        };
+
+        const int32_t kSampleRates[] = {
+                0, 88200, 176400, 192000, 8000, 16000, 22050, 24000,
+                32000, 44100, 48000, 96000,
+        };
+
+        const int32_t kSampleSizes[] = {0, 8, 12, 0, 16, 20, 24, 32};
+
+        void restoreFixed(int32_t *s, int32_t size, int32_t order) {
+            switch (order) {
+                case 0:
+                    break;
+                case 1:
+                    for (int32_t i = 1; i < size; i++) {
+                        s[i] += s[i - 1];
+                    }
+                    break;
+                case 2:
+                    for (int32_t i = 2; i < size; i++) {
+                        s[i] += 2 * s[i - 1] - s[i - 2];
+                    }
+                    break;
+                case 3:
+                    for (int32_t i = 3; i < size; i++) {
+                        s[i] += 3 * s[i - 1] - 3 * s[i - 2] + s[i - 3];
+                    }
+                    break;
+                default:
+                    for (int32_t i = 4; i < size; i++) {
+                        s[i] += 4 * s[i - 1] - 6 * s[i - 2] + 4 * s[i - 3] - s[i - 4];
+                    }
+                    break;
+            }
+        }
+
+        void restoreLpc(int32_t *s, int32_t size, const int32_t *coefficients,
+                        int32_t order, int32_t shift) {
+            for (int32_t i = order; i < size; i++) {
+                int64_t sum = 0;
+                const int32_t *history = s + i - 1;
+                for (int32_t j = 0; j < order; j++) {
+                    sum += (int64_t) coefficients[j] * history[-j];
+                }
+                s[i] += (int32_t) (sum >> shift);
+            }
+        }
+    }
+
+    FlacDecoder::FlacDecoder(int32_t fileDescriptor)
+            : reader(fileDescriptor), bits(reader) {
+    }
+
+    bool FlacDecoder::open() {
+        if (!readMetadata()) {
+            return false;
+        }
+        if (channelCount < 1 || channelCount > kMaxChannels || rate <= 0 ||
+            bitDepth < 4 || bitDepth > kMaxBitDepth) {
+            LOGD("FlacDecoder: unsupported stream, channels=%d, rate=%d, bits=%d",
+                 channelCount, rate, bitDepth);
+            return false;
+        }
+        int32_t capacity = maxBlockSize > 0 ? maxBlockSize : 65535;
+        for (int32_t ch = 0; ch < channelCount; ch++) {
+            samples[ch].resize(capacity);
+        }
+        bits.reset();
+        return true;
+    }
+
+    int32_t FlacDecoder::channels() const {
+        return channelCount;
+    }
+
+    int32_t FlacDecoder::sampleRate() const {
+        return rate;
+    }
+
+    int32_t FlacDecoder::bitsPerSample() const {
+        return bitDepth;
+    }
+
+    int64_t FlacDecoder::totalFrames() const {
+        return total;
+    }
+
+    int64_t FlacDecoder::firstFrameOffset() const {
+        return firstFrame;
+    }
+
+    bool FlacDecoder::hasSeekTable() const {
+        return seekTable;
+    }
+
+    void FlacDecoder::setSeekIndex(std::shared_ptr<const SeekIndex> index) {
+        seekIndex = std::move(index);
+    }
+
+    bool FlacDecoder::seek(int64_t frame) {
+        if (frame < 0 || (total > 0 && frame >= total)) {
+            return false;
+        }
+        int64_t offset = firstFrame;
+        int64_t start = 0;
+        const SeekPoint *point = seekIndex != nullptr ? seekIndex->locate(frame) : nullptr;
+        if (point != nullptr && point->frame <= frame) {
+            offset = point->offset;
+            start = point->frame;
+        }
+        reader.seek(offset);
+        bits.reset();
+        decodedFrames = start;
+        blockSize = 0;
+        blockOffset = 0;
+        ended = false;
+
+        // decode up to the block holding the frame and drop what is before
+        while (decodedFrames <= frame) {
+            if (decodeFrame() <= 0) {
+                return false;
+            }
+        }
+        blockOffset = (int32_t) (frame - (decodedFrames - blockSize));
+        return true;
+    }
+
+    bool FlacDecoder::readMetadata() {
+        uint8_t header[10];
+        if (!reader.read(header, 4)) {
+            return false;
+        }
+        if (memcmp(header, "ID3", 3) == 0) {
+            // an ID3v2 tag in front of the stream, size is syncsafe
+            if (!reader.read(header + 4, 6)) {
+                return false;
+            }
+            int64_t size = (header[6] & 0x7f) << 21 | (header[7] & 0x7f) << 14 |
+                           (header[8] & 0x7f) << 7 | (header[9] & 0x7f);
+            if (header[5] & 0x10) {
+                size += 10; // footer
+            }
+            reader.skip(size);
+            if (!reader.read(header, 4)) {
+                return false;
+            }
+        }
+        if (memcmp(header, "fLaC", 4) != 0) {
+            return false;
+        }
+
+        bool last = false;
+        bool streamInfo = false;
+        while (!last) {
+            uint8_t block[4];
+            if (!reader.read(block, 4)) {
+                return false;
+            }
+            last = block[0] & 0x80;
+            int32_t type = block[0] & 0x7f;
+            int32_t length = block[1] << 16 | block[2] << 8 | block[3];
+            if (type == 3) {
+                seekTable = true;
+            }
+            if (type != 0) {
+                reader.skip(length);
+                continue;
+            }
+            uint8_t info[34];
+            if (length < 34 || !reader.read(info, 34)) {
+                return false;
+            }
+            reader.skip(length - 34);
+            maxBlockSize = info[2] << 8 | info[3];
+            rate = info[10] << 12 | info[11] << 4 | info[12] >> 4;
+            channelCount = ((info[12] >> 1) & 0x07) + 1;
+            bitDepth = ((info[12] & 0x01) << 4 | info[13] >> 4) + 1;
+            total = (int64_t) (info[13] & 0x0f) << 32 | (uint32_t) (info[14] << 24 |
+                    info[15] << 16 | info[16] << 8 | info[17]);
+            streamInfo = true;
+        }
+        firstFrame = reader.position();
+        return streamInfo;
+    }
+
+    int32_t FlacDecoder::read(float *out, int32_t frames) {
+        const float scale = 1.0f / (float) (1 << (bitDepth - 1));
+        int32_t written = 0;
+        while (written < frames) {
+            if (blockOffset >= blockSize) {
+                if (ended) {
+                    break;
+                }
+                int32_t result = decodeFrame();
+                if (result < 0) {
+                    return -1;
+                }
+                if (result == 0) {
+                    ended = true;
+                    break;
+                }
+                continue;
+            }
+            int32_t count = std::min(frames - written, blockSize - blockOffset);
+            float *o = out + (size_t) written * channelCount;
+            for (int32_t ch = 0; ch < channelCount; ch++) {
+                const int32_t *s = samples[ch].data() + blockOffset;
+                for (int32_t i = 0; i < count; i++) {
+                    o[i * channelCount + ch] = (float) s[i] * scale;
+                }
+            }
+            blockOffset += count;
+            written += count;
+        }
+        return written;
+    }
+
+    bool FlacDecoder::findSync() {
+        bits.sync();
+        while (true) {
+            size_t available = reader.fill(2);
+            if (available < 2) {
+                return false;
+            }
+            const uint8_t *p = reader.data();
+            size_t i = 0;
+            for (; i + 1 < available; i++) {
+                if (p[i] == 0xff && (p[i + 1] & 0xfe) == 0xf8) {
+                    reader.advance(i);
+                    return true;
+                }
+            }
+            reader.advance(i);
+        }
+    }
+
+    int32_t FlacDecoder::decodeFrame() {
+        if (total > 0 && decodedFrames >= total) {
+            return 0;
+        }
+        if (!findSync()) {
+            return 0;
+        }
+        bits.clearExhausted();
+
+        bits.readBits(15); // sync code and reserved bit
+        bits.readBits(1); // blocking strategy
+        uint32_t blockSizeCode = bits.readBits(4);
+        uint32_t rateCode = bits.readBits(4);
+        uint32_t assignment = bits.readBits(4);
+        uint32_t sizeCode = bits.readBits(3);
+        bits.readBits(1);
+
+        // frame or sample number, UTF-8 like coding
+        uint32_t lead = bits.readBits(8);
+        int32_t extra = 0;
+        while (extra < 7 && (lead & (0x80 >> extra))) {
+            extra++;
+        }
+        for (int32_t i = 1; i < extra; i++) {
+            bits.readBits(8);
+        }
+
+        int32_t size;
+        if (blockSizeCode == 1) {
+            size = 192;
+        } else if (blockSizeCode >= 2 && blockSizeCode <= 5) {
+            size = 576 << (blockSizeCode - 2);
+        } else if (blockSizeCode == 6) {
+            size = (int32_t) bits.readBits(8) + 1;
+        } else if (blockSizeCode == 7) {
+            size = (int32_t) bits.readBits(16) + 1;
+        } else if (blockSizeCode >= 8) {
+            size = 256 << (blockSizeCode - 8);
+        } else {
+            return -1;
+        }
+        if (rateCode == 12) {
+            bits.readBits(8);
+        } else if (rateCode == 13 || rateCode == 14) {
+            bits.readBits(16);
+        } else if (rateCode == 15) {
+            return -1;
+        }
+        bits.readBits(8); // CRC-8
+
+        int32_t sampleBits = sizeCode == 0 ? bitDepth : kSampleSizes[sizeCode];
+        int32_t frameChannels = assignment < 8 ? (int32_t) assignment + 1 : 2;
+        if (sampleBits != bitDepth || frameChannels != channelCount || assignment > MID_SIDE) {
+            LOGD("FlacDecoder: frame format differs from STREAMINFO");
+            return -1;
+        }
+        if (size > (int32_t) samples[0].size()) {
+            for (int32_t ch = 0; ch < channelCount; ch++) {
+                samples[ch].resize(size);
+            }
+        }
+
+        for (int32_t ch = 0; ch < channelCount; ch++) {
+            // the side channel carries one more bit
+            int32_t channelBits = sampleBits;
+            if ((assignment == LEFT_SIDE && ch == 1) ||
+                (assignment == RIGHT_SIDE && ch == 0) ||
+                (assignment == MID_SIDE && ch == 1)) {
+                channelBits++;
+            }
+            if (!decodeSubframe(samples[ch].data(), size, channelBits)) {
+                return -1;
+            }
+        }
+        bits.alignToByte();
+        bits.readBits(16); // CRC-16
+        if (bits.isExhausted()) {
+            // truncated last frame
+            return 0;
+        }
+
+        int32_t *left = samples[0].data();
+        int32_t *right = channelCount > 1 ? samples[1].data() : nullptr;
+        switch (assignment) {
+            case LEFT_SIDE:
+                for (int32_t i = 0; i < size; i++) {
+                    right[i] = left[i] - right[i];
+                }
+                break;
+            case RIGHT_SIDE:
+                for (int32_t i = 0; i < size; i++) {
+                    left[i] += right[i];
+                }
+                break;
+            case MID_SIDE:
+                for (int32_t i = 0; i < size; i++) {
+                    int32_t side = right[i];
+                    int32_t mid = (left[i] << 1) | (side & 1);
+                    left[i] = (mid + side) >> 1;
+                    right[i] = (mid - side) >> 1;
+                }
+                break;
+            default:
+                break;
+        }
+
+        if (total > 0 && decodedFrames + size > total) {
+            size = (int32_t) (total - decodedFrames);
+        }
+        decodedFrames += size;
+        blockSize = size;
+        blockOffset = 0;
+        return 1;
+    }
+
+    bool FlacDecoder::decodeSubframe(int32_t *out, int32_t size, int32_t sampleBits) {
+        bits.readBits(1); // padding
+        uint32_t type = bits.readBits(6);
+        int32_t wasted = 0;
+        if (bits.readBits(1)) {
+            wasted = (int32_t) bits.readUnary() + 1;
+            if (wasted >= sampleBits) {
+                return false;
+            }
+            sampleBits -= wasted;
+        }
+
+        if (type == 0) {
+            int32_t value = bits.readSigned(sampleBits);
+            std::fill(out, out + size, value);
+        } else if (type == 1) {
+            for (int32_t i = 0; i < size; i++) {
+                out[i] = bits.readSigned(sampleBits);
+            }
+        } else if (type >= 8 && type <= 12) {
+            auto order = (int32_t) (type - 8);
+            if (order > size) {
+                return false;
+            }
+            for (int32_t i = 0; i < order; i++) {
+                out[i] = bits.readSigned(sampleBits);
+            }
+            if (!decodeResidual(out, size, order)) {
+                return false;
+            }
+            restoreFixed(out, size, order);
+        } else if (type >= 32) {
+            auto order = (int32_t) (type - 31);
+            if (order > size) {
+                return false;
+            }
+            for (int32_t i = 0; i < order; i++) {
+                out[i] = bits.readSigned(sampleBits);
+            }
+            int32_t precision = (int32_t) bits.readBits(4) + 1;
+            int32_t shift = bits.readSigned(5);
+            if (precision == 16 || shift < 0) {
+                return false;
+            }
+            int32_t coefficients[32];
+            for (int32_t i = 0; i < order; i++) {
+                coefficients[i] = bits.readSigned(precision);
+            }
+            if (!decodeResidual(out, size, order)) {
+                return false;
+            }
+            restoreLpc(out, size, coefficients, order, shift);
+        } else {
+            return false;
+        }
+
+        if (wasted > 0) {
+            for (int32_t i = 0; i < size; i++) {
+                out[i] = (int32_t) ((uint32_t) out[i] << wasted);
+            }
+        }
+        return !bits.isExhausted();
+    }
+
+    bool FlacDecoder::decodeResidual(int32_t *out, int32_t size, int32_t order) {
+        uint32_t method = bits.readBits(2);
+        if (method > 1) {
+            return false;
+        }
+        const int32_t parameterBits = method == 0 ? 4 : 5;
+        const uint32_t escape = method == 0 ? 15 : 31;
+        int32_t partitionOrder = (int32_t) bits.readBits(4);
+        int32_t partitions = 1 << partitionOrder;
+        if ((size >> partitionOrder) < order || (size & (partitions - 1)) != 0) {
+            return false;
+        }
+
+        int32_t *r = out + order;
+        for (int32_t p = 0; p < partitions; p++) {
+            int32_t count = (size >> partitionOrder) - (p == 0 ? order : 0);
+            uint32_t parameter = bits.readBits(parameterBits);
+            if (parameter == escape) {
+                int32_t rawBits = (int32_t) bits.readBits(5);
+                for (int32_t i = 0; i < count; i++) {
+                    r[i] = bits.readSigned(rawBits);
+                }
+            } else {
+                for (int32_t i = 0; i < count; i++) {
+                    r[i] = bits.readRice((int32_t) parameter);
+                }
+            }
+            r += count;
+            if (bits.isExhausted()) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOUNDSOURCE_FLAC_DECODER_H
+#define SOUNDSOURCE_FLAC_DECODER_H
+
+#include <memory>
+#include <vector>
+
+#include "decoder.h"
+#include "bit_reader.h"
+#include "file_reader.h"
+#include "seek_index.h"
+
+namespace SoundSource::Decoder {
+    /**
+     * Native FLAC decoder reading straight from the file descriptor,
+     * for streams up to 24 bits and 8 channels. The descriptor is not
+     * owned.
+     *
+     * CRCs are not verified; a corrupted frame makes read() fail.
+     */
+    class FlacDecoder : public AudioDecoder {
+    public:
+        explicit FlacDecoder(int32_t fileDescriptor);
+
+        bool open() override;
+
+        int32_t channels() const override;
+
+        int32_t sampleRate() const override;
+
+        int32_t read(float *out, int32_t frames) override;
+
+        /**
+         * Seek sample accurately, starting from the nearest point of the
+         * seek index if one is set, or from the first frame otherwise.
+         */
+        bool seek(int64_t frame) override;
+
+        void setSeekIndex(std::shared_ptr<const SeekIndex> index);
+
+        int32_t bitsPerSample() const;
+
+        /**
+         * @return the total frames from STREAMINFO, 0 if unknown.
+         */
+        int64_t totalFrames() const;
+
+        /**
+         * @return the file offset of the first audio frame.
+         */
+        int64_t firstFrameOffset() const;
+
+        bool hasSeekTable() const;
+
+    private:
+        static constexpr int32_t kMaxChannels = 8;
+
+        FileReader reader;
+        BitReader bits;
+
+        int32_t channelCount = 0;
+        int32_t rate = 0;
+        int32_t bitDepth = 0;
+        int32_t maxBlockSize = 0;
+        int64_t total = 0;
+        int64_t decodedFrames = 0;
+        int64_t firstFrame = 0;
+        bool seekTable = false;
+        std::shared_ptr<const SeekIndex> seekIndex;
+
+        // decoded block, one buffer per channel
+        std::vector<int32_t> samples[kMaxChannels];
+        int32_t blockSize = 0;
+        int32_t blockOffset = 0;
+        bool ended = false;
+
+        bool readMetadata();
+
+        /**
+         * @return 1 if a frame was decoded, 0 at the end of stream, -1 on error.
+         */
+        int32_t decodeFrame();
+
+        bool findSync();
+
+        bool decodeSubframe(int32_t *out, int32_t size, int32_t sampleBits);
+
+        bool decodeResidual(int32_t *out, int32_t size, int32_t order);
+    };
+}
+
+#endif //SOUNDSOURCE_FLAC_DECODER_H
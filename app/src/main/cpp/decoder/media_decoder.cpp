@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "media_decoder.h"
+
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstring>
+
+#include "logging.h"
+
+// Keys not declared before API 28 but honored by earlier decoders.
+#define KEY_PCM_ENCODING "pcm-encoding"
+#define PCM_ENCODING_16BIT 2
+#define PCM_ENCODING_FLOAT 4
+
+namespace SoundSource::Decoder {
+    namespace {
+        constexpr int64_t kDequeueTimeoutUs = 10000;
+    }
+
+    MediaDecoder::MediaDecoder(int32_t fileDescriptor) {
+        this->fileDescriptor = fileDescriptor;
+    }
+
+    MediaDecoder::~MediaDecoder() {
+        if (codec != nullptr) {
+            AMediaCodec_stop(codec);
+            AMediaCodec_delete(codec);
+        }
+        if (extractor != nullptr) {
+            AMediaExtractor_delete(extractor);
+        }
+    }
+
+    bool MediaDecoder::open() {
+        struct stat st;
+        if (fstat(fileDescriptor, &st) != 0) {
+            return false;
+        }
+        extractor = AMediaExtractor_new();
+        if (AMediaExtractor_setDataSourceFd(extractor, fileDescriptor, 0, st.st_size) != AMEDIA_OK) {
+            LOGD("MediaDecoder: cannot set data source fd=%d", fileDescriptor);
+            return false;
+        }
+
+        size_t trackCount = AMediaExtractor_getTrackCount(extractor);
+        for (size_t i = 0; i < trackCount; i++) {
+            AMediaFormat *format = AMediaExtractor_getTrackFormat(extractor, i);
+            const char *mime = nullptr;
+            if (!AMediaFormat_getString(format, AMEDIAFORMAT_KEY_MIME, &mime) ||
+                strncmp(mime, "audio/", 6) != 0) {
+                AMediaFormat_delete(format);
+                continue;
+            }
+            AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_CHANNEL_COUNT, &channelCount);
+            AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_SAMPLE_RATE, &rate);
+            AMediaFormat_setInt32(format, KEY_PCM_ENCODING, PCM_ENCODING_FLOAT);
+
+            codec = AMediaCodec_createDecoderByType(mime);
+            bool configured = codec != nullptr &&
+                              AMediaCodec_configure(codec, format, nullptr, nullptr, 0) == AMEDIA_OK &&
+                              AMediaCodec_start(codec) == AMEDIA_OK;
+            AMediaFormat_delete(format);
+            if (!configured) {
+                LOGD("MediaDecoder: cannot start decoder for %s", mime);
+                if (codec != nullptr) {
+                    AMediaCodec_delete(codec);
+                    codec = nullptr;
+                }
+                return false;
+            }
+            AMediaExtractor_selectTrack(extractor, i);
+            updateOutputFormat();
+            opened = true;
+            return channelCount > 0 && rate > 0;
+        }
+        return false;
+    }
+
+    int32_t MediaDecoder::channels() const {
+        return channelCount;
+    }
+
+    int32_t MediaDecoder::sampleRate() const {
+        return rate;
+    }
+
+    int32_t MediaDecoder::read(float *out, int32_t frames) {
+        if (codec == nullptr) {
+            return -1;
+        }
+        size_t wanted = (size_t) frames * channelCount;
+        size_t written = 0;
+        while (written < wanted) {
+            if (pendingOffset < pending.size()) {
+                size_t count = std::min(wanted - written, pending.size() - pendingOffset);
+                memcpy(out + written, pending.data() + pendingOffset, count * sizeof(float));
+                pendingOffset += count;
+                written += count;
+                continue;
+            }
+            if (outputEnded) {
+                break;
+            }
+            feedInput();
+            if (!drainOutput()) {
+                return -1;
+            }
+        }
+        return (int32_t) (written / channelCount);
+    }
+
+    void MediaDecoder::feedInput() {
+        if (inputEnded) {
+            return;
+        }
+        ssize_t index = AMediaCodec_dequeueInputBuffer(codec, kDequeueTimeoutUs);
+        if (index < 0) {
+            return;
+        }
+        size_t capacity = 0;
+        uint8_t *buffer = AMediaCodec_getInputBuffer(codec, index, &capacity);
+        ssize_t size = AMediaExtractor_readSampleData(extractor, buffer, capacity);
+        if (size < 0) {
+            inputEnded = true;
+            AMediaCodec_queueInputBuffer(codec, index, 0, 0, 0,
+                                         AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM);
+            return;
+        }
+        int64_t time = AMediaExtractor_getSampleTime(extractor);
+        AMediaCodec_queueInputBuffer(codec, index, 0, size, time, 0);
+        AMediaExtractor_advance(extractor);
+    }
+
+    bool MediaDecoder::drainOutput() {
+        AMediaCodecBufferInfo info;
+        ssize_t index = AMediaCodec_dequeueOutputBuffer(codec, &info, kDequeueTimeoutUs);
+        if (index == AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED) {
+            updateOutputFormat();
+            return !formatError;
+        }
+        if (index < 0) {
+            // try again later, or output buffers changed
+            return true;
+        }
+
+        size_t capacity = 0;
+        uint8_t *buffer = AMediaCodec_getOutputBuffer(codec, index, &capacity);
+        if (buffer == nullptr) {
+            AMediaCodec_releaseOutputBuffer(codec, index, false);
+            return false;
+        }
+        const uint8_t *data = buffer + info.offset;
+        pending.clear();
+        pendingOffset = 0;
+        if (floatOutput) {
+            size_t count = info.size / sizeof(float);
+            pending.resize(count);
+            memcpy(pending.data(), data, count * sizeof(float));
+        } else {
+            size_t count = info.size / sizeof(int16_t);
+            pending.resize(count);
+            const auto *samples = (const int16_t *) data;
+            for (size_t i = 0; i < count; i++) {
+                pending[i] = samples[i] * (1.0f / 32768.0f);
+            }
+        }
+        AMediaCodec_releaseOutputBuffer(codec, index, false);
+
+        if (info.flags & AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM) {
+            outputEnded = true;
+        }
+        return true;
+    }
+
+    void MediaDecoder::updateOutputFormat() {
+        AMediaFormat *format = AMediaCodec_getOutputFormat(codec);
+        if (format == nullptr) {
+            return;
+        }
+        int32_t value = 0;
+        if (AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_CHANNEL_COUNT, &value) && value > 0) {
+            // callers size their buffers by the channels reported after open()
+            formatError = opened && value != channelCount;
+            channelCount = value;
+        }
+        if (AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_SAMPLE_RATE, &value) && value > 0) {
+            rate = value;
+        }
+        int32_t encoding = PCM_ENCODING_16BIT;
+        AMediaFormat_getInt32(format, KEY_PCM_ENCODING, &encoding);
+        floatOutput = encoding == PCM_ENCODING_FLOAT;
+        AMediaFormat_delete(format);
+    }
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOUNDSOURCE_MEDIA_DECODER_H
+#define SOUNDSOURCE_MEDIA_DECODER_H
+
+#include <vector>
+
+#include <media/NdkMediaCodec.h>
+#include <media/NdkMediaExtractor.h>
+
+#include "decoder.h"
+
+namespace SoundSource::Decoder {
+    /**
+     * Decodes any format supported by the platform through
+     * NdkMediaExtractor and NdkMediaCodec, reading from the given
+     * file descriptor. The descriptor is not owned.
+     */
+    class MediaDecoder : public AudioDecoder {
+    public:
+        explicit MediaDecoder(int32_t fileDescriptor);
+
+        ~MediaDecoder() override;
+
+        bool open() override;
+
+        int32_t channels() const override;
+
+        int32_t sampleRate() const override;
+
+        int32_t read(float *out, int32_t frames) override;
+
+    private:
+        int32_t fileDescriptor;
+        AMediaExtractor *extractor = nullptr;
+        AMediaCodec *codec = nullptr;
+
+        int32_t channelCount = 0;
+        int32_t rate = 0;
+        bool floatOutput = false;
+        bool opened = false;
+        bool formatError = false;
+        bool inputEnded = false;
+        bool outputEnded = false;
+
+        // decoded samples not yet returned by read()
+        std::vector<float> pending;
+        size_t pendingOffset = 0;
+
+        void feedInput();
+
+        /**
+         * @return false on decode error.
+         */
+        bool drainOutput();
+
+        void updateOutputFormat();
+    };
+}
+
+#endif //SOUNDSOURCE_MEDIA_DECODER_H
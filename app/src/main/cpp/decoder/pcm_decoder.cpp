@@ -0,0 +1,315 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pcm_decoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "logging.h"
+
+namespace SoundSource::Decoder {
+    namespace {
+        constexpr uint16_t WAVE_FORMAT_PCM = 0x0001;
+        constexpr uint16_t WAVE_FORMAT_IEEE_FLOAT = 0x0003;
+        constexpr uint16_t WAVE_FORMAT_EXTENSIBLE = 0xfffe;
+
+        inline uint32_t le32(const uint8_t *p) {
+            return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t) p[3] << 24;
+        }
+
+        inline uint16_t le16(const uint8_t *p) {
+            return p[0] | p[1] << 8;
+        }
+
+        inline uint32_t be32(const uint8_t *p) {
+            return (uint32_t) p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+        }
+
+        inline uint16_t be16(const uint8_t *p) {
+            return p[0] << 8 | p[1];
+        }
+
+        /**
+         * Decode the 80-bit IEEE extended sample rate of AIFF.
+         */
+        double extended(const uint8_t *p) {
+            int32_t exponent = ((p[0] & 0x7f) << 8 | p[1]) - 16383;
+            uint64_t mantissa = 0;
+            for (int32_t i = 2; i < 10; i++) {
+                mantissa = mantissa << 8 | p[i];
+            }
+            double value = std::ldexp((double) mantissa, exponent - 63);
+            return (p[0] & 0x80) ? -value : value;
+        }
+
+        template<int32_t Bytes, bool BigEndian>
+        inline int32_t readInt(const uint8_t *p) {
+            // left aligned to 32 bits
+            uint32_t value = 0;
+            for (int32_t i = 0; i < Bytes; i++) {
+                uint32_t b = BigEndian ? p[i] : p[Bytes - 1 - i];
+                value |= b << (24 - 8 * i);
+            }
+            return (int32_t) value;
+        }
+
+        template<int32_t Bytes, bool BigEndian>
+        void convertInt(const uint8_t *in, float *out, size_t count, bool isUnsigned) {
+            const float scale = 1.0f / 2147483648.0f;
+            const uint32_t bias = isUnsigned ? 0x80000000u : 0;
+            for (size_t i = 0; i < count; i++) {
+                auto value = (int32_t) ((uint32_t) readInt<Bytes, BigEndian>(in) ^ bias);
+                out[i] = (float) value * scale;
+                in += Bytes;
+            }
+        }
+
+        template<bool BigEndian>
+        void convertFloat(const uint8_t *in, float *out, size_t count, int32_t bytes) {
+            for (size_t i = 0; i < count; i++) {
+                uint8_t b[8];
+                for (int32_t k = 0; k < bytes; k++) {
+                    b[k] = BigEndian ? in[bytes - 1 - k] : in[k];
+                }
+                if (bytes == 4) {
+                    float f;
+                    memcpy(&f, b, 4);
+                    out[i] = f;
+                } else {
+                    double d;
+                    memcpy(&d, b, 8);
+                    out[i] = (float) d;
+                }
+                in += bytes;
+            }
+        }
+
+        template<bool BigEndian>
+        void convertInt(const uint8_t *in, float *out, size_t count,
+                        int32_t bytes, bool isUnsigned) {
+            switch (bytes) {
+                case 1:
+                    convertInt<1, BigEndian>(in, out, count, isUnsigned);
+                    break;
+                case 2:
+                    convertInt<2, BigEndian>(in, out, count, isUnsigned);
+                    break;
+                case 3:
+                    convertInt<3, BigEndian>(in, out, count, isUnsigned);
+                    break;
+                default:
+                    convertInt<4, BigEndian>(in, out, count, isUnsigned);
+                    break;
+            }
+        }
+    }
+
+    PcmDecoder::PcmDecoder(int32_t fileDescriptor) : reader(fileDescriptor) {
+    }
+
+    bool PcmDecoder::open() {
+        uint8_t header[12];
+        if (!reader.read(header, 12)) {
+            return false;
+        }
+        if (memcmp(header, "RIFF", 4) == 0 && memcmp(header + 8, "WAVE", 4) == 0) {
+            return openWave() && validate();
+        }
+        if (memcmp(header, "FORM", 4) == 0) {
+            if (memcmp(header + 8, "AIFF", 4) == 0) {
+                return openAiff(false) && validate();
+            }
+            if (memcmp(header + 8, "AIFC", 4) == 0) {
+                return openAiff(true) && validate();
+            }
+        }
+        return false;
+    }
+
+    bool PcmDecoder::openWave() {
+        bool format = false;
+        uint8_t chunk[8];
+        while (reader.read(chunk, 8)) {
+            uint32_t size = le32(chunk + 4);
+            if (memcmp(chunk, "fmt ", 4) == 0) {
+                uint8_t fmt[40] = {};
+                size_t length = std::min<size_t>(size, sizeof(fmt));
+                if (size < 16 || !reader.read(fmt, length)) {
+                    return false;
+                }
+                reader.skip((int64_t) (size - length) + (size & 1));
+                uint16_t tag = le16(fmt);
+                if (tag == WAVE_FORMAT_EXTENSIBLE && size >= 40) {
+                    // first two bytes of the sub format GUID
+                    tag = le16(fmt + 24);
+                }
+                channelCount = le16(fmt + 2);
+                rate = (int32_t) le32(fmt + 4);
+                bytesPerSample = channelCount > 0 ? le16(fmt + 12) / channelCount : 0;
+                bitDepth = le16(fmt + 14);
+                if (tag == WAVE_FORMAT_PCM) {
+                    encoding = bytesPerSample == 1 ? Encoding::UNSIGNED : Encoding::SIGNED;
+                } else if (tag == WAVE_FORMAT_IEEE_FLOAT) {
+                    encoding = Encoding::FLOAT;
+                } else {
+                    LOGD("PcmDecoder: unsupported WAVE format %#x", tag);
+                    return false;
+                }
+                format = true;
+                continue;
+            }
+            if (memcmp(chunk, "data", 4) == 0) {
+                if (!format) {
+                    return false;
+                }
+                dataOffset = reader.position();
+                // streamed files leave the size unset
+                int64_t end = size == 0 || size == 0xffffffff
+                              ? reader.size() : dataOffset + size;
+                dataEnd = std::min(end, reader.size());
+                return true;
+            }
+            reader.skip((int64_t) size + (size & 1));
+        }
+        return false;
+    }
+
+    bool PcmDecoder::openAiff(bool compressed) {
+        bigEndian = true;
+        bool common = false;
+        uint8_t chunk[8];
+        while (reader.read(chunk, 8)) {
+            uint32_t size = be32(chunk + 4);
+            if (memcmp(chunk, "COMM", 4) == 0) {
+                uint8_t comm[22] = {};
+                size_t length = std::min<size_t>(size, sizeof(comm));
+                if (size < 18 || !reader.read(comm, length)) {
+                    return false;
+                }
+                reader.skip((int64_t) (size - length) + (size & 1));
+                channelCount = be16(comm);
+                bitDepth = be16(comm + 6);
+                rate = (int32_t) std::lround(extended(comm + 8));
+                bytesPerSample = (bitDepth + 7) / 8;
+                encoding = Encoding::SIGNED;
+                if (compressed && size >= 22) {
+                    if (memcmp(comm + 18, "sowt", 4) == 0) {
+                        bigEndian = false;
+                    } else if (memcmp(comm + 18, "fl32", 4) == 0 ||
+                               memcmp(comm + 18, "FL32", 4) == 0) {
+                        encoding = Encoding::FLOAT;
+                        bitDepth = 32;
+                        bytesPerSample = 4;
+                    } else if (memcmp(comm + 18, "fl64", 4) == 0 ||
+                               memcmp(comm + 18, "FL64", 4) == 0) {
+                        encoding = Encoding::FLOAT;
+                        bitDepth = 64;
+                        bytesPerSample = 8;
+                    } else if (memcmp(comm + 18, "NONE", 4) != 0) {
+                        LOGD("PcmDecoder: unsupported AIFF-C compression");
+                        return false;
+                    }
+                }
+                common = true;
+                continue;
+            }
+            if (memcmp(chunk, "SSND", 4) == 0) {
+                uint8_t ssnd[8];
+                if (!common || size < 8 || !reader.read(ssnd, 8)) {
+                    return false;
+                }
+                reader.skip(be32(ssnd));
+                dataOffset = reader.position();
+                dataEnd = std::min(dataOffset - 8 - (int64_t) be32(ssnd) + size, reader.size());
+                return true;
+            }
+            reader.skip((int64_t) size + (size & 1));
+        }
+        return false;
+    }
+
+    bool PcmDecoder::validate() {
+        if (channelCount <= 0 || rate <= 0 || dataEnd <= dataOffset) {
+            return false;
+        }
+        if (encoding == Encoding::FLOAT) {
+            return bytesPerSample == 4 || bytesPerSample == 8;
+        }
+        return bytesPerSample >= 1 && bytesPerSample <= 4;
+    }
+
+    int32_t PcmDecoder::channels() const {
+        return channelCount;
+    }
+
+    int32_t PcmDecoder::sampleRate() const {
+        return rate;
+    }
+
+    int32_t PcmDecoder::bitsPerSample() const {
+        return bitDepth;
+    }
+
+    int64_t PcmDecoder::totalFrames() const {
+        return (dataEnd - dataOffset) / ((int64_t) bytesPerSample * channelCount);
+    }
+
+    bool PcmDecoder::seek(int64_t frame) {
+        if (frame < 0 || frame > totalFrames()) {
+            return false;
+        }
+        reader.seek(dataOffset + frame * bytesPerSample * channelCount);
+        return true;
+    }
+
+    int32_t PcmDecoder::read(float *out, int32_t frames) {
+        const size_t frameBytes = (size_t) bytesPerSample * channelCount;
+        int32_t written = 0;
+        while (written < frames) {
+            int64_t remaining = (dataEnd - reader.position()) / (int64_t) frameBytes;
+            if (remaining <= 0) {
+                break;
+            }
+            size_t wanted = (size_t) std::min<int64_t>(frames - written, remaining) * frameBytes;
+            size_t available = reader.fill(std::min(wanted, FileReader::kDefaultWindow));
+            int32_t count = (int32_t) (std::min(available, wanted) / frameBytes);
+            if (count == 0) {
+                // truncated file
+                break;
+            }
+            const uint8_t *in = reader.data();
+            float *o = out + (size_t) written * channelCount;
+            size_t n = (size_t) count * channelCount;
+            bool isUnsigned = encoding == Encoding::UNSIGNED;
+            if (encoding == Encoding::FLOAT) {
+                if (bigEndian) {
+                    convertFloat<true>(in, o, n, bytesPerSample);
+                } else {
+                    convertFloat<false>(in, o, n, bytesPerSample);
+                }
+            } else if (bigEndian) {
+                convertInt<true>(in, o, n, bytesPerSample, isUnsigned);
+            } else {
+                convertInt<false>(in, o, n, bytesPerSample, isUnsigned);
+            }
+            reader.advance((size_t) count * frameBytes);
+            written += count;
+        }
+        return written;
+    }
+}
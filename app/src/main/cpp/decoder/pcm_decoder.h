@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOUNDSOURCE_PCM_DECODER_H
+#define SOUNDSOURCE_PCM_DECODER_H
+
+#include "decoder.h"
+#include "file_reader.h"
+
+namespace SoundSource::Decoder {
+    /**
+     * Reads uncompressed PCM from WAV (RIFF/WAVE, including
+     * WAVE_FORMAT_EXTENSIBLE) and AIFF/AIFF-C files straight from the
+     * file descriptor. The descriptor is not owned.
+     *
+     * Supports 8 to 32-bit integer and 32/64-bit float samples in
+     * either byte order.
+     */
+    class PcmDecoder : public AudioDecoder {
+    public:
+        explicit PcmDecoder(int32_t fileDescriptor);
+
+        bool open() override;
+
+        int32_t channels() const override;
+
+        int32_t sampleRate() const override;
+
+        int32_t read(float *out, int32_t frames) override;
+
+        bool seek(int64_t frame) override;
+
+        int32_t bitsPerSample() const;
+
+        int64_t totalFrames() const;
+
+    private:
+        enum class Encoding {
+            UNSIGNED,
+            SIGNED,
+            FLOAT,
+        };
+
+        FileReader reader;
+
+        int32_t channelCount = 0;
+        int32_t rate = 0;
+        int32_t bitDepth = 0;
+        int32_t bytesPerSample = 0;
+        Encoding encoding = Encoding::SIGNED;
+        bool bigEndian = false;
+
+        int64_t dataOffset = 0;
+        int64_t dataEnd = 0;
+
+        bool openWave();
+
+        bool openAiff(bool compressed);
+
+        bool validate();
+    };
+}
+
+#endif //SOUNDSOURCE_PCM_DECODER_H
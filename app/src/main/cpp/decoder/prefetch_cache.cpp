@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "prefetch_cache.h"
+
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+
+#include "decoder_factory.h"
+#include "logging.h"
+
+namespace SoundSource::Decoder {
+    namespace {
+        constexpr int32_t kReadFrames = 4096;
+
+        int64_t nowNanos() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        int64_t bytesOf(const std::vector<float> &buffer) {
+            return (int64_t) (buffer.size() * sizeof(float));
+        }
+    }
+
+    PrefetchCache::PrefetchCache(int64_t budgetBytes) : budget(std::max<int64_t>(budgetBytes, 0)) {
+    }
+
+    int32_t PrefetchCache::rankOf(int64_t key) const {
+        auto it = std::find(queue.begin(), queue.end(), key);
+        return it == queue.end() ? -1 : (int32_t) (it - queue.begin());
+    }
+
+    void PrefetchCache::setQueue(const int64_t *keys, int32_t count) {
+        // destroyed after the lock is released, closing the files
+        std::vector<std::unique_ptr<PrefetchEntry>> evicted;
+        std::lock_guard<std::mutex> guard(lock);
+        queue.assign(keys, keys + std::max(count, 0));
+        for (auto it = entries.begin(); it != entries.end();) {
+            int32_t rank = rankOf((*it)->key);
+            if (rank >= 0) {
+                (*it)->rank = rank;
+                ++it;
+                continue;
+            }
+            liveBytes -= bytesOf((*it)->head);
+            release(std::move((*it)->head));
+            evicted.push_back(std::move(*it));
+            it = entries.erase(it);
+            evictions++;
+        }
+    }
+
+    bool PrefetchCache::makeRoom(int64_t bytes, int32_t rank,
+                                 std::vector<std::unique_ptr<PrefetchEntry>> &evicted) {
+        while (liveBytes + bytes > budget) {
+            auto last = std::max_element(entries.begin(), entries.end(), [](auto &a, auto &b) {
+                return a->rank < b->rank;
+            });
+            // never drop a likelier track for a less likely one
+            if (last == entries.end() || (*last)->rank <= rank) {
+                return false;
+            }
+            liveBytes -= bytesOf((*last)->head);
+            release(std::move((*last)->head));
+            evicted.push_back(std::move(*last));
+            entries.erase(last);
+            evictions++;
+        }
+        return true;
+    }
+
+    std::vector<float> PrefetchCache::obtainBuffer(size_t samples) {
+        auto best = pool.end();
+        for (auto it = pool.begin(); it != pool.end(); ++it) {
+            if (it->capacity() >= samples &&
+                (best == pool.end() || it->capacity() < best->capacity())) {
+                best = it;
+            }
+        }
+        if (best == pool.end()) {
+            return std::vector<float>(samples);
+        }
+        std::vector<float> buffer = std::move(*best);
+        pool.erase(best);
+        pooledBytes -= (int64_t) (buffer.capacity() * sizeof(float));
+        buffer.resize(samples);
+        return buffer;
+    }
+
+    void PrefetchCache::release(std::vector<float> buffer) {
+        auto bytes = (int64_t) (buffer.capacity() * sizeof(float));
+        if (bytes == 0 || pooledBytes + bytes > budget / kPoolShare) {
+            return;
+        }
+        pooledBytes += bytes;
+        pool.push_back(std::move(buffer));
+    }
+
+    bool PrefetchCache::prefetch(int64_t key, int32_t fileDescriptor, int32_t headMillis) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            bool present = std::any_of(entries.begin(), entries.end(), [key](auto &entry) {
+                return entry->key == key;
+            });
+            if (present || rankOf(key) < 0) {
+                ::close(fileDescriptor);
+                return present;
+            }
+        }
+
+        const int64_t start = nowNanos();
+        auto entry = std::make_unique<PrefetchEntry>();
+        entry->key = key;
+        entry->accessor = std::make_unique<AudioTagAccessor>(fileDescriptor, true);
+        if (entry->accessor->isNull()) {
+            return false;
+        }
+        entry->decoder = openDecoder(*entry->accessor);
+        if (entry->decoder == nullptr) {
+            LOGD("PrefetchCache: cannot decode %lld", (long long) key);
+            return false;
+        }
+        entry->channels = entry->decoder->channels();
+        entry->sampleRate = entry->decoder->sampleRate();
+        const auto frames = (int32_t) ((int64_t) entry->sampleRate * std::max(headMillis, 0) / 1000);
+        const int64_t bytes = (int64_t) frames * entry->channels * (int64_t) sizeof(float);
+
+        std::vector<std::unique_ptr<PrefetchEntry>> evicted;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            entry->rank = rankOf(key);
+            if (entry->rank < 0 || !makeRoom(bytes, entry->rank, evicted)) {
+                return false;
+            }
+            // reserved while decoding outside of the lock
+            liveBytes += bytes;
+            entry->head = obtainBuffer((size_t) frames * entry->channels);
+        }
+
+        int32_t written = 0;
+        while (written < frames) {
+            int32_t count = std::min(kReadFrames, frames - written);
+            int32_t read = entry->decoder->read(
+                    entry->head.data() + (size_t) written * entry->channels, count);
+            if (read <= 0) {
+                break;
+            }
+            written += read;
+        }
+        entry->headFrames = written;
+        entry->openNanos = nowNanos() - start;
+
+        std::lock_guard<std::mutex> guard(lock);
+        entry->rank = rankOf(key);
+        if (entry->rank < 0) {
+            // left the queue while decoding
+            liveBytes -= bytes;
+            release(std::move(entry->head));
+            evicted.push_back(std::move(entry));
+            return false;
+        }
+        entries.push_back(std::move(entry));
+        return true;
+    }
+
+    bool PrefetchCache::contains(int64_t key) {
+        std::lock_guard<std::mutex> guard(lock);
+        return std::any_of(entries.begin(), entries.end(), [key](auto &entry) {
+            return entry->key == key;
+        });
+    }
+
+    std::unique_ptr<PrefetchEntry> PrefetchCache::take(int64_t key) {
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = std::find_if(entries.begin(), entries.end(), [key](auto &entry) {
+            return entry->key == key;
+        });
+        if (it == entries.end()) {
+            misses++;
+            return nullptr;
+        }
+        std::unique_ptr<PrefetchEntry> entry = std::move(*it);
+        entries.erase(it);
+        liveBytes -= bytesOf(entry->head);
+        hits++;
+        savedNanos += entry->openNanos;
+        return entry;
+    }
+
+    void PrefetchCache::recycle(std::unique_ptr<PrefetchEntry> entry) {
+        if (entry == nullptr) {
+            return;
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        release(std::move(entry->head));
+    }
+
+    PrefetchStats PrefetchCache::stats() {
+        std::lock_guard<std::mutex> guard(lock);
+        return {
+                hits,
+                misses,
+                evictions,
+                (int32_t) entries.size(),
+                liveBytes,
+                hits == 0 ? 0 : savedNanos / hits,
+        };
+    }
+}
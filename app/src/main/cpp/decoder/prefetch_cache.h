@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_PREFETCH_CACHE_H
+#define SOUNDSOURCE_PREFETCH_CACHE_H
+
+#include <sys/types.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <tags/tags.h>
+
+#include "decoder.h"
+
+namespace SoundSource::Decoder {
+    /**
+     * A track opened ahead of time: the parsed accessor, its opened
+     * decoder positioned after the head, and the decoded head.
+     */
+    struct PrefetchEntry {
+        int64_t key = 0;
+        // position in the upcoming queue, 0 for the next track
+        int32_t rank = 0;
+        // declared before the decoder, which reads through its descriptor
+        std::unique_ptr<AudioTagAccessor> accessor;
+        std::unique_ptr<AudioDecoder> decoder;
+        std::vector<float> head;
+        int32_t headFrames = 0;
+        int32_t channels = 0;
+        int32_t sampleRate = 0;
+        // time spent opening, parsing and decoding the head
+        int64_t openNanos = 0;
+    };
+
+    struct PrefetchStats {
+        int64_t hits;
+        int64_t misses;
+        int64_t evictions;
+        int32_t entries;
+        int64_t bytes;
+        // mean openNanos of the entries taken
+        int64_t meanSavedNanos;
+    };
+
+    /**
+     * Holds the next tracks of the play queue opened and with their
+     * first samples decoded, so a track change finds the file parsed
+     * and its first blocks in the page cache.
+     *
+     * Head buffers come from a pool and are counted against a memory
+     * budget; when a new entry would exceed it, the entries furthest
+     * down the queue go first. Entries that fall out of the queue (on
+     * reordering or shuffling) are evicted when the queue is set.
+     *
+     * Safe to use from several threads, the opening and decoding run
+     * outside of the lock.
+     */
+    class PrefetchCache {
+    public:
+        explicit PrefetchCache(int64_t budgetBytes);
+
+        /**
+         * Set the upcoming queue, most likely next first. Entries not in
+         * it are evicted, the others ranked by their position.
+         */
+        void setQueue(const int64_t *keys, int32_t count);
+
+        /**
+         * Open the file, taking ownership of the descriptor, and decode
+         * its first headMillis milliseconds.
+         *
+         * @return false if the file cannot be decoded, is not in the
+         * queue anymore, or its head does not fit into the budget.
+         */
+        bool prefetch(int64_t key, int32_t fileDescriptor, int32_t headMillis);
+
+        bool contains(int64_t key);
+
+        /**
+         * Remove the entry of the key, counting a hit or a miss.
+         *
+         * @return the entry, or nullptr if it was not prefetched.
+         */
+        std::unique_ptr<PrefetchEntry> take(int64_t key);
+
+        /**
+         * Return the head buffer of a taken entry to the pool.
+         */
+        void recycle(std::unique_ptr<PrefetchEntry> entry);
+
+        PrefetchStats stats();
+
+    private:
+        // pooled buffers beyond the live ones are kept up to this share
+        // of the budget
+        static constexpr int32_t kPoolShare = 4;
+
+        const int64_t budget;
+
+        std::mutex lock;
+        std::vector<int64_t> queue;
+        std::vector<std::unique_ptr<PrefetchEntry>> entries;
+        std::vector<std::vector<float>> pool;
+        int64_t liveBytes = 0;
+        int64_t pooledBytes = 0;
+
+        int64_t hits = 0;
+        int64_t misses = 0;
+        int64_t evictions = 0;
+        int64_t savedNanos = 0;
+
+        int32_t rankOf(int64_t key) const;
+
+        std::vector<float> obtainBuffer(size_t samples);
+
+        void release(std::vector<float> buffer);
+
+        /**
+         * Evict the lowest ranked entries until bytes more fit.
+         *
+         * @return false if they do not fit even then.
+         */
+        bool makeRoom(int64_t bytes, int32_t rank,
+                      std::vector<std::unique_ptr<PrefetchEntry>> &evicted);
+    };
+}
+
+#endif //SOUNDSOURCE_PREFETCH_CACHE_H
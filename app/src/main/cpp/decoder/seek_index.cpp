@@ -0,0 +1,496 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "seek_index.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "file_reader.h"
+#include "flac_decoder.h"
+
+namespace SoundSource::Decoder {
+    namespace {
+        constexpr uint8_t kMagic[4] = {'S', 'S', 'K', 'I'};
+        constexpr uint8_t kVersion = 1;
+        constexpr size_t kHeaderSize = 28;
+        constexpr size_t kScanWindow = 1024 * 1024;
+
+        // ---- serialization ----
+
+        void putVarint(std::vector<uint8_t> &out, uint64_t value) {
+            while (value >= 0x80) {
+                out.push_back((uint8_t) (value | 0x80));
+                value >>= 7;
+            }
+            out.push_back((uint8_t) value);
+        }
+
+        bool getVarint(const uint8_t *&p, const uint8_t *end, uint64_t &value) {
+            value = 0;
+            for (int32_t shift = 0; shift < 64 && p < end; shift += 7) {
+                uint8_t b = *p++;
+                value |= (uint64_t) (b & 0x7f) << shift;
+                if (!(b & 0x80)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void putLe(std::vector<uint8_t> &out, uint64_t value, int32_t bytes) {
+            for (int32_t i = 0; i < bytes; i++) {
+                out.push_back((uint8_t) (value >> (8 * i)));
+            }
+        }
+
+        uint64_t getLe(const uint8_t *p, int32_t bytes) {
+            uint64_t value = 0;
+            for (int32_t i = bytes - 1; i >= 0; i--) {
+                value = value << 8 | p[i];
+            }
+            return value;
+        }
+
+        // ---- FLAC ----
+
+        struct Crc8Table {
+            uint8_t table[256]{};
+
+            constexpr Crc8Table() {
+                for (int32_t i = 0; i < 256; i++) {
+                    uint8_t crc = (uint8_t) i;
+                    for (int32_t k = 0; k < 8; k++) {
+                        crc = (uint8_t) ((crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1);
+                    }
+                    table[i] = crc;
+                }
+            }
+        };
+
+        constexpr Crc8Table kCrc8;
+
+        struct FlacFrameHeader {
+            bool variableBlockSize;
+            int32_t blockSize;
+            // frame number, or sample number with variable block sizes
+            int64_t number;
+        };
+
+        /**
+         * @return the header length, 0 if p does not start a valid header.
+         */
+        size_t parseFlacHeader(const uint8_t *p, size_t available, FlacFrameHeader &header) {
+            if (available < 16 || p[0] != 0xff || (p[1] & 0xfe) != 0xf8) {
+                return 0;
+            }
+            uint32_t blockSizeCode = p[2] >> 4;
+            uint32_t rateCode = p[2] & 0x0f;
+            uint32_t assignment = p[3] >> 4;
+            uint32_t sizeCode = (p[3] >> 1) & 0x07;
+            if (blockSizeCode == 0 || rateCode == 15 || assignment > 10 ||
+                sizeCode == 3 || (p[3] & 0x01)) {
+                return 0;
+            }
+            size_t n = 4;
+            uint8_t lead = p[n++];
+            int32_t extra = 0;
+            while (extra < 7 && (lead & (0x80 >> extra))) {
+                extra++;
+            }
+            if (extra == 1 || extra == 7) {
+                return 0;
+            }
+            int64_t number = extra == 0 ? lead : lead & (0x7f >> extra);
+            for (int32_t i = 1; i < extra; i++) {
+                if ((p[n] & 0xc0) != 0x80) {
+                    return 0;
+                }
+                number = number << 6 | (p[n++] & 0x3f);
+            }
+            int32_t blockSize;
+            if (blockSizeCode == 1) {
+                blockSize = 192;
+            } else if (blockSizeCode <= 5) {
+                blockSize = 576 << (blockSizeCode - 2);
+            } else if (blockSizeCode == 6) {
+                blockSize = p[n++] + 1;
+            } else if (blockSizeCode == 7) {
+                blockSize = (p[n] << 8 | p[n + 1]) + 1;
+                n += 2;
+            } else {
+                blockSize = 256 << (blockSizeCode - 8);
+            }
+            if (rateCode == 12) {
+                n += 1;
+            } else if (rateCode == 13 || rateCode == 14) {
+                n += 2;
+            }
+            uint8_t crc = 0;
+            for (size_t i = 0; i < n; i++) {
+                crc = kCrc8.table[crc ^ p[i]];
+            }
+            if (crc != p[n]) {
+                return 0;
+            }
+            header.variableBlockSize = p[1] & 0x01;
+            header.blockSize = blockSize;
+            header.number = number;
+            return n + 1;
+        }
+
+        // ---- MPEG ----
+
+        const int16_t kMpegBitrates[5][16] = {
+                // MPEG-1 layer I, II, III
+                {0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448, 0},
+                {0, 32, 48, 56, 64,  80,  96,  112, 128, 160, 192, 224, 256, 320, 384, 0},
+                {0, 32, 40, 48, 56,  64,  80,  96,  112, 128, 160, 192, 224, 256, 320, 0},
+                // MPEG-2/2.5 layer I, II and III
+                {0, 32, 48, 56, 64,  80,  96,  112, 128, 144, 160, 176, 192, 224, 256, 0},
+                {0, 8,  16, 24, 32,  40,  48,  56,  64,  80,  96,  112, 128, 144, 160, 0},
+        };
+
+        const int32_t kMpegSampleRates[3] = {44100, 48000, 32000};
+
+        struct MpegFrameHeader {
+            // 0 for MPEG-1, 1 for MPEG-2, 2 for MPEG-2.5
+            int32_t version;
+            int32_t layer;
+            int32_t sampleRate;
+            int32_t frameLength;
+            int32_t samplesPerFrame;
+            // header, CRC and layer III side info
+            int32_t headerLength;
+        };
+
+        bool parseMpegHeader(const uint8_t *p, MpegFrameHeader &header) {
+            if (p[0] != 0xff || (p[1] & 0xe0) != 0xe0) {
+                return false;
+            }
+            int32_t versionBits = (p[1] >> 3) & 0x03;
+            int32_t layerBits = (p[1] >> 1) & 0x03;
+            int32_t bitrateIndex = p[2] >> 4;
+            int32_t rateIndex = (p[2] >> 2) & 0x03;
+            if (versionBits == 1 || layerBits == 0 || bitrateIndex == 0 ||
+                bitrateIndex == 15 || rateIndex == 3) {
+                return false;
+            }
+            header.version = versionBits == 3 ? 0 : versionBits == 2 ? 1 : 2;
+            header.layer = 4 - layerBits;
+            header.sampleRate = kMpegSampleRates[rateIndex] >> header.version;
+            int32_t table = header.version == 0
+                            ? header.layer - 1
+                            : header.layer == 1 ? 3 : 4;
+            int32_t bitrate = kMpegBitrates[table][bitrateIndex] * 1000;
+            int32_t padding = (p[2] >> 1) & 0x01;
+            bool mono = (p[3] >> 6) == 3;
+            bool crc = !(p[1] & 0x01);
+
+            if (header.layer == 1) {
+                header.samplesPerFrame = 384;
+                header.frameLength = (12 * bitrate / header.sampleRate + padding) * 4;
+            } else if (header.layer == 2 || header.version == 0) {
+                header.samplesPerFrame = 1152;
+                header.frameLength = 144 * bitrate / header.sampleRate + padding;
+            } else {
+                header.samplesPerFrame = 576;
+                header.frameLength = 72 * bitrate / header.sampleRate + padding;
+            }
+            header.headerLength = 4 + (crc ? 2 : 0);
+            if (header.layer == 3) {
+                header.headerLength += header.version == 0
+                                       ? (mono ? 17 : 32)
+                                       : (mono ? 9 : 17);
+            }
+            return header.frameLength > header.headerLength;
+        }
+
+        bool sameStream(const MpegFrameHeader &a, const MpegFrameHeader &b) {
+            return a.version == b.version && a.layer == b.layer && a.sampleRate == b.sampleRate;
+        }
+
+        /**
+         * Move the reader to the next frame header that is followed by
+         * another header of the same stream.
+         */
+        bool syncMpeg(FileReader &reader, MpegFrameHeader &header) {
+            while (true) {
+                if (reader.fill(4) < 4) {
+                    return false;
+                }
+                if (parseMpegHeader(reader.data(), header)) {
+                    size_t wanted = (size_t) header.frameLength + 4;
+                    size_t available = reader.fill(wanted);
+                    MpegFrameHeader next{};
+                    // the last frame has no successor to check against
+                    if (available < wanted ||
+                        (parseMpegHeader(reader.data() + header.frameLength, next) &&
+                         sameStream(header, next))) {
+                        return true;
+                    }
+                }
+                const uint8_t *p = reader.data();
+                size_t available = reader.available();
+                const void *hit = memchr(p + 1, 0xff, available - 1);
+                reader.advance(hit != nullptr ? (const uint8_t *) hit - p : available);
+            }
+        }
+
+        struct MpegFrame {
+            int64_t offset;
+            int64_t index;
+            int32_t mainDataBytes;
+            int32_t mainDataBegin;
+        };
+    }
+
+    std::unique_ptr<SeekIndex> SeekIndex::buildFlac(int32_t fileDescriptor, int32_t intervalMs) {
+        FlacDecoder decoder(fileDescriptor);
+        if (!decoder.open() || decoder.hasSeekTable() || intervalMs <= 0) {
+            return nullptr;
+        }
+        auto index = std::make_unique<SeekIndex>();
+        index->indexFormat = SeekIndexFormat::FLAC;
+        index->rate = decoder.sampleRate();
+        index->interval = std::max((int32_t) ((int64_t) index->rate * intervalMs / 1000), 1);
+
+        FileReader reader(fileDescriptor, kScanWindow);
+        reader.seek(decoder.firstFrameOffset());
+        int64_t sample = 0;
+        int64_t frameNumber = 0;
+        int64_t target = 0;
+        while (true) {
+            size_t available = reader.fill(16);
+            if (available < 16) {
+                break;
+            }
+            const uint8_t *p = reader.data();
+            size_t i = 0;
+            const size_t end = available - 15;
+            while (i < end) {
+                const void *hit = memchr(p + i, 0xff, end - i);
+                if (hit == nullptr) {
+                    i = end;
+                    break;
+                }
+                i = (const uint8_t *) hit - p;
+                FlacFrameHeader header{};
+                size_t length = parseFlacHeader(p + i, available - i, header);
+                // the coded number rules out sync patterns in the frame data
+                int64_t expected = header.variableBlockSize ? sample : frameNumber;
+                if (length == 0 || header.number != expected) {
+                    i++;
+                    continue;
+                }
+                while (target < sample + header.blockSize) {
+                    index->points.push_back({sample, reader.position() + (int64_t) i});
+                    target += index->interval;
+                }
+                sample += header.blockSize;
+                frameNumber++;
+                i += length;
+            }
+            reader.advance(i);
+        }
+        int64_t total = decoder.totalFrames();
+        index->total = total > 0 ? std::min(total, sample) : sample;
+        return index;
+    }
+
+    std::unique_ptr<SeekIndex> SeekIndex::buildMpeg(int32_t fileDescriptor, int32_t intervalMs) {
+        if (intervalMs <= 0) {
+            return nullptr;
+        }
+        FileReader reader(fileDescriptor, kScanWindow);
+        uint8_t id3[10];
+        while (reader.fill(10) >= 10 && memcmp(reader.data(), "ID3", 3) == 0) {
+            memcpy(id3, reader.data(), 10);
+            int64_t size = (id3[6] & 0x7f) << 21 | (id3[7] & 0x7f) << 14 |
+                           (id3[8] & 0x7f) << 7 | (id3[9] & 0x7f);
+            reader.skip(10 + size + ((id3[5] & 0x10) ? 10 : 0));
+        }
+
+        MpegFrameHeader first{};
+        if (!syncMpeg(reader, first)) {
+            return nullptr;
+        }
+        auto index = std::make_unique<SeekIndex>();
+        index->indexFormat = SeekIndexFormat::MPEG;
+        index->rate = first.sampleRate;
+        index->interval = std::max((int32_t) ((int64_t) index->rate * intervalMs / 1000), 1);
+
+        // the first frame may be a Xing/Info/VBRI header without audio
+        reader.fill(first.headerLength + 4);
+        const uint8_t *p = reader.data();
+        if (reader.available() >= (size_t) first.headerLength + 4 &&
+            (memcmp(p + first.headerLength, "Xing", 4) == 0 ||
+             memcmp(p + first.headerLength, "Info", 4) == 0)) {
+            reader.skip(first.frameLength);
+        } else if (reader.fill(40) >= 40 && memcmp(reader.data() + 36, "VBRI", 4) == 0) {
+            reader.skip(first.frameLength);
+        }
+
+        // frames the reservoir of the next frames may reach back to
+        constexpr int32_t kHistory = 32;
+        MpegFrame history[kHistory];
+        int64_t frameIndex = 0;
+        int64_t target = 0;
+        const int32_t samplesPerFrame = first.samplesPerFrame;
+
+        while (true) {
+            if (reader.fill(4) < 4) {
+                break;
+            }
+            p = reader.data();
+            if (memcmp(p, "TAG", 3) == 0 || (reader.fill(8) >= 8 &&
+                                              memcmp(reader.data(), "APETAGEX", 8) == 0)) {
+                break;
+            }
+            MpegFrameHeader header{};
+            if (!parseMpegHeader(reader.data(), header) || !sameStream(header, first)) {
+                if (!syncMpeg(reader, header) || !sameStream(header, first)) {
+                    break;
+                }
+            }
+            if (reader.fill(header.headerLength) < (size_t) header.headerLength) {
+                break;
+            }
+            p = reader.data();
+            int32_t mainDataBegin = 0;
+            if (header.layer == 3) {
+                const uint8_t *side = p + 4 + (p[1] & 0x01 ? 0 : 2);
+                mainDataBegin = header.version == 0 ? side[0] << 1 | side[1] >> 7 : side[0];
+            }
+            MpegFrame &frame = history[frameIndex % kHistory];
+            frame = {reader.position(), frameIndex,
+                     header.frameLength - header.headerLength, mainDataBegin};
+
+            int64_t sample = frameIndex * samplesPerFrame;
+            if (target < sample + samplesPerFrame) {
+                // start where the main data of this frame and of the
+                // previous one (for the MDCT overlap) begins
+                int64_t start = frameIndex;
+                if (header.layer == 3) {
+                    int64_t oldest = std::max<int64_t>(0, frameIndex - kHistory + 1);
+                    for (int64_t f = std::max(oldest, frameIndex - 1); f <= frameIndex; f++) {
+                        int32_t need = history[f % kHistory].mainDataBegin;
+                        int64_t s = f;
+                        while (need > 0 && s > oldest) {
+                            s--;
+                            need -= history[s % kHistory].mainDataBytes;
+                        }
+                        start = std::min(start, s);
+                    }
+                }
+                const MpegFrame &startFrame = history[start % kHistory];
+                while (target < sample + samplesPerFrame) {
+                    index->points.push_back({startFrame.index * samplesPerFrame,
+                                             startFrame.offset});
+                    target += index->interval;
+                }
+            }
+            frameIndex++;
+            reader.skip(header.frameLength);
+        }
+        index->total = frameIndex * samplesPerFrame;
+        if (index->points.empty()) {
+            return nullptr;
+        }
+        return index;
+    }
+
+    std::unique_ptr<SeekIndex> SeekIndex::deserialize(const uint8_t *data, size_t size) {
+        if (size < kHeaderSize || memcmp(data, kMagic, 4) != 0 || data[4] != kVersion) {
+            return nullptr;
+        }
+        auto index = std::make_unique<SeekIndex>();
+        if (data[5] != (uint8_t) SeekIndexFormat::FLAC && data[5] != (uint8_t) SeekIndexFormat::MPEG) {
+            return nullptr;
+        }
+        index->indexFormat = (SeekIndexFormat) data[5];
+        index->rate = (int32_t) getLe(data + 8, 4);
+        index->interval = (int32_t) getLe(data + 12, 4);
+        index->total = (int64_t) getLe(data + 16, 8);
+        uint32_t count = (uint32_t) getLe(data + 24, 4);
+        // every point takes at least two bytes
+        if (index->rate <= 0 || index->interval <= 0 || count > (size - kHeaderSize) / 2) {
+            return nullptr;
+        }
+        index->points.resize(count);
+        const uint8_t *p = data + kHeaderSize;
+        const uint8_t *end = data + size;
+        int64_t frame = 0, offset = 0;
+        for (SeekPoint &point: index->points) {
+            uint64_t frameDelta, offsetDelta;
+            if (!getVarint(p, end, frameDelta) || !getVarint(p, end, offsetDelta)) {
+                return nullptr;
+            }
+            frame += (int64_t) frameDelta;
+            offset += (int64_t) offsetDelta;
+            point = {frame, offset};
+        }
+        return index;
+    }
+
+    std::vector<uint8_t> SeekIndex::serialize() const {
+        std::vector<uint8_t> out;
+        out.reserve(kHeaderSize + points.size() * 4);
+        for (uint8_t b: kMagic) {
+            out.push_back(b);
+        }
+        out.push_back(kVersion);
+        out.push_back((uint8_t) indexFormat);
+        putLe(out, 0, 2);
+        putLe(out, rate, 4);
+        putLe(out, interval, 4);
+        putLe(out, total, 8);
+        putLe(out, points.size(), 4);
+        int64_t frame = 0, offset = 0;
+        for (const SeekPoint &point: points) {
+            putVarint(out, point.frame - frame);
+            putVarint(out, point.offset - offset);
+            frame = point.frame;
+            offset = point.offset;
+        }
+        return out;
+    }
+
+    const SeekPoint *SeekIndex::locate(int64_t frame) const {
+        if (points.empty()) {
+            return nullptr;
+        }
+        // point k is the start for the sample k * interval
+        int64_t k = std::clamp<int64_t>(frame / interval, 0, (int64_t) points.size() - 1);
+        return &points[k];
+    }
+
+    SeekIndexFormat SeekIndex::format() const {
+        return indexFormat;
+    }
+
+    int32_t SeekIndex::sampleRate() const {
+        return rate;
+    }
+
+    int64_t SeekIndex::totalFrames() const {
+        return total;
+    }
+
+    size_t SeekIndex::size() const {
+        return points.size();
+    }
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOUNDSOURCE_SEEK_INDEX_H
+#define SOUNDSOURCE_SEEK_INDEX_H
+
+#include <sys/types.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace SoundSource::Decoder {
+    enum class SeekIndexFormat : uint8_t {
+        FLAC = 1,
+        MPEG = 2,
+    };
+
+    struct SeekPoint {
+        /**
+         * Index of the first sample frame decoded from offset.
+         */
+        int64_t frame;
+
+        /**
+         * File offset of a frame header.
+         */
+        int64_t offset;
+    };
+
+    /**
+     * Frame offsets sampled every interval, built by walking the frame
+     * headers once so seeking needs neither bisection nor a (coarse)
+     * Xing TOC.
+     *
+     * Seeking to a sample: decode from locate(sample) and drop the
+     * samples before it. For MPEG layer III the points are moved back
+     * by the frames the bit reservoir and the MDCT overlap of the target
+     * frame depend on, so the target decodes exactly. Sample frames
+     * count from the first audio frame, a Xing/Info/VBRI frame is not
+     * counted.
+     */
+    class SeekIndex {
+    public:
+        /**
+         * Build the index of a FLAC file.
+         *
+         * @return nullptr if the file is not a FLAC file, or does not
+         * need an index because it has a SEEKTABLE.
+         */
+        static std::unique_ptr<SeekIndex> buildFlac(int32_t fileDescriptor, int32_t intervalMs);
+
+        /**
+         * Build the index of an MPEG audio (MP1/MP2/MP3) file.
+         */
+        static std::unique_ptr<SeekIndex> buildMpeg(int32_t fileDescriptor, int32_t intervalMs);
+
+        /**
+         * Read a serialized index.
+         *
+         * @return nullptr if the data is not a valid index.
+         */
+        static std::unique_ptr<SeekIndex> deserialize(const uint8_t *data, size_t size);
+
+        /**
+         * Serialize as a small binary blob, points are stored as
+         * variable length deltas (about 4 bytes per point).
+         */
+        std::vector<uint8_t> serialize() const;
+
+        /**
+         * Find the point to start decoding from to reach the given
+         * sample frame, in constant time.
+         *
+         * @return nullptr if the index is empty.
+         */
+        const SeekPoint *locate(int64_t frame) const;
+
+        SeekIndexFormat format() const;
+
+        int32_t sampleRate() const;
+
+        int64_t totalFrames() const;
+
+        size_t size() const;
+
+    private:
+        SeekIndexFormat indexFormat = SeekIndexFormat::FLAC;
+        int32_t rate = 0;
+        int32_t interval = 0;
+        int64_t total = 0;
+        std::vector<SeekPoint> points;
+    };
+}
+
+#endif //SOUNDSOURCE_SEEK_INDEX_H
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include <benchmark/benchmark.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <decoder/flac_decoder.h>
+#include <decoder/pcm_decoder.h>
+
+#include "samples.h"
+
+using namespace SoundSource;
+using namespace SoundSource::Decoder;
+
+namespace {
+    // what the player asks for per read
+    constexpr int32_t kReadFrames = 4096;
+    constexpr double kTrackSeconds = 30;
+
+    enum Container : int64_t {
+        FLAC,
+        WAV,
+        AIFF,
+    };
+
+    std::unique_ptr<AudioDecoder> decoderFor(Container container, int32_t fd) {
+        if (container == FLAC) {
+            return std::make_unique<FlacDecoder>(fd);
+        }
+        return std::make_unique<PcmDecoder>(fd);
+    }
+
+    /**
+     * Open and decode the whole file into a scratch buffer that is
+     * never looked at, the host stand-in for /dev/null.
+     *
+     * @return the frames decoded, -1 if the file cannot be decoded.
+     */
+    int64_t decodeAll(Container container, int32_t fd, std::vector<float> &scratch) {
+        auto decoder = decoderFor(container, fd);
+        if (!decoder->open()) {
+            return -1;
+        }
+        scratch.resize((size_t) kReadFrames * decoder->channels());
+        int64_t frames = 0;
+        int32_t read;
+        while ((read = decoder->read(scratch.data(), kReadFrames)) > 0) {
+            benchmark::DoNotOptimize(scratch.data());
+            frames += read;
+        }
+        return read < 0 ? -1 : frames;
+    }
+
+    const Host::MemoryFile &track(Container container, int32_t bits, int32_t rate) {
+        static std::vector<std::pair<std::string, std::unique_ptr<Host::MemoryFile>>> tracks;
+        std::string key = std::to_string(container) + "/" + std::to_string(bits) + "/" +
+                          std::to_string(rate);
+        for (const auto &[name, file]: tracks) {
+            if (name == key) {
+                return *file;
+            }
+        }
+        Host::PcmFormat format{2, rate, bits};
+        auto samples = Host::musicPcm(format, kTrackSeconds);
+        Host::Bytes data = container == FLAC ? Host::encodeFlac(samples, format)
+                           : container == WAV ? Host::encodeWav(samples, format)
+                                              : Host::encodeAiff(samples, format);
+        tracks.emplace_back(key, std::make_unique<Host::MemoryFile>(data));
+        return *tracks.back().second;
+    }
+
+    /**
+     * A stereo track decoded from open to end of stream, reported as
+     * bytes read per second and audio seconds decoded per second
+     * ("realtime").
+     */
+    void BM_Decode(benchmark::State &state) {
+        auto container = (Container) state.range(0);
+        auto bits = (int32_t) state.range(1);
+        auto rate = (int32_t) state.range(2);
+        const auto &file = track(container, bits, rate);
+        std::vector<float> scratch;
+        int64_t frames = 0;
+        for (auto _: state) {
+            frames = decodeAll(container, file.fileDescriptor(), scratch);
+            if (frames < 0) {
+                state.SkipWithError("decode failed");
+                return;
+            }
+        }
+        state.SetBytesProcessed(state.iterations() *
+                                lseek(file.fileDescriptor(), 0, SEEK_END));
+        state.counters["realtime"] = benchmark::Counter(
+                (double) state.iterations() * frames / rate, benchmark::Counter::kIsRate);
+    }
+
+    /**
+     * Open and the first read, the part of the startup latency the
+     * decoder adds before the first buffer can be queued.
+     */
+    void BM_DecodeFirstBuffer(benchmark::State &state) {
+        auto container = (Container) state.range(0);
+        const auto &file = track(container, 16, 44100);
+        std::vector<float> scratch((size_t) kReadFrames * 2);
+        for (auto _: state) {
+            auto decoder = decoderFor(container, file.fileDescriptor());
+            if (!decoder->open() || decoder->read(scratch.data(), kReadFrames) <= 0) {
+                state.SkipWithError("decode failed");
+                return;
+            }
+            benchmark::DoNotOptimize(scratch.data());
+        }
+    }
+
+    void containers(benchmark::internal::Benchmark *benchmark) {
+        benchmark->ArgNames({"container", "bits", "rate"});
+        for (int64_t container: {FLAC, WAV, AIFF}) {
+            benchmark->Args({container, 16, 44100});
+            benchmark->Args({container, 24, 96000});
+        }
+    }
+
+    bool endsWith(const std::string &value, const char *suffix) {
+        std::string end(suffix);
+        return value.size() >= end.size() &&
+               value.compare(value.size() - end.size(), end.size(), end) == 0;
+    }
+
+    /**
+     * Every .flac, .wav and .aif(f) file of the directory in
+     * SOUNDSOURCE_BENCH_CORPUS decoded in turn, through the page cache
+     * like the player reads them.
+     */
+    void BM_DecodeCorpus(benchmark::State &state, std::vector<std::string> paths) {
+        std::vector<float> scratch;
+        int64_t bytes = 0;
+        for (auto _: state) {
+            for (const auto &path: paths) {
+                int32_t fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0) {
+                    continue;
+                }
+                Container container = endsWith(path, ".flac") ? FLAC : WAV;
+                if (decodeAll(container, fd, scratch) >= 0) {
+                    bytes += lseek(fd, 0, SEEK_END);
+                }
+                ::close(fd);
+            }
+        }
+        state.SetBytesProcessed(bytes);
+        state.counters["files"] = benchmark::Counter(
+                (double) state.iterations() * paths.size(), benchmark::Counter::kIsRate);
+    }
+
+    [[maybe_unused]] const bool corpusRegistered = [] {
+        const char *directory = getenv("SOUNDSOURCE_BENCH_CORPUS");
+        if (directory == nullptr) {
+            return false;
+        }
+        std::vector<std::string> paths;
+        if (DIR *dir = opendir(directory)) {
+            while (dirent *entry = readdir(dir)) {
+                std::string name = entry->d_name;
+                if (endsWith(name, ".flac") || endsWith(name, ".wav") ||
+                    endsWith(name, ".aif") || endsWith(name, ".aiff")) {
+                    paths.push_back(std::string(directory) + "/" + name);
+                }
+            }
+            closedir(dir);
+        }
+        if (paths.empty()) {
+            return false;
+        }
+        benchmark::RegisterBenchmark("BM_DecodeCorpus", BM_DecodeCorpus, paths)
+                ->Unit(benchmark::kMillisecond);
+        return true;
+    }();
+}
+
+BENCHMARK(BM_Decode)->Apply(containers)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DecodeFirstBuffer)->Arg(FLAC)->Arg(WAV)->Arg(AIFF)->ArgName("container");
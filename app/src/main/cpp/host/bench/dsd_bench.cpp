@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <decoder/dsd_decoder.h>
+
+#include "samples.h"
+
+using namespace SoundSource;
+using namespace SoundSource::Decoder;
+
+namespace {
+    constexpr int32_t kReadFrames = 4096;
+    constexpr double kTrackSeconds = 5;
+    constexpr int32_t kDsd64Rate = 2822400;
+
+    enum Container : int64_t {
+        DSF,
+        DSDIFF,
+    };
+
+    const Host::MemoryFile &track(Container container, int32_t dsdRate) {
+        static std::vector<std::pair<std::string, std::unique_ptr<Host::MemoryFile>>> tracks;
+        std::string key = std::to_string(container) + "/" + std::to_string(dsdRate);
+        for (const auto &[name, file]: tracks) {
+            if (name == key) {
+                return *file;
+            }
+        }
+        auto planes = Host::modulateDsd(2, dsdRate, kTrackSeconds, container == DSF);
+        Host::Bytes data = container == DSF ? Host::encodeDsf(planes, dsdRate)
+                                            : Host::encodeDsdiff(planes, dsdRate);
+        tracks.emplace_back(key, std::make_unique<Host::MemoryFile>(data));
+        return *tracks.back().second;
+    }
+
+    /**
+     * A stereo DSD file decoded to 88.2 kHz PCM from open to end of
+     * stream, reported as audio seconds per second ("realtime").
+     */
+    void BM_DsdDecode(benchmark::State &state) {
+        auto container = (Container) state.range(0);
+        auto dsdRate = (int32_t) (state.range(1) / 64 * kDsd64Rate);
+        const auto &file = track(container, dsdRate);
+        std::vector<float> scratch((size_t) kReadFrames * 2);
+        for (auto _: state) {
+            DsdDecoder decoder(file.fileDescriptor());
+            if (!decoder.open()) {
+                state.SkipWithError("decode failed");
+                return;
+            }
+            int32_t read;
+            while ((read = decoder.read(scratch.data(), kReadFrames)) > 0) {
+                benchmark::DoNotOptimize(scratch.data());
+            }
+        }
+        state.SetBytesProcessed(state.iterations() * (int64_t) (kTrackSeconds * dsdRate / 4));
+        state.counters["realtime"] = benchmark::Counter(
+                (double) state.iterations() * kTrackSeconds, benchmark::Counter::kIsRate);
+    }
+
+    void dsdRates(benchmark::internal::Benchmark *benchmark) {
+        benchmark->ArgNames({"container", "dsd"});
+        for (int64_t container: {DSF, DSDIFF}) {
+            for (int64_t multiple: {64, 128, 256}) {
+                benchmark->Args({container, multiple});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_DsdDecode)->Apply(dsdRates)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <audio/fft.h>
+#include <audio/spectrum.h>
+
+using namespace SoundSource::Audio;
+
+namespace {
+    /**
+     * One forward transform of white noise, reported per transform and
+     * as points per second.
+     */
+    void BM_RealFft(benchmark::State &state) {
+        auto n = (int32_t) state.range(0);
+        RealFft fft(n);
+        std::vector<float> in((size_t) n);
+        std::vector<float> re((size_t) n / 2 + 1);
+        std::vector<float> im((size_t) n / 2 + 1);
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> uniform(-1, 1);
+        for (float &value: in) {
+            value = uniform(random);
+        }
+        for (auto _: state) {
+            fft.forward(in.data(), re.data(), im.data());
+            benchmark::DoNotOptimize(re.data());
+            benchmark::DoNotOptimize(im.data());
+        }
+        state.SetItemsProcessed(state.iterations() * n);
+    }
+
+    /**
+     * The playback thread side of the analyser with the defaults of
+     * the app (2048 points, 32 bands): a second of 48 kHz stereo in
+     * 480 frame blocks, which includes the downmix, about 60
+     * transforms and the band folding.
+     */
+    void BM_SpectrumAnalyzer(benchmark::State &state) {
+        constexpr int32_t kRate = 48000;
+        constexpr int32_t kBlockFrames = 480;
+        SpectrumAnalyzer analyzer(2048, 32);
+        analyzer.configure(2, kRate);
+        std::vector<float> in((size_t) kRate * 2);
+        for (int32_t i = 0; i < kRate; i++) {
+            in[2 * i] = in[2 * i + 1] = 0.5f * std::sin(2 * (float) M_PI * 1000.0f * i / kRate);
+        }
+        for (auto _: state) {
+            for (int32_t frame = 0; frame < kRate; frame += kBlockFrames) {
+                analyzer.process(in.data() + 2 * frame, kBlockFrames);
+            }
+        }
+        state.counters["realtime"] = benchmark::Counter(
+                (double) state.iterations(), benchmark::Counter::kIsRate);
+    }
+}
+
+BENCHMARK(BM_RealFft)->Arg(1024)->Arg(2048)->Arg(4096)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SpectrumAnalyzer)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include <audio/gain.h>
+
+#include "samples.h"
+
+using namespace SoundSource;
+using namespace SoundSource::Audio;
+
+namespace {
+    // what a MediaCodec output buffer usually holds
+    constexpr int32_t kBlockFrames = 4096;
+
+    /**
+     * The ReplayGain processor on the playback thread: gain, peak
+     * detection and limiting of music-like PCM, reported per sample
+     * ("per_sample", one channel of one frame) and as realtime.
+     *
+     * The gain of 6 dB keeps the limiter busy, at 0 dB it only delays.
+     */
+    template<typename T>
+    void BM_GainProcessor(benchmark::State &state) {
+        auto channels = (int32_t) state.range(0);
+        auto rate = (int32_t) state.range(1);
+        auto gainDb = (float) state.range(2);
+        std::vector<int32_t> pcm = Host::musicPcm({channels, rate, 16}, 1.0);
+        std::vector<T> source(pcm.size());
+        for (size_t i = 0; i < pcm.size(); i++) {
+            if constexpr (std::is_same_v<T, float>) {
+                source[i] = (float) pcm[i] / 32768.0f;
+            } else {
+                source[i] = (int16_t) pcm[i];
+            }
+        }
+        const size_t blockSamples = (size_t) kBlockFrames * channels;
+        std::vector<T> block(blockSamples);
+        GainProcessor processor(channels, rate);
+        processor.setGain(gainDb);
+        size_t offset = 0;
+        for (auto _: state) {
+            if (offset + blockSamples > source.size()) {
+                offset = 0;
+            }
+            std::memcpy(block.data(), source.data() + offset, blockSamples * sizeof(T));
+            processor.process(block.data(), kBlockFrames);
+            benchmark::DoNotOptimize(block.data());
+            offset += blockSamples;
+        }
+        state.SetItemsProcessed(state.iterations() * (int64_t) blockSamples);
+        state.counters["per_sample"] = benchmark::Counter(
+                (double) blockSamples,
+                benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+        state.counters["realtime"] = benchmark::Counter(
+                (double) state.iterations() * kBlockFrames / rate, benchmark::Counter::kIsRate);
+    }
+
+    void gainFormats(benchmark::internal::Benchmark *benchmark) {
+        benchmark->ArgNames({"channels", "rate", "gain"});
+        benchmark->Args({2, 44100, 6});
+        benchmark->Args({2, 44100, 0});
+        benchmark->Args({2, 96000, 6});
+        benchmark->Args({6, 48000, 6});
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_GainProcessor, float)->Apply(gainFormats);
+BENCHMARK_TEMPLATE(BM_GainProcessor, int16_t)->Apply(gainFormats);
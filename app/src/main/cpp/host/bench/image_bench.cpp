@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include <image/image.h>
+
+#include "samples.h"
+
+using namespace SoundSource;
+
+namespace {
+    void BM_GetImageInfo(benchmark::State &state, const char *format) {
+        const Host::Sample &sample = Host::findSample(Host::imageSamples(), format);
+        for (auto _: state) {
+            Image::ImageInfo info = Image::getImageInfo(sample.data.data(), sample.data.size());
+            benchmark::DoNotOptimize(info);
+        }
+    }
+
+    template<typename Pixel>
+    std::vector<Pixel> randomPixels(int64_t count) {
+        std::mt19937 random(1);
+        std::vector<Pixel> pixels(count);
+        for (auto &pixel: pixels) {
+            pixel = (Pixel) random();
+        }
+        return pixels;
+    }
+
+    // blurring in place again costs the same, the kernels do not
+    // depend on the pixel values
+    void BM_BlurArgb8888(benchmark::State &state) {
+        auto width = (int32_t) state.range(0);
+        auto height = (int32_t) state.range(1);
+        auto radius = (int32_t) state.range(2);
+        auto pixels = randomPixels<int32_t>((int64_t) width * height);
+        for (auto _: state) {
+            benchmark::DoNotOptimize(
+                    Image::ImageProcessor::BlurArgb8888(pixels.data(), width, height, radius));
+        }
+        state.SetItemsProcessed(state.iterations() * width * height);
+    }
+
+    void BM_BlurRgb565(benchmark::State &state) {
+        auto width = (int32_t) state.range(0);
+        auto height = (int32_t) state.range(1);
+        auto radius = (int32_t) state.range(2);
+        auto pixels = randomPixels<int16_t>((int64_t) width * height);
+        for (auto _: state) {
+            benchmark::DoNotOptimize(
+                    Image::ImageProcessor::BlurRgb565(pixels.data(), width, height, radius));
+        }
+        state.SetItemsProcessed(state.iterations() * width * height);
+    }
+
+    // cover thumbnails, full covers and a phone screen background, at
+    // the radii of the now playing backdrop
+    void blurSizes(benchmark::internal::Benchmark *benchmark) {
+        benchmark->ArgNames({"width", "height", "radius"});
+        for (int64_t radius: {8, 25}) {
+            benchmark->Args({300, 300, radius});
+            benchmark->Args({600, 600, radius});
+            benchmark->Args({1080, 1920, radius});
+        }
+    }
+}
+
+BENCHMARK_CAPTURE(BM_GetImageInfo, avif, "avif");
+BENCHMARK_CAPTURE(BM_GetImageInfo, bmp, "bmp");
+BENCHMARK_CAPTURE(BM_GetImageInfo, gif, "gif");
+BENCHMARK_CAPTURE(BM_GetImageInfo, hdr, "hdr");
+BENCHMARK_CAPTURE(BM_GetImageInfo, icns, "icns");
+BENCHMARK_CAPTURE(BM_GetImageInfo, ico, "ico");
+BENCHMARK_CAPTURE(BM_GetImageInfo, jp2, "jp2");
+BENCHMARK_CAPTURE(BM_GetImageInfo, jpg, "jpg");
+BENCHMARK_CAPTURE(BM_GetImageInfo, png, "png");
+BENCHMARK_CAPTURE(BM_GetImageInfo, psd, "psd");
+BENCHMARK_CAPTURE(BM_GetImageInfo, qoi, "qoi");
+BENCHMARK_CAPTURE(BM_GetImageInfo, tiff, "tiff");
+BENCHMARK_CAPTURE(BM_GetImageInfo, webp, "webp");
+BENCHMARK_CAPTURE(BM_GetImageInfo, unknown, "unknown");
+
+BENCHMARK(BM_BlurArgb8888)->Apply(blurSizes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_BlurRgb565)->Apply(blurSizes)->Unit(benchmark::kMillisecond);
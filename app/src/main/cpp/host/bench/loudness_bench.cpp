@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <audio/loudness.h>
+
+#include "samples.h"
+
+using namespace SoundSource;
+using namespace SoundSource::Audio;
+
+namespace {
+    /**
+     * The meter over ten seconds of music-like PCM in the 4096 frame
+     * blocks the scan decodes, with the K-weighting, gating and true
+     * peak. A scan needs 200 times realtime to stay bound by decoding.
+     */
+    void BM_LoudnessMeter(benchmark::State &state) {
+        auto channels = (int32_t) state.range(0);
+        auto rate = (int32_t) state.range(1);
+        constexpr double kSeconds = 10.0;
+        constexpr int32_t kBlockFrames = 4096;
+        std::vector<int32_t> pcm = Host::musicPcm({channels, rate, 16}, kSeconds);
+        std::vector<float> samples(pcm.size());
+        for (size_t i = 0; i < pcm.size(); i++) {
+            samples[i] = (float) pcm[i] / 32768.0f;
+        }
+        auto frames = (int32_t) (samples.size() / channels);
+        for (auto _: state) {
+            LoudnessMeter meter(channels, rate);
+            for (int32_t frame = 0; frame < frames; frame += kBlockFrames) {
+                meter.process(samples.data() + (size_t) frame * channels,
+                              std::min(kBlockFrames, frames - frame));
+            }
+            benchmark::DoNotOptimize(meter.integratedLoudness());
+        }
+        state.counters["realtime"] = benchmark::Counter(
+                (double) state.iterations() * kSeconds, benchmark::Counter::kIsRate);
+    }
+
+    void loudnessFormats(benchmark::internal::Benchmark *benchmark) {
+        benchmark->ArgNames({"channels", "rate"});
+        benchmark->Args({2, 44100});
+        benchmark->Args({2, 48000});
+        benchmark->Args({2, 96000});
+        benchmark->Args({6, 48000});
+    }
+}
+
+BENCHMARK(BM_LoudnessMeter)->Apply(loudnessFormats)->Unit(benchmark::kMillisecond);
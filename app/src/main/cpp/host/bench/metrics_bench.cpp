@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include <benchmark/benchmark.h>
+
+#include <metrics.h>
+
+using namespace SoundSource;
+
+namespace {
+    constexpr int32_t kFlac = 1;
+
+    void BM_MetricsAdd(benchmark::State &state) {
+        for (auto _: state) {
+            Metrics::add(Metrics::Counter::BYTES_READ, kFlac, 4096);
+        }
+    }
+
+    /**
+     * A histogram record from every thread at once, which must not
+     * slow down with the thread count as every thread has its shard.
+     */
+    void BM_MetricsRecord(benchmark::State &state) {
+        int64_t value = 1;
+        for (auto _: state) {
+            Metrics::record(Metrics::Histogram::OPEN_TIME, kFlac, value);
+            value = value * 3 % 100003;
+        }
+    }
+
+    /**
+     * Two steady_clock reads and a record, the cost of a Timer scope.
+     */
+    void BM_MetricsTimer(benchmark::State &state) {
+        for (auto _: state) {
+            Metrics::Timer timer(Metrics::Histogram::PARSE_TIME, kFlac);
+        }
+    }
+
+    void BM_MetricsSnapshot(benchmark::State &state) {
+        for (auto _: state) {
+            benchmark::DoNotOptimize(Metrics::snapshot());
+        }
+    }
+}
+
+BENCHMARK(BM_MetricsAdd);
+BENCHMARK(BM_MetricsRecord)->ThreadRange(1, 8);
+BENCHMARK(BM_MetricsTimer);
+BENCHMARK(BM_MetricsSnapshot)->Unit(benchmark::kMicrosecond);
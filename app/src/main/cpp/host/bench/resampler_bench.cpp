@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+#include <audio/resampler.h>
+
+using namespace SoundSource::Audio;
+
+namespace {
+    constexpr int32_t kChannels = 2;
+    // what a MediaCodec output buffer usually holds
+    constexpr int32_t kBlockFrames = 4096;
+
+    /**
+     * Stereo float resampling, reported as the audio seconds converted
+     * per second ("realtime").
+     */
+    void BM_Resample(benchmark::State &state) {
+        auto inputRate = (int32_t) state.range(0);
+        auto outputRate = (int32_t) state.range(1);
+        auto quality = (ResamplerQuality) state.range(2);
+        Resampler resampler(kChannels, inputRate, outputRate, quality);
+        std::vector<float> in((size_t) kBlockFrames * kChannels);
+        for (int32_t i = 0; i < kBlockFrames; i++) {
+            float value = 0.5f * std::sin(2 * (float) M_PI * 1000.0f * i / inputRate);
+            in[kChannels * i] = value;
+            in[kChannels * i + 1] = -value;
+        }
+        std::vector<float> out((size_t) resampler.maxOutputFrames(kBlockFrames) * kChannels);
+        for (auto _: state) {
+            benchmark::DoNotOptimize(resampler.process(in.data(), kBlockFrames, out.data()));
+        }
+        state.SetItemsProcessed(state.iterations() * kBlockFrames);
+        state.counters["realtime"] = benchmark::Counter(
+                (double) state.iterations() * kBlockFrames / inputRate,
+                benchmark::Counter::kIsRate);
+    }
+
+    void resampleRatios(benchmark::internal::Benchmark *benchmark) {
+        benchmark->ArgNames({"in", "out", "quality"});
+        for (int64_t quality = 0; quality <= 2; quality++) {
+            benchmark->Args({44100, 48000, quality});
+            benchmark->Args({48000, 44100, quality});
+            benchmark->Args({88200, 48000, quality});
+            benchmark->Args({96000, 48000, quality});
+            benchmark->Args({192000, 48000, quality});
+        }
+    }
+}
+
+BENCHMARK(BM_Resample)->Apply(resampleRatios);
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <benchmark/benchmark.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <tags/scan_cache.h>
+#include <tags/string_table.h>
+
+#include "samples.h"
+
+using namespace SoundSource;
+
+namespace {
+    constexpr size_t kBatchSize = 128;
+    constexpr size_t kFiles = 128;
+
+    const std::vector<std::string> kFieldKeys = {
+            "TITLE", "ARTIST", "ALBUM", "ALBUMARTIST", "GENRE", "DATE", "TRACKNUMBER"
+    };
+
+    /**
+     * A cache of a library of count files: ten tracks an album, ten
+     * albums an artist. The entries cycle through kFiles memory files
+     * for their size and last modified time, so they validate
+     * unchanged against the descriptors of those.
+     */
+    class Library {
+    public:
+        explicit Library(size_t count) {
+            for (size_t i = 0; i < kFiles; i++) {
+                files.push_back(std::make_unique<Host::MemoryFile>(Host::Bytes(1024 + i)));
+                struct stat st{};
+                fstat(files.back()->fileDescriptor(), &st);
+                stats.push_back({(int64_t) st.st_size,
+                                 (int64_t) st.st_mtim.tv_sec * 1000 +
+                                 st.st_mtim.tv_nsec / 1000000});
+            }
+
+            path = "/tmp/soundsource-scan-cache-" + std::to_string(getpid()) + "-" +
+                   std::to_string(count);
+            StringTable table;
+            ScanCacheWriter writer(kFieldKeys, table);
+            std::vector<uint32_t> values(kFieldKeys.size());
+            for (size_t i = 0; i < count; i++) {
+                std::string artist = "Artist " + std::to_string(i / 100);
+                std::string album = "Album " + std::to_string(i / 10);
+                std::string title = "Title " + std::to_string(i);
+                identifiers.push_back("primary:Music/" + artist + "/" + album + "/" +
+                                      std::to_string(i % 10 + 1) + " " + title + ".flac");
+                values[0] = table.intern(title);
+                values[1] = table.intern(artist);
+                values[2] = table.intern(album);
+                values[3] = values[1];
+                values[4] = table.intern("Genre " + std::to_string(i % 20));
+                values[5] = table.intern(std::to_string(1970 + i % 50));
+                values[6] = table.intern(std::to_string(i % 10 + 1));
+                const Stat &stat = statOf(i);
+                writer.put(identifiers.back(), stat.size, stat.lastModified,
+                           {2, 900, 16, 44100, 240000}, values.data());
+            }
+            writer.write(path);
+        }
+
+        ~Library() {
+            std::remove(path.c_str());
+        }
+
+        struct Stat {
+            int64_t size;
+            int64_t lastModified;
+        };
+
+        const Stat &statOf(size_t index) const {
+            return stats[index % kFiles];
+        }
+
+        const Host::MemoryFile &fileOf(size_t index) const {
+            return *files[index % kFiles];
+        }
+
+        std::string path;
+        std::vector<std::string> identifiers;
+
+    private:
+        std::vector<std::unique_ptr<Host::MemoryFile>> files;
+        std::vector<Stat> stats;
+    };
+
+    /**
+     * Validation of a rescan by the size and last modified time of
+     * the document query, in the batches of the scan, opening no file.
+     */
+    void BM_ScanCacheValidateStats(benchmark::State &state) {
+        auto count = (size_t) state.range(0);
+        Library library(count);
+        ScanCache cache(library.path, kFieldKeys);
+        std::vector<std::string_view> identifiers(kBatchSize);
+        std::vector<int64_t> sizes(kBatchSize);
+        std::vector<int64_t> modified(kBatchSize);
+        std::vector<int64_t> lastModified(kBatchSize);
+        size_t unchanged = 0;
+        for (auto _: state) {
+            unchanged = 0;
+            for (size_t begin = 0; begin < count; begin += kBatchSize) {
+                size_t batch = std::min(kBatchSize, count - begin);
+                for (size_t i = 0; i < batch; i++) {
+                    identifiers[i] = library.identifiers[begin + i];
+                    sizes[i] = library.statOf(begin + i).size;
+                    modified[i] = library.statOf(begin + i).lastModified;
+                }
+                unchanged += cache.validate(identifiers.data(), sizes.data(), modified.data(),
+                                            batch, lastModified.data());
+            }
+        }
+        if (unchanged != count) {
+            state.SkipWithError("cached entries did not validate");
+        }
+        state.SetItemsProcessed((int64_t) (state.iterations() * count));
+    }
+
+    /**
+     * The same with a descriptor opened and closed per file, as the
+     * scan did before. On a device each open is a binder call to the
+     * document provider, so this is the lower bound of that cost.
+     */
+    void BM_ScanCacheValidateOpen(benchmark::State &state) {
+        auto count = (size_t) state.range(0);
+        Library library(count);
+        ScanCache cache(library.path, kFieldKeys);
+        std::vector<std::string_view> identifiers(kBatchSize);
+        std::vector<int32_t> descriptors(kBatchSize);
+        std::vector<int64_t> lastModified(kBatchSize);
+        size_t unchanged = 0;
+        for (auto _: state) {
+            unchanged = 0;
+            for (size_t begin = 0; begin < count; begin += kBatchSize) {
+                size_t batch = std::min(kBatchSize, count - begin);
+                for (size_t i = 0; i < batch; i++) {
+                    identifiers[i] = library.identifiers[begin + i];
+                    descriptors[i] = library.fileOf(begin + i).open();
+                }
+                unchanged += cache.validate(identifiers.data(), descriptors.data(), batch,
+                                            lastModified.data());
+                for (size_t i = 0; i < batch; i++) {
+                    close(descriptors[i]);
+                }
+            }
+        }
+        if (unchanged != count) {
+            state.SkipWithError("cached entries did not validate");
+        }
+        state.SetItemsProcessed((int64_t) (state.iterations() * count));
+    }
+
+    /**
+     * A whole rescan of an unchanged library through the cache: map
+     * it, validate every file by its columns, carry every entry over
+     * and write the new cache.
+     */
+    void BM_ScanCacheRescan(benchmark::State &state) {
+        auto count = (size_t) state.range(0);
+        Library library(count);
+        std::string next = library.path + ".next";
+        std::vector<int64_t> sizes(count);
+        std::vector<int64_t> modified(count);
+        std::vector<int64_t> lastModified(count);
+        std::vector<std::string_view> identifiers(library.identifiers.begin(),
+                                                  library.identifiers.end());
+        for (size_t i = 0; i < count; i++) {
+            sizes[i] = library.statOf(i).size;
+            modified[i] = library.statOf(i).lastModified;
+        }
+        for (auto _: state) {
+            ScanCache cache(library.path, kFieldKeys);
+            StringTable table;
+            ScanCacheWriter writer(kFieldKeys, table);
+            for (size_t begin = 0; begin < count; begin += kBatchSize) {
+                size_t batch = std::min(kBatchSize, count - begin);
+                cache.validate(identifiers.data() + begin, sizes.data() + begin,
+                               modified.data() + begin, batch, lastModified.data() + begin);
+            }
+            for (size_t i = 0; i < count; i++) {
+                if (lastModified[i] >= 0) {
+                    writer.keep(cache, identifiers[i]);
+                }
+            }
+            if (writer.size() != count || !writer.write(next)) {
+                state.SkipWithError("rescan did not keep every entry");
+                break;
+            }
+        }
+        std::remove(next.c_str());
+        state.SetItemsProcessed((int64_t) (state.iterations() * count));
+    }
+}
+
+BENCHMARK(BM_ScanCacheValidateStats)->ArgName("entries")->Arg(50000)
+        ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ScanCacheValidateOpen)->ArgName("entries")->Arg(50000)
+        ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ScanCacheRescan)->ArgName("entries")->Arg(50000)
+        ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include <benchmark/benchmark.h>
+
+#include <fstream>
+#include <string>
+#include <utility>
+
+#include <tags/tags.h>
+
+#include "samples.h"
+
+using namespace SoundSource;
+using namespace TagLib;
+
+namespace {
+    /**
+     * @return the read syscalls (read, pread and the like) the thread
+     * issued so far, -1 where the kernel does not account them.
+     */
+    int64_t readSyscalls() {
+        std::ifstream io("/proc/thread-self/io");
+        std::string key;
+        int64_t value;
+        while (io >> key >> value) {
+            if (key == "syscr:") {
+                return value;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * Counts the read syscalls of each iteration, less the ones reading
+     * /proc takes itself.
+     */
+    class ReadSyscalls {
+    public:
+        ReadSyscalls() {
+            int64_t first = readSyscalls();
+            overhead = readSyscalls() - first;
+        }
+
+        void start() {
+            begin = readSyscalls();
+        }
+
+        void stop() {
+            if (begin >= 0) {
+                total += readSyscalls() - begin - overhead;
+            }
+        }
+
+        void report(benchmark::State &state, int64_t readCalls) const {
+            if (begin >= 0) {
+                state.counters["read_syscalls"] = benchmark::Counter(
+                        (double) total, benchmark::Counter::kAvgIterations);
+            }
+            if (readCalls >= 0) {
+                state.counters["stream_calls"] = benchmark::Counter(
+                        (double) readCalls, benchmark::Counter::kAvgIterations);
+            }
+        }
+
+    private:
+        int64_t overhead = 0;
+        int64_t begin = -1;
+        int64_t total = 0;
+    };
+
+    /**
+     * What a library scan does per file: open, read every field and the
+     * audio properties. The FILE variant is TagLib's own FileStream, the
+     * baseline the others are measured against.
+     */
+    void BM_ReadTags(benchmark::State &state, const char *format, TagStream streamType) {
+        const Host::Sample &sample = Host::findSample(Host::tagSamples(), format);
+        Host::MemoryFile file(sample.data);
+        ReadSyscalls syscalls;
+        int64_t readCalls = 0;
+        for (auto _: state) {
+            syscalls.start();
+            AudioTagAccessor accessor(file.open(), true, streamType, sample.format);
+            if (accessor.isNull()) {
+                state.SkipWithError("TagLib rejected the sample");
+                break;
+            }
+            PropertyMap properties = accessor.tag()->properties();
+            benchmark::DoNotOptimize(properties);
+            AudioProperties *audioProperties = accessor.fileRef()->audioProperties();
+            benchmark::DoNotOptimize(audioProperties->lengthInMilliseconds());
+            syscalls.stop();
+            readCalls += accessor.readCalls();
+        }
+        syscalls.report(state, streamType == TagStream::FILE ? -1 : readCalls);
+        state.SetBytesProcessed(state.iterations() * (int64_t) sample.data.size());
+    }
+
+    void BM_ReadArtwork(benchmark::State &state, const char *format, TagStream streamType) {
+        const Host::Sample &sample = Host::findSample(Host::tagSamples(), format);
+        Host::MemoryFile file(sample.data);
+        ReadSyscalls syscalls;
+        int64_t readCalls = 0;
+        for (auto _: state) {
+            syscalls.start();
+            AudioTagAccessor accessor(file.open(), true, streamType, sample.format);
+            if (accessor.isNull()) {
+                state.SkipWithError("TagLib rejected the sample");
+                break;
+            }
+            List<VariantMap> pictures = accessor.fileRef()->file()->complexProperties("PICTURE");
+            if (pictures.isEmpty()) {
+                state.SkipWithError("no picture read");
+                break;
+            }
+            benchmark::DoNotOptimize(pictures.front()["data"].toByteVector().size());
+            syscalls.stop();
+            readCalls += accessor.readCalls();
+        }
+        syscalls.report(state, streamType == TagStream::FILE ? -1 : readCalls);
+    }
+
+    [[maybe_unused]] const bool registered = [] {
+        const std::pair<const char *, TagStream> streams[] = {
+                {"file", TagStream::FILE},
+                {"windowed", TagStream::WINDOWED},
+                {"mapped", TagStream::MAPPED},
+        };
+        for (const auto &sample: Host::tagSamples()) {
+            const char *format = sample.name.c_str();
+            for (const auto &[name, streamType]: streams) {
+                std::string suffix = "/" + sample.name + "/" + name;
+                benchmark::RegisterBenchmark(("BM_ReadTags" + suffix).c_str(),
+                                             BM_ReadTags, format, streamType);
+                benchmark::RegisterBenchmark(("BM_ReadArtwork" + suffix).c_str(),
+                                             BM_ReadArtwork, format, streamType);
+            }
+        }
+        return true;
+    }();
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <vector>
+
+#include <audio/waveform.h>
+#include <decoder/flac_decoder.h>
+
+#include "samples.h"
+
+using namespace SoundSource;
+using namespace SoundSource::Audio;
+using namespace SoundSource::Decoder;
+
+namespace {
+    constexpr int32_t kBucketCount = 1024;
+    constexpr int32_t kReadFrames = 4096;
+    // a typical track
+    constexpr double kTrackSeconds = 240;
+    constexpr Host::PcmFormat kFormat{2, 44100, 16};
+
+    const Host::MemoryFile &flacTrack() {
+        static const Host::MemoryFile file(
+                Host::encodeFlac(Host::musicPcm(kFormat, kTrackSeconds), kFormat));
+        return file;
+    }
+
+    /**
+     * The builder alone over decoded stereo, reported as audio seconds
+     * summarized per second ("realtime").
+     */
+    void BM_WaveformBuild(benchmark::State &state) {
+        std::vector<float> in((size_t) kReadFrames * kFormat.channels);
+        auto samples = Host::musicPcm(kFormat, (double) kReadFrames / kFormat.sampleRate);
+        for (size_t i = 0; i < in.size(); i++) {
+            in[i] = (float) samples[i] / 32768.0f;
+        }
+        const int64_t frames = (int64_t) (kTrackSeconds * kFormat.sampleRate);
+        for (auto _: state) {
+            WaveformBuilder builder(kFormat.channels, kFormat.sampleRate, kBucketCount);
+            for (int64_t done = 0; done < frames; done += kReadFrames) {
+                builder.process(in.data(), kReadFrames);
+            }
+            builder.finish();
+            benchmark::DoNotOptimize(builder.serialize());
+        }
+        state.SetItemsProcessed(state.iterations() * frames);
+        state.counters["realtime"] = benchmark::Counter(
+                (double) state.iterations() * kTrackSeconds, benchmark::Counter::kIsRate);
+    }
+
+    /**
+     * What WaveformWorker does per track on one thread: decode a four
+     * minute 16-bit FLAC, summarize and serialize it, reported as
+     * tracks per minute.
+     */
+    void BM_WaveformExtract(benchmark::State &state) {
+        const auto &file = flacTrack();
+        std::vector<float> buffer((size_t) kReadFrames * kFormat.channels);
+        auto start = std::chrono::steady_clock::now();
+        for (auto _: state) {
+            FlacDecoder decoder(file.fileDescriptor());
+            if (!decoder.open()) {
+                state.SkipWithError("decode failed");
+                return;
+            }
+            WaveformBuilder builder(decoder.channels(), decoder.sampleRate(), kBucketCount);
+            int32_t read;
+            while ((read = decoder.read(buffer.data(), kReadFrames)) > 0) {
+                builder.process(buffer.data(), read);
+            }
+            builder.finish();
+            benchmark::DoNotOptimize(builder.serialize());
+        }
+        // a plain counter, a rate would be printed per second
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        state.counters["tracks_per_minute"] = (double) state.iterations() * 60 / elapsed.count();
+    }
+}
+
+BENCHMARK(BM_WaveformBuild)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_WaveformExtract)->Unit(benchmark::kMillisecond);
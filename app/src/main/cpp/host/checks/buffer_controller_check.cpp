@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include <algorithm>
+#include <random>
+
+#include <audio/buffer_controller.h>
+
+#include "check.h"
+
+using namespace SoundSource;
+using namespace SoundSource::Audio;
+
+namespace {
+    constexpr int32_t kSampleRate = 48000;
+    constexpr int32_t kBurst = 192;
+    constexpr int32_t kCapacity = 32 * kBurst;
+    constexpr int64_t kStablePeriod = 10'000'000'000LL;
+    constexpr int64_t kBurstNanos = (int64_t) kBurst * 1'000'000'000LL / kSampleRate;
+    constexpr int64_t kTick = 100'000;
+    constexpr int64_t kSecond = 1'000'000'000LL;
+
+    /**
+     * Callback durations: the usual fraction of a millisecond, and
+     * stalls of a few to many milliseconds with some probability.
+     */
+    struct Load {
+        double stallChance;
+        double minStallMillis;
+        double maxStallMillis;
+    };
+
+    const Load kIdle{0, 0, 0};
+
+    struct Phase {
+        int64_t untilNanos;
+        Load load;
+    };
+
+    struct Result {
+        int32_t underruns = 0;
+        int32_t maxSize = 0;
+        int32_t finalSize = 0;
+        // per phase
+        std::vector<int32_t> phaseUnderruns;
+        std::vector<int32_t> phaseMaxSize;
+        std::vector<int32_t> phaseEndSize;
+    };
+
+    /**
+     * Simulates an output stream: the device takes a burst every burst
+     * period, and starves if less than a burst is queued. The data
+     * callback is invoked while the queue is a burst below the buffer
+     * size, and queues its burst when it returns. The controller sees
+     * the underrun count on every callback, as in OboeOutput.
+     *
+     * @param adaptive false to keep the initial two bursts.
+     */
+    Result simulate(const std::vector<Phase> &phases, bool adaptive, uint32_t seed) {
+        std::mt19937 random(seed);
+        // the distributions of <random> differ between libraries
+        auto uniform = [&random]() { return (random() >> 8) * (1.0 / (1 << 24)); };
+
+        BufferSizeController controller(kBurst, kCapacity, 2 * kBurst, kStablePeriod);
+        Result result;
+        int32_t queued = 2 * kBurst;
+        int32_t size = controller.bufferSize();
+        int64_t nextDrain = kBurstNanos;
+        int64_t callbackEnd = -1;
+        size_t phase = 0;
+        result.phaseUnderruns.assign(phases.size(), 0);
+        result.phaseMaxSize.assign(phases.size(), 0);
+        result.phaseEndSize.assign(phases.size(), 0);
+
+        for (int64_t now = 0; now < phases.back().untilNanos; now += kTick) {
+            if (now >= phases[phase].untilNanos) {
+                result.phaseEndSize[phase] = size;
+                phase++;
+            }
+            if (now >= nextDrain) {
+                nextDrain += kBurstNanos;
+                if (queued < kBurst) {
+                    result.underruns++;
+                    result.phaseUnderruns[phase]++;
+                    queued = 0;
+                } else {
+                    queued -= kBurst;
+                }
+            }
+            if (callbackEnd >= 0 && now >= callbackEnd) {
+                queued += kBurst;
+                callbackEnd = -1;
+            }
+            if (callbackEnd < 0 && queued <= size - kBurst) {
+                if (adaptive) {
+                    size = controller.update(result.underruns, now);
+                }
+                const Load &load = phases[phase].load;
+                double millis = 0.3 + 0.4 * uniform();
+                if (uniform() < load.stallChance) {
+                    millis = load.minStallMillis +
+                             (load.maxStallMillis - load.minStallMillis) * uniform();
+                }
+                callbackEnd = now + (int64_t) (millis * 1e6);
+            }
+            result.maxSize = std::max(result.maxSize, size);
+            result.phaseMaxSize[phase] = std::max(result.phaseMaxSize[phase], size);
+        }
+        result.phaseEndSize[phase] = size;
+        result.finalSize = size;
+        return result;
+    }
+}
+
+/**
+ * Replays the buffer size controller against injected callback jitter,
+ * deterministically, and compares it with a fixed two burst buffer.
+ */
+int main() {
+    // a minute of thermal load between quiet stretches
+    const std::vector<Phase> thermal{
+            {60 * kSecond, kIdle},
+            {120 * kSecond, {0.02, 6, 16}},
+            {300 * kSecond, kIdle},
+    };
+    for (uint32_t seed = 1; seed <= 3; seed++) {
+        Result adaptive = simulate(thermal, true, seed);
+        Result fixed = simulate(thermal, false, seed);
+        std::printf("thermal load, seed %u: %d underruns (fixed buffer %d), "
+                    "peak %d bursts, %d bursts at the end\n",
+                    seed, adaptive.underruns, fixed.underruns, adaptive.maxSize / kBurst,
+                    adaptive.finalSize / kBurst);
+        Host::expect(adaptive.phaseUnderruns[0] == 0 && adaptive.phaseMaxSize[0] == 2 * kBurst,
+                     "quiet start stays at two bursts without underruns");
+        Host::expect(adaptive.underruns * 10 <= fixed.underruns,
+                     "at most a tenth of the underruns of a fixed buffer (%d vs %d)",
+                     adaptive.underruns, fixed.underruns);
+        Host::expect(adaptive.maxSize <= 8 * kBurst,
+                     "peak size within 8 bursts (%d)", adaptive.maxSize / kBurst);
+        Host::expect(adaptive.phaseUnderruns[2] == 0 && adaptive.finalSize <= 3 * kBurst,
+                     "no underruns after the load and back to at most 3 bursts (%d)",
+                     adaptive.finalSize / kBurst);
+    }
+
+    // stalls that never stop: the floor keeps the size from shrinking
+    // into underruns again after every stable period
+    const std::vector<Phase> sustained{
+            {60 * kSecond, {0.01, 5, 9}},
+            {600 * kSecond, {0.01, 5, 9}},
+    };
+    for (uint32_t seed = 1; seed <= 3; seed++) {
+        Result adaptive = simulate(sustained, true, seed);
+        Result fixed = simulate(sustained, false, seed);
+        std::printf("sustained load, seed %u: %d underruns in the first minute, %d after "
+                    "(fixed buffer %d), %d bursts at the end\n",
+                    seed, adaptive.phaseUnderruns[0], adaptive.phaseUnderruns[1],
+                    fixed.underruns, adaptive.finalSize / kBurst);
+        // the floor decays after six quiet periods and the shrink that
+        // follows probes a smaller size, which may cost an underrun
+        int32_t probes = (int32_t) ((sustained[1].untilNanos - sustained[0].untilNanos) /
+                                    (6 * kStablePeriod));
+        Host::expect(adaptive.phaseUnderruns[1] <= probes + 2,
+                     "once settled, about one underrun per floor decay (%d, %d decays)",
+                     adaptive.phaseUnderruns[1], probes);
+        Host::expect(adaptive.underruns * 10 <= fixed.underruns,
+                     "at most a tenth of the underruns of a fixed buffer (%d vs %d)",
+                     adaptive.underruns, fixed.underruns);
+        Host::expect(adaptive.maxSize <= 8 * kBurst,
+                     "peak size within 8 bursts (%d)", adaptive.maxSize / kBurst);
+    }
+    return Host::checkExitCode();
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_HOST_CHECK_H
+#define SOUNDSOURCE_HOST_CHECK_H
+
+#include <sys/types.h>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+
+/**
+ * The expectations of a host check, a plain executable that prints what
+ * it measured and exits with 1 if any expectation failed.
+ */
+namespace SoundSource::Host {
+    inline int32_t &checkFailures() {
+        static int32_t failures = 0;
+        return failures;
+    }
+
+    /**
+     * Print the formatted line, marked as failed unless the condition
+     * holds.
+     */
+    __attribute__((format(printf, 2, 3)))
+    inline void expect(bool condition, const char *format, ...) {
+        va_list args;
+        va_start(args, format);
+        std::printf("%s ", condition ? "ok  " : "FAIL");
+        std::vprintf(format, args);
+        std::printf("\n");
+        va_end(args);
+        if (!condition) {
+            checkFailures()++;
+        }
+    }
+
+    inline int checkExitCode() {
+        std::printf("%d failed\n", checkFailures());
+        return checkFailures() == 0 ? 0 : 1;
+    }
+}
+
+#endif //SOUNDSOURCE_HOST_CHECK_H
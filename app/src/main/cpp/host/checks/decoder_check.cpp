@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include <decoder/flac_decoder.h>
+#include <decoder/pcm_decoder.h>
+
+#include "samples.h"
+#include "check.h"
+
+using namespace SoundSource;
+using namespace SoundSource::Decoder;
+
+namespace {
+    constexpr int32_t kReadFrames = 4096;
+
+    /**
+     * Decode from the given frame to the end and compare every sample
+     * with the source, scaled the way the decoders scale.
+     *
+     * @return the count of samples that differ, -1 if decoding failed.
+     */
+    int64_t compare(AudioDecoder &decoder, const std::vector<int32_t> &samples,
+                    int32_t bits, int64_t from) {
+        const int32_t channels = decoder.channels();
+        const double scale = 1.0 / (double) (1ll << (bits - 1));
+        std::vector<float> out((size_t) kReadFrames * channels);
+        auto position = (size_t) (from * channels);
+        int64_t mismatches = 0;
+        int32_t read;
+        while ((read = decoder.read(out.data(), kReadFrames)) > 0) {
+            for (size_t i = 0; i < (size_t) read * channels; i++, position++) {
+                if (position >= samples.size() ||
+                    out[i] != (float) (samples[position] * scale)) {
+                    mismatches++;
+                }
+            }
+        }
+        if (read < 0) {
+            return -1;
+        }
+        return mismatches + (int64_t) (samples.size() - std::min(position, samples.size()));
+    }
+
+    void check(const char *name, const Host::PcmFormat &format, double seconds) {
+        auto samples = Host::musicPcm(format, seconds);
+        Host::Bytes data = name[0] == 'F' ? Host::encodeFlac(samples, format)
+                           : name[0] == 'W' ? Host::encodeWav(samples, format)
+                                            : Host::encodeAiff(samples, format);
+        Host::MemoryFile file(data);
+        auto open = [&]() -> std::unique_ptr<AudioDecoder> {
+            if (name[0] == 'F') {
+                return std::make_unique<FlacDecoder>(file.fileDescriptor());
+            }
+            return std::make_unique<PcmDecoder>(file.fileDescriptor());
+        };
+
+        auto decoder = open();
+        bool opened = decoder->open() && decoder->channels() == format.channels &&
+                      decoder->sampleRate() == format.sampleRate;
+        int64_t mismatches = opened ? compare(*decoder, samples, format.bitsPerSample, 0) : -1;
+        Host::expect(mismatches == 0, "%-4s %d ch %2d bit %6d Hz %5.2f s: %lld mismatches",
+                     name, format.channels, format.bitsPerSample, format.sampleRate,
+                     seconds, (long long) mismatches);
+
+        // into the middle of a block, then to the end
+        int64_t frames = (int64_t) samples.size() / format.channels;
+        int64_t target = frames / 3 + 1;
+        mismatches = decoder->seek(target)
+                     ? compare(*decoder, samples, format.bitsPerSample, target) : -1;
+        Host::expect(mismatches == 0, "%-4s %d ch %2d bit %6d Hz seek %lld: %lld mismatches",
+                     name, format.channels, format.bitsPerSample, format.sampleRate,
+                     (long long) target, (long long) mismatches);
+    }
+}
+
+/**
+ * FLAC, WAV and AIFF files written by the host samples, decoded sample
+ * for sample, from the start and after a seek.
+ */
+int main() {
+    const Host::PcmFormat formats[] = {
+            {2, 44100, 16},
+            {2, 96000, 24},
+            {1, 48000, 16},
+            {6, 48000, 24},
+    };
+    for (const char *name: {"FLAC", "WAV", "AIFF"}) {
+        for (const auto &format: formats) {
+            // a partial last block
+            check(name, format, 1.37);
+        }
+    }
+    return Host::checkExitCode();
+}
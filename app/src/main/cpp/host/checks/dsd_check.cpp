@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include <cmath>
+#include <vector>
+
+#include <decoder/dsd_decoder.h>
+
+#include "samples.h"
+#include "check.h"
+
+using namespace SoundSource;
+using namespace SoundSource::Decoder;
+
+namespace {
+    constexpr int32_t kReadFrames = 1000;
+    constexpr double kSeconds = 1.3;
+
+    struct Case {
+        bool dsf;
+        int32_t channels;
+        int32_t dsdRate;
+        // a few dB under the SNR the second order modulator allows
+        double minSnr;
+    };
+
+    struct Fit {
+        double amplitude;
+        double snr;
+    };
+
+    /**
+     * Least squares fit of the sine of the channel, skipping the first
+     * and last 100 ms.
+     */
+    Fit fitSine(const std::vector<float> &pcm, int32_t channels, int32_t channel, int32_t rate) {
+        const double frequency = 1000.0 * (channel + 1);
+        const auto frames = (int64_t) (pcm.size() / channels);
+        double ss = 0, cc = 0, sc = 0, sx = 0, cx = 0;
+        for (int64_t i = rate / 10; i < frames - rate / 10; i++) {
+            double t = 2 * M_PI * frequency * (double) i / rate;
+            double s = std::sin(t), c = std::cos(t), x = pcm[(size_t) (i * channels + channel)];
+            ss += s * s;
+            cc += c * c;
+            sc += s * c;
+            sx += s * x;
+            cx += c * x;
+        }
+        double det = ss * cc - sc * sc;
+        double a = (sx * cc - cx * sc) / det;
+        double b = (cx * ss - sx * sc) / det;
+        double residual = 0;
+        int64_t count = 0;
+        for (int64_t i = rate / 10; i < frames - rate / 10; i++, count++) {
+            double t = 2 * M_PI * frequency * (double) i / rate;
+            double error = pcm[(size_t) (i * channels + channel)] - a * std::sin(t) - b * std::cos(t);
+            residual += error * error;
+        }
+        double amplitude = std::hypot(a, b);
+        return {amplitude, 20 * std::log10(amplitude / std::sqrt(2 * residual / (double) count))};
+    }
+
+    void check(const Case &c) {
+        auto planes = Host::modulateDsd(c.channels, c.dsdRate, kSeconds, c.dsf);
+        Host::MemoryFile file(c.dsf ? Host::encodeDsf(planes, c.dsdRate)
+                                    : Host::encodeDsdiff(planes, c.dsdRate));
+        const char *name = c.dsf ? "DSF" : "DSDIFF";
+        const int32_t multiple = c.dsdRate / (c.dsdRate % 44100 == 0 ? 44100 : 48000);
+
+        DsdDecoder decoder(file.fileDescriptor());
+        if (!decoder.open()) {
+            Host::expect(false, "%-6s DSD%d %d ch: open failed", name, multiple, c.channels);
+            return;
+        }
+        std::vector<float> pcm;
+        std::vector<float> buffer((size_t) kReadFrames * c.channels);
+        int32_t read;
+        while ((read = decoder.read(buffer.data(), kReadFrames)) > 0) {
+            pcm.insert(pcm.end(), buffer.begin(), buffer.begin() + read * c.channels);
+        }
+        const auto frames = (int64_t) (pcm.size() / c.channels);
+        const int32_t rate = decoder.sampleRate();
+        Host::expect(read == 0 && frames == decoder.totalFrames() &&
+                     frames == (int64_t) planes[0].size() * 8 * rate / c.dsdRate,
+                     "%-6s DSD%d %d ch: %lld frames at %d Hz", name, multiple, c.channels,
+                     (long long) frames, rate);
+
+        for (int32_t ch = 0; ch < c.channels; ch++) {
+            Fit fit = fitSine(pcm, c.channels, ch, rate);
+            // the half scale input comes out at -6 dBFS
+            Host::expect(std::abs(fit.amplitude - 0.5) < 0.005 && fit.snr > c.minSnr,
+                         "%-6s DSD%d ch %d: amplitude %.4f, SNR %.1f dB", name, multiple, ch,
+                         fit.amplitude, fit.snr);
+        }
+
+        int64_t target = frames / 2 + 7;
+        bool sought = decoder.seek(target);
+        read = sought ? decoder.read(buffer.data(), kReadFrames) : -1;
+        double difference = 0;
+        for (int32_t i = 0; i < read * c.channels; i++) {
+            difference = std::max(difference, (double) std::abs(
+                    buffer[i] - pcm[(size_t) (target * c.channels + i)]));
+        }
+        Host::expect(read == kReadFrames && difference < 1e-6,
+                     "%-6s DSD%d seek %lld: %d frames, max difference %.2e", name, multiple,
+                     (long long) target, read, difference);
+    }
+}
+
+/**
+ * DSF and DSDIFF files of modulated sines at every supported rate,
+ * decoded whole and after a seek.
+ */
+int main() {
+    const Case cases[] = {
+            {true, 2, 2822400, 58},
+            {false, 2, 2822400, 58},
+            {true, 3, 5644800, 73},
+            {false, 2, 5644800, 73},
+            {true, 2, 11289600, 88},
+            {false, 6, 11289600, 88},
+            // the 48 kHz family
+            {true, 2, 3072000, 58},
+            {false, 1, 6144000, 73},
+    };
+    for (const Case &c: cases) {
+        check(c);
+    }
+    return Host::checkExitCode();
+}
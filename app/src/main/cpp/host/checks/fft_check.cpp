@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <random>
+#include <vector>
+
+#include <audio/fft.h>
+#include <audio/spectrum.h>
+
+#include "check.h"
+
+using namespace SoundSource;
+using namespace SoundSource::Audio;
+
+namespace {
+    /**
+     * Compare the transform of white noise with a direct DFT in double
+     * precision.
+     *
+     * @return the largest error relative to the largest bin.
+     */
+    double relativeError(int32_t n) {
+        RealFft fft(n);
+        std::vector<float> in((size_t) n);
+        std::vector<float> re((size_t) n / 2 + 1);
+        std::vector<float> im((size_t) n / 2 + 1);
+        std::mt19937 random((uint32_t) n);
+        std::uniform_real_distribution<float> uniform(-1, 1);
+        for (float &value: in) {
+            value = uniform(random);
+        }
+        fft.forward(in.data(), re.data(), im.data());
+
+        double error = 0;
+        double largest = 0;
+        for (int32_t k = 0; k <= n / 2; k++) {
+            std::complex<double> sum = 0;
+            for (int32_t t = 0; t < n; t++) {
+                // the index product modulo n keeps the angle exact
+                double angle = -2 * M_PI * (double) (((int64_t) k * t) % n) / n;
+                sum += (double) in[t] * std::polar(1.0, angle);
+            }
+            error = std::max(error, std::abs(sum - std::complex<double>(re[k], im[k])));
+            largest = std::max(largest, std::abs(sum));
+        }
+        return error / largest;
+    }
+
+    /**
+     * @return the loudest band of the last bands read while a second
+     * of a full scale sine is fed in 10 ms blocks.
+     */
+    float sineLevel(double frequency) {
+        constexpr int32_t kRate = 48000;
+        SpectrumAnalyzer analyzer(2048, 32);
+        analyzer.configure(1, kRate);
+        std::vector<float> in(kRate);
+        for (int32_t i = 0; i < kRate; i++) {
+            in[i] = (float) std::sin(2 * M_PI * frequency * i / kRate);
+        }
+        std::vector<float> bands((size_t) analyzer.bandCount());
+        float level = SPECTRUM_FLOOR_DB;
+        for (int32_t frame = 0; frame < kRate; frame += 480) {
+            analyzer.process(in.data() + frame, 480);
+            if (analyzer.read(bands.data())) {
+                level = *std::max_element(bands.begin(), bands.end());
+            }
+        }
+        return level;
+    }
+}
+
+/**
+ * RealFft against a direct DFT for every size from 8 to 4096, and the
+ * level the analyser reports for full scale sines.
+ */
+int main() {
+    for (int32_t n = 8; n <= 4096; n *= 2) {
+        double error = relativeError(n);
+        // single precision rounding grows with log2(n)
+        Host::expect(error < 1e-6, "fft %4d points: relative error %.2e", n, error);
+    }
+    for (double frequency: {100.0, 1000.0, 10000.0}) {
+        float level = sineLevel(frequency);
+        // the Hann window loses up to 1.4 dB between bin centres
+        Host::expect(level <= 0.1f && level > -1.5f,
+                     "spectrum sine %5.0f Hz: %.2f dBFS", frequency, level);
+    }
+    return Host::checkExitCode();
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <audio/gain.h>
+
+#include "samples.h"
+#include "check.h"
+
+using namespace SoundSource;
+using namespace SoundSource::Audio;
+
+namespace {
+    constexpr int32_t kChannels = 2;
+    constexpr int32_t kRate = 44100;
+    constexpr int32_t kBlockFrames = 1024;
+
+    std::vector<float> music(double gainDb) {
+        std::vector<int32_t> pcm = Host::musicPcm({kChannels, kRate, 16}, 2.0);
+        std::vector<float> out(pcm.size());
+        auto gain = (float) std::pow(10.0, gainDb / 20.0);
+        for (size_t i = 0; i < pcm.size(); i++) {
+            out[i] = (float) pcm[i] / 32768.0f * gain;
+        }
+        return out;
+    }
+
+    /**
+     * Feed the input in blocks and then the latency in silence, the way
+     * the audio processor drains at the end of stream, and drop the
+     * latency from the head of the output.
+     *
+     * @param changeFrame the frame from whose block on changeGainDb
+     * applies, -1 for none.
+     * @return as many frames as the input.
+     */
+    std::vector<float> processPrimed(GainProcessor &processor, std::vector<float> in,
+                                     int32_t changeFrame = -1, float changeGainDb = 0.0f) {
+        const int32_t latency = processor.latencyFrames();
+        in.resize(in.size() + (size_t) latency * kChannels, 0.0f);
+        auto frames = (int32_t) (in.size() / kChannels);
+        for (int32_t frame = 0; frame < frames; frame += kBlockFrames) {
+            if (frame == changeFrame) {
+                processor.setGain(changeGainDb);
+            }
+            processor.process(in.data() + (size_t) frame * kChannels,
+                              std::min(kBlockFrames, frames - frame));
+        }
+        in.erase(in.begin(), in.begin() + (ptrdiff_t) latency * kChannels);
+        return in;
+    }
+
+    /**
+     * @return the largest difference between the output and the input
+     * times the gain.
+     */
+    float error(const std::vector<float> &in, const std::vector<float> &out, float gain) {
+        float largest = 0;
+        for (size_t i = 0; i < in.size(); i++) {
+            largest = std::max(largest, std::fabs(out[i] - in[i] * gain));
+        }
+        return largest;
+    }
+
+    float samplePeak(const std::vector<float> &samples) {
+        float peak = 0;
+        for (float value: samples) {
+            peak = std::max(peak, std::fabs(value));
+        }
+        return peak;
+    }
+}
+
+/**
+ * The output of the ReplayGain processor lines up with its input once
+ * the latency is dropped from the head and drained at the end, is the
+ * exact input at 0 dB, and stays under the ceiling when the gain
+ * pushes the peaks over it.
+ */
+int main() {
+    std::vector<float> loud = music(0.0);
+    std::vector<float> quiet = music(-20.0);
+
+    GainProcessor unity(kChannels, kRate);
+    unity.setGain(0.0f);
+    unity.reset();
+    std::vector<float> out = processPrimed(unity, loud);
+    float difference = error(loud, out, 1.0f);
+    Host::expect(difference == 0.0f, "0 dB: output differs from the input by %g", difference);
+
+    GainProcessor attenuating(kChannels, kRate);
+    attenuating.setGain(-6.0f);
+    attenuating.reset();
+    out = processPrimed(attenuating, quiet);
+    difference = error(quiet, out, std::pow(10.0f, -6.0f / 20.0f));
+    Host::expect(difference < 1e-6f, "-6 dB: output differs from the gained input by %g",
+                 difference);
+
+    GainProcessor boosting(kChannels, kRate);
+    boosting.setGain(12.0f);
+    boosting.reset();
+    out = processPrimed(boosting, loud);
+    float peak = samplePeak(out);
+    // the gain is the mean of the window, rounded to float
+    Host::expect(peak <= 0.891f + 1e-4f, "+12 dB: sample peak %.5f, ceiling 0.891", peak);
+
+    // a gain set midway ramps in over one block, without a gap or a
+    // shift in time
+    GainProcessor midway(kChannels, kRate);
+    midway.setGain(0.0f);
+    midway.reset();
+    constexpr int32_t kChangeFrame = 32 * kBlockFrames;
+    out = processPrimed(midway, quiet, kChangeFrame, -6.0f);
+    const auto change = (ptrdiff_t) kChangeFrame * kChannels;
+    const auto ramped = change + (ptrdiff_t) kBlockFrames * kChannels;
+    float before = error(std::vector<float>(quiet.begin(), quiet.begin() + change),
+                         std::vector<float>(out.begin(), out.begin() + change), 1.0f);
+    float after = error(std::vector<float>(quiet.begin() + ramped, quiet.end()),
+                        std::vector<float>(out.begin() + ramped, out.end()),
+                        std::pow(10.0f, -6.0f / 20.0f));
+    Host::expect(before == 0.0f && after < 1e-6f,
+                 "-6 dB midway: differs by %g before and %g after the ramp", before, after);
+    return Host::checkExitCode();
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <audio/loudness.h>
+
+#include "check.h"
+
+using namespace SoundSource;
+using namespace SoundSource::Audio;
+
+namespace {
+    constexpr int32_t kRate = 48000;
+
+    struct Tone {
+        /**
+         * Peak level of the sine in dBFS, per channel.
+         */
+        std::vector<double> levels;
+        double seconds;
+    };
+
+    /**
+     * The sines of the tones one after another, in phase on every
+     * channel, as EBU Tech 3341 describes its test signals.
+     */
+    std::vector<float> tones(const std::vector<Tone> &sequence, double frequency) {
+        std::vector<float> out;
+        int64_t frame = 0;
+        for (const Tone &tone: sequence) {
+            auto channels = (int32_t) tone.levels.size();
+            auto frames = (int64_t) std::llround(tone.seconds * kRate);
+            for (int64_t i = 0; i < frames; i++, frame++) {
+                double value = std::sin(2 * M_PI * frequency * (double) frame / kRate);
+                for (int32_t c = 0; c < channels; c++) {
+                    out.push_back((float) (value * std::pow(10.0, tone.levels[c] / 20.0)));
+                }
+            }
+        }
+        return out;
+    }
+
+    /**
+     * Feed the samples in blocks of the size the scan decodes.
+     */
+    void measure(LoudnessMeter &meter, const std::vector<float> &samples, size_t from,
+                 size_t to) {
+        const auto channels = (size_t) meter.channels();
+        constexpr size_t kBlockFrames = 4096;
+        for (size_t frame = from; frame < to; frame += kBlockFrames) {
+            size_t count = std::min(kBlockFrames, to - frame);
+            meter.process(samples.data() + frame * channels, (int32_t) count);
+        }
+    }
+
+    double integrated(int32_t channels, const std::vector<Tone> &sequence) {
+        LoudnessMeter meter(channels, kRate);
+        std::vector<float> samples = tones(sequence, 1000.0);
+        measure(meter, samples, 0, samples.size() / channels);
+        return meter.integratedLoudness();
+    }
+
+    /**
+     * @return the true peak in dBTP of a sine of a fraction of the rate,
+     * sampled at the given phase so that no sample hits its peak. The
+     * sine fades in over 10 ms, the reconstruction of a step to it would
+     * overshoot.
+     */
+    double truePeak(double fraction, double phaseDegrees, double level) {
+        LoudnessMeter meter(2, kRate);
+        std::vector<float> samples;
+        double amplitude = std::pow(10.0, level / 20.0);
+        constexpr int32_t kFadeFrames = kRate / 100;
+        for (int32_t i = 0; i < kRate; i++) {
+            double fade = i < kFadeFrames ? 0.5 - 0.5 * std::cos(M_PI * i / kFadeFrames) : 1.0;
+            double value = fade * amplitude *
+                           std::sin(2 * M_PI * fraction * i + phaseDegrees * M_PI / 180.0);
+            samples.push_back((float) value);
+            samples.push_back((float) value);
+        }
+        measure(meter, samples, 0, kRate);
+        return 20.0 * std::log10(meter.truePeak());
+    }
+
+    /**
+     * An album of the sequence split into two tracks, the merged gated
+     * blocks against the sequence measured as one.
+     */
+    double albumError(const std::vector<Tone> &sequence) {
+        std::vector<float> samples = tones(sequence, 1000.0);
+        size_t frames = samples.size() / 2;
+        LoudnessMeter whole(2, kRate);
+        measure(whole, samples, 0, frames);
+
+        // a split on a block boundary, so both see the same blocks
+        size_t split = frames / 2 / (kRate / 10) * (kRate / 10);
+        LoudnessMeter first(2, kRate);
+        LoudnessMeter second(2, kRate);
+        measure(first, samples, 0, split);
+        measure(second, samples, split, frames);
+        AlbumLoudness album;
+        album.add(first);
+        album.add(second);
+        return std::fabs(album.integratedLoudness() - whole.integratedLoudness());
+    }
+}
+
+/**
+ * The minimum requirements of EBU Tech 3341 the meter can be fed
+ * without the reference files: the integrated loudness of cases 1 to 6
+ * within 0.1 LU, and the true peak of full scale sines peaking between
+ * samples within the +0.2/-0.4 dB of its true peak cases.
+ */
+int main() {
+    const std::vector<double> stereo23{-23.0, -23.0};
+    const struct {
+        const char *name;
+        std::vector<Tone> sequence;
+        double expected;
+    } cases[] = {
+            {"case 1", {{stereo23, 20}}, -23.0},
+            {"case 2", {{{-33.0, -33.0}, 20}}, -33.0},
+            {"case 3", {{{-36.0, -36.0}, 10}, {stereo23, 60}, {{-36.0, -36.0}, 10}}, -23.0},
+            {"case 4", {{{-72.0, -72.0}, 10}, {{-36.0, -36.0}, 10}, {stereo23, 60},
+                        {{-36.0, -36.0}, 10}, {{-72.0, -72.0}, 10}}, -23.0},
+            {"case 5", {{{-26.0, -26.0}, 20}, {{-20.0, -20.0}, 20.1},
+                        {{-26.0, -26.0}, 20}}, -23.0},
+            // L R C LFE Ls Rs, the LFE silent
+            {"case 6", {{{-28.0, -28.0, -24.0, -200.0, -30.0, -30.0}, 20}}, -23.0},
+    };
+    for (const auto &c: cases) {
+        auto channels = (int32_t) c.sequence.front().levels.size();
+        double loudness = integrated(channels, c.sequence);
+        Host::expect(std::fabs(loudness - c.expected) <= 0.1,
+                     "integrated %s: %.2f LUFS, expected %.1f", c.name, loudness, c.expected);
+    }
+
+    const struct {
+        double fraction;
+        double phase;
+        double level;
+    } peaks[] = {
+            {0.25, 45.0, 0.0},
+            {0.25, 60.0, -6.0},
+            {1.0 / 6.0, 60.0, 0.0},
+            {0.125, 67.5, 0.0},
+    };
+    for (const auto &p: peaks) {
+        double peak = truePeak(p.fraction, p.phase, p.level);
+        Host::expect(peak >= p.level - 0.4 && peak <= p.level + 0.2,
+                     "true peak of fs/%.0f at %4.1f deg: %.2f dBTP, expected %.1f",
+                     1.0 / p.fraction, p.phase, peak, p.level);
+    }
+
+    double error = albumError({{{-26.0, -26.0}, 20}, {{-20.0, -20.0}, 20}});
+    // the bins of the merged histograms hold the exact energies
+    Host::expect(error <= 0.01, "album of two tracks against one: %.3f LU apart", error);
+    return Host::checkExitCode();
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include <metrics.h>
+
+#include "check.h"
+
+using namespace SoundSource;
+
+namespace {
+    constexpr int32_t kFlac = 1;
+    constexpr int32_t kThreads = 8;
+    constexpr int64_t kRecordsPerThread = 100000;
+    // version, formats, counters, histograms, buckets
+    constexpr size_t kHeader = 5;
+
+    struct View {
+        std::vector<int64_t> values;
+
+        int64_t counter(Metrics::Counter counter, int32_t format) const {
+            return values[kHeader + (size_t) counter * Metrics::kFormatCount + format];
+        }
+
+        /**
+         * @param cell 0 for the count, 1 for the sum, 2 + bucket.
+         */
+        int64_t histogram(Metrics::Histogram histogram, int32_t format, int32_t cell) const {
+            size_t counters = (size_t) Metrics::Counter::COUNT * Metrics::kFormatCount;
+            size_t index = ((size_t) histogram * Metrics::kFormatCount + format) *
+                           (2 + Metrics::kBucketCount) + cell;
+            return values[kHeader + counters + index];
+        }
+    };
+
+    View snapshot() {
+        return {Metrics::snapshot()};
+    }
+
+    void checkBuckets() {
+        int64_t misplaced = 0;
+        int64_t tooWide = 0;
+        for (int64_t value = 0; value < (1 << 25); value++) {
+            int32_t bucket = Metrics::bucketOf(value);
+            int64_t lower = Metrics::bucketLowerBound(bucket);
+            int64_t upper = Metrics::bucketLowerBound(bucket + 1);
+            if (value < lower || value >= upper) {
+                misplaced++;
+            }
+            if (upper - lower > std::max<int64_t>(1, lower / 4)) {
+                tooWide++;
+            }
+        }
+        Host::expect(misplaced == 0 && tooWide == 0,
+                     "buckets up to 2^25: %lld misplaced, %lld wider than 25%%",
+                     (long long) misplaced, (long long) tooWide);
+        Host::expect(Metrics::bucketOf(-5) == 0 &&
+                     Metrics::bucketOf(INT64_MAX) == Metrics::kBucketCount - 1 &&
+                     Metrics::bucketOf(1 << 25) == Metrics::kBucketCount - 1,
+                     "negative values in the first bucket, large ones in the last");
+    }
+
+    void record(int32_t thread) {
+        for (int64_t i = 0; i < kRecordsPerThread; i++) {
+            Metrics::add(Metrics::Counter::OPENED, kFlac);
+            Metrics::record(Metrics::Histogram::OPEN_TIME, kFlac, (thread * 7919 + i) % 5000);
+        }
+    }
+
+    int64_t expectedSum() {
+        int64_t sum = 0;
+        for (int32_t thread = 0; thread < kThreads; thread++) {
+            for (int64_t i = 0; i < kRecordsPerThread; i++) {
+                sum += (thread * 7919 + i) % 5000;
+            }
+        }
+        return sum;
+    }
+
+    /**
+     * Threads record and exit while snapshots are taken: no snapshot
+     * may go backwards, and once every thread exited its values must
+     * all be there, merged into the retired shard.
+     */
+    void checkExitedThreads() {
+        const View before = snapshot();
+        std::vector<std::thread> threads;
+        for (int32_t thread = 0; thread < kThreads; thread++) {
+            threads.emplace_back(record, thread);
+        }
+        int64_t last = before.counter(Metrics::Counter::OPENED, kFlac);
+        int32_t backwards = 0;
+        int32_t snapshots = 0;
+        for (; snapshots < 200; snapshots++) {
+            int64_t opened = snapshot().counter(Metrics::Counter::OPENED, kFlac);
+            if (opened < last) {
+                backwards++;
+            }
+            last = opened;
+        }
+        for (std::thread &thread: threads) {
+            thread.join();
+        }
+        Host::expect(backwards == 0, "%d of %d concurrent snapshots went backwards",
+                     backwards, snapshots);
+
+        const View after = snapshot();
+        const int64_t records = kThreads * kRecordsPerThread;
+        int64_t opened = after.counter(Metrics::Counter::OPENED, kFlac) -
+                         before.counter(Metrics::Counter::OPENED, kFlac);
+        int64_t count = after.histogram(Metrics::Histogram::OPEN_TIME, kFlac, 0) -
+                        before.histogram(Metrics::Histogram::OPEN_TIME, kFlac, 0);
+        int64_t sum = after.histogram(Metrics::Histogram::OPEN_TIME, kFlac, 1) -
+                      before.histogram(Metrics::Histogram::OPEN_TIME, kFlac, 1);
+        int64_t buckets = 0;
+        for (int32_t bucket = 0; bucket < Metrics::kBucketCount; bucket++) {
+            buckets += after.histogram(Metrics::Histogram::OPEN_TIME, kFlac, 2 + bucket) -
+                       before.histogram(Metrics::Histogram::OPEN_TIME, kFlac, 2 + bucket);
+        }
+        Host::expect(opened == records && count == records && buckets == records &&
+                     sum == expectedSum(),
+                     "%d exited threads: %lld opened, %lld recorded, %lld in buckets",
+                     kThreads, (long long) opened, (long long) count, (long long) buckets);
+    }
+
+    void checkFormats() {
+        const View before = snapshot();
+        Metrics::add(Metrics::Counter::PARSE_FAILED, -1);
+        Metrics::add(Metrics::Counter::PARSE_FAILED, Metrics::kFormatCount + 3);
+        const View after = snapshot();
+        int64_t counted = after.counter(Metrics::Counter::PARSE_FAILED, Metrics::kNoFormat) -
+                          before.counter(Metrics::Counter::PARSE_FAILED, Metrics::kNoFormat);
+        Host::expect(after.values[1] == Metrics::kFormatCount && counted == 2,
+                     "unknown formats counted as no format: %lld", (long long) counted);
+    }
+}
+
+/**
+ * Bucket bounds of the histograms and the merging of the shards of
+ * exited threads, which snapshots must never lose.
+ */
+int main() {
+    checkBuckets();
+    checkExitedThreads();
+    checkFormats();
+    return Host::checkExitCode();
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include <cmath>
+#include <vector>
+
+#include <audio/resampler.h>
+
+#include "check.h"
+
+using namespace SoundSource;
+using namespace SoundSource::Audio;
+
+namespace {
+    constexpr double kAmplitude = 0.5;
+    constexpr double kSeconds = 2;
+    // odd, so blocks do not line up with the internal chunks
+    constexpr int32_t kBlockFrames = 997;
+
+    struct Case {
+        int32_t inputRate;
+        int32_t outputRate;
+        ResamplerQuality quality;
+        double frequency;
+        double maxThdN;
+        // through the 16-bit path, which the player uses for 16-bit PCM
+        bool pcm16;
+    };
+
+    struct Measurement {
+        double thdN;
+        double gain;
+        // output samples the output is behind the input
+        double lag;
+        int64_t frames;
+        int64_t expectedFrames;
+    };
+
+    const char *nameOf(ResamplerQuality quality) {
+        switch (quality) {
+            case ResamplerQuality::LOW:
+                return "LOW";
+            case ResamplerQuality::MEDIUM:
+                return "MEDIUM";
+            case ResamplerQuality::HIGH:
+            default:
+                return "HIGH";
+        }
+    }
+
+    /**
+     * Resample a stereo sine, fit a sine of the same frequency (and an
+     * offset) to the steady state of the first channel by least squares,
+     * and take everything else as distortion and noise.
+     */
+    Measurement measure(const Case &c) {
+        Resampler resampler(2, c.inputRate, c.outputRate, c.quality);
+        const auto inputFrames = (int64_t) (kSeconds * c.inputRate);
+        std::vector<float> in((size_t) kBlockFrames * 2);
+        std::vector<float> out((size_t) resampler.maxOutputFrames(kBlockFrames) * 2);
+        std::vector<int16_t> in16(in.size());
+        std::vector<int16_t> out16(out.size());
+        std::vector<double> output;
+
+        int64_t position = 0;
+        const int64_t total = inputFrames + resampler.delayFrames();
+        while (position < total) {
+            auto frames = (int32_t) std::min<int64_t>(kBlockFrames, total - position);
+            for (int32_t i = 0; i < frames; i++) {
+                int64_t t = position + i;
+                double value = t < inputFrames
+                               ? kAmplitude * std::sin(2 * M_PI * c.frequency * t / c.inputRate)
+                               : 0;
+                in[2 * i] = (float) value;
+                in[2 * i + 1] = (float) -value;
+            }
+            int32_t produced;
+            if (c.pcm16) {
+                for (int32_t i = 0; i < frames * 2; i++) {
+                    in16[i] = (int16_t) std::lrint(in[i] * 32767.0);
+                }
+                produced = resampler.process(in16.data(), frames, out16.data());
+                for (int32_t i = 0; i < produced; i++) {
+                    output.push_back(out16[2 * i] / 32768.0);
+                }
+            } else {
+                produced = resampler.process(in.data(), frames, out.data());
+                for (int32_t i = 0; i < produced; i++) {
+                    output.push_back(out[2 * i]);
+                }
+            }
+            position += frames;
+        }
+
+        // skip the edges, where the filter sees the silence around the sine
+        const auto skip = (size_t) (0.1 * c.outputRate);
+        const size_t end = (size_t) (inputFrames * c.outputRate / c.inputRate) - skip;
+        const double omega = 2 * M_PI * c.frequency / c.outputRate;
+        // normal equations of [sin, cos, 1]
+        double a[3][3] = {};
+        double b[3] = {};
+        for (size_t n = skip; n < end; n++) {
+            double basis[3] = {std::sin(omega * n), std::cos(omega * n), 1};
+            for (int i = 0; i < 3; i++) {
+                for (int j = 0; j < 3; j++) {
+                    a[i][j] += basis[i] * basis[j];
+                }
+                b[i] += basis[i] * output[n];
+            }
+        }
+        // Gaussian elimination, the system is well conditioned
+        for (int i = 0; i < 3; i++) {
+            for (int k = i + 1; k < 3; k++) {
+                double factor = a[k][i] / a[i][i];
+                for (int j = i; j < 3; j++) {
+                    a[k][j] -= factor * a[i][j];
+                }
+                b[k] -= factor * b[i];
+            }
+        }
+        double x[3];
+        for (int i = 2; i >= 0; i--) {
+            double sum = b[i];
+            for (int j = i + 1; j < 3; j++) {
+                sum -= a[i][j] * x[j];
+            }
+            x[i] = sum / a[i][i];
+        }
+
+        double signal = 0;
+        double residual = 0;
+        for (size_t n = skip; n < end; n++) {
+            double fitted = x[0] * std::sin(omega * n) + x[1] * std::cos(omega * n) + x[2];
+            signal += fitted * fitted;
+            residual += (output[n] - fitted) * (output[n] - fitted);
+        }
+
+        Measurement m{};
+        m.thdN = 10 * std::log10(residual / signal);
+        double amplitude = std::hypot(x[0], x[1]);
+        m.gain = 20 * std::log10(amplitude / kAmplitude);
+        // sin(omega * (n - lag)) = cos(omega * lag) sin - sin(omega * lag) cos
+        m.lag = std::atan2(-x[1], x[0]) / omega;
+        m.frames = (int64_t) output.size();
+        m.expectedFrames = (inputFrames * c.outputRate + c.inputRate - 1) / c.inputRate;
+        return m;
+    }
+
+    void check(const Case &c) {
+        Measurement m = measure(c);
+        Host::expect(m.thdN <= c.maxThdN && std::abs(m.gain) < 0.05 &&
+                     std::abs(m.lag) < 0.01 && std::abs(m.frames - m.expectedFrames) <= 1,
+                     "%6d -> %6d %-6s %-5s %5.0f Hz: THD+N %7.1f dB (max %.0f), "
+                     "gain %+.4f dB, lag %+.4f, frames %lld of %lld",
+                     c.inputRate, c.outputRate, nameOf(c.quality), c.pcm16 ? "int16" : "float",
+                     c.frequency, m.thdN, c.maxThdN, m.gain, m.lag, (long long) m.frames,
+                     (long long) m.expectedFrames);
+    }
+}
+
+/**
+ * THD+N, passband gain and alignment of the resampler, at the ratios
+ * the player uses.
+ */
+int main() {
+    const std::pair<int32_t, int32_t> ratios[] = {
+            {44100, 48000},
+            {48000, 44100},
+            {88200, 48000},
+            {96000, 48000},
+            {192000, 48000},
+            {48000, 48000},
+    };
+    // about 6 dB above the worst THD+N measured for every preset, for
+    // a tone low in the band and one in the upper half of it
+    const std::pair<ResamplerQuality, double> qualities[] = {
+            {ResamplerQuality::LOW, -64},
+            {ResamplerQuality::MEDIUM, -88},
+            {ResamplerQuality::HIGH, -115},
+    };
+    for (const auto &[inputRate, outputRate]: ratios) {
+        for (const auto &[quality, maxThdN]: qualities) {
+            for (double frequency: {1000.0, 10000.0}) {
+                check({inputRate, outputRate, quality, frequency, maxThdN, false});
+            }
+        }
+        // quantizing the input and the output to 16 bits limits the
+        // 16-bit path to about -89 dB
+        check({inputRate, outputRate, ResamplerQuality::HIGH, 1000.0, -85, true});
+    }
+    return Host::checkExitCode();
+}
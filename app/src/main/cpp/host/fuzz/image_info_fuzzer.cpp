@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include <image/image.h>
+
+using namespace SoundSource;
+
+/**
+ * Every detector runs on the untrusted bytes of embedded artwork.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    Image::ImageInfo info = Image::getImageInfo(data, size);
+    if (info.ok()) {
+        volatile int64_t area = info.size().width * info.size().height;
+        (void) area;
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+namespace {
+    constexpr double kDefaultBudgetMillis = 5;
+    // the best of a few runs, so page faults and preemption do not count
+    constexpr int32_t kRuns = 3;
+
+    std::vector<uint8_t> readFile(const std::filesystem::path &path) {
+        std::ifstream in(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+
+    double runMillis(const std::vector<uint8_t> &input) {
+        double best = 0;
+        for (int32_t run = 0; run < kRuns; run++) {
+            auto start = std::chrono::steady_clock::now();
+            LLVMFuzzerTestOneInput(input.data(), input.size());
+            std::chrono::duration<double, std::milli> elapsed =
+                    std::chrono::steady_clock::now() - start;
+            best = run == 0 ? elapsed.count() : std::min(best, elapsed.count());
+        }
+        return best;
+    }
+}
+
+/**
+ * Replays a fuzz target over corpus files without libFuzzer and fails
+ * if an input takes longer than the budget, so inputs that once were
+ * slow to reject stay fast.
+ *
+ * Usage: replay [--budget-ms=N] <file or directory>...
+ */
+int main(int argc, char **argv) {
+    double budget = kDefaultBudgetMillis;
+    std::vector<std::filesystem::path> inputs;
+    for (int32_t i = 1; i < argc; i++) {
+        const char *prefix = "--budget-ms=";
+        if (std::strncmp(argv[i], prefix, std::strlen(prefix)) == 0) {
+            budget = std::atof(argv[i] + std::strlen(prefix));
+            continue;
+        }
+        std::filesystem::path path(argv[i]);
+        if (std::filesystem::is_directory(path)) {
+            for (const auto &entry: std::filesystem::recursive_directory_iterator(path)) {
+                if (entry.is_regular_file()) {
+                    inputs.push_back(entry.path());
+                }
+            }
+        } else {
+            inputs.push_back(path);
+        }
+    }
+    if (inputs.empty()) {
+        std::fprintf(stderr, "usage: %s [--budget-ms=N] <file or directory>...\n", argv[0]);
+        return 2;
+    }
+    std::sort(inputs.begin(), inputs.end());
+
+    int32_t slow = 0;
+    double slowest = 0;
+    std::string slowestName;
+    for (const auto &path: inputs) {
+        double millis = runMillis(readFile(path));
+        if (millis > budget) {
+            std::fprintf(stderr, "slow input %s: %.3f ms\n", path.c_str(), millis);
+            slow++;
+        }
+        if (millis >= slowest) {
+            slowest = millis;
+            slowestName = path.filename().string();
+        }
+    }
+    std::printf("%zu inputs, slowest %.3f ms (%s), budget %.3f ms\n",
+                inputs.size(), slowest, slowestName.c_str(), budget);
+    return slow == 0 ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include <tags/tags.h>
+#include <tags/embedded_lyric.h>
+
+#include "samples.h"
+
+using namespace SoundSource;
+
+/**
+ * Opens the input as a file the way scans and playback do, through
+ * TagLib's FileStream, the pread() windows or the mapping picked by the
+ * first byte, and reads everything the app reads from it.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    Host::MemoryFile file(data, size);
+    auto streamType = (TagStream) (size > 0 ? data[0] % 3 : 0);
+    AudioTagAccessor accessor(file.open(), true, streamType);
+    if (accessor.isNull()) {
+        return 0;
+    }
+    TagLib::Tag *tag = accessor.tag();
+    if (tag != nullptr) {
+        TagLib::PropertyMap properties = tag->properties();
+        (void) properties.size();
+    }
+    TagLib::AudioProperties *audioProperties = accessor.fileRef()->audioProperties();
+    if (audioProperties != nullptr) {
+        (void) audioProperties->lengthInMilliseconds();
+    }
+    (void) accessor.bitDepth();
+    TagLib::File *taglibFile = accessor.fileRef()->file();
+    auto pictures = taglibFile->complexProperties("PICTURE");
+    (void) pictures.size();
+    LyricTimeline lyric = readEmbeddedLyric(taglibFile);
+    (void) lyric;
+    return 0;
+}
@@ -0,0 +1,1432 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include "samples.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iterator>
+#include <stdexcept>
+
+namespace SoundSource::Host {
+    namespace {
+        // ordinals of AudioFormatType
+        constexpr int32_t kMp3 = 0;
+        constexpr int32_t kFlac = 1;
+        constexpr int32_t kWav = 2;
+        constexpr int32_t kOgg = 3;
+        constexpr int32_t kAac = 4;
+        constexpr int32_t kApe = 6;
+        constexpr int32_t kAiff = 8;
+        constexpr int32_t kOpus = 10;
+
+        constexpr int32_t kCoverSize = 600;
+        constexpr size_t kCoverBytes = 48 * 1024;
+        constexpr int32_t kSampleRate = 44100;
+
+        struct Tags {
+            const char *title;
+            const char *artist;
+            const char *album;
+            const char *albumArtist;
+            const char *date;
+            const char *genre;
+            const char *track;
+        };
+
+        const Tags kTags{
+                "Symphony No. 9 in D minor, Op. 125: IV. Presto - Allegro assai",
+                "Berliner Philharmoniker",
+                "Beethoven: The Symphonies",
+                "Herbert von Karajan",
+                "1963",
+                "Classical",
+                "9",
+        };
+
+        void putBe(Bytes &out, uint64_t value, int32_t bytes) {
+            for (int32_t i = bytes - 1; i >= 0; i--) {
+                out.push_back((uint8_t) (value >> (8 * i)));
+            }
+        }
+
+        void putLe(Bytes &out, uint64_t value, int32_t bytes) {
+            for (int32_t i = 0; i < bytes; i++) {
+                out.push_back((uint8_t) (value >> (8 * i)));
+            }
+        }
+
+        void putString(Bytes &out, const std::string &value) {
+            out.insert(out.end(), value.begin(), value.end());
+        }
+
+        void putBytes(Bytes &out, const Bytes &value) {
+            out.insert(out.end(), value.begin(), value.end());
+        }
+
+        void putSyncSafe(Bytes &out, uint32_t value) {
+            for (int32_t i = 3; i >= 0; i--) {
+                out.push_back((uint8_t) ((value >> (7 * i)) & 0x7F));
+            }
+        }
+
+        void setBe32(Bytes &out, size_t offset, uint32_t value) {
+            for (int32_t i = 0; i < 4; i++) {
+                out[offset + i] = (uint8_t) (value >> (8 * (3 - i)));
+            }
+        }
+
+        void setLe32(Bytes &out, size_t offset, uint32_t value) {
+            for (int32_t i = 0; i < 4; i++) {
+                out[offset + i] = (uint8_t) (value >> (8 * i));
+            }
+        }
+
+        Bytes jpegHeader() {
+            Bytes out{0xFF, 0xD8};
+            // JFIF
+            putBe(out, 0xFFE0, 2);
+            putBe(out, 16, 2);
+            putString(out, std::string("JFIF\0", 5));
+            putBe(out, 0x0101, 2);
+            out.push_back(0);
+            putBe(out, 1, 2);
+            putBe(out, 1, 2);
+            out.push_back(0);
+            out.push_back(0);
+            // an Exif segment the detector has to skip
+            putBe(out, 0xFFE1, 2);
+            putBe(out, 2 + 6 + 1024, 2);
+            putString(out, std::string("Exif\0\0", 6));
+            out.resize(out.size() + 1024);
+            // baseline frame, three components
+            putBe(out, 0xFFC0, 2);
+            putBe(out, 17, 2);
+            out.push_back(8);
+            putBe(out, kCoverSize, 2);
+            putBe(out, kCoverSize, 2);
+            out.push_back(3);
+            for (uint8_t component = 1; component <= 3; component++) {
+                out.push_back(component);
+                out.push_back(component == 1 ? 0x22 : 0x11);
+                out.push_back(component == 1 ? 0 : 1);
+            }
+            return out;
+        }
+
+        /**
+         * A cover of about kCoverBytes, only its header is real.
+         */
+        Bytes jpegCover() {
+            Bytes out = jpegHeader();
+            out.resize(kCoverBytes - 2, 0x55);
+            putBe(out, 0xFFD9, 2);
+            return out;
+        }
+
+        Bytes id3v2Frame(const char *id, const Bytes &body) {
+            Bytes out;
+            putString(out, id);
+            putSyncSafe(out, (uint32_t) body.size());
+            putBe(out, 0, 2);
+            putBytes(out, body);
+            return out;
+        }
+
+        Bytes id3v2TextFrame(const char *id, const char *text) {
+            // UTF-8
+            Bytes body{3};
+            putString(body, text);
+            return id3v2Frame(id, body);
+        }
+
+        /**
+         * An ID3v2.4 tag with padding, as taggers write it.
+         */
+        Bytes id3v2Tag() {
+            Bytes frames;
+            putBytes(frames, id3v2TextFrame("TIT2", kTags.title));
+            putBytes(frames, id3v2TextFrame("TPE1", kTags.artist));
+            putBytes(frames, id3v2TextFrame("TALB", kTags.album));
+            putBytes(frames, id3v2TextFrame("TPE2", kTags.albumArtist));
+            putBytes(frames, id3v2TextFrame("TDRC", kTags.date));
+            putBytes(frames, id3v2TextFrame("TCON", kTags.genre));
+            putBytes(frames, id3v2TextFrame("TRCK", kTags.track));
+
+            Bytes picture{0};
+            putString(picture, std::string("image/jpeg\0", 11));
+            // front cover, empty description
+            picture.push_back(3);
+            picture.push_back(0);
+            putBytes(picture, jpegCover());
+            putBytes(frames, id3v2Frame("APIC", picture));
+            frames.resize(frames.size() + 2048);
+
+            Bytes out;
+            putString(out, "ID3");
+            out.push_back(4);
+            out.push_back(0);
+            out.push_back(0);
+            putSyncSafe(out, (uint32_t) frames.size());
+            putBytes(out, frames);
+            return out;
+        }
+
+        Bytes mp3File() {
+            Bytes out = id3v2Tag();
+            // MPEG-1 layer III, 128 kbit/s, 44.1 kHz, joint stereo
+            constexpr int32_t kFrameSize = 144 * 128000 / kSampleRate;
+            for (int32_t frame = 0; frame < 200; frame++) {
+                putBe(out, 0xFFFB9064, 4);
+                out.resize(out.size() + kFrameSize - 4);
+            }
+            return out;
+        }
+
+        void putFlacBlock(Bytes &out, int32_t type, const Bytes &body, bool last) {
+            out.push_back((uint8_t) ((last ? 0x80 : 0) | type));
+            putBe(out, body.size(), 3);
+            putBytes(out, body);
+        }
+
+        void putVorbisComment(Bytes &out, const std::string &comment) {
+            putLe(out, comment.size(), 4);
+            putString(out, comment);
+        }
+
+        /**
+         * A FLAC picture block body holding the front cover, which Ogg
+         * files carry base64 encoded in METADATA_BLOCK_PICTURE.
+         */
+        Bytes flacPicture() {
+            Bytes picture;
+            putBe(picture, 3, 4);
+            putBe(picture, 10, 4);
+            putString(picture, "image/jpeg");
+            putBe(picture, 0, 4);
+            putBe(picture, kCoverSize, 4);
+            putBe(picture, kCoverSize, 4);
+            putBe(picture, 24, 4);
+            putBe(picture, 0, 4);
+            Bytes cover = jpegCover();
+            putBe(picture, cover.size(), 4);
+            putBytes(picture, cover);
+            return picture;
+        }
+
+        std::vector<std::string> vorbisFields() {
+            return {
+                    std::string("TITLE=") + kTags.title,
+                    std::string("ARTIST=") + kTags.artist,
+                    std::string("ALBUM=") + kTags.album,
+                    std::string("ALBUMARTIST=") + kTags.albumArtist,
+                    std::string("DATE=") + kTags.date,
+                    std::string("GENRE=") + kTags.genre,
+                    std::string("TRACKNUMBER=") + kTags.track,
+            };
+        }
+
+        Bytes flacFile() {
+            Bytes out;
+            putString(out, "fLaC");
+
+            Bytes streamInfo;
+            putBe(streamInfo, 4096, 2);
+            putBe(streamInfo, 4096, 2);
+            putBe(streamInfo, 0, 3);
+            putBe(streamInfo, 0, 3);
+            // rate:20 | channels - 1:3 | bits - 1:5 | samples:36
+            uint64_t samples = kSampleRate * 5;
+            putBe(streamInfo, (uint64_t) kSampleRate << 44 | 1ull << 41 | 15ull << 36 | samples, 8);
+            streamInfo.resize(streamInfo.size() + 16);
+            putFlacBlock(out, 0, streamInfo, false);
+
+            Bytes comments;
+            putVorbisComment(comments, "reference libFLAC 1.4.3 20230623");
+            const std::vector<std::string> fields = vorbisFields();
+            putLe(comments, fields.size(), 4);
+            for (const auto &field: fields) {
+                putVorbisComment(comments, field);
+            }
+            putFlacBlock(out, 4, comments, false);
+
+            putFlacBlock(out, 6, flacPicture(), false);
+
+            putFlacBlock(out, 1, Bytes(4096), true);
+            return out;
+        }
+
+        void putRiffChunk(Bytes &out, const char *id, const Bytes &body) {
+            putString(out, id);
+            putLe(out, body.size(), 4);
+            putBytes(out, body);
+            if (body.size() % 2 != 0) {
+                out.push_back(0);
+            }
+        }
+
+        Bytes wavFile() {
+            Bytes out;
+            putString(out, "RIFF");
+            putLe(out, 0, 4);
+            putString(out, "WAVE");
+
+            Bytes format;
+            putLe(format, 1, 2);
+            putLe(format, 2, 2);
+            putLe(format, kSampleRate, 4);
+            putLe(format, kSampleRate * 4, 4);
+            putLe(format, 4, 2);
+            putLe(format, 16, 2);
+            putRiffChunk(out, "fmt ", format);
+            putRiffChunk(out, "data", Bytes(kSampleRate * 4 / 2));
+
+            Bytes info;
+            putString(info, "INFO");
+            const std::pair<const char *, const char *> fields[] = {
+                    {"INAM", kTags.title},
+                    {"IART", kTags.artist},
+                    {"IPRD", kTags.album},
+                    {"ICRD", kTags.date},
+                    {"IGNR", kTags.genre},
+                    {"ITRK", kTags.track},
+            };
+            for (const auto &[id, value]: fields) {
+                Bytes text;
+                putString(text, std::string(value) + '\0');
+                putRiffChunk(info, id, text);
+            }
+            putRiffChunk(out, "LIST", info);
+            putRiffChunk(out, "id3 ", id3v2Tag());
+
+            setLe32(out, 4, (uint32_t) (out.size() - 8));
+            return out;
+        }
+
+        Bytes aiffFile() {
+            Bytes out;
+            putString(out, "FORM");
+            putBe(out, 0, 4);
+            putString(out, "AIFF");
+
+            const int32_t frames = kSampleRate / 2;
+            Bytes common;
+            putBe(common, 2, 2);
+            putBe(common, frames, 4);
+            putBe(common, 16, 2);
+            // 44100 as an 80-bit extended float
+            putBe(common, 0x400E, 2);
+            putBe(common, 0xAC44000000000000ull, 8);
+
+            Bytes sound;
+            putBe(sound, 0, 4);
+            putBe(sound, 0, 4);
+            sound.resize(sound.size() + frames * 4);
+
+            for (const auto &[id, body]: {std::pair<const char *, Bytes>{"COMM", common},
+                                          {"SSND", sound},
+                                          {"ID3 ", id3v2Tag()}}) {
+                putString(out, id);
+                putBe(out, body.size(), 4);
+                putBytes(out, body);
+                if (body.size() % 2 != 0) {
+                    out.push_back(0);
+                }
+            }
+
+            setBe32(out, 4, (uint32_t) (out.size() - 8));
+            return out;
+        }
+
+        Bytes mp4Atom(const char *type, const Bytes &body) {
+            Bytes out;
+            putBe(out, body.size() + 8, 4);
+            putString(out, type);
+            putBytes(out, body);
+            return out;
+        }
+
+        /**
+         * An ilst item holding one data atom of the given well-known type.
+         */
+        Bytes mp4Item(const char *type, int32_t dataType, const Bytes &value) {
+            Bytes data;
+            putBe(data, dataType, 4);
+            putBe(data, 0, 4);
+            putBytes(data, value);
+            return mp4Atom(type, mp4Atom("data", data));
+        }
+
+        Bytes mp4TextItem(const char *type, const char *text) {
+            Bytes value;
+            putString(value, text);
+            // UTF-8
+            return mp4Item(type, 1, value);
+        }
+
+        Bytes mp4Handler(const char *handler, const char *manufacturer) {
+            Bytes body;
+            putBe(body, 0, 4);
+            putBe(body, 0, 4);
+            putString(body, handler);
+            putString(body, manufacturer);
+            putBe(body, 0, 8);
+            body.push_back(0);
+            return mp4Atom("hdlr", body);
+        }
+
+        /**
+         * An M4A as iTunes writes it: the moov with an AAC track and the
+         * ilst before the mdat.
+         */
+        Bytes mp4File() {
+            constexpr int32_t kSeconds = 5;
+
+            Bytes fileType;
+            putString(fileType, "M4A ");
+            putBe(fileType, 0, 4);
+            putString(fileType, "M4A mp42isom");
+
+            Bytes movieHeader;
+            putBe(movieHeader, 0, 4);
+            putBe(movieHeader, 0, 8);
+            putBe(movieHeader, kSampleRate, 4);
+            putBe(movieHeader, kSampleRate * kSeconds, 4);
+            putBe(movieHeader, 0x00010000, 4);
+            putBe(movieHeader, 0x0100, 2);
+            movieHeader.resize(movieHeader.size() + 10 + 36 + 24);
+            putBe(movieHeader, 2, 4);
+
+            Bytes trackHeader;
+            putBe(trackHeader, 7, 4);
+            putBe(trackHeader, 0, 8);
+            putBe(trackHeader, 1, 4);
+            putBe(trackHeader, 0, 4);
+            putBe(trackHeader, kSampleRate * kSeconds, 4);
+            trackHeader.resize(trackHeader.size() + 8 + 4 + 4 + 36 + 8);
+
+            Bytes mediaHeader;
+            putBe(mediaHeader, 0, 4);
+            putBe(mediaHeader, 0, 8);
+            putBe(mediaHeader, kSampleRate, 4);
+            putBe(mediaHeader, kSampleRate * kSeconds, 4);
+            putBe(mediaHeader, 0x55C4, 2);
+            putBe(mediaHeader, 0, 2);
+
+            Bytes sampleEntry;
+            sampleEntry.resize(6);
+            putBe(sampleEntry, 1, 2);
+            putBe(sampleEntry, 0, 8);
+            putBe(sampleEntry, 2, 2);
+            putBe(sampleEntry, 16, 2);
+            putBe(sampleEntry, 0, 4);
+            putBe(sampleEntry, (uint64_t) kSampleRate << 16, 4);
+            // AAC LC at 128 kbit/s, 44.1 kHz stereo
+            Bytes decoderConfig{0x40, 0x15};
+            putBe(decoderConfig, 0, 3);
+            putBe(decoderConfig, 128000, 4);
+            putBe(decoderConfig, 128000, 4);
+            putBytes(decoderConfig, {0x05, 2, 0x12, 0x10});
+            Bytes elementaryStream;
+            putBe(elementaryStream, 1, 2);
+            elementaryStream.push_back(0);
+            elementaryStream.push_back(0x04);
+            elementaryStream.push_back((uint8_t) decoderConfig.size());
+            putBytes(elementaryStream, decoderConfig);
+            putBytes(elementaryStream, {0x06, 1, 0x02});
+            Bytes streamDescriptor;
+            putBe(streamDescriptor, 0, 4);
+            streamDescriptor.push_back(0x03);
+            streamDescriptor.push_back((uint8_t) elementaryStream.size());
+            putBytes(streamDescriptor, elementaryStream);
+            putBytes(sampleEntry, mp4Atom("esds", streamDescriptor));
+            Bytes sampleDescription;
+            putBe(sampleDescription, 0, 4);
+            putBe(sampleDescription, 1, 4);
+            putBytes(sampleDescription, mp4Atom("mp4a", sampleEntry));
+
+            Bytes sampleTable = mp4Atom("stsd", sampleDescription);
+            Bytes mediaInformation = mp4Atom("stbl", sampleTable);
+            Bytes media = mp4Atom("mdhd", mediaHeader);
+            putBytes(media, mp4Handler("soun", "\0\0\0\0"));
+            putBytes(media, mp4Atom("minf", mediaInformation));
+            Bytes track = mp4Atom("tkhd", trackHeader);
+            putBytes(track, mp4Atom("mdia", media));
+
+            Bytes trackNumber;
+            putBe(trackNumber, 0, 2);
+            putBe(trackNumber, std::stoi(kTags.track), 2);
+            putBe(trackNumber, 0, 4);
+            Bytes items;
+            putBytes(items, mp4TextItem("\xA9nam", kTags.title));
+            putBytes(items, mp4TextItem("\xA9" "ART", kTags.artist));
+            putBytes(items, mp4TextItem("\xA9" "alb", kTags.album));
+            putBytes(items, mp4TextItem("aART", kTags.albumArtist));
+            putBytes(items, mp4TextItem("\xA9" "day", kTags.date));
+            putBytes(items, mp4TextItem("\xA9gen", kTags.genre));
+            putBytes(items, mp4Item("trkn", 0, trackNumber));
+            // JPEG
+            putBytes(items, mp4Item("covr", 13, jpegCover()));
+            Bytes meta;
+            putBe(meta, 0, 4);
+            putBytes(meta, mp4Handler("mdir", "appl"));
+            putBytes(meta, mp4Atom("ilst", items));
+            putBytes(meta, mp4Atom("free", Bytes(2048)));
+
+            Bytes movie = mp4Atom("mvhd", movieHeader);
+            putBytes(movie, mp4Atom("trak", track));
+            putBytes(movie, mp4Atom("udta", mp4Atom("meta", meta)));
+
+            Bytes out = mp4Atom("ftyp", fileType);
+            putBytes(out, mp4Atom("moov", movie));
+            putBytes(out, mp4Atom("mdat", Bytes(kSampleRate * kSeconds / 64)));
+            return out;
+        }
+
+        uint32_t oggCrc(const Bytes &page) {
+            static const auto table = [] {
+                std::array<uint32_t, 256> values{};
+                for (uint32_t i = 0; i < 256; i++) {
+                    uint32_t value = i << 24;
+                    for (int32_t bit = 0; bit < 8; bit++) {
+                        value = value & 0x80000000 ? value << 1 ^ 0x04C11DB7 : value << 1;
+                    }
+                    values[i] = value;
+                }
+                return values;
+            }();
+            uint32_t crc = 0;
+            for (uint8_t value: page) {
+                crc = crc << 8 ^ table[(crc >> 24 ^ value) & 0xFF];
+            }
+            return crc;
+        }
+
+        /**
+         * Put each packet on pages of its own, continued over as many
+         * pages as its lacing needs.
+         *
+         * @param granule the granule position of the last packet, the
+         * packets before it are headers at 0.
+         */
+        Bytes oggStream(const std::vector<Bytes> &packets, int64_t granule) {
+            constexpr uint32_t kSerial = 0x50AC1E55;
+            Bytes out;
+            uint32_t sequence = 0;
+            for (size_t packet = 0; packet < packets.size(); packet++) {
+                const Bytes &data = packets[packet];
+                std::vector<uint8_t> lacing(data.size() / 255, 255);
+                lacing.push_back((uint8_t) (data.size() % 255));
+
+                size_t segment = 0;
+                size_t offset = 0;
+                while (segment < lacing.size()) {
+                    size_t count = std::min<size_t>(255, lacing.size() - segment);
+                    bool ends = segment + count == lacing.size();
+                    uint8_t flags = 0;
+                    if (segment > 0) {
+                        flags |= 0x01;
+                    }
+                    if (sequence == 0) {
+                        flags |= 0x02;
+                    }
+                    if (ends && packet + 1 == packets.size()) {
+                        flags |= 0x04;
+                    }
+                    int64_t position = !ends ? -1 : packet + 1 == packets.size() ? granule : 0;
+
+                    Bytes page;
+                    putString(page, "OggS");
+                    page.push_back(0);
+                    page.push_back(flags);
+                    putLe(page, (uint64_t) position, 8);
+                    putLe(page, kSerial, 4);
+                    putLe(page, sequence++, 4);
+                    putLe(page, 0, 4);
+                    page.push_back((uint8_t) count);
+                    size_t bytes = 0;
+                    for (size_t i = segment; i < segment + count; i++) {
+                        page.push_back(lacing[i]);
+                        bytes += lacing[i];
+                    }
+                    page.insert(page.end(), data.begin() + (ptrdiff_t) offset,
+                                data.begin() + (ptrdiff_t) (offset + bytes));
+                    setLe32(page, 22, oggCrc(page));
+                    putBytes(out, page);
+
+                    segment += count;
+                    offset += bytes;
+                }
+            }
+            return out;
+        }
+
+        std::string base64(const Bytes &data) {
+            static const char kAlphabet[] =
+                    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            std::string out;
+            for (size_t i = 0; i < data.size(); i += 3) {
+                uint32_t value = data[i] << 16;
+                if (i + 1 < data.size()) {
+                    value |= data[i + 1] << 8;
+                }
+                if (i + 2 < data.size()) {
+                    value |= data[i + 2];
+                }
+                out.push_back(kAlphabet[value >> 18 & 0x3F]);
+                out.push_back(kAlphabet[value >> 12 & 0x3F]);
+                out.push_back(i + 1 < data.size() ? kAlphabet[value >> 6 & 0x3F] : '=');
+                out.push_back(i + 2 < data.size() ? kAlphabet[value & 0x3F] : '=');
+            }
+            return out;
+        }
+
+        /**
+         * The comment header body shared by Vorbis and Opus, with the
+         * cover in METADATA_BLOCK_PICTURE.
+         */
+        Bytes xiphComment(const std::string &vendor) {
+            Bytes out;
+            putVorbisComment(out, vendor);
+            std::vector<std::string> fields = vorbisFields();
+            fields.push_back("METADATA_BLOCK_PICTURE=" + base64(flacPicture()));
+            putLe(out, fields.size(), 4);
+            for (const auto &field: fields) {
+                putVorbisComment(out, field);
+            }
+            return out;
+        }
+
+        Bytes vorbisFile() {
+            Bytes identification{1};
+            putString(identification, "vorbis");
+            putLe(identification, 0, 4);
+            identification.push_back(2);
+            putLe(identification, kSampleRate, 4);
+            putLe(identification, 0, 4);
+            putLe(identification, 160000, 4);
+            putLe(identification, 0, 4);
+            // blocks of 256 and 2048 samples, framing bit
+            identification.push_back(0xB8);
+            identification.push_back(1);
+
+            Bytes comment{3};
+            putString(comment, "vorbis");
+            putBytes(comment, xiphComment("Xiph.Org libVorbis I 20200704 (Reducing Environment)"));
+            comment.push_back(1);
+
+            // only its header, TagLib does not parse the codebooks
+            Bytes setup{5};
+            putString(setup, "vorbis");
+            setup.resize(setup.size() + 3072, 0x5A);
+
+            return oggStream({identification, comment, setup, Bytes(4096, 0x3C)},
+                             kSampleRate * 5);
+        }
+
+        Bytes opusFile() {
+            constexpr int32_t kPreSkip = 312;
+
+            Bytes head;
+            putString(head, "OpusHead");
+            head.push_back(1);
+            head.push_back(2);
+            putLe(head, kPreSkip, 2);
+            putLe(head, kSampleRate, 4);
+            putLe(head, 0, 2);
+            head.push_back(0);
+
+            Bytes tags;
+            putString(tags, "OpusTags");
+            putBytes(tags, xiphComment("libopus 1.4"));
+
+            // granules count at 48 kHz whatever the input rate was
+            return oggStream({head, tags, Bytes(4096, 0x3C)}, 48000 * 5 + kPreSkip);
+        }
+
+        void putApeItem(Bytes &out, const char *key, const Bytes &value, uint32_t flags) {
+            putLe(out, value.size(), 4);
+            putLe(out, flags, 4);
+            putString(out, std::string(key) + '\0');
+            putBytes(out, value);
+        }
+
+        void putApeText(Bytes &out, const char *key, const char *text) {
+            Bytes value;
+            putString(value, text);
+            putApeItem(out, key, value, 0);
+        }
+
+        void putApeTagHeader(Bytes &out, uint32_t size, uint32_t items, bool header) {
+            putString(out, "APETAGEX");
+            putLe(out, 2000, 4);
+            putLe(out, size, 4);
+            putLe(out, items, 4);
+            // contains a header, this is the header
+            putLe(out, 0x80000000u | (header ? 0x20000000u : 0), 4);
+            putLe(out, 0, 8);
+        }
+
+        /**
+         * A Monkey's Audio file of the current (3.98+) layout with an
+         * APEv2 tag at its end.
+         */
+        Bytes apeFile() {
+            constexpr uint32_t kBlocksPerFrame = 73728;
+            const uint32_t blocks = kSampleRate * 5;
+
+            Bytes out;
+            putString(out, "MAC ");
+            putLe(out, 3990, 2);
+            putLe(out, 0, 2);
+            // descriptor, header, seek table, header data, frame data
+            putLe(out, 52, 4);
+            putLe(out, 24, 4);
+            putLe(out, 0, 4);
+            putLe(out, 0, 4);
+            putLe(out, 8192, 4);
+            putLe(out, 0, 4);
+            putLe(out, 0, 4);
+            out.resize(out.size() + 16);
+
+            // normal compression
+            putLe(out, 2000, 2);
+            putLe(out, 0, 2);
+            putLe(out, kBlocksPerFrame, 4);
+            putLe(out, blocks % kBlocksPerFrame, 4);
+            putLe(out, blocks / kBlocksPerFrame + 1, 4);
+            putLe(out, 16, 2);
+            putLe(out, 2, 2);
+            putLe(out, kSampleRate, 4);
+            out.resize(out.size() + 8192, 0x3C);
+
+            Bytes items;
+            putApeText(items, "Title", kTags.title);
+            putApeText(items, "Artist", kTags.artist);
+            putApeText(items, "Album", kTags.album);
+            putApeText(items, "Album Artist", kTags.albumArtist);
+            putApeText(items, "Year", kTags.date);
+            putApeText(items, "Genre", kTags.genre);
+            putApeText(items, "Track", kTags.track);
+            Bytes cover;
+            putString(cover, std::string("cover.jpg\0", 10));
+            putBytes(cover, jpegCover());
+            // binary
+            putApeItem(items, "Cover Art (Front)", cover, 0x2);
+
+            const uint32_t size = (uint32_t) items.size() + 32;
+            putApeTagHeader(out, size, 8, true);
+            putBytes(out, items);
+            putApeTagHeader(out, size, 8, false);
+            return out;
+        }
+
+        Bytes pngHeader() {
+            Bytes out{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+            putBe(out, 13, 4);
+            putString(out, "IHDR");
+            putBe(out, kCoverSize, 4);
+            putBe(out, kCoverSize, 4);
+            // 8-bit RGB, CRC left zero
+            putBe(out, 0x0802000000, 5);
+            putBe(out, 0, 4);
+            return out;
+        }
+
+        Bytes avifHeader() {
+            Bytes out;
+            putBe(out, 24, 4);
+            putString(out, "ftypavif");
+            putBe(out, 0, 4);
+            putString(out, "mif1avif");
+            // meta > iprp > ipco > ispe
+            putBe(out, 12 + 8 + 8 + 20, 4);
+            putString(out, "meta");
+            putBe(out, 0, 4);
+            putBe(out, 8 + 8 + 20, 4);
+            putString(out, "iprp");
+            putBe(out, 8 + 20, 4);
+            putString(out, "ipco");
+            putBe(out, 20, 4);
+            putString(out, "ispe");
+            putBe(out, 0, 4);
+            putBe(out, kCoverSize, 4);
+            putBe(out, kCoverSize, 4);
+            // the start of the coded image
+            putBe(out, 8 + 64, 4);
+            putString(out, "mdat");
+            out.resize(out.size() + 64);
+            return out;
+        }
+
+        Bytes webpHeader() {
+            Bytes out;
+            putString(out, "RIFF");
+            putLe(out, 22, 4);
+            putString(out, "WEBPVP8 ");
+            putLe(out, 10, 4);
+            // key frame tag and start code
+            putBe(out, 0x000000, 3);
+            putBe(out, 0x9D012A, 3);
+            putLe(out, kCoverSize, 2);
+            putLe(out, kCoverSize, 2);
+            return out;
+        }
+
+        Bytes gifHeader() {
+            Bytes out;
+            putString(out, "GIF89a");
+            putLe(out, kCoverSize, 2);
+            putLe(out, kCoverSize, 2);
+            putBe(out, 0xF70000, 3);
+            return out;
+        }
+
+        Bytes bmpHeader() {
+            Bytes out;
+            putString(out, "BM");
+            putLe(out, 54 + kCoverSize * kCoverSize * 3, 4);
+            putLe(out, 0, 4);
+            putLe(out, 54, 4);
+            putLe(out, 40, 4);
+            putLe(out, kCoverSize, 4);
+            // top-down
+            putLe(out, (uint32_t) -kCoverSize, 4);
+            putLe(out, 1, 2);
+            putLe(out, 24, 2);
+            out.resize(54);
+            return out;
+        }
+
+        Bytes tiffHeader() {
+            Bytes out;
+            putString(out, "II");
+            putLe(out, 42, 2);
+            putLe(out, 8, 4);
+            putLe(out, 2, 2);
+            // ImageWidth and ImageLength as SHORT
+            for (uint32_t tag: {0x100u, 0x101u}) {
+                putLe(out, tag, 2);
+                putLe(out, 3, 2);
+                putLe(out, 1, 4);
+                putLe(out, kCoverSize, 4);
+            }
+            putLe(out, 0, 4);
+            return out;
+        }
+
+        Bytes jp2Header() {
+            Bytes out;
+            putBe(out, 12, 4);
+            putString(out, "jP  ");
+            putBe(out, 0x0D0A870A, 4);
+            putBe(out, 20, 4);
+            putString(out, "ftypjp2 ");
+            putBe(out, 0, 4);
+            putString(out, "jp2 ");
+            putBe(out, 8 + 22, 4);
+            putString(out, "jp2h");
+            putBe(out, 22, 4);
+            putString(out, "ihdr");
+            putBe(out, kCoverSize, 4);
+            putBe(out, kCoverSize, 4);
+            putBe(out, 3, 2);
+            putBe(out, 0x07070000, 4);
+            return out;
+        }
+
+        Bytes icoHeader() {
+            Bytes out;
+            putLe(out, 0, 2);
+            putLe(out, 1, 2);
+            putLe(out, 1, 2);
+            // 0 means 256
+            out.push_back(0);
+            out.push_back(0);
+            out.push_back(0);
+            out.push_back(0);
+            putLe(out, 1, 2);
+            putLe(out, 32, 2);
+            putLe(out, 0, 4);
+            putLe(out, 22, 4);
+            return out;
+        }
+
+        Bytes icnsHeader() {
+            Bytes out;
+            putString(out, "icns");
+            putBe(out, 8 + 16, 4);
+            putString(out, "ic09");
+            putBe(out, 16, 4);
+            out.resize(out.size() + 8);
+            return out;
+        }
+
+        Bytes psdHeader() {
+            Bytes out;
+            putString(out, std::string("8BPS\0\1", 6));
+            out.resize(out.size() + 6);
+            putBe(out, 3, 2);
+            putBe(out, kCoverSize, 4);
+            putBe(out, kCoverSize, 4);
+            putBe(out, 8, 2);
+            putBe(out, 3, 2);
+            return out;
+        }
+
+        Bytes qoiHeader() {
+            Bytes out;
+            putString(out, "qoif");
+            putBe(out, kCoverSize, 4);
+            putBe(out, kCoverSize, 4);
+            out.push_back(3);
+            out.push_back(0);
+            return out;
+        }
+
+        Bytes hdrHeader() {
+            Bytes out;
+            putString(out, "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\nEXPOSURE=1.0\n\n");
+            putString(out, "-Y " + std::to_string(kCoverSize) + " +X " + std::to_string(kCoverSize) + "\n");
+            return out;
+        }
+
+        Bytes unknownHeader() {
+            Bytes out(4096);
+            uint32_t state = 1;
+            for (auto &byte: out) {
+                state = state * 1103515245u + 12345u;
+                byte = (uint8_t) (state >> 24);
+            }
+            // no magic of any detector
+            out[0] = 0;
+            out[1] = 0;
+            return out;
+        }
+    }
+
+    namespace {
+        /**
+         * MSB first bit writer with the CRCs of FLAC frames.
+         */
+        class BitWriter {
+        public:
+            void put(uint64_t value, int32_t bits) {
+                for (int32_t i = bits - 1; i >= 0; i--) {
+                    current = (uint8_t) (current << 1 | ((value >> i) & 1));
+                    if (++used == 8) {
+                        out.push_back(current);
+                        current = 0;
+                        used = 0;
+                    }
+                }
+            }
+
+            void putSigned(int64_t value, int32_t bits) {
+                put((uint64_t) value & ((1ull << bits) - 1), bits);
+            }
+
+            void putRice(int64_t value, int32_t parameter) {
+                uint64_t folded = value < 0 ? ((uint64_t) -(value + 1) << 1) | 1
+                                            : (uint64_t) value << 1;
+                uint64_t quotient = folded >> parameter;
+                for (uint64_t i = 0; i < quotient; i++) {
+                    put(0, 1);
+                }
+                put(1, 1);
+                put(folded & ((1ull << parameter) - 1), parameter);
+            }
+
+            void alignToByte() {
+                if (used > 0) {
+                    put(0, 8 - used);
+                }
+            }
+
+            Bytes &bytes() {
+                return out;
+            }
+
+        private:
+            Bytes out;
+            uint8_t current = 0;
+            int32_t used = 0;
+        };
+
+        uint8_t crc8(const uint8_t *data, size_t size) {
+            uint8_t crc = 0;
+            for (size_t i = 0; i < size; i++) {
+                crc ^= data[i];
+                for (int32_t bit = 0; bit < 8; bit++) {
+                    crc = (uint8_t) (crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1);
+                }
+            }
+            return crc;
+        }
+
+        uint16_t crc16(const uint8_t *data, size_t size) {
+            uint16_t crc = 0;
+            for (size_t i = 0; i < size; i++) {
+                crc ^= (uint16_t) (data[i] << 8);
+                for (int32_t bit = 0; bit < 8; bit++) {
+                    crc = (uint16_t) (crc & 0x8000 ? (crc << 1) ^ 0x8005 : crc << 1);
+                }
+            }
+            return crc;
+        }
+
+        constexpr int32_t kFlacBlockSize = 4096;
+        constexpr int32_t kMaxFixedOrder = 4;
+        constexpr int32_t kPartitionOrder = 4;
+
+        int64_t fixedResidual(const int32_t *x, int32_t i, int32_t order) {
+            switch (order) {
+                case 0:
+                    return x[i];
+                case 1:
+                    return (int64_t) x[i] - x[i - 1];
+                case 2:
+                    return (int64_t) x[i] - 2ll * x[i - 1] + x[i - 2];
+                case 3:
+                    return (int64_t) x[i] - 3ll * x[i - 1] + 3ll * x[i - 2] - x[i - 3];
+                default:
+                    return (int64_t) x[i] - 4ll * x[i - 1] + 6ll * x[i - 2] -
+                           4ll * x[i - 3] + x[i - 4];
+            }
+        }
+
+        int32_t riceParameter(const std::vector<int64_t> &residual, size_t begin, size_t end) {
+            uint64_t sum = 0;
+            for (size_t i = begin; i < end; i++) {
+                sum += residual[i] < 0 ? -residual[i] : residual[i];
+            }
+            uint64_t mean = end > begin ? sum / (end - begin) : 0;
+            int32_t parameter = 0;
+            while (parameter < 14 && (1ull << (parameter + 1)) <= mean) {
+                parameter++;
+            }
+            return parameter;
+        }
+
+        void putFixedSubframe(BitWriter &writer, const int32_t *x, int32_t size, int32_t bits) {
+            // the order with the smallest residual, as flac -0 picks it
+            int32_t order = 0;
+            uint64_t best = UINT64_MAX;
+            for (int32_t candidate = 0; candidate <= std::min(kMaxFixedOrder, size - 1);
+                 candidate++) {
+                uint64_t sum = 0;
+                for (int32_t i = candidate; i < size; i++) {
+                    int64_t r = fixedResidual(x, i, candidate);
+                    sum += r < 0 ? -r : r;
+                }
+                if (sum < best) {
+                    best = sum;
+                    order = candidate;
+                }
+            }
+
+            writer.put(0, 1);
+            writer.put(0x08 | order, 6);
+            writer.put(0, 1);
+            for (int32_t i = 0; i < order; i++) {
+                writer.putSigned(x[i], bits);
+            }
+
+            std::vector<int64_t> residual((size_t) size);
+            for (int32_t i = order; i < size; i++) {
+                residual[i] = fixedResidual(x, i, order);
+            }
+            int32_t partitionOrder = kPartitionOrder;
+            while (partitionOrder > 0 &&
+                   ((size % (1 << partitionOrder)) != 0 ||
+                    (size >> partitionOrder) <= order)) {
+                partitionOrder--;
+            }
+            const int32_t partitionSize = size >> partitionOrder;
+            writer.put(0, 2);
+            writer.put(partitionOrder, 4);
+            for (int32_t partition = 0; partition < (1 << partitionOrder); partition++) {
+                size_t begin = partition == 0 ? order : (size_t) partition * partitionSize;
+                size_t end = (size_t) (partition + 1) * partitionSize;
+                int32_t parameter = riceParameter(residual, begin, end);
+                writer.put(parameter, 4);
+                for (size_t i = begin; i < end; i++) {
+                    writer.putRice(residual[i], parameter);
+                }
+            }
+        }
+
+        void putUtf8(BitWriter &writer, uint32_t value) {
+            if (value < 0x80) {
+                writer.put(value, 8);
+                return;
+            }
+            int32_t extra = value < 0x800 ? 1 : value < 0x10000 ? 2 : value < 0x200000 ? 3 : 4;
+            writer.put(((0xFF00 >> (extra + 1)) & 0xFF) | (value >> (6 * extra)), 8);
+            for (int32_t i = extra - 1; i >= 0; i--) {
+                writer.put(0x80 | ((value >> (6 * i)) & 0x3F), 8);
+            }
+        }
+
+        uint64_t fullScale(int32_t bits) {
+            return 1ull << (bits - 1);
+        }
+    }
+
+    std::vector<int32_t> musicPcm(const PcmFormat &format, double seconds) {
+        const auto frames = (int64_t) (seconds * format.sampleRate);
+        const double scale = (double) fullScale(format.bitsPerSample) - 1;
+        std::vector<int32_t> out((size_t) (frames * format.channels));
+        // a minor chord and its harmonics, slightly detuned per channel
+        const double tones[] = {220.0, 261.63, 329.63, 440.0, 880.0, 1760.0, 3520.0};
+        uint32_t noise = 1;
+        for (int64_t i = 0; i < frames; i++) {
+            double t = (double) i / format.sampleRate;
+            double swell = 0.6 + 0.4 * std::sin(2 * M_PI * 0.25 * t);
+            for (int32_t ch = 0; ch < format.channels; ch++) {
+                double value = 0;
+                for (size_t k = 0; k < std::size(tones); k++) {
+                    double frequency = tones[k] * (1 + 0.001 * ch);
+                    value += std::sin(2 * M_PI * frequency * t + k) / (double) (k + 1);
+                }
+                noise = noise * 1664525u + 1013904223u;
+                double dither = ((double) (noise >> 8) / (1 << 24) - 0.5) * 0.01;
+                out[(size_t) (i * format.channels + ch)] =
+                        (int32_t) std::lrint((0.25 * swell * value + dither) * scale);
+            }
+        }
+        return out;
+    }
+
+    Bytes encodeFlac(const std::vector<int32_t> &samples, const PcmFormat &format) {
+        const int32_t c = format.channels;
+        const auto frames = (int64_t) (samples.size() / c);
+        Bytes out;
+        putString(out, "fLaC");
+
+        Bytes streamInfo;
+        putBe(streamInfo, kFlacBlockSize, 2);
+        putBe(streamInfo, kFlacBlockSize, 2);
+        putBe(streamInfo, 0, 3);
+        putBe(streamInfo, 0, 3);
+        putBe(streamInfo, (uint64_t) format.sampleRate << 44 | (uint64_t) (c - 1) << 41 |
+                          (uint64_t) (format.bitsPerSample - 1) << 36 | (uint64_t) frames, 8);
+        streamInfo.resize(streamInfo.size() + 16);
+        putFlacBlock(out, 0, streamInfo, true);
+
+        std::vector<int32_t> channel(kFlacBlockSize);
+        uint32_t frameNumber = 0;
+        for (int64_t start = 0; start < frames; start += kFlacBlockSize, frameNumber++) {
+            auto size = (int32_t) std::min<int64_t>(kFlacBlockSize, frames - start);
+            BitWriter writer;
+            writer.put(0xFFF8, 16);
+            // 4096, or a 16-bit size at the end of the header
+            writer.put(size == kFlacBlockSize ? 12 : 7, 4);
+            // rate and sample size from STREAMINFO, independent channels
+            writer.put(0, 4);
+            writer.put(c - 1, 4);
+            writer.put(0, 3);
+            writer.put(0, 1);
+            putUtf8(writer, frameNumber);
+            if (size != kFlacBlockSize) {
+                writer.put(size - 1, 16);
+            }
+            writer.put(crc8(writer.bytes().data(), writer.bytes().size()), 8);
+            for (int32_t ch = 0; ch < c; ch++) {
+                for (int32_t i = 0; i < size; i++) {
+                    channel[i] = samples[(size_t) ((start + i) * c + ch)];
+                }
+                putFixedSubframe(writer, channel.data(), size, format.bitsPerSample);
+            }
+            writer.alignToByte();
+            writer.put(crc16(writer.bytes().data(), writer.bytes().size()), 16);
+            putBytes(out, writer.bytes());
+        }
+        return out;
+    }
+
+    Bytes encodeWav(const std::vector<int32_t> &samples, const PcmFormat &format) {
+        const int32_t bytesPerSample = format.bitsPerSample / 8;
+        Bytes out;
+        putString(out, "RIFF");
+        putLe(out, 0, 4);
+        putString(out, "WAVE");
+
+        Bytes header;
+        putLe(header, 1, 2);
+        putLe(header, format.channels, 2);
+        putLe(header, format.sampleRate, 4);
+        putLe(header, format.sampleRate * format.channels * bytesPerSample, 4);
+        putLe(header, format.channels * bytesPerSample, 2);
+        putLe(header, format.bitsPerSample, 2);
+        putRiffChunk(out, "fmt ", header);
+
+        Bytes data;
+        data.reserve(samples.size() * bytesPerSample);
+        for (int32_t sample: samples) {
+            putLe(data, (uint32_t) sample, bytesPerSample);
+        }
+        putRiffChunk(out, "data", data);
+        setLe32(out, 4, (uint32_t) (out.size() - 8));
+        return out;
+    }
+
+    Bytes encodeAiff(const std::vector<int32_t> &samples, const PcmFormat &format) {
+        const int32_t bytesPerSample = format.bitsPerSample / 8;
+        Bytes out;
+        putString(out, "FORM");
+        putBe(out, 0, 4);
+        putString(out, "AIFF");
+
+        Bytes common;
+        putBe(common, format.channels, 2);
+        putBe(common, samples.size() / format.channels, 4);
+        putBe(common, format.bitsPerSample, 2);
+        // the rate as an 80-bit extended float
+        int32_t exponent = 0;
+        while ((format.sampleRate >> exponent) > 1) {
+            exponent++;
+        }
+        putBe(common, 16383 + exponent, 2);
+        putBe(common, (uint64_t) format.sampleRate << (63 - exponent), 8);
+
+        Bytes sound;
+        putBe(sound, 0, 4);
+        putBe(sound, 0, 4);
+        sound.reserve(sound.size() + samples.size() * bytesPerSample);
+        for (int32_t sample: samples) {
+            putBe(sound, (uint32_t) sample, bytesPerSample);
+        }
+
+        for (const auto &[id, body]: {std::pair<const char *, const Bytes &>{"COMM", common},
+                                      {"SSND", sound}}) {
+            putString(out, id);
+            putBe(out, body.size(), 4);
+            putBytes(out, body);
+            if (body.size() % 2 != 0) {
+                out.push_back(0);
+            }
+        }
+        setBe32(out, 4, (uint32_t) (out.size() - 8));
+        return out;
+    }
+
+    DsdPlanes modulateDsd(int32_t channels, int32_t dsdRate, double seconds, bool lsbFirst) {
+        const auto bytes = (size_t) (seconds * dsdRate / 8);
+        DsdPlanes planes((size_t) channels, Bytes(bytes));
+        for (int32_t ch = 0; ch < channels; ch++) {
+            // the sine as a rotating phasor, much cheaper than sin()
+            const double step = 2 * M_PI * 1000.0 * (ch + 1) / dsdRate;
+            const double stepCos = std::cos(step);
+            const double stepSin = std::sin(step);
+            double re = 1;
+            double im = 0;
+            double integrator1 = 0;
+            double integrator2 = 0;
+            double feedback = 0;
+            for (size_t i = 0; i < bytes; i++) {
+                uint8_t value = 0;
+                for (int32_t bit = 0; bit < 8; bit++) {
+                    double x = 0.5 * im;
+                    double rotated = re * stepCos - im * stepSin;
+                    im = re * stepSin + im * stepCos;
+                    re = rotated;
+                    integrator1 += x - feedback;
+                    integrator2 += integrator1 - feedback;
+                    int32_t one = integrator2 >= 0;
+                    feedback = one ? 1 : -1;
+                    value |= (uint8_t) (one << (lsbFirst ? bit : 7 - bit));
+                }
+                planes[ch][i] = value;
+            }
+        }
+        return planes;
+    }
+
+    Bytes encodeDsf(const DsdPlanes &planes, int32_t dsdRate) {
+        constexpr size_t kBlockSize = 4096;
+        const auto channels = (int32_t) planes.size();
+        const size_t bytes = planes[0].size();
+        const size_t groups = (bytes + kBlockSize - 1) / kBlockSize;
+        Bytes out;
+        putString(out, "DSD ");
+        putLe(out, 28, 8);
+        putLe(out, 0, 8);
+        // no metadata
+        putLe(out, 0, 8);
+
+        putString(out, "fmt ");
+        putLe(out, 52, 8);
+        putLe(out, 1, 4);
+        // raw
+        putLe(out, 0, 4);
+        // channel type: mono, stereo, 3 channels, quad, 5 and 5.1
+        const uint32_t channelTypes[] = {1, 2, 3, 4, 6, 7};
+        putLe(out, channelTypes[std::clamp(channels, 1, 6) - 1], 4);
+        putLe(out, channels, 4);
+        putLe(out, dsdRate, 4);
+        putLe(out, 1, 4);
+        putLe(out, bytes * 8, 8);
+        putLe(out, kBlockSize, 4);
+        putLe(out, 0, 4);
+
+        putString(out, "data");
+        putLe(out, 12 + groups * kBlockSize * channels, 8);
+        for (size_t group = 0; group < groups; group++) {
+            for (const Bytes &plane: planes) {
+                size_t begin = group * kBlockSize;
+                size_t end = std::min(begin + kBlockSize, bytes);
+                out.insert(out.end(), plane.begin() + (ptrdiff_t) begin,
+                           plane.begin() + (ptrdiff_t) end);
+                out.resize(out.size() + kBlockSize - (end - begin));
+            }
+        }
+        setLe32(out, 12, (uint32_t) out.size());
+        return out;
+    }
+
+    Bytes encodeDsdiff(const DsdPlanes &planes, int32_t dsdRate) {
+        const auto channels = (int32_t) planes.size();
+        const size_t bytes = planes[0].size();
+
+        Bytes properties;
+        putString(properties, "SND ");
+        putString(properties, "FS  ");
+        putBe(properties, 4, 8);
+        putBe(properties, dsdRate, 4);
+        putString(properties, "CHNL");
+        putBe(properties, 2 + 4 * channels, 8);
+        putBe(properties, channels, 2);
+        const char *multichannel[] = {"MLFT", "MRGT", "C   ", "LFE ", "LS  ", "RS  "};
+        for (int32_t ch = 0; ch < channels; ch++) {
+            putString(properties, channels == 2 ? (ch == 0 ? "SLFT" : "SRGT")
+                                                : channels == 1 ? "C   " : multichannel[ch % 6]);
+        }
+        const std::string compression = "not compressed";
+        putString(properties, "CMPR");
+        putBe(properties, 4 + 1 + compression.size() + 1, 8);
+        putString(properties, "DSD ");
+        properties.push_back((uint8_t) compression.size());
+        putString(properties, compression);
+        properties.push_back(0);
+
+        Bytes out;
+        putString(out, "FRM8");
+        putBe(out, 0, 8);
+        putString(out, "DSD ");
+        putString(out, "FVER");
+        putBe(out, 4, 8);
+        putBe(out, 0x01050000, 4);
+        putString(out, "PROP");
+        putBe(out, properties.size(), 8);
+        putBytes(out, properties);
+        putString(out, "DSD ");
+        putBe(out, bytes * channels, 8);
+        out.reserve(out.size() + bytes * channels);
+        for (size_t i = 0; i < bytes; i++) {
+            for (const Bytes &plane: planes) {
+                out.push_back(plane[i]);
+            }
+        }
+        size_t size = out.size() - 12;
+        for (int32_t i = 0; i < 8; i++) {
+            out[4 + i] = (uint8_t) (size >> (56 - 8 * i));
+        }
+        return out;
+    }
+
+    const std::vector<Sample> &imageSamples() {
+        static const std::vector<Sample> samples{
+                {"avif", -1, avifHeader()},
+                {"bmp", -1, bmpHeader()},
+                {"gif", -1, gifHeader()},
+                {"hdr", -1, hdrHeader()},
+                {"icns", -1, icnsHeader()},
+                {"ico", -1, icoHeader()},
+                {"jp2", -1, jp2Header()},
+                {"jpg", -1, jpegHeader()},
+                {"png", -1, pngHeader()},
+                {"psd", -1, psdHeader()},
+                {"qoi", -1, qoiHeader()},
+                {"tiff", -1, tiffHeader()},
+                {"webp", -1, webpHeader()},
+                {"unknown", -1, unknownHeader()},
+        };
+        return samples;
+    }
+
+    const std::vector<Sample> &tagSamples() {
+        static const std::vector<Sample> samples{
+                {"mp3", kMp3, mp3File()},
+                {"flac", kFlac, flacFile()},
+                {"wav", kWav, wavFile()},
+                {"aiff", kAiff, aiffFile()},
+                {"mp4", kAac, mp4File()},
+                {"ogg", kOgg, vorbisFile()},
+                {"opus", kOpus, opusFile()},
+                {"ape", kApe, apeFile()},
+        };
+        return samples;
+    }
+
+    const Sample &findSample(const std::vector<Sample> &samples, const std::string &name) {
+        for (const auto &sample: samples) {
+            if (sample.name == name) {
+                return sample;
+            }
+        }
+        throw std::out_of_range("no sample " + name);
+    }
+
+    MemoryFile::MemoryFile(const Bytes &data) : MemoryFile(data.data(), data.size()) {
+    }
+
+    MemoryFile::MemoryFile(const void *data, size_t size) {
+        fd = memfd_create("soundsource-sample", 0);
+        if (fd < 0) {
+            throw std::runtime_error("memfd_create failed");
+        }
+        size_t written = 0;
+        while (written < size) {
+            ssize_t result = write(fd, (const uint8_t *) data + written, size - written);
+            if (result <= 0) {
+                close(fd);
+                throw std::runtime_error("write failed");
+            }
+            written += result;
+        }
+    }
+
+    MemoryFile::~MemoryFile() {
+        close(fd);
+    }
+
+    int32_t MemoryFile::fileDescriptor() const {
+        return fd;
+    }
+
+    int32_t MemoryFile::open() const {
+        // a dup() would share the offset with every other descriptor
+        std::string path = "/proc/self/fd/" + std::to_string(fd);
+        return ::open(path.c_str(), O_RDONLY);
+    }
+}
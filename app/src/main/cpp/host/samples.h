@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_HOST_SAMPLES_H
+#define SOUNDSOURCE_HOST_SAMPLES_H
+
+#include <sys/types.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Synthetic media for the host benchmarks and checks, built in memory
+ * so no sample files have to be checked in.
+ */
+namespace SoundSource::Host {
+    using Bytes = std::vector<uint8_t>;
+
+    struct Sample {
+        std::string name;
+        /**
+         * The ordinal of the AudioFormatType, -1 for images.
+         */
+        int32_t format;
+        Bytes data;
+    };
+
+    /**
+     * The header of a cover in every common format getImageInfo
+     * detects, plus "unknown" bytes that no detector accepts.
+     */
+    const std::vector<Sample> &imageSamples();
+
+    /**
+     * Tagged MP3 (ID3v2.4), FLAC (Vorbis comment and picture block), WAV
+     * (RIFF INFO and ID3v2), AIFF (ID3v2), MP4 (ilst), Ogg Vorbis and
+     * Opus (Vorbis comment with METADATA_BLOCK_PICTURE) and APE (APEv2)
+     * files with a short silent stream and a JPEG front cover.
+     */
+    const std::vector<Sample> &tagSamples();
+
+    struct PcmFormat {
+        int32_t channels;
+        int32_t sampleRate;
+        int32_t bitsPerSample;
+    };
+
+    /**
+     * A deterministic signal with roughly the level and spectrum of
+     * music: a few harmonic tones, swelling and fading, over noise.
+     *
+     * @return interleaved samples at the full scale of the format.
+     */
+    std::vector<int32_t> musicPcm(const PcmFormat &format, double seconds);
+
+    /**
+     * Encode as FLAC the simple way: fixed predictors and Rice coded
+     * residuals, independent channels, blocks of 4096 frames.
+     */
+    Bytes encodeFlac(const std::vector<int32_t> &samples, const PcmFormat &format);
+
+    Bytes encodeWav(const std::vector<int32_t> &samples, const PcmFormat &format);
+
+    Bytes encodeAiff(const std::vector<int32_t> &samples, const PcmFormat &format);
+
+    /**
+     * One plane of bytes per channel, 8 DSD samples per byte.
+     */
+    using DsdPlanes = std::vector<Bytes>;
+
+    /**
+     * A half scale sine of 1 kHz times the channel number through a
+     * second order delta-sigma modulator, which is about what a 0 dB
+     * SACD signal looks like, only noisier.
+     *
+     * @param lsbFirst whether the first sample of a byte goes to its
+     * least significant bit, as DSF stores it.
+     */
+    DsdPlanes modulateDsd(int32_t channels, int32_t dsdRate, double seconds, bool lsbFirst);
+
+    /**
+     * Encode LSB first planes as DSF in blocks of 4096 bytes per channel.
+     */
+    Bytes encodeDsf(const DsdPlanes &planes, int32_t dsdRate);
+
+    /**
+     * Encode MSB first planes as uncompressed, byte interleaved DSDIFF.
+     */
+    Bytes encodeDsdiff(const DsdPlanes &planes, int32_t dsdRate);
+
+    /**
+     * @return the sample of the given name, throws std::out_of_range if
+     * there is none.
+     */
+    const Sample &findSample(const std::vector<Sample> &samples, const std::string &name);
+
+    /**
+     * An anonymous in-memory file holding the given bytes, for code
+     * that reads from a file descriptor.
+     */
+    class MemoryFile {
+    public:
+        /**
+         * Throws std::runtime_error if the file cannot be created.
+         */
+        explicit MemoryFile(const Bytes &data);
+
+        MemoryFile(const void *data, size_t size);
+
+        ~MemoryFile();
+
+        MemoryFile(const MemoryFile &) = delete;
+
+        MemoryFile &operator=(const MemoryFile &) = delete;
+
+        int32_t fileDescriptor() const;
+
+        /**
+         * @return a new readonly descriptor of the file with an offset of
+         * its own, owned by the caller, or -1 on error.
+         */
+        int32_t open() const;
+
+    private:
+        int32_t fd;
+    };
+}
+
+#endif //SOUNDSOURCE_HOST_SAMPLES_H
@@ -18,12 +18,16 @@
 #include <malloc.h>
 #include <algorithm>
 
+#include "metrics.h"
+#include "trace.h"
+
 #define ABS(a) ((a)<(0)?(-(a)):(a))
 #define MAX(a, b) ((a)>(b)?(a):(b))
 #define MIN(a, b) ((a)<(b)?(a):(b))
 
 namespace SoundSource::Image {
     int16_t *ImageProcessor::BlurRgb565(int16_t *pix, int32_t w, int32_t h, int32_t radius) {
+        Metrics::Timer timer(Metrics::Histogram::BLUR_TIME, Metrics::kNoFormat);
         int32_t wm = w - 1;
         int32_t hm = h - 1;
         int32_t wh = w * h;
@@ -58,6 +62,7 @@ namespace SoundSource::Image {
         int32_t routsum, goutsum, boutsum;
         int32_t rinsum, ginsum, binsum;
 
+        Trace::Section horizontal("BlurRgb565::horizontal");
         for (y = 0; y < h; y++) {
             rinsum = ginsum = binsum = routsum = goutsum = boutsum = r_sum = g_sum = b_sum = 0;
             for (i = -radius; i <= radius; i++) {
@@ -132,6 +137,9 @@ namespace SoundSource::Image {
             }
             yw += w;
         }
+        horizontal.end();
+
+        Trace::Section vertical("BlurRgb565::vertical");
         for (x = 0; x < w; x++) {
             rinsum = ginsum = binsum = routsum = goutsum = boutsum = r_sum = g_sum = b_sum = 0;
             yp = -radius * w;
@@ -213,6 +221,7 @@ namespace SoundSource::Image {
                 yi += w;
             }
         }
+        vertical.end();
 
         free(r);
         free(g);
@@ -224,6 +233,7 @@ namespace SoundSource::Image {
     }
 
     int32_t *ImageProcessor::BlurArgb8888(int32_t *pix, int32_t w, int32_t h, int32_t radius) {
+        Metrics::Timer timer(Metrics::Histogram::BLUR_TIME, Metrics::kNoFormat);
         int32_t wm = w - 1;
         int32_t hm = h - 1;
         int32_t wh = w * h;
@@ -254,6 +264,7 @@ namespace SoundSource::Image {
         int32_t routsum, goutsum, boutsum;
         int32_t rinsum, ginsum, binsum;
 
+        Trace::Section horizontal("BlurArgb8888::horizontal");
         for (y = 0; y < h; y++) {
             rinsum = ginsum = binsum = routsum = goutsum = boutsum = rsum = gsum = bsum = 0;
             for (i = -radius; i <= radius; i++) {
@@ -328,6 +339,9 @@ namespace SoundSource::Image {
             }
             yw += w;
         }
+        horizontal.end();
+
+        Trace::Section vertical("BlurArgb8888::vertical");
         for (x = 0; x < w; x++) {
             rinsum = ginsum = binsum = routsum = goutsum = boutsum = rsum = gsum = bsum = 0;
             yp = -radius * w;
@@ -408,6 +422,7 @@ namespace SoundSource::Image {
                 yi += w;
             }
         }
+        vertical.end();
 
         free(r);
         free(g);
@@ -419,11 +434,13 @@ namespace SoundSource::Image {
     }
 
     ImageInfo getImageInfo(const char *path) {
+        TRACE_SECTION("Image::parse");
         ImageInfo info = parse<FilePathReader>(path);
         return info;
     }
 
     ImageInfo getImageInfo(const void *data, size_t size) {
+        TRACE_SECTION("Image::parse");
         ImageInfo info = parse<RawDataReader>(RawData(data, size));
         return info;
     }
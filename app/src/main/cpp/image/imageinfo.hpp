@@ -51,6 +51,7 @@
 #include <cassert>
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <functional>
@@ -292,24 +293,45 @@ namespace SoundSource::Image {
 
         inline int64_t readS64Be(off_t offset) { return readInt<int64_t>(offset, true); }
 
+        /**
+         * @return whether [offset, offset + size) lies inside the buffer.
+         */
+        inline bool contains(off_t offset, size_t size) const {
+            return offset >= 0 && (size_t) offset <= size_ && size <= size_ - (size_t) offset;
+        }
+
+        // Reads past the end (the sizes and offsets come from the file)
+        // yield 0, an empty string or a mismatch instead of touching
+        // memory outside the buffer.
+
         template<typename T>
         inline T readInt(off_t offset, bool swap_endian = false) {
-            T val = *((T *) (data() + offset));
+            if (!contains(offset, sizeof(T))) {
+                return 0;
+            }
+            T val;
+            memcpy(&val, data() + offset, sizeof(T));
             return swap_endian ? swapE<T>(val) : val;
         }
 
         inline std::string readString(off_t offset, size_t size) {
+            if (!contains(offset, size)) {
+                return {};
+            }
             return std::string((char *) data() + offset, size);
         }
 
         inline std::string toString() { return std::string((char *) data(), size()); }
 
         inline bool cmp(off_t offset, size_t size, const void *buf) {
-            return memcmp(data() + offset, buf, size) == 0;
+            return contains(offset, size) && memcmp(data() + offset, buf, size) == 0;
         }
 
         inline bool
         cmpAnyOf(off_t offset, size_t size, const std::initializer_list<const void *> &bufs) {
+            if (!contains(offset, size)) {
+                return false;
+            }
             return std::any_of(bufs.begin(), bufs.end(),
                                [this, offset, size](const void *buf) {
                                    return memcmp(data() + offset, buf, size) == 0;
@@ -349,9 +371,15 @@ namespace SoundSource::Image {
 #endif
         }
 
+        /**
+         * Read size bytes at offset, truncated at the end of the data.
+         * An offset outside the data gives an empty buffer.
+         */
         inline Buffer readBuffer(off_t offset, size_t size) {
-            assert(offset >= 0);
-            assert(offset + size <= length_);
+            if (offset < 0 || (size_t) offset > length_) {
+                return Buffer(0);
+            }
+            size = (std::min)(size, length_ - (size_t) offset);
             Buffer buffer(size);
 #ifndef II_DISABLE_HEADER_CACHE
             if (offset + size <= header_cache_.size()) {
@@ -481,7 +509,10 @@ namespace SoundSource::Image {
         }
         auto buffer = ri.readBuffer(0, 4);
         uint32_t ftyp_box_length = buffer.readU32Be(0);
-        if (length < ftyp_box_length + 12) {
+        // the ftyp box holds the major brand, the minor version and a
+        // few compatible brands
+        if (ftyp_box_length < 16 || ftyp_box_length > 4096 ||
+            length < (size_t) ftyp_box_length + 12) {
             return false;
         }
         buffer = ri.readBuffer(0, ftyp_box_length + 12);
@@ -525,7 +556,7 @@ namespace SoundSource::Image {
 
         uint32_t meta_length = buffer.readU32Be(ftyp_box_length);
 
-        if (length < ftyp_box_length + 12 + meta_length) {
+        if (meta_length < 12 || length < (size_t) ftyp_box_length + 12 + meta_length) {
             return false;
         }
 
@@ -545,10 +576,15 @@ namespace SoundSource::Image {
          *           - ...
          *           - ispe
          */
-        while (offset < end) {
+        while (offset + 8 <= end) {
             uint32_t box_size = buffer.readU32Be(offset);
+            if (box_size < 8) {
+                // size 0 (to the end of file) and 1 (64-bit size) never
+                // hold the properties, anything else is malformed
+                return false;
+            }
             if (buffer.cmpAnyOf(offset + 4, 4, {"iprp", "ipco"})) {
-                end = offset + box_size;
+                end = (std::min)(end, offset + (off_t) box_size);
                 offset += 8;
             } else if (buffer.cmp(offset + 4, 4, "ispe")) {
                 if (is_avif) {
@@ -708,25 +744,46 @@ namespace SoundSource::Image {
         }
 
         const size_t piece = 64;
+        // the resolution line follows a handful of short variable lines,
+        // stop early on garbage
+        const size_t max_header = 4096;
         std::string header;
         static const std::regex x_pattern(R"(\s[+-]X\s(\d+)\s)");
         static const std::regex y_pattern(R"(\s[+-]Y\s(\d+)\s)");
-        while (offset < length) {
+        // the empty line ending the variables, the resolution line is
+        // the next one, so only that line is searched
+        size_t blank = std::string::npos;
+        while (offset < length && header.size() < max_header) {
             buffer = ri.readBuffer(offset, std::min<size_t>(length - offset, piece));
             offset += (off_t) buffer.size();
+            size_t appended = header.size();
             header += buffer.toString();
+            if (blank == std::string::npos) {
+                blank = header.find("\n\n", appended > 0 ? appended - 1 : 0);
+                if (blank == std::string::npos) {
+                    continue;
+                }
+            }
+            size_t line_end = header.find('\n', blank + 2);
+            if (line_end == std::string::npos) {
+                continue;
+            }
+            // with the newlines around it, which the patterns match as
+            // whitespace
+            std::string line = header.substr(blank + 1, line_end - blank);
             std::smatch x_results;
             std::smatch y_results;
-            std::regex_search(header, x_results, x_pattern);
-            std::regex_search(header, y_results, y_pattern);
-            if (x_results.size() >= 2 && y_results.size() >= 2) {
-                info = ImageInfo(HDR, "hdr", "hdr", "image/vnd.radiance");
-                info.setSize(                    //
-                        std::stol(x_results.str(1)),  //
-                        std::stol(y_results.str(1))   //
-                );
-                return true;
+            std::regex_search(line, x_results, x_pattern);
+            std::regex_search(line, y_results, y_pattern);
+            if (x_results.size() < 2 || y_results.size() < 2) {
+                return false;
             }
+            info = ImageInfo(HDR, "hdr", "hdr", "image/vnd.radiance");
+            info.setSize(                    //
+                    std::strtoll(x_results.str(1).c_str(), nullptr, 10),  //
+                    std::strtoll(y_results.str(1).c_str(), nullptr, 10)   //
+            );
+            return true;
         }
         return false;
     }
@@ -790,10 +847,18 @@ namespace SoundSource::Image {
             buffer = ri.readBuffer(offset, 8);
             auto type = buffer.readString(0, 4);
             uint32_t entry_size = buffer.readU32Be(4);
-            int64_t s = size_map.at(type);
+            if (entry_size < 8) {
+                return false;
+            }
+            offset += entry_size;
+            auto it = size_map.find(type);
+            if (it == size_map.end()) {
+                // TOC, icnV and other entries without an image
+                continue;
+            }
+            int64_t s = it->second;
             entry_sizes.emplace_back(s, s);
             max_size = (std::max)(max_size, s);
-            offset += entry_size;
         }
 
         info = ImageInfo(ICNS, "icns", "icns", "image/icns");
@@ -819,7 +884,7 @@ namespace SoundSource::Image {
         uint32_t signature_length = buffer.readU32Be(0);
         off_t offset = signature_length;
 
-        if (length < offset + 12) {
+        if (length < (size_t) offset + 12) {
             return false;
         }
 
@@ -838,6 +903,9 @@ namespace SoundSource::Image {
         }
 
         uint32_t ftyp_length = buffer.readU32Be(0);
+        if (ftyp_length < 12) {
+            return false;
+        }
         offset += ftyp_length;
 
         while (offset + 24 <= length) {
@@ -859,6 +927,10 @@ namespace SoundSource::Image {
                 }
             }
             uint32_t box_length = buffer.readU32Be(0);
+            if (box_length < 8) {
+                // 0 runs to the end of file, 1 has a 64-bit length
+                return false;
+            }
             offset += box_length;
         }
         return false;
@@ -881,8 +953,11 @@ namespace SoundSource::Image {
             buffer = ri.readBuffer(offset, 9);
             uint16_t section_size = buffer.readU16Be(2);
             if (!buffer.cmp(0, 1, "\xFF")) {
-                // skip garbage bytes
-                offset += 1;
+                // skip garbage bytes up to the next marker
+                auto garbage = ri.readBuffer(offset, (std::min)(length - (size_t) offset,
+                                                                (size_t) 4096));
+                auto *marker = (const uint8_t *) memchr(garbage.data(), 0xFF, garbage.size());
+                offset += marker == nullptr ? (off_t) garbage.size() : marker - garbage.data();
                 continue;
             }
 
@@ -1010,8 +1085,8 @@ namespace SoundSource::Image {
 
         bool swap_endian = buffer[0] == 0x4D;
 
-        auto offset = buffer.readInt<uint32_t>(4, swap_endian);
-        if (length < offset + 2) {
+        off_t offset = buffer.readInt<uint32_t>(4, swap_endian);
+        if (length < (size_t) offset + 2) {
             return false;
         }
 
@@ -1022,7 +1097,7 @@ namespace SoundSource::Image {
 
         int64_t width = -1;
         int64_t height = -1;
-        for (uint16_t i = 0; i < num_entry && length >= offset + 12 &&
+        for (uint16_t i = 0; i < num_entry && length >= (size_t) offset + 12 &&
                              (width == -1 || height == -1); ++i, offset += 12) {
             buffer = ri.readBuffer(offset, 12);
 
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "scale.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "audio/simd.h"
+#include "trace.h"
+
+namespace SoundSource::Image {
+    namespace Simd = SoundSource::Audio::Simd;
+
+    namespace {
+        /**
+         * The source pixels and weights of every output pixel along one
+         * axis, count weights per output, normalized to sum to 1.
+         */
+        struct Contributions {
+            int32_t count = 0;
+            std::vector<int32_t> first;
+            std::vector<float> weights;
+        };
+
+        Contributions contributions(int32_t srcLength, int32_t dstLength) {
+            const double scale = (double) srcLength / dstLength;
+            const double radius = std::max(scale, 1.0);
+
+            Contributions result;
+            result.count = (int32_t) std::ceil(radius) * 2 + 1;
+            result.first.resize((size_t) dstLength);
+            result.weights.assign((size_t) dstLength * result.count, 0.0f);
+            for (int32_t i = 0; i < dstLength; i++) {
+                const double centre = (i + 0.5) * scale;
+                auto first = (int32_t) std::floor(centre - radius);
+                first = std::clamp(first, 0, std::max(srcLength - result.count, 0));
+                float *weights = result.weights.data() + (size_t) i * result.count;
+                double sum = 0;
+                for (int32_t k = 0; k < result.count && first + k < srcLength; k++) {
+                    double distance = std::fabs(first + k + 0.5 - centre) / radius;
+                    double weight = std::max(0.0, 1 - distance);
+                    weights[k] = (float) weight;
+                    sum += weight;
+                }
+                if (sum <= 0) {
+                    // the nearest pixel, only reached by rounding
+                    auto nearest = std::clamp((int32_t) centre - first, 0, result.count - 1);
+                    weights[nearest] = 1;
+                    sum = 1;
+                }
+                for (int32_t k = 0; k < result.count; k++) {
+                    weights[k] = (float) (weights[k] / sum);
+                }
+                result.first[i] = first;
+            }
+            return result;
+        }
+    }
+
+    ImageSize artworkTargetSize(const ImageInfo &info, size_t bytes,
+                                int32_t maxDimension, int64_t maxBytes) {
+        const int64_t width = info.size().width;
+        const int64_t height = info.size().height;
+        if (!info.ok() || width <= 0 || height <= 0) {
+            return {};
+        }
+        const int64_t longest = std::max(width, height);
+        if (maxDimension > 0 && longest > maxDimension) {
+            const double scale = (double) maxDimension / (double) longest;
+            return {
+                    std::max<int64_t>(1, std::llround((double) width * scale)),
+                    std::max<int64_t>(1, std::llround((double) height * scale))
+            };
+        }
+        if (maxBytes > 0 && (int64_t) bytes > maxBytes) {
+            return {width, height};
+        }
+        return {};
+    }
+
+    void resizeRgba8888(const uint8_t *src, int32_t srcWidth, int32_t srcHeight, size_t srcStride,
+                        uint8_t *dst, int32_t dstWidth, int32_t dstHeight, size_t dstStride) {
+        if (srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0) {
+            return;
+        }
+        TRACE_SECTION("Image::resizeRgba8888");
+        const Contributions columns = contributions(srcWidth, dstWidth);
+        const Contributions rows = contributions(srcHeight, dstHeight);
+
+        // one source wide row, filtered vertically, then horizontally
+        std::vector<float> column((size_t) srcWidth * 4);
+        std::vector<float> row((size_t) dstWidth * 4);
+        const Simd::float4 rounding = Simd::set1(0.5f);
+        const Simd::float4 ceiling = Simd::set1(255.0f);
+
+        for (int32_t y = 0; y < dstHeight; y++) {
+            std::fill(column.begin(), column.end(), 0.0f);
+            const float *rowWeights = rows.weights.data() + (size_t) y * rows.count;
+            for (int32_t k = 0; k < rows.count; k++) {
+                const float weight = rowWeights[k];
+                if (weight == 0) {
+                    continue;
+                }
+                const uint8_t *line = src + (size_t) (rows.first[y] + k) * srcStride;
+                for (size_t i = 0; i < column.size(); i++) {
+                    column[i] += weight * (float) line[i];
+                }
+            }
+
+            for (int32_t x = 0; x < dstWidth; x++) {
+                const float *columnWeights = columns.weights.data() + (size_t) x * columns.count;
+                const float *pixel = column.data() + (size_t) columns.first[x] * 4;
+                Simd::float4 acc = Simd::zero();
+                for (int32_t k = 0; k < columns.count; k++) {
+                    if (columnWeights[k] != 0) {
+                        acc = Simd::madd(Simd::load(pixel + k * 4), Simd::set1(columnWeights[k]),
+                                         acc);
+                    }
+                }
+                acc = Simd::min(Simd::max(Simd::add(acc, rounding), Simd::zero()), ceiling);
+                Simd::store(row.data() + (size_t) x * 4, acc);
+            }
+
+            uint8_t *out = dst + (size_t) y * dstStride;
+            for (size_t i = 0; i < row.size(); i++) {
+                out[i] = (uint8_t) row[i];
+            }
+        }
+    }
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_IMAGE_SCALE_H
+#define SOUNDSOURCE_IMAGE_SCALE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <imageinfo.hpp>
+
+namespace SoundSource::Image {
+    /**
+     * Decide how a cover is embedded.
+     *
+     * A cover larger than maxDimension on its longest side is scaled to
+     * fit it, keeping the aspect ratio. A cover within the dimension but
+     * over maxBytes is re-encoded at its own size. A limit of 0 or less
+     * is not checked.
+     *
+     * @return the size to re-encode the cover to, or an invalid size
+     * (-1 x -1) if it is embedded as is, which includes covers that
+     * cannot be identified.
+     */
+    ImageSize artworkTargetSize(const ImageInfo &info, size_t bytes,
+                                int32_t maxDimension, int64_t maxBytes);
+
+    /**
+     * Resample 8-bit 4 channel pixels with a separable triangle filter
+     * as wide as the scale factor (bilinear when enlarging), filtering
+     * all four channels of a pixel in one SIMD lane group. The channel
+     * order does not matter; premultiplied alpha is filtered correctly.
+     *
+     * @param srcStride, dstStride bytes per row.
+     */
+    void resizeRgba8888(const uint8_t *src, int32_t srcWidth, int32_t srcHeight, size_t srcStride,
+                        uint8_t *dst, int32_t dstWidth, int32_t dstHeight, size_t dstStride);
+}
+
+#endif //SOUNDSOURCE_IMAGE_SCALE_H
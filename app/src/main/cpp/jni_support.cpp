@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "jni_support.h"
+
+#include "logging.h"
+
+namespace SoundSource::Jni {
+    namespace {
+        Bindings cached{};
+
+        jclass globalClass(JNIEnv *env, const char *name) {
+            jclass local = env->FindClass(name);
+            if (local == nullptr) {
+                LOGE("Cannot find class %s", name);
+                return nullptr;
+            }
+            auto global = (jclass) env->NewGlobalRef(local);
+            env->DeleteLocalRef(local);
+            return global;
+        }
+
+        struct ClassBinding {
+            jclass Bindings::*target;
+            const char *name;
+        };
+
+        struct ConstructorBinding {
+            jmethodID Bindings::*target;
+            jclass Bindings::*clazz;
+            const char *signature;
+        };
+
+        const ClassBinding classes[] = {
+                {&Bindings::nullPointerException, "java/lang/NullPointerException"},
+                {&Bindings::illegalArgumentException, "java/lang/IllegalArgumentException"},
+                {&Bindings::ioException, "java/io/IOException"},
+                {&Bindings::nativeArtwork,
+                 "tech/rollw/player/audio/tag/NativeLibAudioTag$NativeArtwork"},
+                {&Bindings::audioProperties, "tech/rollw/player/audio/tag/AudioProperties"},
+                {&Bindings::string, "java/lang/String"},
+                {&Bindings::lyricTimeline, "tech/rollw/player/audio/tag/LyricTimeline"},
+                {&Bindings::scanCacheEntry, "tech/rollw/player/audio/tag/ScanCache$Entry"},
+                {&Bindings::loudness, "tech/rollw/player/audio/analysis/Loudness"},
+                {&Bindings::musicFeatures, "tech/rollw/player/audio/analysis/MusicFeatures"},
+                {&Bindings::duplicateMatch, "tech/rollw/player/audio/analysis/DuplicateMatch"},
+                {&Bindings::outputStats, "tech/rollw/player/audio/player/OutputStats"},
+                {&Bindings::prefetchStats, "tech/rollw/player/audio/player/PrefetchStats"},
+        };
+
+        const ConstructorBinding constructors[] = {
+                {&Bindings::nativeArtworkInit, &Bindings::nativeArtwork,
+                 "(Ljava/lang/String;[BIIJLjava/lang/String;Ljava/lang/String;)V"},
+                {&Bindings::audioPropertiesInit, &Bindings::audioProperties, "(IIIIJ)V"},
+                {&Bindings::lyricTimelineInit, &Bindings::lyricTimeline,
+                 "([J[Ljava/lang/String;[I[I[J[I[Ljava/lang/String;J)V"},
+                {&Bindings::scanCacheEntryInit, &Bindings::scanCacheEntry,
+                 "([ILtech/rollw/player/audio/tag/AudioProperties;JJ)V"},
+                {&Bindings::loudnessInit, &Bindings::loudness, "(DD)V"},
+                {&Bindings::musicFeaturesInit, &Bindings::musicFeatures, "(DFIF)V"},
+                {&Bindings::duplicateMatchInit, &Bindings::duplicateMatch, "(JJF)V"},
+                {&Bindings::outputStatsInit, &Bindings::outputStats, "(JJIIIIIID[I)V"},
+                {&Bindings::prefetchStatsInit, &Bindings::prefetchStats, "(JJJIJJ)V"},
+        };
+
+        /**
+         * Stops at the first missing class or constructor: the failed
+         * lookup leaves a NoClassDefFoundError or NoSuchMethodError
+         * pending, and no further JNI call may run until it is handled.
+         */
+        bool resolve(JNIEnv *env) {
+            Bindings b{};
+            for (const auto &binding: classes) {
+                b.*binding.target = globalClass(env, binding.name);
+                if (b.*binding.target == nullptr) {
+                    return false;
+                }
+            }
+            for (const auto &binding: constructors) {
+                b.*binding.target = env->GetMethodID(b.*binding.clazz, "<init>", binding.signature);
+                if (b.*binding.target == nullptr) {
+                    LOGE("Cannot find constructor %s", binding.signature);
+                    return false;
+                }
+            }
+            cached = b;
+            return true;
+        }
+    }
+
+    const Bindings &bindings() {
+        return cached;
+    }
+
+    void throwAccessorNull(JNIEnv *env) {
+        env->ThrowNew(cached.nullPointerException, "accessor is null");
+    }
+
+    StringChars::StringChars(JNIEnv *env, jstring string)
+            : env(env), string(string),
+              chars(string == nullptr ? nullptr : env->GetStringUTFChars(string, nullptr)) {
+    }
+
+    StringChars::~StringChars() {
+        if (chars != nullptr) {
+            env->ReleaseStringUTFChars(string, chars);
+        }
+    }
+
+    bool registerNatives(JNIEnv *env, const char *className,
+                         const JNINativeMethod *methods, size_t count) {
+        jclass clazz = env->FindClass(className);
+        if (clazz == nullptr) {
+            LOGE("Cannot find class %s", className);
+            return false;
+        }
+        jint result = env->RegisterNatives(clazz, methods, (jint) count);
+        env->DeleteLocalRef(clazz);
+        if (result != JNI_OK) {
+            LOGE("Cannot register natives of %s", className);
+            return false;
+        }
+        return true;
+    }
+}
+
+using namespace SoundSource;
+
+extern "C"
+JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved) {
+    JNIEnv *env;
+    if (vm->GetEnv((void **) &env, JNI_VERSION_1_6) != JNI_OK) {
+        return JNI_ERR;
+    }
+    if (!Jni::resolve(env) ||
+        !Jni::registerNativeLibAudioTag(env) ||
+        !Jni::registerImageUtils(env)) {
+        return JNI_ERR;
+    }
+    return JNI_VERSION_1_6;
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_JNI_SUPPORT_H
+#define SOUNDSOURCE_JNI_SUPPORT_H
+
+#include <jni.h>
+#include <cstddef>
+
+namespace SoundSource::Jni {
+    /**
+     * Classes and method IDs resolved once in JNI_OnLoad. The classes
+     * are global references, valid on every thread for the lifetime
+     * of the library.
+     */
+    struct Bindings {
+        jclass nullPointerException;
+        jclass illegalArgumentException;
+        jclass ioException;
+
+        jclass nativeArtwork;
+        jmethodID nativeArtworkInit;
+
+        jclass audioProperties;
+        jmethodID audioPropertiesInit;
+
+        jclass string;
+
+        jclass lyricTimeline;
+        jmethodID lyricTimelineInit;
+
+        jclass scanCacheEntry;
+        jmethodID scanCacheEntryInit;
+
+        jclass loudness;
+        jmethodID loudnessInit;
+
+        jclass musicFeatures;
+        jmethodID musicFeaturesInit;
+
+        jclass duplicateMatch;
+        jmethodID duplicateMatchInit;
+
+        jclass outputStats;
+        jmethodID outputStatsInit;
+
+        jclass prefetchStats;
+        jmethodID prefetchStatsInit;
+    };
+
+    const Bindings &bindings();
+
+    /**
+     * Throw a NullPointerException for a released native handle.
+     */
+    void throwAccessorNull(JNIEnv *env);
+
+    /**
+     * Modified UTF-8 chars of a Java string, released when leaving the
+     * scope. get() is nullptr for a null string or when out of memory.
+     */
+    class StringChars {
+    public:
+        StringChars(JNIEnv *env, jstring string);
+
+        ~StringChars();
+
+        StringChars(const StringChars &) = delete;
+
+        StringChars &operator=(const StringChars &) = delete;
+
+        const char *get() const {
+            return chars;
+        }
+
+        explicit operator bool() const {
+            return chars != nullptr;
+        }
+
+    private:
+        JNIEnv *env;
+        jstring string;
+        const char *chars;
+    };
+
+    template<typename Array>
+    struct ArrayTraits;
+
+    template<>
+    struct ArrayTraits<jbyteArray> {
+        using Element = jbyte;
+
+        static Element *get(JNIEnv *env, jbyteArray array) {
+            return env->GetByteArrayElements(array, nullptr);
+        }
+
+        static void release(JNIEnv *env, jbyteArray array, Element *elements, jint mode) {
+            env->ReleaseByteArrayElements(array, elements, mode);
+        }
+    };
+
+    template<>
+    struct ArrayTraits<jintArray> {
+        using Element = jint;
+
+        static Element *get(JNIEnv *env, jintArray array) {
+            return env->GetIntArrayElements(array, nullptr);
+        }
+
+        static void release(JNIEnv *env, jintArray array, Element *elements, jint mode) {
+            env->ReleaseIntArrayElements(array, elements, mode);
+        }
+    };
+
+    /**
+     * Elements of a Java primitive array, released when leaving the
+     * scope. Changes are copied back only if writeBack is set.
+     */
+    template<typename Array>
+    class ArrayElements {
+    public:
+        using Element = typename ArrayTraits<Array>::Element;
+
+        ArrayElements(JNIEnv *env, Array array, bool writeBack = false)
+                : env(env), array(array), mode(writeBack ? 0 : JNI_ABORT) {
+            if (array != nullptr) {
+                elements = ArrayTraits<Array>::get(env, array);
+                length = elements == nullptr ? 0 : (size_t) env->GetArrayLength(array);
+            }
+        }
+
+        ~ArrayElements() {
+            if (elements != nullptr) {
+                ArrayTraits<Array>::release(env, array, elements, mode);
+            }
+        }
+
+        ArrayElements(const ArrayElements &) = delete;
+
+        ArrayElements &operator=(const ArrayElements &) = delete;
+
+        Element *data() const {
+            return elements;
+        }
+
+        size_t size() const {
+            return length;
+        }
+
+        explicit operator bool() const {
+            return elements != nullptr;
+        }
+
+    private:
+        JNIEnv *env;
+        Array array;
+        jint mode;
+        Element *elements = nullptr;
+        size_t length = 0;
+    };
+
+    using ByteArrayElements = ArrayElements<jbyteArray>;
+    using IntArrayElements = ArrayElements<jintArray>;
+
+    /**
+     * Register the natives of a class.
+     *
+     * @return false with a pending exception if the class or a method
+     * is missing.
+     */
+    bool registerNatives(JNIEnv *env, const char *className,
+                         const JNINativeMethod *methods, size_t count);
+
+    /**
+     * Natives of NativeLibAudioTag, in NativeLibAudioTag_jni.cpp.
+     */
+    bool registerNativeLibAudioTag(JNIEnv *env);
+
+    /**
+     * Natives of ImageUtils, in ImageUtils_jni.cpp.
+     */
+    bool registerImageUtils(JNIEnv *env);
+}
+
+#endif //SOUNDSOURCE_JNI_SUPPORT_H
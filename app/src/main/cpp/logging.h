@@ -17,13 +17,14 @@
 #ifndef SOUNDSOURCE_LOGGING_H
 #define SOUNDSOURCE_LOGGING_H
 
-#include <android/log.h>
-
 #if 1
 #ifndef GLOBAL_TAG
 #define GLOBAL_TAG  "SoundSourceNative"
 #endif
 
+#ifdef __ANDROID__
+#include <android/log.h>
+
 #define LOGV(...) __android_log_print(ANDROID_LOG_VERBOSE, GLOBAL_TAG, __VA_ARGS__)
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, GLOBAL_TAG, __VA_ARGS__)
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, GLOBAL_TAG, __VA_ARGS__)
@@ -31,7 +32,40 @@
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, GLOBAL_TAG, __VA_ARGS__)
 #define LOGF(...) __android_log_print(ANDROID_LOG_FATAL, GLOBAL_TAG, __VA_ARGS__)
 
-#define ASSERT(cond, ...) if (!(cond)) {__android_log_assert(#cond, MODULE_NAME, __VA_ARGS__);}
+#define ASSERT(cond, ...) if (!(cond)) {__android_log_assert(#cond, GLOBAL_TAG, __VA_ARGS__);}
+#else
+// host builds of the core library log to stderr
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+namespace SoundSource::Logging {
+    /**
+     * Print one line to stderr, like __android_log_print.
+     */
+    __attribute__((format(printf, 3, 4)))
+    inline void print(const char *level, const char *tag, const char *format, ...) {
+        va_list args;
+        va_start(args, format);
+        // keep the line of a thread together
+        flockfile(stderr);
+        std::fprintf(stderr, "%s/%s: ", level, tag);
+        std::vfprintf(stderr, format, args);
+        std::fputc('\n', stderr);
+        funlockfile(stderr);
+        va_end(args);
+    }
+}
+
+#define LOGV(...) ::SoundSource::Logging::print("V", GLOBAL_TAG, __VA_ARGS__)
+#define LOGD(...) ::SoundSource::Logging::print("D", GLOBAL_TAG, __VA_ARGS__)
+#define LOGI(...) ::SoundSource::Logging::print("I", GLOBAL_TAG, __VA_ARGS__)
+#define LOGW(...) ::SoundSource::Logging::print("W", GLOBAL_TAG, __VA_ARGS__)
+#define LOGE(...) ::SoundSource::Logging::print("E", GLOBAL_TAG, __VA_ARGS__)
+#define LOGF(...) ::SoundSource::Logging::print("F", GLOBAL_TAG, __VA_ARGS__)
+
+#define ASSERT(cond, ...) if (!(cond)) {LOGF(__VA_ARGS__); std::abort();}
+#endif
 #else
 #define LOGV(...)
 #define LOGD(...)
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace SoundSource::Metrics {
+    namespace {
+        constexpr int64_t kVersion = 1;
+        constexpr int32_t kCounters = (int32_t) Counter::COUNT;
+        constexpr int32_t kHistograms = (int32_t) Histogram::COUNT;
+        constexpr int32_t kSubBuckets = 1 << kSubBucketBits;
+        // count, sum and the buckets
+        constexpr int32_t kHistogramCells = 2 + kBucketCount;
+        constexpr size_t kCells = (size_t) kCounters * kFormatCount +
+                                  (size_t) kHistograms * kFormatCount * kHistogramCells;
+
+        /**
+         * The values of one thread. Only the owner writes, with plain
+         * relaxed stores, snapshots read them concurrently.
+         */
+        struct Shard {
+            std::atomic<int64_t> cells[kCells]{};
+
+            void add(size_t cell, int64_t value) {
+                cells[cell].store(cells[cell].load(std::memory_order_relaxed) + value,
+                                  std::memory_order_relaxed);
+            }
+        };
+
+        std::mutex shardsLock;
+        std::vector<Shard *> shards;
+        // values of exited threads
+        Shard retired;
+
+        struct ShardHolder {
+            std::unique_ptr<Shard> shard = std::make_unique<Shard>();
+
+            ShardHolder() {
+                std::lock_guard<std::mutex> guard(shardsLock);
+                shards.push_back(shard.get());
+            }
+
+            ~ShardHolder() {
+                std::lock_guard<std::mutex> guard(shardsLock);
+                for (size_t i = 0; i < kCells; i++) {
+                    retired.add(i, shard->cells[i].load(std::memory_order_relaxed));
+                }
+                shards.erase(std::find(shards.begin(), shards.end(), shard.get()));
+            }
+        };
+
+        Shard &localShard() {
+            thread_local ShardHolder holder;
+            return *holder.shard;
+        }
+
+        inline int32_t clampFormat(int32_t format) {
+            return format < 0 || format >= kFormatCount ? kNoFormat : format;
+        }
+
+        inline size_t histogramCell(Histogram histogram, int32_t format) {
+            return (size_t) kCounters * kFormatCount +
+                   ((size_t) histogram * kFormatCount + format) * kHistogramCells;
+        }
+    }
+
+    int32_t bucketOf(int64_t value) {
+        if (value < kSubBuckets) {
+            return (int32_t) std::max<int64_t>(value, 0);
+        }
+        int32_t exponent = 63 - __builtin_clzll((uint64_t) value);
+        int32_t sub = (int32_t) (value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+        int32_t bucket = (exponent - kSubBucketBits + 1) * kSubBuckets + sub;
+        return std::min(bucket, kBucketCount - 1);
+    }
+
+    int64_t bucketLowerBound(int32_t bucket) {
+        if (bucket < kSubBuckets) {
+            return bucket;
+        }
+        int32_t exponent = bucket / kSubBuckets + kSubBucketBits - 1;
+        int64_t sub = bucket % kSubBuckets;
+        return (kSubBuckets + sub) << (exponent - kSubBucketBits);
+    }
+
+    void add(Counter counter, int32_t format, int64_t value) {
+        localShard().add((size_t) counter * kFormatCount + clampFormat(format), value);
+    }
+
+    void record(Histogram histogram, int32_t format, int64_t value) {
+        size_t cell = histogramCell(histogram, clampFormat(format));
+        Shard &shard = localShard();
+        shard.add(cell, 1);
+        shard.add(cell + 1, value);
+        shard.add(cell + 2 + bucketOf(value), 1);
+    }
+
+    std::vector<int64_t> snapshot() {
+        std::vector<int64_t> values{kVersion, kFormatCount, kCounters, kHistograms, kBucketCount};
+        const size_t header = values.size();
+        values.resize(header + kCells);
+        std::lock_guard<std::mutex> guard(shardsLock);
+        for (size_t i = 0; i < kCells; i++) {
+            values[header + i] = retired.cells[i].load(std::memory_order_relaxed);
+        }
+        for (Shard *shard: shards) {
+            for (size_t i = 0; i < kCells; i++) {
+                values[header + i] += shard->cells[i].load(std::memory_order_relaxed);
+            }
+        }
+        return values;
+    }
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_METRICS_H
+#define SOUNDSOURCE_METRICS_H
+
+#include <sys/types.h>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace SoundSource::Metrics {
+    /**
+     * Formats match the ordinals of AudioFormatType on the Kotlin side,
+     * kNoFormat counts work not tied to an audio file, such as blurs.
+     */
+    constexpr int32_t kFormatCount = 12;
+    constexpr int32_t kNoFormat = kFormatCount - 1;
+
+    enum class Counter : int32_t {
+        OPENED = 0,
+        /**
+         * Files TagLib cannot parse.
+         */
+        PARSE_FAILED = 1,
+        /**
+         * Bytes TagLib read through MappedFileStream, that is in scans.
+         */
+        BYTES_READ = 2,
+        ARTWORK_READ = 3,
+        COUNT = 4,
+    };
+
+    /**
+     * Durations are recorded in microseconds, sizes in bytes.
+     */
+    enum class Histogram : int32_t {
+        OPEN_TIME = 0,
+        PARSE_TIME = 1,
+        ARTWORK_TIME = 2,
+        BLUR_TIME = 3,
+        ARTWORK_SIZE = 4,
+        COUNT = 5,
+    };
+
+    /**
+     * Log buckets with four linear sub-buckets per power of two, so a
+     * bucket is at most 25% wide. Values past the last bucket (2^25)
+     * are counted in it.
+     */
+    constexpr int32_t kSubBucketBits = 2;
+    constexpr int32_t kBucketCount = 96;
+
+    int32_t bucketOf(int64_t value);
+
+    int64_t bucketLowerBound(int32_t bucket);
+
+    /**
+     * Add to a counter of the calling thread, without locks or
+     * atomic read-modify-write instructions.
+     */
+    void add(Counter counter, int32_t format, int64_t value = 1);
+
+    void record(Histogram histogram, int32_t format, int64_t value);
+
+    /**
+     * Sum the values of every thread, since the library was loaded:
+     *
+     * <pre>
+     * version | formats | counters | histograms | buckets
+     * | counters * formats values
+     * | histograms * formats * (count | sum | buckets * count)
+     * </pre>
+     *
+     * Reads of a thread still recording may be a few values behind.
+     */
+    std::vector<int64_t> snapshot();
+
+    /**
+     * Records the microseconds of the enclosing scope, or up to stop().
+     */
+    class Timer {
+    public:
+        Timer(Histogram histogram, int32_t format)
+                : histogram(histogram), format(format),
+                  start(std::chrono::steady_clock::now()) {
+        }
+
+        ~Timer() {
+            stop();
+        }
+
+        Timer(const Timer &) = delete;
+
+        Timer &operator=(const Timer &) = delete;
+
+        void stop() {
+            if (stopped) {
+                return;
+            }
+            stopped = true;
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            record(histogram, format,
+                   std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+        }
+
+    private:
+        Histogram histogram;
+        int32_t format;
+        std::chrono::steady_clock::time_point start;
+        bool stopped = false;
+    };
+}
+
+#endif //SOUNDSOURCE_METRICS_H
@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "embedded_lyric.h"
+
+#include "aifffile.h"
+#include "apefile.h"
+#include "apetag.h"
+#include "asftag.h"
+#include "dsdifffile.h"
+#include "dsffile.h"
+#include "flacfile.h"
+#include "id3v2tag.h"
+#include "mp4tag.h"
+#include "mpcfile.h"
+#include "mpegfile.h"
+#include "mpegproperties.h"
+#include "synchronizedlyricsframe.h"
+#include "trueaudiofile.h"
+#include "unsynchronizedlyricsframe.h"
+#include "wavfile.h"
+#include "wavpackfile.h"
+#include "xiphcomment.h"
+
+using namespace TagLib;
+
+namespace SoundSource {
+    namespace {
+        constexpr int64_t kUnknownFrameLength = -1;
+
+        inline bool isLineBreak(char c) {
+            return c == '\n' || c == '\r';
+        }
+
+        /**
+         * @return the microseconds of an MPEG frame, for SYLT frames
+         * timed in MPEG frames.
+         */
+        int64_t mpegFrameMicros(File *file) {
+            auto *properties = dynamic_cast<MPEG::Properties *>(file->audioProperties());
+            if (properties == nullptr || properties->sampleRate() <= 0) {
+                return kUnknownFrameLength;
+            }
+            int64_t samples;
+            switch (properties->layer()) {
+                case 1:
+                    samples = 384;
+                    break;
+                case 2:
+                    samples = 1152;
+                    break;
+                default:
+                    samples = properties->version() == MPEG::Header::Version1 ? 1152 : 576;
+                    break;
+            }
+            return samples * 1000000 / properties->sampleRate();
+        }
+
+        ID3v2::Tag *id3v2TagOf(File *file) {
+            if (auto *mpegFile = dynamic_cast<MPEG::File *>(file)) {
+                return mpegFile->ID3v2Tag();
+            } else if (auto *flacFile = dynamic_cast<FLAC::File *>(file)) {
+                return flacFile->ID3v2Tag();
+            } else if (auto *wavFile = dynamic_cast<RIFF::WAV::File *>(file)) {
+                return wavFile->ID3v2Tag();
+            } else if (auto *aiffFile = dynamic_cast<RIFF::AIFF::File *>(file)) {
+                return aiffFile->tag();
+            } else if (auto *trueAudioFile = dynamic_cast<TrueAudio::File *>(file)) {
+                return trueAudioFile->ID3v2Tag();
+            } else if (auto *dsfFile = dynamic_cast<DSF::File *>(file)) {
+                return dsfFile->tag();
+            } else if (auto *dsdiffFile = dynamic_cast<DSDIFF::File *>(file)) {
+                return dsdiffFile->ID3v2Tag();
+            }
+            return nullptr;
+        }
+
+        APE::Tag *apeTagOf(File *file) {
+            if (auto *apeFile = dynamic_cast<APE::File *>(file)) {
+                return apeFile->APETag();
+            } else if (auto *wavPackFile = dynamic_cast<WavPack::File *>(file)) {
+                return wavPackFile->APETag();
+            } else if (auto *mpcFile = dynamic_cast<MPC::File *>(file)) {
+                return mpcFile->APETag();
+            } else if (auto *mpegFile = dynamic_cast<MPEG::File *>(file)) {
+                return mpegFile->APETag();
+            }
+            return nullptr;
+        }
+
+        /**
+         * Entries either hold a line each, or, in karaoke files, a
+         * syllable each with line breaks starting or ending the lines.
+         */
+        void addSynchedText(LyricTimeline &timeline,
+                            const ID3v2::SynchronizedLyricsFrame::SynchedTextList &entries,
+                            int64_t frameMicros) {
+            bool karaoke = false;
+            for (const auto &entry: entries) {
+                std::string text = entry.text.to8Bit(true);
+                if (!text.empty() && (isLineBreak(text.front()) || isLineBreak(text.back()))) {
+                    karaoke = true;
+                    break;
+                }
+            }
+
+            bool lineStart = true;
+            for (const auto &entry: entries) {
+                int64_t timestamp = frameMicros == kUnknownFrameLength
+                                    ? (int64_t) entry.time
+                                    : (int64_t) entry.time * frameMicros / 1000;
+                std::string text = entry.text.to8Bit(true);
+                std::string_view value(text);
+                bool breakBefore = false;
+                while (!value.empty() && isLineBreak(value.front())) {
+                    value.remove_prefix(1);
+                    breakBefore = true;
+                }
+                bool breakAfter = false;
+                while (!value.empty() && isLineBreak(value.back())) {
+                    value.remove_suffix(1);
+                    breakAfter = true;
+                }
+                if (!karaoke) {
+                    timeline.add(timestamp, value);
+                    continue;
+                }
+                if (lineStart || breakBefore) {
+                    timeline.add(timestamp, {});
+                }
+                timeline.addWord(timestamp, value);
+                lineStart = breakAfter;
+            }
+        }
+
+        bool readSynchronized(ID3v2::Tag *tag, File *file, LyricTimeline &timeline) {
+            const ID3v2::FrameList &frames = tag->frameList("SYLT");
+            ID3v2::SynchronizedLyricsFrame *chosen = nullptr;
+            for (ID3v2::Frame *frame: frames) {
+                auto *lyrics = dynamic_cast<ID3v2::SynchronizedLyricsFrame *>(frame);
+                if (lyrics == nullptr || lyrics->synchedText().isEmpty() ||
+                    lyrics->timestampFormat() == ID3v2::SynchronizedLyricsFrame::Unknown) {
+                    continue;
+                }
+                if (chosen == nullptr || (chosen->type() != ID3v2::SynchronizedLyricsFrame::Lyrics &&
+                                          lyrics->type() == ID3v2::SynchronizedLyricsFrame::Lyrics)) {
+                    chosen = lyrics;
+                }
+            }
+            if (chosen == nullptr) {
+                return false;
+            }
+            int64_t frameMicros = kUnknownFrameLength;
+            if (chosen->timestampFormat() == ID3v2::SynchronizedLyricsFrame::AbsoluteMpegFrames) {
+                frameMicros = mpegFrameMicros(file);
+                if (frameMicros == kUnknownFrameLength) {
+                    return false;
+                }
+            }
+            addSynchedText(timeline, chosen->synchedText(), frameMicros);
+            timeline.finish();
+            return !timeline.empty();
+        }
+
+        bool readUnsynchronized(ID3v2::Tag *tag, LyricTimeline &timeline) {
+            for (ID3v2::Frame *frame: tag->frameList("USLT")) {
+                auto *lyrics = dynamic_cast<ID3v2::UnsynchronizedLyricsFrame *>(frame);
+                if (lyrics == nullptr || lyrics->text().isEmpty()) {
+                    continue;
+                }
+                timeline = LyricTimeline::parse(lyrics->text().to8Bit(true));
+                if (!timeline.empty()) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool readID3v2(File *file, LyricTimeline &timeline) {
+            ID3v2::Tag *tag = id3v2TagOf(file);
+            if (tag == nullptr || tag->isEmpty()) {
+                return false;
+            }
+            return readSynchronized(tag, file, timeline) || readUnsynchronized(tag, timeline);
+        }
+
+        bool parseFirst(const StringList &values, LyricTimeline &timeline) {
+            for (const String &value: values) {
+                if (value.isEmpty()) {
+                    continue;
+                }
+                timeline = LyricTimeline::parse(value.to8Bit(true));
+                if (!timeline.empty()) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool readXiphComment(File *file, LyricTimeline &timeline) {
+            Ogg::XiphComment *comment;
+            if (auto *flacFile = dynamic_cast<FLAC::File *>(file)) {
+                comment = flacFile->xiphComment();
+            } else {
+                // Vorbis, Opus, Speex and Ogg FLAC
+                comment = dynamic_cast<Ogg::XiphComment *>(file->tag());
+            }
+            if (comment == nullptr) {
+                return false;
+            }
+            const auto &fields = comment->fieldListMap();
+            for (const char *key: {"LYRICS", "UNSYNCEDLYRICS"}) {
+                auto it = fields.find(key);
+                if (it != fields.end() && parseFirst(it->second, timeline)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool readMP4(File *file, LyricTimeline &timeline) {
+            auto *tag = dynamic_cast<MP4::Tag *>(file->tag());
+            if (tag == nullptr || !tag->contains("\251lyr")) {
+                return false;
+            }
+            return parseFirst(tag->item("\251lyr").toStringList(), timeline);
+        }
+
+        bool readAPE(File *file, LyricTimeline &timeline) {
+            APE::Tag *tag = apeTagOf(file);
+            if (tag == nullptr) {
+                return false;
+            }
+            const APE::ItemListMap &items = tag->itemListMap();
+            auto it = items.find("LYRICS");
+            if (it == items.end()) {
+                return false;
+            }
+            return parseFirst(it->second.values(), timeline);
+        }
+
+        bool readASF(File *file, LyricTimeline &timeline) {
+            auto *tag = dynamic_cast<ASF::Tag *>(file->tag());
+            if (tag == nullptr) {
+                return false;
+            }
+            for (const ASF::Attribute &attribute: tag->attribute("WM/Lyrics")) {
+                if (parseFirst(StringList(attribute.toString()), timeline)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    LyricTimeline readEmbeddedLyric(File *file) {
+        LyricTimeline timeline;
+        if (file == nullptr || !file->isValid()) {
+            return timeline;
+        }
+        // FLAC files rarely carry ID3v2, read their comments first
+        if (readXiphComment(file, timeline) ||
+            readID3v2(file, timeline) ||
+            readMP4(file, timeline) ||
+            readAPE(file, timeline) ||
+            readASF(file, timeline)) {
+            return timeline;
+        }
+        return {};
+    }
+}
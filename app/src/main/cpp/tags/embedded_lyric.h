@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_EMBEDDED_LYRIC_H
+#define SOUNDSOURCE_EMBEDDED_LYRIC_H
+
+#include <taglib/taglib/toolkit/tfile.h>
+
+#include "lyric.h"
+
+namespace SoundSource {
+    /**
+     * Read the lyrics embedded in the file straight from its format
+     * specific tag, without converting the tag to a PropertyMap.
+     *
+     * ID3v2 SYLT frames (in milliseconds or, for MPEG audio, frames) are
+     * taken as they are; USLT, Xiph LYRICS, MP4 ©lyr, APE LYRICS and
+     * WM/Lyrics text is parsed as LRC, so plain lyrics become untimed
+     * lines. Of several ID3v2 frames, synchronized lyrics win.
+     *
+     * @return the timeline, empty if the file has no lyrics.
+     */
+    LyricTimeline readEmbeddedLyric(TagLib::File *file);
+}
+
+#endif //SOUNDSOURCE_EMBEDDED_LYRIC_H
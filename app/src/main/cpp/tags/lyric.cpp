@@ -0,0 +1,362 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "lyric.h"
+
+#include <algorithm>
+
+namespace SoundSource {
+    namespace {
+        inline bool isDigit(char c) {
+            return c >= '0' && c <= '9';
+        }
+
+        inline bool isSpace(char c) {
+            return c == ' ' || c == '\t';
+        }
+
+        std::string_view trim(std::string_view value) {
+            size_t begin = 0;
+            size_t end = value.size();
+            while (begin < end && isSpace(value[begin])) {
+                begin++;
+            }
+            while (end > begin && isSpace(value[end - 1])) {
+                end--;
+            }
+            return value.substr(begin, end - begin);
+        }
+
+        /**
+         * Parse mm:ss, mm:ss.x - mm:ss.xxx or mm:ss:xx.
+         */
+        bool parseStamp(std::string_view value, int64_t &ms) {
+            value = trim(value);
+            const size_t n = value.size();
+            size_t i = 0;
+            int64_t minutes = 0;
+            for (; i < n && isDigit(value[i]); i++) {
+                if (i >= 4) {
+                    return false;
+                }
+                minutes = minutes * 10 + (value[i] - '0');
+            }
+            if (i == 0 || i >= n || value[i] != ':') {
+                return false;
+            }
+            size_t secondsStart = ++i;
+            int64_t seconds = 0;
+            for (; i < n && isDigit(value[i]); i++) {
+                if (i - secondsStart >= 2) {
+                    return false;
+                }
+                seconds = seconds * 10 + (value[i] - '0');
+            }
+            if (i == secondsStart) {
+                return false;
+            }
+            int64_t fraction = 0;
+            if (i < n && (value[i] == '.' || value[i] == ':')) {
+                size_t fractionStart = ++i;
+                int64_t scale = 100;
+                for (; i < n && isDigit(value[i]); i++) {
+                    // digits past milliseconds are dropped
+                    fraction += (value[i] - '0') * scale;
+                    scale /= 10;
+                }
+                if (i == fractionStart) {
+                    return false;
+                }
+            }
+            if (i != n) {
+                return false;
+            }
+            ms = minutes * 60000 + seconds * 1000 + fraction;
+            return true;
+        }
+
+        bool parseOffset(std::string_view value, int64_t &offset) {
+            value = trim(value);
+            bool negative = false;
+            if (!value.empty() && (value[0] == '+' || value[0] == '-')) {
+                negative = value[0] == '-';
+                value.remove_prefix(1);
+            }
+            if (value.empty() || value.size() > 9) {
+                return false;
+            }
+            int64_t result = 0;
+            for (char c: value) {
+                if (!isDigit(c)) {
+                    return false;
+                }
+                result = result * 10 + (c - '0');
+            }
+            offset = negative ? -result : result;
+            return true;
+        }
+
+        bool isTagId(std::string_view id) {
+            if (id.empty()) {
+                return false;
+            }
+            return std::all_of(id.begin(), id.end(), [](char c) {
+                return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '#';
+            });
+        }
+
+        bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+            if (a.size() != b.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < a.size(); i++) {
+                char x = a[i] >= 'A' && a[i] <= 'Z' ? (char) (a[i] + 32) : a[i];
+                if (x != b[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    LyricTimeline LyricTimeline::parse(std::string_view lrc) {
+        LyricTimeline timeline;
+        if (lrc.substr(0, 3) == "\xEF\xBB\xBF") {
+            lrc.remove_prefix(3);
+        }
+        timeline.text.reserve(lrc.size());
+
+        std::vector<int64_t> stamps;
+        size_t position = 0;
+        while (position < lrc.size()) {
+            size_t end = position;
+            while (end < lrc.size() && lrc[end] != '\n' && lrc[end] != '\r') {
+                end++;
+            }
+            timeline.parseLine(lrc.substr(position, end - position), stamps);
+            position = end + 1;
+            if (end < lrc.size() && lrc[end] == '\r' &&
+                position < lrc.size() && lrc[position] == '\n') {
+                position++;
+            }
+        }
+
+        if (timeline.offsetMs != 0) {
+            // a positive offset shows the lyrics sooner
+            auto shift = [&timeline](int64_t timestamp) {
+                return std::max<int64_t>(0, timestamp - timeline.offsetMs);
+            };
+            for (LyricLine &line: timeline.lineList) {
+                if (line.timestamp != kUntimed) {
+                    line.timestamp = shift(line.timestamp);
+                }
+            }
+            for (LyricWord &word: timeline.wordList) {
+                word.timestamp = shift(word.timestamp);
+            }
+        }
+        timeline.finish();
+        return timeline;
+    }
+
+    void LyricTimeline::parseLine(std::string_view line, std::vector<int64_t> &stamps) {
+        stamps.clear();
+        size_t i = 0;
+        while (i < line.size() && isSpace(line[i])) {
+            i++;
+        }
+        while (i < line.size() && line[i] == '[') {
+            size_t close = line.find(']', i + 1);
+            if (close == std::string_view::npos) {
+                break;
+            }
+            std::string_view inner = line.substr(i + 1, close - i - 1);
+            int64_t stamp;
+            if (parseStamp(inner, stamp)) {
+                stamps.push_back(stamp);
+                i = close + 1;
+                continue;
+            }
+            size_t colon = inner.find(':');
+            if (stamps.empty() && colon != std::string_view::npos &&
+                isTagId(trim(inner.substr(0, colon)))) {
+                std::string_view id = trim(inner.substr(0, colon));
+                std::string_view value = trim(inner.substr(colon + 1));
+                if (equalsIgnoreCase(id, "offset")) {
+                    parseOffset(value, offsetMs);
+                } else {
+                    tagList.emplace_back(std::string(id), std::string(value));
+                }
+                return;
+            }
+            break;
+        }
+
+        if (stamps.empty()) {
+            std::string_view content = trim(line);
+            if (!content.empty()) {
+                uint32_t start = append(content);
+                lineList.push_back({kUntimed, start, (uint32_t) content.size(),
+                                    (uint32_t) wordList.size(), 0});
+            }
+            return;
+        }
+
+        std::string_view rest = line.substr(i);
+        const auto lineStart = (uint32_t) text.size();
+        const auto firstWord = (uint32_t) wordList.size();
+        size_t j = 0;
+        while (j < rest.size()) {
+            size_t marker = rest.find('<', j);
+            if (marker == std::string_view::npos) {
+                marker = rest.size();
+            }
+            std::string_view segment = rest.substr(j, marker - j);
+            bool leading = wordList.size() == firstWord;
+            // spacing between the line stamps and the first word
+            if (!(leading && trim(segment).empty() && marker < rest.size())) {
+                if (text.size() == lineStart) {
+                    size_t skip = 0;
+                    while (skip < segment.size() && isSpace(segment[skip])) {
+                        skip++;
+                    }
+                    segment.remove_prefix(skip);
+                }
+                append(segment);
+            }
+            if (marker == rest.size()) {
+                break;
+            }
+            size_t close = rest.find('>', marker + 1);
+            int64_t stamp;
+            if (close != std::string_view::npos &&
+                parseStamp(rest.substr(marker + 1, close - marker - 1), stamp)) {
+                wordList.push_back({stamp, (uint32_t) text.size(), 0});
+                j = close + 1;
+            } else {
+                append("<");
+                j = marker + 1;
+            }
+        }
+
+        auto lineEnd = (uint32_t) text.size();
+        while (lineEnd > lineStart && isSpace(text[lineEnd - 1])) {
+            lineEnd--;
+        }
+        text.resize(lineEnd);
+        const auto wordCount = (uint32_t) (wordList.size() - firstWord);
+        for (uint32_t w = firstWord; w < wordList.size(); w++) {
+            uint32_t end = w + 1 < wordList.size() ? wordList[w + 1].start : lineEnd;
+            LyricWord &word = wordList[w];
+            word.start = std::min(word.start, lineEnd);
+            word.length = std::max(std::min(end, lineEnd), word.start) - word.start;
+        }
+        for (int64_t stamp: stamps) {
+            lineList.push_back({stamp, lineStart, lineEnd - lineStart, firstWord, wordCount});
+        }
+    }
+
+    uint32_t LyricTimeline::append(std::string_view value) {
+        auto start = (uint32_t) text.size();
+        text.append(value.data(), value.size());
+        return start;
+    }
+
+    void LyricTimeline::add(int64_t timestamp, std::string_view value) {
+        uint32_t start = append(value);
+        lineList.push_back({timestamp, start, (uint32_t) value.size(),
+                            (uint32_t) wordList.size(), 0});
+    }
+
+    void LyricTimeline::addWord(int64_t timestamp, std::string_view value) {
+        if (lineList.empty()) {
+            add(timestamp, {});
+        }
+        LyricLine &line = lineList.back();
+        uint32_t start = append(value);
+        wordList.push_back({timestamp, start, (uint32_t) value.size()});
+        line.length = (uint32_t) text.size() - line.start;
+        line.wordCount++;
+    }
+
+    void LyricTimeline::finish() {
+        std::stable_sort(lineList.begin(), lineList.end(),
+                         [](const LyricLine &a, const LyricLine &b) {
+                             return a.timestamp < b.timestamp;
+                         });
+    }
+
+    int32_t LyricTimeline::findLine(int64_t position) const {
+        auto it = std::upper_bound(lineList.begin(), lineList.end(), position,
+                                   [](int64_t p, const LyricLine &line) {
+                                       return p < line.timestamp;
+                                   });
+        if (it == lineList.begin()) {
+            return -1;
+        }
+        --it;
+        return it->timestamp == kUntimed ? -1 : (int32_t) (it - lineList.begin());
+    }
+
+    int32_t LyricTimeline::findWord(int32_t line, int64_t position) const {
+        if (line < 0 || (size_t) line >= lineList.size()) {
+            return -1;
+        }
+        const LyricLine &l = lineList[line];
+        auto begin = wordList.begin() + l.firstWord;
+        auto end = begin + l.wordCount;
+        auto it = std::upper_bound(begin, end, position,
+                                   [](int64_t p, const LyricWord &word) {
+                                       return p < word.timestamp;
+                                   });
+        if (it == begin) {
+            return -1;
+        }
+        return (int32_t) (it - 1 - wordList.begin());
+    }
+
+    const std::vector<LyricLine> &LyricTimeline::lines() const {
+        return lineList;
+    }
+
+    const std::vector<LyricWord> &LyricTimeline::words() const {
+        return wordList;
+    }
+
+    const std::vector<std::pair<std::string, std::string>> &LyricTimeline::tags() const {
+        return tagList;
+    }
+
+    std::string_view LyricTimeline::textOf(const LyricLine &line) const {
+        return std::string_view(text).substr(line.start, line.length);
+    }
+
+    std::string_view LyricTimeline::textOf(const LyricWord &word) const {
+        return std::string_view(text).substr(word.start, word.length);
+    }
+
+    std::string_view LyricTimeline::textOf(uint32_t start, uint32_t length) const {
+        return std::string_view(text).substr(start, length);
+    }
+
+    int64_t LyricTimeline::offset() const {
+        return offsetMs;
+    }
+
+    bool LyricTimeline::empty() const {
+        return lineList.empty();
+    }
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOUNDSOURCE_LYRIC_H
+#define SOUNDSOURCE_LYRIC_H
+
+#include <sys/types.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace SoundSource {
+    /**
+     * A timed word of an enhanced LRC line. The text runs from start
+     * to the start of the next word of the line, a word without text
+     * marks the end of the previous one.
+     */
+    struct LyricWord {
+        int64_t timestamp;
+        // byte range in the text of the timeline
+        uint32_t start;
+        uint32_t length;
+    };
+
+    struct LyricLine {
+        /**
+         * Milliseconds, kUntimed for lines without a timestamp.
+         */
+        int64_t timestamp;
+        uint32_t start;
+        uint32_t length;
+        // lines repeated at several timestamps share their words
+        uint32_t firstWord;
+        uint32_t wordCount;
+    };
+
+    /**
+     * Flat, sorted timeline of timed lyrics: all text in one buffer,
+     * lines and words as ranges of it, so a position is looked up by
+     * binary search.
+     *
+     * Lines of the same timestamp (such as translations) keep their
+     * order in the source. Untimed lines sort first.
+     */
+    class LyricTimeline {
+    public:
+        static constexpr int64_t kUntimed = -1;
+
+        /**
+         * Parse LRC in a single pass, without copies of the lines.
+         *
+         * Supports several timestamps per line, mm:ss, mm:ss.x to
+         * mm:ss.xxx and mm:ss:xx stamps, ID tags such as [ti:] and
+         * [offset:], and enhanced LRC <mm:ss.xx> word timings. The
+         * offset is applied to every timestamp. Lines that are not LRC
+         * are kept as untimed lines, so plain lyrics parse too.
+         *
+         * @param lrc UTF-8 text.
+         */
+        static LyricTimeline parse(std::string_view lrc);
+
+        /**
+         * Add a line of known timestamp, call finish() after the last.
+         */
+        void add(int64_t timestamp, std::string_view text);
+
+        /**
+         * Append a timed word to the line added last, extending its text.
+         */
+        void addWord(int64_t timestamp, std::string_view text);
+
+        /**
+         * Sort the lines added by add().
+         */
+        void finish();
+
+        /**
+         * @return the index of the line shown at position, the last
+         * line starting at or before it; -1 if none has started.
+         */
+        int32_t findLine(int64_t position) const;
+
+        /**
+         * @return the index into words() of the word of the line sung at
+         * position, -1 if the line has no words or none has started.
+         */
+        int32_t findWord(int32_t line, int64_t position) const;
+
+        const std::vector<LyricLine> &lines() const;
+
+        const std::vector<LyricWord> &words() const;
+
+        /**
+         * ID tags in source order, without the offset.
+         */
+        const std::vector<std::pair<std::string, std::string>> &tags() const;
+
+        std::string_view textOf(const LyricLine &line) const;
+
+        std::string_view textOf(const LyricWord &word) const;
+
+        std::string_view textOf(uint32_t start, uint32_t length) const;
+
+        /**
+         * The [offset:] of the source in milliseconds, already applied.
+         */
+        int64_t offset() const;
+
+        bool empty() const;
+
+    private:
+        std::string text;
+        std::vector<LyricLine> lineList;
+        std::vector<LyricWord> wordList;
+        std::vector<std::pair<std::string, std::string>> tagList;
+        int64_t offsetMs = 0;
+
+        void parseLine(std::string_view line, std::vector<int64_t> &stamps);
+
+        uint32_t append(std::string_view value);
+    };
+}
+
+#endif //SOUNDSOURCE_LYRIC_H
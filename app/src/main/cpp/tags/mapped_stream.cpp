@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "mapped_stream.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+
+namespace SoundSource {
+    MappedFileStream::MappedFileStream(int32_t fileDescriptor, bool map)
+            : fileDescriptor(fileDescriptor) {
+        struct stat st{};
+        if (fileDescriptor < 0 || fstat(fileDescriptor, &st) != 0) {
+            return;
+        }
+        fileSize = st.st_size;
+        if (!map || fileSize <= 0) {
+            return;
+        }
+        // a writer holding this descriptor could truncate the mapping
+        int flags = fcntl(fileDescriptor, F_GETFL);
+        if (flags < 0 || (flags & O_ACCMODE) != O_RDONLY) {
+            return;
+        }
+        void *address = mmap(nullptr, (size_t) fileSize, PROT_READ, MAP_SHARED,
+                             fileDescriptor, 0);
+        if (address == MAP_FAILED) {
+            // pipes and some providers' descriptors cannot be mapped
+            return;
+        }
+        // tags sit at both ends, do not read ahead through the audio
+        madvise(address, (size_t) fileSize, MADV_RANDOM);
+        mapping = (const uint8_t *) address;
+    }
+
+    MappedFileStream::~MappedFileStream() {
+        unmap();
+        if (fileDescriptor >= 0) {
+            ::close(fileDescriptor);
+        }
+    }
+
+    TagLib::FileName MappedFileStream::name() const {
+        return "";
+    }
+
+    TagLib::ByteVector MappedFileStream::readBlock(size_t length) {
+        if (fileSize < 0 || position >= fileSize) {
+            return {};
+        }
+        auto count = (size_t) std::min<int64_t>((int64_t) length, fileSize - position);
+        if (mapping != nullptr && mappingValid()) {
+            TagLib::ByteVector block((const char *) mapping + position, (unsigned int) count);
+            position += (int64_t) count;
+            bytes += (int64_t) count;
+            return block;
+        }
+
+        TagLib::ByteVector block((unsigned int) count, 0);
+        auto *out = (uint8_t *) block.data();
+        size_t copied = 0;
+        while (copied < count) {
+            size_t n;
+            if (count - copied >= kWindowSize) {
+                // large blocks (pictures) skip the windows
+                ssize_t result = pread(fileDescriptor, out + copied, count - copied,
+                                       position + (int64_t) copied);
+                reads++;
+                n = result > 0 ? (size_t) result : 0;
+            } else {
+                n = copyWindowed(position + (int64_t) copied, out + copied, count - copied);
+            }
+            if (n == 0) {
+                break;
+            }
+            copied += n;
+        }
+        if (copied < count) {
+            block.resize((unsigned int) copied);
+        }
+        position += (int64_t) copied;
+        bytes += (int64_t) copied;
+        return block;
+    }
+
+    size_t MappedFileStream::copyWindowed(int64_t offset, uint8_t *out, size_t length) {
+        Window *window = nullptr;
+        for (Window &w: windows) {
+            if (offset >= w.offset && offset < w.offset + (int64_t) w.size) {
+                window = &w;
+                break;
+            }
+        }
+        if (window == nullptr) {
+            window = windows[0].lastUse <= windows[1].lastUse ? &windows[0] : &windows[1];
+            window->data.resize(kWindowSize);
+            // keep a little before the offset, parsers step back to
+            // re-read headers
+            int64_t start = std::max<int64_t>(0, offset - (int64_t) kWindowSize / 16);
+            ssize_t result = pread(fileDescriptor, window->data.data(), kWindowSize, start);
+            reads++;
+            window->offset = start;
+            window->size = result > 0 ? (size_t) result : 0;
+            if (offset >= window->offset + (int64_t) window->size) {
+                return 0;
+            }
+        }
+        window->lastUse = ++useCount;
+        auto index = (size_t) (offset - window->offset);
+        size_t n = std::min(length, window->size - index);
+        std::memcpy(out, window->data.data() + index, n);
+        return n;
+    }
+
+    bool MappedFileStream::mappingValid() {
+        struct stat st{};
+        reads++;
+        bool known = fstat(fileDescriptor, &st) == 0;
+        if (known && st.st_size >= fileSize) {
+            return true;
+        }
+        // pages past the new end would fault, read what is left instead
+        unmap();
+        if (known) {
+            fileSize = st.st_size;
+        }
+        return false;
+    }
+
+    void MappedFileStream::unmap() {
+        if (mapping != nullptr) {
+            munmap((void *) mapping, (size_t) fileSize);
+            mapping = nullptr;
+        }
+    }
+
+    void MappedFileStream::writeBlock(const TagLib::ByteVector &data) {
+    }
+
+    void MappedFileStream::insert(const TagLib::ByteVector &data,
+                                  TagLib::offset_t start, size_t replace) {
+    }
+
+    void MappedFileStream::removeBlock(TagLib::offset_t start, size_t length) {
+    }
+
+    bool MappedFileStream::readOnly() const {
+        return true;
+    }
+
+    bool MappedFileStream::isOpen() const {
+        return fileSize >= 0;
+    }
+
+    void MappedFileStream::seek(TagLib::offset_t offset, Position p) {
+        switch (p) {
+            case Beginning:
+                position = offset;
+                break;
+            case Current:
+                position += offset;
+                break;
+            case End:
+                position = fileSize + offset;
+                break;
+        }
+        position = std::max<int64_t>(position, 0);
+    }
+
+    TagLib::offset_t MappedFileStream::tell() const {
+        return position;
+    }
+
+    TagLib::offset_t MappedFileStream::length() {
+        return std::max<int64_t>(fileSize, 0);
+    }
+
+    void MappedFileStream::truncate(TagLib::offset_t length) {
+    }
+
+    bool MappedFileStream::isMapped() const {
+        return mapping != nullptr;
+    }
+
+    int64_t MappedFileStream::readCalls() const {
+        return reads;
+    }
+
+    int64_t MappedFileStream::bytesRead() const {
+        return bytes;
+    }
+}
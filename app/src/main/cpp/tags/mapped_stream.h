@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_MAPPED_STREAM_H
+#define SOUNDSOURCE_MAPPED_STREAM_H
+
+#include <sys/types.h>
+#include <cstdint>
+#include <vector>
+
+#include <taglib/taglib/toolkit/tiostream.h>
+
+namespace SoundSource {
+    /**
+     * Read-only TagLib stream that reads the file through two pread()
+     * windows of kWindowSize, one usually staying on the head of the
+     * file and the other on its tail, where ID3v1 and APE tags live, so
+     * walking ID3v2 frames, MP4 atoms or Ogg pages costs a few syscalls
+     * instead of one per field.
+     *
+     * The file can instead be mapped, which saves the copies into the
+     * windows. A mapped file that is truncated under the reader raises
+     * SIGBUS and kills the process, so mapping is opt-in and refused for
+     * descriptors open for writing, and the size is checked with fstat()
+     * before every read, falling back to the windows once the file
+     * shrank. That narrows the race but cannot close it: only map files
+     * nothing else writes, never user media that a download or a tag
+     * writer may be rewriting.
+     *
+     * Like TagLib's FileStream the descriptor is owned and closed with
+     * the stream. Writes are ignored.
+     */
+    class MappedFileStream : public TagLib::IOStream {
+    public:
+        static constexpr size_t kWindowSize = 128 * 1024;
+
+        /**
+         * @param map map the file instead of reading it through the
+         * windows, if it is open read-only and can be mapped.
+         */
+        explicit MappedFileStream(int32_t fileDescriptor, bool map = false);
+
+        ~MappedFileStream() override;
+
+        TagLib::FileName name() const override;
+
+        TagLib::ByteVector readBlock(size_t length) override;
+
+        void writeBlock(const TagLib::ByteVector &data) override;
+
+        void insert(const TagLib::ByteVector &data,
+                    TagLib::offset_t start = 0, size_t replace = 0) override;
+
+        void removeBlock(TagLib::offset_t start = 0, size_t length = 0) override;
+
+        bool readOnly() const override;
+
+        bool isOpen() const override;
+
+        void seek(TagLib::offset_t offset, Position p = Beginning) override;
+
+        TagLib::offset_t tell() const override;
+
+        TagLib::offset_t length() override;
+
+        void truncate(TagLib::offset_t length) override;
+
+        bool isMapped() const;
+
+        /**
+         * @return the syscalls issued by reads: pread() into the windows,
+         * or the fstat() guarding a mapping.
+         */
+        int64_t readCalls() const;
+
+        /**
+         * @return bytes handed out by readBlock().
+         */
+        int64_t bytesRead() const;
+
+    private:
+        struct Window {
+            std::vector<uint8_t> data;
+            int64_t offset = 0;
+            size_t size = 0;
+            uint64_t lastUse = 0;
+        };
+
+        int32_t fileDescriptor;
+        int64_t fileSize = -1;
+        const uint8_t *mapping = nullptr;
+        int64_t position = 0;
+
+        Window windows[2];
+        uint64_t useCount = 0;
+        int64_t reads = 0;
+        int64_t bytes = 0;
+
+        /**
+         * Copy up to length bytes at offset out of the windows, loading
+         * the least recently used one if needed.
+         *
+         * @return the bytes copied, 0 at the end of file or on error.
+         */
+        size_t copyWindowed(int64_t offset, uint8_t *out, size_t length);
+
+        /**
+         * Check the mapping still covers the file, unmap it otherwise.
+         */
+        bool mappingValid();
+
+        void unmap();
+    };
+}
+
+#endif //SOUNDSOURCE_MAPPED_STREAM_H
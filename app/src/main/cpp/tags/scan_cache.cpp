@@ -0,0 +1,419 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scan_cache.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+
+namespace SoundSource {
+    namespace {
+        constexpr uint32_t kVersion = 1;
+        // keeps a damaged header from asking for absurd sizes
+        constexpr uint32_t kMaxCount = 1u << 26;
+
+        struct Header {
+            char magic[4];
+            uint32_t version;
+            uint32_t entries;
+            uint32_t fields;
+            uint32_t strings;
+            uint32_t stringBytes;
+            uint64_t reserved;
+        };
+
+        static_assert(sizeof(Header) == 32, "header layout");
+        static_assert(sizeof(ScanCacheEntry) == 56, "entry layout");
+
+        inline int64_t lastModifiedOf(const struct stat &st) {
+            return (int64_t) st.st_mtim.tv_sec * 1000 + st.st_mtim.tv_nsec / 1000000;
+        }
+
+        bool writeFully(int fd, const void *data, size_t size) {
+            auto p = (const uint8_t *) data;
+            while (size > 0) {
+                ssize_t n = ::write(fd, p, size);
+                if (n < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                p += n;
+                size -= (size_t) n;
+            }
+            return true;
+        }
+    }
+
+    ScanCache::ScanCache(const std::string &path, const std::vector<std::string> &fieldKeys) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st{};
+        if (fstat(fd, &st) == 0 && st.st_size >= (off_t) sizeof(Header)) {
+            void *address = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED) {
+                mapping = address;
+                mappingSize = (size_t) st.st_size;
+            }
+        }
+        ::close(fd);
+        if (mapping != nullptr && !load(fieldKeys)) {
+            unmap();
+        }
+    }
+
+    ScanCache::~ScanCache() {
+        unmap();
+    }
+
+    bool ScanCache::load(const std::vector<std::string> &fieldKeys) {
+        Header header{};
+        std::memcpy(&header, mapping, sizeof(header));
+        if (std::memcmp(header.magic, "SSSC", 4) != 0 || header.version != kVersion ||
+            header.entries > kMaxCount || header.strings > kMaxCount ||
+            header.fields != fieldKeys.size() || header.fields > 64) {
+            return false;
+        }
+        uint64_t entriesOffset = sizeof(Header);
+        uint64_t valuesOffset = entriesOffset + (uint64_t) header.entries * sizeof(ScanCacheEntry);
+        uint64_t keysOffset = valuesOffset + (uint64_t) header.entries * header.fields * 4;
+        uint64_t offsetsOffset = keysOffset + (uint64_t) header.fields * 4;
+        uint64_t bytesOffset = offsetsOffset + ((uint64_t) header.strings + 1) * 4;
+        if (bytesOffset + header.stringBytes != mappingSize) {
+            return false;
+        }
+        auto base = (const uint8_t *) mapping;
+        entries = (const ScanCacheEntry *) (base + entriesOffset);
+        entryCount = header.entries;
+        values = (const uint32_t *) (base + valuesOffset);
+        fields = header.fields;
+        offsets = (const uint32_t *) (base + offsetsOffset);
+        stringCount = header.strings;
+        bytes = (const char *) (base + bytesOffset);
+        if (offsets[stringCount] != header.stringBytes) {
+            return false;
+        }
+
+        auto keys = (const uint32_t *) (base + keysOffset);
+        for (size_t i = 0; i < fields; i++) {
+            const char *key = string(keys[i]);
+            if (key == nullptr || fieldKeys[i] != key) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void ScanCache::unmap() {
+        if (mapping != nullptr) {
+            munmap(mapping, mappingSize);
+        }
+        mapping = nullptr;
+        mappingSize = 0;
+        entries = nullptr;
+        entryCount = 0;
+        values = nullptr;
+        fields = 0;
+        offsets = nullptr;
+        stringCount = 0;
+        bytes = nullptr;
+    }
+
+    size_t ScanCache::size() const {
+        return entryCount;
+    }
+
+    uint64_t ScanCache::hashOf(std::string_view identifier) {
+        // FNV-1a
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (char c: identifier) {
+            hash ^= (uint8_t) c;
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    int32_t ScanCache::find(std::string_view identifier) const {
+        const uint64_t hash = hashOf(identifier);
+        const ScanCacheEntry *end = entries + entryCount;
+        const ScanCacheEntry *it = std::lower_bound(
+                entries, end, hash,
+                [](const ScanCacheEntry &entry, uint64_t h) { return entry.hash < h; });
+        for (; it != end && it->hash == hash; it++) {
+            const char *name = string(it->identifier);
+            if (name != nullptr && identifier == std::string_view(name, stringLength(it->identifier))) {
+                return (int32_t) (it - entries);
+            }
+        }
+        return -1;
+    }
+
+    size_t ScanCache::validate(const std::string_view *identifiers, const int32_t *fileDescriptors,
+                               size_t count, int64_t *lastModified) const {
+        size_t unchanged = 0;
+        for (size_t i = 0; i < count; i++) {
+            lastModified[i] = -1;
+            int32_t index = find(identifiers[i]);
+            struct stat st{};
+            if (index < 0 || fstat(fileDescriptors[i], &st) != 0) {
+                continue;
+            }
+            const ScanCacheEntry &cached = entries[index];
+            int64_t modified = lastModifiedOf(st);
+            if (cached.size == (int64_t) st.st_size && cached.lastModified == modified) {
+                lastModified[i] = modified;
+                unchanged++;
+            }
+        }
+        return unchanged;
+    }
+
+    size_t ScanCache::validate(const std::string_view *identifiers, const int64_t *sizes,
+                               const int64_t *modified, size_t count,
+                               int64_t *lastModified) const {
+        size_t unchanged = 0;
+        for (size_t i = 0; i < count; i++) {
+            lastModified[i] = -1;
+            int32_t index = find(identifiers[i]);
+            if (index < 0) {
+                continue;
+            }
+            const ScanCacheEntry &cached = entries[index];
+            if (cached.size == sizes[i] && cached.lastModified == modified[i]) {
+                lastModified[i] = modified[i];
+                unchanged++;
+            }
+        }
+        return unchanged;
+    }
+
+    const ScanCacheEntry &ScanCache::entry(int32_t index) const {
+        return entries[index];
+    }
+
+    std::string_view ScanCache::identifier(int32_t index) const {
+        uint32_t id = entries[index].identifier;
+        const char *name = string(id);
+        return name == nullptr ? std::string_view() : std::string_view(name, stringLength(id));
+    }
+
+    size_t ScanCache::fieldCount() const {
+        return fields;
+    }
+
+    const char *ScanCache::value(int32_t index, size_t field) const {
+        if (field >= fields) {
+            return nullptr;
+        }
+        return string(values[(size_t) index * fields + field]);
+    }
+
+    const char *ScanCache::string(uint32_t id) const {
+        // checked on use, so opening a large cache touches no more
+        // than its header
+        if (id >= stringCount) {
+            return nullptr;
+        }
+        uint32_t start = offsets[id];
+        uint32_t end = offsets[id + 1];
+        if (start >= end || end > offsets[stringCount] || bytes[end - 1] != '\0') {
+            return nullptr;
+        }
+        return bytes + start;
+    }
+
+    uint32_t ScanCache::stringLength(uint32_t id) const {
+        return offsets[id + 1] - offsets[id] - 1;
+    }
+
+    ScanCacheWriter::ScanCacheWriter(std::vector<std::string> fieldKeys, StringTable &strings)
+            : fieldKeys(std::move(fieldKeys)), strings(strings) {
+    }
+
+    size_t ScanCacheWriter::entryFor(std::string_view identifier) {
+        uint32_t id = strings.intern(identifier);
+        auto it = entryOfIdentifier.find(id);
+        if (it != entryOfIdentifier.end()) {
+            return it->second;
+        }
+        size_t index = entries.size();
+        ScanCacheEntry entry{};
+        entry.hash = ScanCache::hashOf(identifier);
+        entry.identifier = id;
+        entries.push_back(entry);
+        values.resize(values.size() + fieldKeys.size(), ScanCache::kNoString);
+        entryOfIdentifier.emplace(id, index);
+        return index;
+    }
+
+    void ScanCacheWriter::put(std::string_view identifier, int64_t size, int64_t lastModified,
+                              const ScanCacheProperties &properties, const uint32_t *fieldValues) {
+        std::lock_guard<std::mutex> guard(lock);
+        size_t index = entryFor(identifier);
+        ScanCacheEntry &entry = entries[index];
+        entry.size = size;
+        entry.lastModified = lastModified;
+        entry.channels = properties.channels;
+        entry.bitRate = properties.bitRate;
+        entry.bitDepth = properties.bitDepth;
+        entry.sampleRate = properties.sampleRate;
+        entry.durationMs = properties.durationMs;
+        std::copy(fieldValues, fieldValues + fieldKeys.size(),
+                  values.data() + index * fieldKeys.size());
+    }
+
+    bool ScanCacheWriter::keep(const ScanCache &cache, std::string_view identifier) {
+        int32_t cached = cache.find(identifier);
+        if (cached < 0 || cache.fieldCount() != fieldKeys.size()) {
+            return false;
+        }
+        std::vector<uint32_t> ids(fieldKeys.size());
+        for (size_t i = 0; i < fieldKeys.size(); i++) {
+            const char *value = cache.value(cached, i);
+            ids[i] = value == nullptr ? StringTable::kNoString : strings.intern(value);
+        }
+        const ScanCacheEntry &source = cache.entry(cached);
+        ScanCacheProperties properties;
+        properties.channels = source.channels;
+        properties.bitRate = source.bitRate;
+        properties.bitDepth = source.bitDepth;
+        properties.sampleRate = source.sampleRate;
+        properties.durationMs = source.durationMs;
+        put(identifier, source.size, source.lastModified, properties, ids.data());
+        return true;
+    }
+
+    size_t ScanCacheWriter::size() const {
+        std::lock_guard<std::mutex> guard(lock);
+        return entries.size();
+    }
+
+    const std::vector<std::string> &ScanCacheWriter::keys() const {
+        return fieldKeys;
+    }
+
+    bool ScanCacheWriter::write(const std::string &path) const {
+        std::lock_guard<std::mutex> guard(lock);
+        const size_t fieldCount = fieldKeys.size();
+
+        // the table may hold strings of other files, renumber the
+        // used ones from 0
+        std::unordered_map<uint32_t, uint32_t> renumbered;
+        std::vector<std::string_view> pool;
+        auto idOf = [&](uint32_t id) {
+            if (id == StringTable::kNoString) {
+                return ScanCache::kNoString;
+            }
+            auto [it, inserted] = renumbered.try_emplace(id, (uint32_t) pool.size());
+            if (inserted) {
+                pool.emplace_back(strings.get(id));
+            }
+            return it->second;
+        };
+
+        std::vector<std::string_view> names;
+        names.reserve(entries.size());
+        for (const ScanCacheEntry &entry: entries) {
+            names.emplace_back(strings.get(entry.identifier));
+        }
+        std::vector<size_t> order(entries.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [this, &names](size_t a, size_t b) {
+            if (entries[a].hash != entries[b].hash) {
+                return entries[a].hash < entries[b].hash;
+            }
+            return names[a] < names[b];
+        });
+
+        std::vector<ScanCacheEntry> sortedEntries;
+        sortedEntries.reserve(entries.size());
+        std::vector<uint32_t> sortedValues;
+        sortedValues.reserve(values.size());
+        for (size_t index: order) {
+            ScanCacheEntry entry = entries[index];
+            entry.identifier = idOf(entry.identifier);
+            sortedEntries.push_back(entry);
+            const uint32_t *entryValues = values.data() + index * fieldCount;
+            for (size_t i = 0; i < fieldCount; i++) {
+                sortedValues.push_back(idOf(entryValues[i]));
+            }
+        }
+        std::vector<uint32_t> keyIds;
+        for (const std::string &key: fieldKeys) {
+            keyIds.push_back(idOf(strings.intern(key)));
+        }
+
+        std::vector<uint32_t> offsets;
+        offsets.reserve(pool.size() + 1);
+        uint64_t stringBytes = 0;
+        for (std::string_view s: pool) {
+            offsets.push_back((uint32_t) stringBytes);
+            stringBytes += s.size() + 1;
+        }
+        if (stringBytes > UINT32_MAX) {
+            return false;
+        }
+        offsets.push_back((uint32_t) stringBytes);
+
+        Header header{};
+        std::memcpy(header.magic, "SSSC", 4);
+        header.version = kVersion;
+        header.entries = (uint32_t) entries.size();
+        header.fields = (uint32_t) fieldCount;
+        header.strings = (uint32_t) pool.size();
+        header.stringBytes = (uint32_t) stringBytes;
+
+        std::vector<uint8_t> out;
+        out.reserve(sizeof(Header) + entries.size() * (sizeof(ScanCacheEntry) + fieldCount * 4) +
+                    fieldCount * 4 + offsets.size() * 4 + (size_t) stringBytes);
+        auto append = [&out](const void *data, size_t size) {
+            auto p = (const uint8_t *) data;
+            out.insert(out.end(), p, p + size);
+        };
+        append(&header, sizeof(header));
+        append(sortedEntries.data(), sortedEntries.size() * sizeof(ScanCacheEntry));
+        append(sortedValues.data(), sortedValues.size() * 4);
+        append(keyIds.data(), keyIds.size() * 4);
+        append(offsets.data(), offsets.size() * 4);
+        for (std::string_view s: pool) {
+            append(s.data(), s.size());
+            out.push_back(0);
+        }
+
+        std::string temp = path + ".tmp";
+        int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (fd < 0) {
+            return false;
+        }
+        bool written = writeFully(fd, out.data(), out.size());
+        written = ::close(fd) == 0 && written;
+        if (!written || rename(temp.c_str(), path.c_str()) != 0) {
+            unlink(temp.c_str());
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOUNDSOURCE_SCAN_CACHE_H
+#define SOUNDSOURCE_SCAN_CACHE_H
+
+#include <sys/types.h>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "string_table.h"
+
+namespace SoundSource {
+    /**
+     * Audio properties of a cached file, as read by TagLib.
+     */
+    struct ScanCacheProperties {
+        int32_t channels = 0;
+        int32_t bitRate = 0;
+        int32_t bitDepth = -1;
+        int32_t sampleRate = 0;
+        int64_t durationMs = 0;
+    };
+
+    /**
+     * An entry of the cache file, valid while size and lastModified
+     * match the file.
+     */
+    struct ScanCacheEntry {
+        uint64_t hash;
+        // string id of the identifier
+        uint32_t identifier;
+        int32_t channels;
+        int64_t size;
+        int64_t lastModified;
+        int64_t durationMs;
+        int32_t bitRate;
+        int32_t bitDepth;
+        int32_t sampleRate;
+        uint32_t reserved;
+    };
+
+    /**
+     * Read-only view of the tags and audio properties of the files seen
+     * by the last scan, so a rescan only parses files that changed.
+     *
+     * The file is mapped and used in place:
+     *
+     * <pre>
+     * header     "SSSC" | version u32 | entries u32 | fields u32 | strings u32 | string bytes u32 | reserved u64
+     * entries    entries * ScanCacheEntry, sorted by identifier hash
+     * values     entries * fields * u32 string id, kNoString if the tag has no such field
+     * keys       fields * u32 string id of the field names
+     * offsets    (strings + 1) * u32 offsets into the string bytes
+     * bytes      NUL terminated UTF-8 strings
+     * </pre>
+     *
+     * Every string (artist, album, genre...) is stored once however many
+     * files share it. Integers are in native byte order, which is little
+     * endian on every Android ABI; a file written elsewhere is rejected
+     * like a damaged one.
+     */
+    class ScanCache {
+    public:
+        static constexpr uint32_t kNoString = UINT32_MAX;
+
+        /**
+         * Map the cache at path. A missing or damaged file, or one written
+         * for other fields, gives an empty cache.
+         *
+         * @param fieldKeys the tag field names of the values, in order.
+         */
+        ScanCache(const std::string &path, const std::vector<std::string> &fieldKeys);
+
+        ~ScanCache();
+
+        ScanCache(const ScanCache &) = delete;
+
+        ScanCache &operator=(const ScanCache &) = delete;
+
+        size_t size() const;
+
+        /**
+         * @return the index of the entry, -1 if not cached.
+         */
+        int32_t find(std::string_view identifier) const;
+
+        /**
+         * Check count files against their entries with one fstat() each.
+         *
+         * @param lastModified receives the last modified time of every
+         * unchanged file, -1 for files that changed or are not cached.
+         * @return the unchanged files.
+         */
+        size_t validate(const std::string_view *identifiers, const int32_t *fileDescriptors,
+                        size_t count, int64_t *lastModified) const;
+
+        /**
+         * Check count files against their entries by the size and last
+         * modified time the caller already has, such as the columns of a
+         * document query, without opening them.
+         *
+         * @param lastModified receives the last modified time of every
+         * matching file, -1 for the others.
+         * @return the matching files.
+         */
+        size_t validate(const std::string_view *identifiers, const int64_t *sizes,
+                        const int64_t *modified, size_t count, int64_t *lastModified) const;
+
+        const ScanCacheEntry &entry(int32_t index) const;
+
+        std::string_view identifier(int32_t index) const;
+
+        size_t fieldCount() const;
+
+        /**
+         * @return the value of the field, or nullptr if the tag had none.
+         */
+        const char *value(int32_t index, size_t field) const;
+
+        /**
+         * @return a NUL terminated string of the pool.
+         */
+        const char *string(uint32_t id) const;
+
+        uint32_t stringLength(uint32_t id) const;
+
+        static uint64_t hashOf(std::string_view identifier);
+
+    private:
+        void *mapping = nullptr;
+        size_t mappingSize = 0;
+
+        const ScanCacheEntry *entries = nullptr;
+        uint32_t entryCount = 0;
+        const uint32_t *values = nullptr;
+        uint32_t fields = 0;
+        const uint32_t *offsets = nullptr;
+        uint32_t stringCount = 0;
+        const char *bytes = nullptr;
+
+        bool load(const std::vector<std::string> &fieldKeys);
+
+        void unmap();
+    };
+
+    /**
+     * Collects the entries of a scan and writes them as a new cache
+     * file. Thread safe.
+     *
+     * Strings live in the StringTable of the scan session, which must
+     * outlive the writer; only those the entries use are written.
+     */
+    class ScanCacheWriter {
+    public:
+        ScanCacheWriter(std::vector<std::string> fieldKeys, StringTable &strings);
+
+        /**
+         * Add a parsed file, replacing an earlier entry of the identifier.
+         *
+         * @param values one string id of the table per field key,
+         * StringTable::kNoString if absent.
+         */
+        void put(std::string_view identifier, int64_t size, int64_t lastModified,
+                 const ScanCacheProperties &properties, const uint32_t *values);
+
+        /**
+         * Carry the entry of an unchanged file over from the previous cache,
+         * which must use the same field keys.
+         *
+         * @return false if the cache has no such entry.
+         */
+        bool keep(const ScanCache &cache, std::string_view identifier);
+
+        size_t size() const;
+
+        /**
+         * Write the cache to a temporary file and move it over path.
+         *
+         * @return false on I/O errors, leaving any old cache in place.
+         */
+        bool write(const std::string &path) const;
+
+        const std::vector<std::string> &keys() const;
+
+    private:
+        std::vector<std::string> fieldKeys;
+        StringTable &strings;
+
+        mutable std::mutex lock;
+        std::unordered_map<uint32_t, size_t> entryOfIdentifier;
+        // string ids are those of the table until written
+        std::vector<ScanCacheEntry> entries;
+        std::vector<uint32_t> values;
+
+        /**
+         * @return the index of the entry of the identifier, appended if new.
+         */
+        size_t entryFor(std::string_view identifier);
+    };
+}
+
+#endif //SOUNDSOURCE_SCAN_CACHE_H
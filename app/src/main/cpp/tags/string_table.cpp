@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "string_table.h"
+
+namespace SoundSource {
+    uint32_t StringTable::intern(std::string_view value) {
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = ids.find(value);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        auto id = (uint32_t) strings.size();
+        const std::string &stored = strings.emplace_back(value);
+        ids.emplace(std::string_view(stored), id);
+        return id;
+    }
+
+    uint32_t StringTable::find(std::string_view value) const {
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = ids.find(value);
+        return it == ids.end() ? kNoString : it->second;
+    }
+
+    const std::string &StringTable::get(uint32_t id) const {
+        std::lock_guard<std::mutex> guard(lock);
+        return strings[id];
+    }
+
+    uint32_t StringTable::size() const {
+        std::lock_guard<std::mutex> guard(lock);
+        return (uint32_t) strings.size();
+    }
+
+    void StringTable::copy(uint32_t begin, std::vector<std::string_view> &out) const {
+        std::lock_guard<std::mutex> guard(lock);
+        for (size_t id = begin; id < strings.size(); id++) {
+            out.emplace_back(strings[id]);
+        }
+    }
+}
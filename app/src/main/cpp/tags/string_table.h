@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOUNDSOURCE_STRING_TABLE_H
+#define SOUNDSOURCE_STRING_TABLE_H
+
+#include <sys/types.h>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace SoundSource {
+    /**
+     * Interns the strings of a scan session. Every distinct string gets
+     * a small id, counting up from 0, and is stored once however many
+     * files share it, so results can carry ids and the strings be
+     * handed over once.
+     *
+     * Thread safe. Strings are never removed, references returned by
+     * get() stay valid for the lifetime of the table.
+     */
+    class StringTable {
+    public:
+        static constexpr uint32_t kNoString = UINT32_MAX;
+
+        uint32_t intern(std::string_view value);
+
+        /**
+         * @return the id of the string, kNoString if not interned.
+         */
+        uint32_t find(std::string_view value) const;
+
+        /**
+         * @return the string of an id below size().
+         */
+        const std::string &get(uint32_t id) const;
+
+        uint32_t size() const;
+
+        /**
+         * Copy the strings of ids from begin up to size() into out.
+         */
+        void copy(uint32_t begin, std::vector<std::string_view> &out) const;
+
+    private:
+        mutable std::mutex lock;
+        // deque elements do not move, the views of ids point into them
+        std::deque<std::string> strings;
+        std::unordered_map<std::string_view, uint32_t> ids;
+    };
+}
+
+#endif //SOUNDSOURCE_STRING_TABLE_H
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tag_batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "tags.h"
+#include "trace.h"
+
+namespace SoundSource {
+    namespace {
+        // the work is mostly small writes, more threads only queue up
+        // on the storage
+        constexpr int32_t kMaxConcurrency = 8;
+
+        TagBatchResult editFile(const TagBatchFile &file, const TagEdit &edit) {
+            TRACE_SECTION("TagBatch::editFile");
+            AudioTagAccessor accessor(file.fileDescriptor, false, TagStream::FILE,
+                                      file.format);
+            if (accessor.isNull()) {
+                return TagBatchResult::OPEN_FAILED;
+            }
+            if (!edit.commit(accessor.fileRef()->file())) {
+                return TagBatchResult::SAVE_FAILED;
+            }
+            return TagBatchResult::SAVED;
+        }
+    }
+
+    int32_t runTagBatch(const std::vector<TagBatchFile> &files, const TagEdit &edit,
+                        int32_t concurrency,
+                        const std::function<bool(size_t, TagBatchResult)> &progress) {
+        if (files.empty()) {
+            return 0;
+        }
+        const auto threads = (size_t) std::clamp(concurrency, 1, kMaxConcurrency);
+
+        std::atomic<size_t> next{0};
+        std::mutex lock;
+        std::condition_variable done;
+        std::deque<std::pair<size_t, TagBatchResult>> results;
+
+        auto work = [&]() {
+            size_t i;
+            while ((i = next.fetch_add(1, std::memory_order_relaxed)) < files.size()) {
+                TagBatchResult result = editFile(files[i], edit);
+                std::lock_guard<std::mutex> guard(lock);
+                results.emplace_back(i, result);
+                done.notify_one();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < std::min(threads, files.size()); t++) {
+            workers.emplace_back(work);
+        }
+
+        int32_t saved = 0;
+        bool reporting = true;
+        for (size_t completed = 0; completed < files.size();) {
+            std::unique_lock<std::mutex> guard(lock);
+            done.wait(guard, [&results] { return !results.empty(); });
+            std::deque<std::pair<size_t, TagBatchResult>> batch;
+            batch.swap(results);
+            guard.unlock();
+
+            for (const auto &[index, result]: batch) {
+                completed++;
+                if (result == TagBatchResult::SAVED) {
+                    saved++;
+                }
+                if (reporting) {
+                    reporting = progress(index, result);
+                }
+            }
+        }
+        for (std::thread &worker: workers) {
+            worker.join();
+        }
+        return saved;
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_TAG_BATCH_H
+#define SOUNDSOURCE_TAG_BATCH_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "tag_edit.h"
+
+namespace SoundSource {
+    /**
+     * Outcome of one file of a batch.
+     *
+     * Values match TagBatchEditor.Result on the Kotlin side.
+     */
+    enum class TagBatchResult : int32_t {
+        SAVED = 0,
+        OPEN_FAILED = 1,
+        SAVE_FAILED = 2,
+    };
+
+    struct TagBatchFile {
+        int32_t fileDescriptor;
+        /**
+         * The ordinal of the AudioFormatType, -1 if unknown.
+         */
+        int32_t format;
+    };
+
+    /**
+     * Apply one edit to many files on up to concurrency worker threads.
+     *
+     * Every file is opened read-write, committed and closed by a worker,
+     * the job owns and closes all the descriptors. The edit is shared by
+     * the workers, its artwork bytes are referenced and not copied per
+     * file.
+     *
+     * progress(index, result) is called on the calling thread, once per
+     * file in completion order, while the workers go on. Once it returns
+     * false it is not called again, but the remaining files are still
+     * edited and closed.
+     *
+     * @return the count of files saved.
+     */
+    int32_t runTagBatch(const std::vector<TagBatchFile> &files, const TagEdit &edit,
+                        int32_t concurrency,
+                        const std::function<bool(size_t index, TagBatchResult result)> &progress);
+}
+
+#endif //SOUNDSOURCE_TAG_BATCH_H
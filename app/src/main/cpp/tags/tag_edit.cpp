@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tag_edit.h"
+
+#include "tpropertymap.h"
+#include "tvariant.h"
+#include "trace.h"
+
+using namespace TagLib;
+
+namespace SoundSource {
+    void TagEdit::setField(const String &name, const String &value) {
+        fields.push_back({name, value, false});
+    }
+
+    void TagEdit::deleteField(const String &name) {
+        fields.push_back({name, String(), true});
+    }
+
+    void TagEdit::setArtwork(const ByteVector &data) {
+        artwork = data;
+        artworkChanged = true;
+    }
+
+    void TagEdit::deleteArtwork() {
+        artwork.clear();
+        artworkChanged = true;
+    }
+
+    bool TagEdit::isEmpty() const {
+        return fields.empty() && !artworkChanged;
+    }
+
+    void TagEdit::clear() {
+        fields.clear();
+        artwork.clear();
+        artworkChanged = false;
+    }
+
+    bool TagEdit::commit(File *file) const {
+        if (isEmpty()) {
+            return true;
+        }
+        if (file == nullptr || file->readOnly()) {
+            return false;
+        }
+        TRACE_SECTION("TagEdit::commit");
+        if (!fields.empty()) {
+            PropertyMap properties = file->properties();
+            for (const FieldEdit &edit: fields) {
+                if (edit.remove) {
+                    properties.erase(edit.name);
+                } else {
+                    properties.replace(edit.name, StringList(edit.value));
+                }
+            }
+            // fields the format cannot hold are dropped, as documented
+            // on AudioTag.setTagField
+            file->setProperties(properties);
+        }
+        if (artworkChanged) {
+            if (artwork.isEmpty()) {
+                file->setComplexProperties("PICTURE", {});
+            } else {
+                file->setComplexProperties("PICTURE", List<VariantMap>{
+                        VariantMap{
+                                {"data",        artwork},
+                                {"pictureType", "Front Cover"}
+                        }
+                });
+            }
+        }
+        return file->save();
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_TAG_EDIT_H
+#define SOUNDSOURCE_TAG_EDIT_H
+
+#include <vector>
+#include <taglib/taglib/toolkit/tfile.h>
+#include <taglib/taglib/toolkit/tstring.h>
+
+namespace SoundSource {
+    /**
+     * Tag changes collected for one file and written together.
+     *
+     * Field edits are applied in order to a single PropertyMap of the
+     * file and stored with one setProperties(), the artwork with one
+     * setComplexProperties("PICTURE"), then the file is saved once.
+     * TagLib writes a tag that fits the padding of the old one in place
+     * (FLAC padding blocks, ID3v2 padding, MP4 free atoms), so a small
+     * edit does not move the audio data.
+     */
+    class TagEdit {
+    public:
+        void setField(const TagLib::String &name, const TagLib::String &value);
+
+        void deleteField(const TagLib::String &name);
+
+        /**
+         * Replace the pictures of the file with a front cover.
+         */
+        void setArtwork(const TagLib::ByteVector &data);
+
+        void deleteArtwork();
+
+        bool isEmpty() const;
+
+        void clear();
+
+        /**
+         * Apply the edits and save the file. Does not touch the file
+         * if there are no edits.
+         *
+         * @return false if the file could not be saved.
+         */
+        bool commit(TagLib::File *file) const;
+
+    private:
+        struct FieldEdit {
+            TagLib::String name;
+            TagLib::String value;
+            bool remove;
+        };
+
+        std::vector<FieldEdit> fields;
+        TagLib::ByteVector artwork;
+        bool artworkChanged = false;
+    };
+}
+
+#endif //SOUNDSOURCE_TAG_EDIT_H
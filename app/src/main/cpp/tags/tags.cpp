@@ -17,6 +17,9 @@
 #include <sys/stat.h>
 #include "tags.h"
 #include "tfilestream.h"
+#include "mapped_stream.h"
+#include "trace.h"
+#include "metrics.h"
 
 #include "asfproperties.h"
 #include "apeproperties.h"
@@ -36,10 +39,13 @@
 using namespace TagLib;
 
 namespace SoundSource {
-    AudioTagAccessor::AudioTagAccessor(int32_t fileDescriptor, bool readonly) {
+    AudioTagAccessor::AudioTagAccessor(int32_t fileDescriptor, bool readonly,
+                                       TagStream streamType, int32_t format) {
         this->pfileRef = nullptr;
         this->fileDescriptor = fileDescriptor;
         this->readonly = readonly;
+        this->streamType = readonly ? streamType : TagStream::FILE;
+        this->format = format;
         internalOpen(fileDescriptor, readonly);
     }
 
@@ -73,6 +79,14 @@ namespace SoundSource {
         return st.st_size;
     }
 
+    int32_t AudioTagAccessor::getFileDescriptor() {
+        return fileDescriptor;
+    }
+
+    int32_t AudioTagAccessor::formatType() {
+        return format;
+    }
+
     int32_t AudioTagAccessor::bitDepth() {
         AudioProperties *properties = pfileRef->audioProperties();
         if (properties == nullptr) {
@@ -110,6 +124,20 @@ namespace SoundSource {
         return -1;
     }
 
+    TagEdit &AudioTagAccessor::edit() {
+        return pendingEdit;
+    }
+
+    bool AudioTagAccessor::save() {
+        if (pfileRef == nullptr || pfileRef->isNull()) {
+            pendingEdit.clear();
+            return false;
+        }
+        bool saved = pendingEdit.commit(pfileRef->file());
+        pendingEdit.clear();
+        return saved;
+    }
+
     void AudioTagAccessor::open() {
         internalOpen(fileDescriptor, readonly);
     }
@@ -118,16 +146,40 @@ namespace SoundSource {
         if (pfileRef != nullptr) {
             return;
         }
-        FileStream *fs = new FileStream(fileDescriptor, readonly);
-        pfileRef = new FileRef(fs);
+        TRACE_SECTION("AudioTagAccessor::internalOpen");
+        Metrics::Timer timer(Metrics::Histogram::OPEN_TIME, format);
+        if (streamType != TagStream::FILE) {
+            stream = new MappedFileStream(fileDescriptor, streamType == TagStream::MAPPED);
+        } else {
+            stream = new FileStream(fileDescriptor, readonly);
+        }
+        pfileRef = new FileRef(stream);
+        Metrics::add(Metrics::Counter::OPENED, format);
+        if (pfileRef->isNull()) {
+            Metrics::add(Metrics::Counter::PARSE_FAILED, format);
+        }
     }
 
     void AudioTagAccessor::close() {
         if (pfileRef == nullptr) {
             return;
         }
-        free(pfileRef);
+        if (streamType != TagStream::FILE) {
+            auto *mappedStream = static_cast<MappedFileStream *>(stream);
+            Metrics::add(Metrics::Counter::BYTES_READ, format, mappedStream->bytesRead());
+        }
+        // the file ref does not own its stream
+        delete pfileRef;
         pfileRef = nullptr;
+        delete stream;
+        stream = nullptr;
+    }
+
+    int64_t AudioTagAccessor::readCalls() {
+        if (stream == nullptr || streamType == TagStream::FILE) {
+            return -1;
+        }
+        return static_cast<MappedFileStream *>(stream)->readCalls();
     }
 
     bool AudioTagAccessor::isNull() {
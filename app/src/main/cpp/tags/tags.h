@@ -22,10 +22,39 @@
 #include <taglib/taglib/fileref.h>
 #include <taglib/taglib/tag.h>
 
+#include "tag_edit.h"
+
 namespace SoundSource {
+    /**
+     * How a readonly AudioTagAccessor reads its file, writable ones
+     * always use TagLib's FileStream.
+     */
+    enum class TagStream : int32_t {
+        /**
+         * TagLib's FileStream.
+         */
+        FILE,
+        /**
+         * MappedFileStream over pread() windows, suited to scans.
+         */
+        WINDOWED,
+        /**
+         * MappedFileStream over a mapping of the file, only for files
+         * nothing truncates while they are read, see MappedFileStream.
+         */
+        MAPPED,
+    };
+
     class AudioTagAccessor {
     public:
-        AudioTagAccessor(int32_t fileDescriptor, bool readonly);
+        /**
+         * @param streamType how the file is read, only applies in
+         * readonly mode.
+         * @param format the ordinal of the AudioFormatType of the file,
+         * the metrics of the file are counted under it.
+         */
+        AudioTagAccessor(int32_t fileDescriptor, bool readonly,
+                         TagStream streamType = TagStream::FILE, int32_t format = -1);
 
         ~AudioTagAccessor();
 
@@ -37,13 +66,47 @@ namespace SoundSource {
 
         int64_t size();
 
+        /**
+         * @return the file descriptor the accessor reads from, still owned
+         * by the accessor.
+         */
+        int32_t getFileDescriptor();
+
+        /**
+         * @return the ordinal of the AudioFormatType, -1 if unknown.
+         */
+        int32_t formatType();
+
         /**
          * @return -1 if no bit depth information is available
          */
         int32_t bitDepth();
 
+        /**
+         * @return the syscalls the MappedFileStream issued for reads so
+         * far, -1 when reading through TagLib's FileStream.
+         */
+        int64_t readCalls();
+
+        /**
+         * The edits waiting for save(). Reads keep returning the saved
+         * tag until then.
+         */
+        TagEdit &edit();
+
+        /**
+         * Write the pending edits with a single save and drop them,
+         * also if saving failed.
+         *
+         * @return false if the file could not be saved.
+         */
+        bool save();
+
         void open();
 
+        /**
+         * Release the file and its stream, which closes the descriptor.
+         */
         void close();
 
         bool isNull();
@@ -52,8 +115,12 @@ namespace SoundSource {
 
     private:
         TagLib::FileRef *pfileRef;
+        TagLib::IOStream *stream = nullptr;
         int fileDescriptor;
         bool readonly;
+        TagStream streamType;
+        int32_t format;
+        TagEdit pendingEdit;
 
         void internalOpen(int fileDescriptor, bool readonly);
     };
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "trace.h"
+
+#ifdef __ANDROID__
+
+#include <android/trace.h>
+
+#else
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+
+#endif
+
+namespace SoundSource::Trace {
+    namespace Internal {
+        std::atomic<bool> enabled{false};
+
+        thread_local int32_t openSections = 0;
+    }
+
+#ifdef __ANDROID__
+
+    namespace Internal {
+        int64_t beginSection(const char *name) {
+            ATrace_beginSection(name);
+            return 0;
+        }
+
+        void endSection(const char *, int64_t) {
+            ATrace_endSection();
+        }
+    }
+
+    bool writeJson(const char *) {
+        return false;
+    }
+
+#else
+
+    namespace {
+        struct Event {
+            const char *name;
+            int32_t thread;
+            int64_t start;
+            int64_t duration;
+        };
+
+        std::mutex eventsLock;
+        std::vector<Event> events;
+        std::atomic<int32_t> nextThread{1};
+
+        int64_t nowMicros() {
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        int32_t threadId() {
+            thread_local int32_t id = nextThread.fetch_add(1, std::memory_order_relaxed);
+            return id;
+        }
+    }
+
+    namespace Internal {
+        int64_t beginSection(const char *) {
+            return nowMicros();
+        }
+
+        void endSection(const char *name, int64_t start) {
+            Event event{name, threadId(), start, nowMicros() - start};
+            std::lock_guard<std::mutex> guard(eventsLock);
+            events.push_back(event);
+        }
+    }
+
+    bool writeJson(const char *path) {
+        std::vector<Event> written;
+        {
+            std::lock_guard<std::mutex> guard(eventsLock);
+            written.swap(events);
+        }
+        FILE *file = std::fopen(path, "w");
+        if (file == nullptr) {
+            return false;
+        }
+        const int pid = getpid();
+        std::fputs("{\"traceEvents\":[", file);
+        for (size_t i = 0; i < written.size(); i++) {
+            const Event &event = written[i];
+            // names are literals of the code, no escaping needed
+            std::fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                               "\"ts\":%lld,\"dur\":%lld}",
+                         i == 0 ? "" : ",", event.name, pid, event.thread,
+                         (long long) event.start, (long long) event.duration);
+        }
+        std::fputs("\n]}\n", file);
+        return std::fclose(file) == 0;
+    }
+
+#endif
+
+    void setEnabled(bool enabled) {
+        Internal::enabled.store(enabled, std::memory_order_relaxed);
+    }
+}
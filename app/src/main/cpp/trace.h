@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SOUNDSOURCE_TRACE_H
+#define SOUNDSOURCE_TRACE_H
+
+#include <sys/types.h>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+
+namespace SoundSource::Trace {
+    namespace Internal {
+        extern std::atomic<bool> enabled;
+
+        /**
+         * Sections open on the calling thread.
+         */
+        extern thread_local int32_t openSections;
+
+        int64_t beginSection(const char *name);
+
+        void endSection(const char *name, int64_t start);
+    }
+
+    /**
+     * Tracing is off until enabled, a disabled section costs one
+     * relaxed load and branch.
+     */
+    inline bool isEnabled() {
+        return Internal::enabled.load(std::memory_order_relaxed);
+    }
+
+    void setEnabled(bool enabled);
+
+    /**
+     * Write the sections recorded so far as Chrome trace JSON (for
+     * chrome://tracing or Perfetto) and drop them. Sections are only
+     * recorded on hosts, on Android they go to ATrace.
+     *
+     * @return false if the file cannot be written.
+     */
+    bool writeJson(const char *path);
+
+    /**
+     * Traces the enclosing scope, or up to end().
+     *
+     * Sections of a thread must end in the reverse order they began,
+     * ATrace always ends the innermost one whatever its name. An end()
+     * out of order asserts in debug builds and is a no-op otherwise,
+     * the section then ends in its destructor.
+     *
+     * @param name a string literal, it is kept until the section ends.
+     */
+    class Section {
+    public:
+        explicit Section(const char *name) {
+            if (isEnabled()) {
+                this->name = name;
+                depth = ++Internal::openSections;
+                start = Internal::beginSection(name);
+            }
+        }
+
+        ~Section() {
+            end();
+        }
+
+        Section(const Section &) = delete;
+
+        Section &operator=(const Section &) = delete;
+
+        void end() {
+            if (name == nullptr) {
+                return;
+            }
+            assert(depth == Internal::openSections && "trace sections must end in reverse order");
+            if (depth != Internal::openSections) {
+                return;
+            }
+            Internal::endSection(name, start);
+            Internal::openSections--;
+            name = nullptr;
+        }
+
+    private:
+        const char *name = nullptr;
+        int64_t start = 0;
+        int32_t depth = 0;
+    };
+}
+
+#define SOUNDSOURCE_TRACE_CONCAT_(a, b) a##b
+#define SOUNDSOURCE_TRACE_CONCAT(a, b) SOUNDSOURCE_TRACE_CONCAT_(a, b)
+
+/**
+ * Trace the rest of the enclosing scope.
+ */
+#define TRACE_SECTION(name) \
+    ::SoundSource::Trace::Section SOUNDSOURCE_TRACE_CONCAT(traceSection, __LINE__)(name)
+
+#endif //SOUNDSOURCE_TRACE_H
@@ -28,11 +28,13 @@ import coil.disk.DiskCache
 import coil.memory.MemoryCache
 import tech.rollw.player.audio.player.AudioPlaylistProvider
 import tech.rollw.player.audio.player.DefaultAudioPlaylistProvider
+import tech.rollw.player.audio.player.SpectrumAnalyzer
 import tech.rollw.player.data.storage.CommonResources
 import tech.rollw.player.data.storage.ContentPathImageFetcher
 import tech.rollw.player.data.storage.LocalImageLoader
 import tech.rollw.player.util.FileLogger
 import tech.rollw.player.util.Logger
+import tech.rollw.player.util.NativeTrace
 import tech.rollw.player.util.today
 import tech.rollw.support.io.ContentPath
 import java.io.File
@@ -52,6 +54,7 @@ class PlayerApplication : Application(),
             put(AudioPlaylistProvider::class.java) { DefaultAudioPlaylistProvider() }
             put(LocalImageLoader::class.java) { LocalImageLoader(this@PlayerApplication) }
             put(CommonResources::class.java) { CommonResources(this@PlayerApplication) }
+            put(SpectrumAnalyzer::class.java) { SpectrumAnalyzer() }
         }
 
     override fun onCreate() {
@@ -61,6 +64,9 @@ class PlayerApplication : Application(),
 
     private fun initServices() {
         CrashHandler.install(this, logger)
+        if (BuildConfig.DEBUG) {
+            NativeTrace.setEnabled(true)
+        }
     }
 
     private val services: MutableMap<Class<*>, Any> = hashMapOf()
@@ -20,6 +20,7 @@ import androidx.room.ColumnInfo
 import androidx.room.Entity
 import androidx.room.Index
 import androidx.room.PrimaryKey
+import tech.rollw.player.audio.analysis.ReplayGain
 import tech.rollw.player.audio.tag.AudioTag
 import tech.rollw.player.audio.tag.AudioTagField
 import java.io.Serializable
@@ -57,7 +58,36 @@ data class Audio(
     @ColumnInfo(name = "type") val type: AudioFormatType,
     @ColumnInfo(name = "size") val size: Long,
     @ColumnInfo(name = "last_modified") val lastModified: Long,
-    @ColumnInfo(name = "create_time") val createTime: Long
+    @ColumnInfo(name = "create_time") val createTime: Long,
+    /**
+     * ReplayGain track gain in dB, null if not measured.
+     */
+    @ColumnInfo(name = "track_gain") val trackGain: Double? = null,
+    /**
+     * Linear track peak, null if not measured.
+     */
+    @ColumnInfo(name = "track_peak") val trackPeak: Double? = null,
+    @ColumnInfo(name = "album_gain") val albumGain: Double? = null,
+    @ColumnInfo(name = "album_peak") val albumPeak: Double? = null,
+    /**
+     * [id] of the audio this one is a copy or re-encode of, null if
+     * it is not a known duplicate.
+     */
+    @ColumnInfo(name = "duplicate_of") val duplicateOf: Long? = null,
+    /**
+     * Tempo in BPM, null if not tagged or analyzed.
+     */
+    @ColumnInfo(name = "bpm") val bpm: Double? = null,
+    /**
+     * Musical key, such as "Eb" or "F#m", null if not tagged or analyzed.
+     */
+    @ColumnInfo(name = "musical_key") val key: String? = null,
+    /**
+     * Whether the loudness of this version of the file could not be
+     * measured, scans do not try again until the file changes.
+     */
+    @ColumnInfo(name = "loudness_failed", defaultValue = "0")
+    val loudnessFailed: Boolean = false
 ): Serializable {
 
     companion object {
@@ -97,5 +127,12 @@ fun AudioTag.toAudio(
     audioFormatType,
     getSize(),
     getLastModified(),
-    createTime
+    createTime,
+    ReplayGain.parseGain(getTagField(AudioTagField.REPLAYGAIN_TRACK_GAIN)),
+    ReplayGain.parsePeak(getTagField(AudioTagField.REPLAYGAIN_TRACK_PEAK)),
+    ReplayGain.parseGain(getTagField(AudioTagField.REPLAYGAIN_ALBUM_GAIN)),
+    ReplayGain.parsePeak(getTagField(AudioTagField.REPLAYGAIN_ALBUM_PEAK)),
+    null,
+    getTagField(AudioTagField.BPM)?.trim()?.toDoubleOrNull()?.takeIf { it > 0 },
+    getTagField(AudioTagField.INITIAL_KEY)?.trim()?.ifEmpty { null }
 )
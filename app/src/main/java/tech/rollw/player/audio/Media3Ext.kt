@@ -26,6 +26,16 @@ import tech.rollw.support.io.ContentPath
  * @author RollW
  */
 
+/**
+ * [MediaMetadata.extras] key of the ReplayGain track gain in dB.
+ */
+const val EXTRA_TRACK_GAIN = "track_gain"
+
+/**
+ * [MediaMetadata.extras] key of the ReplayGain album gain in dB.
+ */
+const val EXTRA_ALBUM_GAIN = "album_gain"
+
 /**
  * Convert [Audio] to [MediaItem].
  */
@@ -54,6 +64,8 @@ fun Audio.toMediaItem(
             .setExtras(Bundle().apply {
                 putString("path", contentPath.path)
                 putSerializable("type", contentPath.type)
+                trackGain?.let { putDouble(EXTRA_TRACK_GAIN, it) }
+                albumGain?.let { putDouble(EXTRA_ALBUM_GAIN, it) }
             })
             .build()
     )
@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package tech.rollw.player.audio.analysis
+
+import androidx.annotation.Keep
+
+/**
+ * Two audios whose fingerprints match, see [FingerprintExtractor.Index].
+ *
+ * @author RollW
+ */
+@Keep
+data class DuplicateMatch(
+    val audioId: Long,
+    val duplicateAudioId: Long,
+    /**
+     * Share of equal fingerprint bits, from 0.5 for unrelated audio
+     * to 1.0 for identical audio.
+     */
+    val similarity: Float
+)
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package tech.rollw.player.audio.analysis
+
+import androidx.annotation.Keep
+import tech.rollw.player.audio.tag.NativeLibAudioTag
+import java.io.Closeable
+
+/**
+ * Native chroma fingerprint extractor for finding re-encodes and
+ * copies of the same recording, decodes the beginning of the audio
+ * through the file descriptor held by [NativeLibAudioTag].
+ *
+ * @author RollW
+ */
+@Keep
+object FingerprintExtractor {
+    const val DEFAULT_MAX_SECONDS = 120
+
+    /**
+     * Highest share of differing bits of a match.
+     */
+    const val DEFAULT_MAX_BIT_ERROR_RATE = 0.25f
+
+    init {
+        System.loadLibrary("soundsource")
+    }
+
+    /**
+     * Decode up to [maxSeconds] of the audio and fingerprint it.
+     *
+     * Blocks the calling thread, should be called from a worker thread.
+     *
+     * @return the serialized fingerprint (about 32 bytes per second),
+     * or null if the audio cannot be decoded.
+     */
+    fun extract(
+        audioTag: NativeLibAudioTag,
+        maxSeconds: Int = DEFAULT_MAX_SECONDS
+    ): ByteArray? = extractFingerprint(audioTag.accessorRef, maxSeconds)
+
+    /**
+     * Collects fingerprints and searches for duplicates among them.
+     */
+    class Index : Closeable {
+        private val indexRef: Long = createIndex()
+
+        private var closed = false
+
+        /**
+         * @param durationMs duration of the audio, only audios of
+         * about the same duration are compared.
+         * @return false if [fingerprint] is not a valid fingerprint.
+         */
+        fun add(audioId: Long, durationMs: Long, fingerprint: ByteArray): Boolean =
+            addFingerprint(indexRef, audioId, durationMs, fingerprint)
+
+        /**
+         * Compare all fingerprints added.
+         *
+         * Blocks the calling thread, should be called from a worker thread.
+         */
+        fun findDuplicates(
+            maxBitErrorRate: Float = DEFAULT_MAX_BIT_ERROR_RATE
+        ): List<DuplicateMatch> = findDuplicates(indexRef, maxBitErrorRate).asList()
+
+        override fun close() {
+            if (closed) {
+                return
+            }
+            closed = true
+            releaseIndex(indexRef)
+        }
+    }
+
+    private external fun extractFingerprint(accessorRef: Long, maxSeconds: Int): ByteArray?
+
+    private external fun createIndex(): Long
+
+    private external fun releaseIndex(indexRef: Long)
+
+    private external fun addFingerprint(
+        indexRef: Long,
+        audioId: Long,
+        durationMs: Long,
+        fingerprint: ByteArray
+    ): Boolean
+
+    private external fun findDuplicates(
+        indexRef: Long,
+        maxBitErrorRate: Float
+    ): Array<DuplicateMatch>
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package tech.rollw.player.audio.analysis
+
+import androidx.annotation.Keep
+
+/**
+ * Loudness of a track or an album, measured by ITU-R BS.1770.
+ *
+ * @author RollW
+ */
+@Keep
+data class Loudness(
+    /**
+     * Gated integrated loudness in LUFS.
+     */
+    val integrated: Double,
+    /**
+     * True peak in linear amplitude, 1.0 means 0 dBTP.
+     */
+    val truePeak: Double
+) {
+    /**
+     * ReplayGain 2.0 gain in dB.
+     */
+    val gain: Double
+        get() = ReplayGain.REFERENCE_LOUDNESS - integrated
+}
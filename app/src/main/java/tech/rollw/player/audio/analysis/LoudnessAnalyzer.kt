@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package tech.rollw.player.audio.analysis
+
+import androidx.annotation.Keep
+import tech.rollw.player.audio.tag.NativeLibAudioTag
+import java.io.Closeable
+
+/**
+ * Native loudness analyzer, decodes the audio through the file
+ * descriptor held by [NativeLibAudioTag] and measures it by
+ * ITU-R BS.1770 / EBU R128.
+ *
+ * @author RollW
+ */
+@Keep
+object LoudnessAnalyzer {
+    init {
+        System.loadLibrary("soundsource")
+    }
+
+    /**
+     * Decode and measure the whole audio.
+     *
+     * Blocks the calling thread until the audio is decoded,
+     * should be called from a worker thread.
+     *
+     * @param album if not null, the track is also accumulated
+     * into the album.
+     * @return the loudness, or null if the audio cannot be decoded
+     * or is silent.
+     */
+    fun analyze(
+        audioTag: NativeLibAudioTag,
+        album: AlbumLoudness? = null
+    ): Loudness? = analyzeTrack(audioTag.accessorRef, album?.albumRef ?: 0)
+
+    /**
+     * Accumulates the loudness of the tracks in one album.
+     * Tracks can be added concurrently.
+     */
+    class AlbumLoudness : Closeable {
+        internal val albumRef: Long = createAlbum()
+
+        private var closed = false
+
+        /**
+         * @return the loudness of all the tracks added, or null
+         * if none of them is measurable.
+         */
+        fun getLoudness(): Loudness? = getAlbumLoudness(albumRef)
+
+        override fun close() {
+            if (closed) {
+                return
+            }
+            closed = true
+            releaseAlbum(albumRef)
+        }
+    }
+
+    private external fun analyzeTrack(accessorRef: Long, albumRef: Long): Loudness?
+
+    private external fun createAlbum(): Long
+
+    private external fun releaseAlbum(albumRef: Long)
+
+    private external fun getAlbumLoudness(albumRef: Long): Loudness?
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package tech.rollw.player.audio.analysis
+
+import android.net.Uri
+import tech.rollw.player.audio.Audio
+import tech.rollw.player.audio.tag.NativeLibAudioTag
+import java.io.Closeable
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.ConcurrentLinkedQueue
+
+/**
+ * Loudness analysis over one library scan.
+ *
+ * Tracks are measured on the scan threads through [analyze], and
+ * accumulated by album and album artist, so same named albums of
+ * different artists are not gated together. Album gains are
+ * computed by [finish] once all tracks are measured, only for the
+ * albums measured completely in this session.
+ *
+ * @author RollW
+ */
+class LoudnessScanSession : Closeable {
+    private val albums = ConcurrentHashMap<AlbumKey, LoudnessAnalyzer.AlbumLoudness>()
+    private val analyzed = ConcurrentLinkedQueue<AnalyzedAudio>()
+
+    private data class AlbumKey(
+        val album: String,
+        val albumArtist: String?
+    )
+
+    data class AnalyzedAudio(
+        val audio: Audio,
+        val uri: Uri
+    )
+
+    /**
+     * Measure the track, returns the audio with its track gain
+     * and peak filled, or marked with [Audio.loudnessFailed] if it
+     * cannot be measured.
+     */
+    fun analyze(audioTag: NativeLibAudioTag, audio: Audio): Audio {
+        val album = albumKeyOf(audio)?.let {
+            albums.computeIfAbsent(it) { LoudnessAnalyzer.AlbumLoudness() }
+        }
+        val loudness = LoudnessAnalyzer.analyze(audioTag, album)
+            ?: return audio.copy(loudnessFailed = true)
+        return audio.copy(
+            trackGain = loudness.gain,
+            trackPeak = loudness.truePeak
+        )
+    }
+
+    /**
+     * Called after the analyzed audio is saved.
+     */
+    fun onSaved(audio: Audio, uri: Uri) {
+        analyzed.add(AnalyzedAudio(audio, uri))
+    }
+
+    /**
+     * Fill the album gain and peak of the analyzed audios.
+     *
+     * An album with a member in [scanned] that was not measured in
+     * this session, because it is tagged or was measured by an earlier
+     * scan, gets no album gain: the gating blocks of that member are
+     * not kept, and a gain over part of the album would be wrong.
+     *
+     * @param scanned every audio of the scan.
+     */
+    fun finish(scanned: Collection<Audio>): List<AnalyzedAudio> {
+        val members = scanned.groupingBy { albumKeyOf(it) }.eachCount()
+        val measured = analyzed.groupingBy { albumKeyOf(it.audio) }.eachCount()
+        val albumLoudness = albums
+            .filterKeys { members[it] == measured[it] }
+            .mapValues { it.value.getLoudness() }
+        return analyzed.map {
+            val loudness = albumKeyOf(it.audio)?.let { key -> albumLoudness[key] }
+                ?: return@map it
+            it.copy(
+                audio = it.audio.copy(
+                    albumGain = loudness.gain,
+                    albumPeak = loudness.truePeak
+                )
+            )
+        }
+    }
+
+    private fun albumKeyOf(audio: Audio): AlbumKey? {
+        val album = audio.album ?: return null
+        return AlbumKey(album, audio.albumArtist)
+    }
+
+    override fun close() {
+        albums.values.forEach { it.close() }
+        albums.clear()
+    }
+}
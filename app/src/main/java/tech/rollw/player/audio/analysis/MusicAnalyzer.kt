@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+package tech.rollw.player.audio.analysis
+
+import androidx.annotation.Keep
+import tech.rollw.player.audio.tag.NativeLibAudioTag
+
+/**
+ * Native tempo and key analyzer, decodes the audio through the file
+ * descriptor held by [NativeLibAudioTag] and analyzes it at 11025 Hz.
+ *
+ * @author RollW
+ */
+@Keep
+object MusicAnalyzer {
+    /**
+     * Long enough for tempo and key of a track, bounds the work of
+     * long mixes.
+     */
+    const val DEFAULT_MAX_SECONDS = 300
+
+    init {
+        System.loadLibrary("soundsource")
+    }
+
+    /**
+     * Decode up to [maxSeconds] of the audio and estimate its tempo
+     * and key.
+     *
+     * Blocks the calling thread, should be called from a worker thread.
+     *
+     * @return the features, or null if the audio cannot be decoded.
+     */
+    fun analyze(
+        audioTag: NativeLibAudioTag,
+        maxSeconds: Int = DEFAULT_MAX_SECONDS
+    ): MusicFeatures? = analyzeMusic(audioTag.accessorRef, maxSeconds)
+
+    private external fun analyzeMusic(accessorRef: Long, maxSeconds: Int): MusicFeatures?
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+package tech.rollw.player.audio.analysis
+
+import androidx.annotation.Keep
+
+/**
+ * Tempo and key of a track, estimated by [MusicAnalyzer].
+ *
+ * @author RollW
+ */
+@Keep
+data class MusicFeatures(
+    /**
+     * Tempo in BPM, 0 if unknown.
+     */
+    val bpm: Double,
+    /**
+     * Normalized autocorrelation of the onsets at [bpm], 0 - 1.
+     */
+    val bpmConfidence: Float,
+    /**
+     * 0 - 11 for C - B major, 12 - 23 for C - B minor, -1 if unknown.
+     */
+    val keyIndex: Int,
+    /**
+     * Correlation of the chroma with the key profile, -1 - 1.
+     */
+    val keyConfidence: Float
+) {
+    /**
+     * The tempo, null if it is not reliable.
+     */
+    val tempo: Double?
+        get() = bpm.takeIf { it > 0 && bpmConfidence >= MIN_BPM_CONFIDENCE }
+
+    /**
+     * The key in the notation of the ID3 TKEY frame, such as "Eb" or
+     * "F#m", null if it is not reliable.
+     */
+    val key: String?
+        get() {
+            if (keyIndex !in KEY_NAMES.indices || keyConfidence < MIN_KEY_CONFIDENCE) {
+                return null
+            }
+            return KEY_NAMES[keyIndex]
+        }
+
+    companion object {
+        /**
+         * Noise and speech stay below, most music is above 0.7.
+         */
+        const val MIN_BPM_CONFIDENCE = 0.5f
+
+        const val MIN_KEY_CONFIDENCE = 0.5f
+
+        private val KEY_NAMES = listOf(
+            "C", "Db", "D", "Eb", "E", "F", "F#", "G", "Ab", "A", "Bb", "B",
+            "Cm", "C#m", "Dm", "Ebm", "Em", "Fm", "F#m", "Gm", "G#m", "Am", "Bbm", "Bm"
+        )
+    }
+}
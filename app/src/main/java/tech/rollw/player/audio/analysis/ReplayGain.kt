@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package tech.rollw.player.audio.analysis
+
+import java.util.Locale
+
+/**
+ * Reads and writes ReplayGain tag values, such as "-6.54 dB"
+ * for gains and "0.988212" for peaks.
+ *
+ * @author RollW
+ */
+object ReplayGain {
+    /**
+     * ReplayGain 2.0 reference loudness in LUFS.
+     */
+    const val REFERENCE_LOUDNESS = -18.0
+
+    private const val GAIN_UNIT = "dB"
+
+    fun parseGain(value: String?): Double? {
+        if (value.isNullOrBlank()) {
+            return null
+        }
+        return value.trim()
+            .removeSuffix(GAIN_UNIT)
+            .trim()
+            .toDoubleOrNull()
+    }
+
+    fun parsePeak(value: String?): Double? {
+        if (value.isNullOrBlank()) {
+            return null
+        }
+        return value.trim().toDoubleOrNull()
+    }
+
+    fun formatGain(gain: Double): String =
+        String.format(Locale.ROOT, "%.2f %s", gain, GAIN_UNIT)
+
+    fun formatPeak(peak: Double): String =
+        String.format(Locale.ROOT, "%.6f", peak)
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package tech.rollw.player.audio.analysis
+
+import androidx.annotation.Keep
+import tech.rollw.player.audio.tag.NativeLibAudioTag
+
+/**
+ * Builds seek indexes of MP3 and FLAC files, frame offsets sampled
+ * every interval, by walking the frame headers through the file
+ * descriptor held by [NativeLibAudioTag].
+ *
+ * @author RollW
+ */
+@Keep
+object SeekIndexBuilder {
+    const val DEFAULT_INTERVAL_MS = 1000
+
+    init {
+        System.loadLibrary("soundsource")
+    }
+
+    /**
+     * Walk the whole file and build its index.
+     *
+     * Blocks the calling thread, should be called from a worker thread.
+     *
+     * @return the serialized index, or null if the file is neither
+     * MP3 nor FLAC, or is a FLAC file that already has a SEEKTABLE.
+     */
+    fun build(
+        audioTag: NativeLibAudioTag,
+        intervalMs: Int = DEFAULT_INTERVAL_MS
+    ): ByteArray? = buildSeekIndex(audioTag.accessorRef, intervalMs)
+
+    private external fun buildSeekIndex(accessorRef: Long, intervalMs: Int): ByteArray?
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package tech.rollw.player.audio.analysis
+
+import android.content.Context
+import java.io.File
+import java.security.MessageDigest
+
+/**
+ * Stores data derived from audio files (seek indexes, waveforms,
+ * fingerprints) as sidecar files in the app's private storage, keyed
+ * by the audio identifier and its last modified time, so data of a
+ * modified file is never used.
+ *
+ * @author RollW
+ */
+class SidecarStore(
+    context: Context,
+    directoryName: String,
+    private val suffix: String
+) {
+    private val directory = File(context.filesDir, directoryName)
+
+    fun contains(identifier: String, lastModified: Long): Boolean =
+        fileOf(identifier, lastModified).exists()
+
+    fun read(identifier: String, lastModified: Long): ByteArray? {
+        val file = fileOf(identifier, lastModified)
+        return try {
+            file.readBytes()
+        } catch (e: Exception) {
+            null
+        }
+    }
+
+    /**
+     * Save the data, replacing the data of older versions
+     * of the file.
+     */
+    fun write(identifier: String, lastModified: Long, data: ByteArray) {
+        directory.mkdirs()
+        val file = fileOf(identifier, lastModified)
+        val temp = File(directory, "${file.name}.tmp")
+        temp.writeBytes(data)
+        if (!temp.renameTo(file)) {
+            temp.delete()
+            return
+        }
+        val prefix = prefixOf(identifier)
+        directory.listFiles { f ->
+            f.name.startsWith(prefix) && f.name != file.name
+        }?.forEach { it.delete() }
+    }
+
+    private fun fileOf(identifier: String, lastModified: Long) =
+        File(directory, "${prefixOf(identifier)}$lastModified$suffix")
+
+    private fun prefixOf(identifier: String): String {
+        val digest = MessageDigest.getInstance("SHA-1")
+            .digest(identifier.toByteArray())
+        return digest.joinToString("", postfix = "-") { "%02x".format(it) }
+    }
+
+    companion object {
+        /**
+         * Store of [SeekIndexBuilder] indexes.
+         */
+        fun seekIndexes(context: Context) =
+            SidecarStore(context, "seek_index", ".sidx")
+
+        /**
+         * Store of [WaveformExtractor] overviews.
+         */
+        fun waveforms(context: Context) =
+            SidecarStore(context, "waveform", ".swf")
+
+        /**
+         * Store of [FingerprintExtractor] fingerprints.
+         */
+        fun fingerprints(context: Context) =
+            SidecarStore(context, "fingerprint", ".sfp")
+    }
+}
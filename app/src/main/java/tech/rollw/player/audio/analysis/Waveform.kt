@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package tech.rollw.player.audio.analysis
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Peak overview of an audio file, built by [WaveformExtractor].
+ *
+ * Bucket `i` covers the same share of the track, values are
+ * normalized to range [-1, 1] ([rms] to [0, 1]).
+ *
+ * @author RollW
+ */
+class Waveform(
+    val channels: Int,
+    val sampleRate: Int,
+    val totalFrames: Long,
+    private val data: ByteArray
+) {
+    val bucketCount: Int = (data.size - HEADER_SIZE) / 3
+
+    val durationMs: Long
+        get() = if (sampleRate == 0) 0 else totalFrames * 1000 / sampleRate
+
+    fun min(bucket: Int): Float = data[offsetOf(bucket)] / 127f
+
+    fun max(bucket: Int): Float = data[offsetOf(bucket) + 1] / 127f
+
+    fun rms(bucket: Int): Float =
+        (data[offsetOf(bucket) + 2].toInt() and 0xFF) / 255f
+
+    private fun offsetOf(bucket: Int) = HEADER_SIZE + bucket * 3
+
+    companion object {
+        private const val MAGIC = 0x46575353 // "SSWF"
+        private const val VERSION = 1
+        private const val HEADER_SIZE = 24
+
+        /**
+         * Read an overview serialized by [WaveformExtractor.extract].
+         *
+         * @return null if the data is not a valid overview.
+         */
+        fun parse(data: ByteArray): Waveform? {
+            if (data.size < HEADER_SIZE) {
+                return null
+            }
+            val buffer = ByteBuffer.wrap(data).order(ByteOrder.LITTLE_ENDIAN)
+            if (buffer.getInt(0) != MAGIC || data[4].toInt() != VERSION) {
+                return null
+            }
+            val count = buffer.getInt(20)
+            if (count < 0 || data.size.toLong() != HEADER_SIZE + count * 3L) {
+                return null
+            }
+            return Waveform(
+                channels = data[5].toInt() and 0xFF,
+                sampleRate = buffer.getInt(8),
+                totalFrames = buffer.getLong(12),
+                data = data
+            )
+        }
+    }
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package tech.rollw.player.audio.analysis
+
+import androidx.annotation.Keep
+import tech.rollw.player.audio.tag.NativeLibAudioTag
+
+/**
+ * Extracts peak overviews ([Waveform]) of audio files, decoding
+ * them once through the file descriptor held by [NativeLibAudioTag].
+ *
+ * @author RollW
+ */
+@Keep
+object WaveformExtractor {
+    const val DEFAULT_BUCKET_COUNT = 1024
+
+    init {
+        System.loadLibrary("soundsource")
+    }
+
+    /**
+     * Decode the whole file and summarize it in [bucketCount] buckets.
+     *
+     * Blocks the calling thread, should be called from a worker thread.
+     *
+     * @return the serialized overview (about 3 bytes per bucket), read
+     * it with [Waveform.parse]; or null if the file cannot be decoded.
+     */
+    fun extract(
+        audioTag: NativeLibAudioTag,
+        bucketCount: Int = DEFAULT_BUCKET_COUNT
+    ): ByteArray? = extractWaveform(audioTag.accessorRef, bucketCount)
+
+    private external fun extractWaveform(accessorRef: Long, bucketCount: Int): ByteArray?
+}
@@ -17,6 +17,7 @@
 package tech.rollw.player.audio.player
 
 import android.os.Bundle
+import android.os.SystemClock
 import androidx.annotation.OptIn
 import androidx.media3.common.MediaItem
 import androidx.media3.common.PlaybackException
@@ -40,6 +41,10 @@ import tech.rollw.player.audio.toMediaItem
  * [player] implementation, such as [Player.seekToNext],
  * [Player.seekToPrevious] and so on.
  *
+ * The next tracks are opened ahead of time by the [prefetcher] when
+ * one is given, and the time from a track change to the player being
+ * ready is recorded with it.
+ *
  * @param player player to delegate
  * @author RollW
  */
@@ -47,7 +52,8 @@ import tech.rollw.player.audio.toMediaItem
 @OptIn(UnstableApi::class)
 class AudioPlaylistDelegatePlayer(
     private val player: Player,
-    private val audioPlaylistProvider: AudioPlaylistProvider
+    private val audioPlaylistProvider: AudioPlaylistProvider,
+    private val prefetcher: PlaybackPrefetcher? = null
 ) : Player by player, Player.Listener, AudioPlaylistProvider.OnAudioPlaylistListener {
     init {
         audioPlaylistProvider.addOnAudioPlaylistListener(this)
@@ -61,6 +67,12 @@ class AudioPlaylistDelegatePlayer(
         putString(AudioPlaylistProvider.EXTRA_CHANGE_SOURCE, TAG)
     }
 
+    /**
+     * Time of the last track change not yet ready, 0 if none.
+     */
+    private var changeStartMillis = 0L
+    private var changePrefetched = false
+
     override fun getAvailableCommands(): Commands = Commands
         .Builder()
         .addAll(
@@ -136,6 +148,12 @@ class AudioPlaylistDelegatePlayer(
         if (playbackState == Player.STATE_ENDED) {
             seekToNext()
         }
+        if (playbackState == Player.STATE_READY && changeStartMillis != 0L) {
+            val millis = SystemClock.elapsedRealtime() - changeStartMillis
+            changeStartMillis = 0L
+            prefetcher?.recordTimeToReady(changePrefetched, millis)
+            Log.d(TAG, "Ready $millis ms after track change, prefetched: $changePrefetched")
+        }
     }
 
     override fun onMediaItemTransition(
@@ -148,6 +166,8 @@ class AudioPlaylistDelegatePlayer(
         audioContent: AudioContent,
         play: Boolean
     ) {
+        changeStartMillis = SystemClock.elapsedRealtime()
+        changePrefetched = prefetcher?.take(audioContent) ?: false
         val mediaItem = audioContent.toMediaItem()
         setMediaItem(mediaItem)
         prepare()
@@ -155,6 +175,20 @@ class AudioPlaylistDelegatePlayer(
         if (play) {
             playWhenReady = true
         }
+        prefetchUpcoming()
+    }
+
+    private fun prefetchUpcoming() {
+        val prefetcher = prefetcher ?: return
+        val playlist = audioPlaylistProvider.playlist
+        val next = audioPlaylistProvider.index + 1
+        if (next >= playlist.size) {
+            prefetcher.update(emptyList())
+            return
+        }
+        prefetcher.update(
+            playlist.subList(next, minOf(playlist.size, next + prefetcher.lookahead))
+        )
     }
 
     override fun onPlaylistChanged(
@@ -204,10 +238,11 @@ class AudioPlaylistDelegatePlayer(
 }
 
 fun Player.withAudioPlaylistProvider(
-    audioPlaylistProvider: AudioPlaylistProvider
+    audioPlaylistProvider: AudioPlaylistProvider,
+    prefetcher: PlaybackPrefetcher? = null
 ): Player {
     if (this is AudioPlaylistDelegatePlayer) {
         return this
     }
-    return AudioPlaylistDelegatePlayer(this, audioPlaylistProvider)
+    return AudioPlaylistDelegatePlayer(this, audioPlaylistProvider, prefetcher)
 }
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+package tech.rollw.player.audio.player
+
+import java.io.Closeable
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * PCM output through a native Oboe stream.
+ *
+ * Frames are queued into a ring buffer without blocking, the stream
+ * drains it on its own thread and sizes its buffer by the underruns
+ * it sees, see [stats].
+ *
+ * Check [isValid] after creating, the stream may fail to open.
+ *
+ * @param floatEncoding whether the frames are float, otherwise 16-bit.
+ * @param lowLatency open a low latency stream, which saves latency at
+ * the cost of power.
+ * @author RollW
+ */
+class OboeAudioOutput(
+    val channelCount: Int,
+    val sampleRate: Int,
+    val floatEncoding: Boolean,
+    lowLatency: Boolean = false
+) : Closeable {
+    private var outputRef = createOutput(channelCount, sampleRate, floatEncoding, lowLatency)
+
+    private var stagingBuffer: ByteBuffer = ByteBuffer.allocateDirect(0)
+
+    val bytesPerFrame = channelCount * if (floatEncoding) 4 else 2
+
+    val isValid: Boolean
+        get() = outputRef != 0L
+
+    /**
+     * Frames queued and not yet taken by the stream.
+     */
+    val queuedFrames: Int
+        get() = getQueuedFrames(outputRef)
+
+    /**
+     * Frames played since the last [flush].
+     */
+    val playedFrames: Long
+        get() = getPlayedFrames(outputRef)
+
+    /**
+     * Queue the whole frames remaining in [buffer], advancing its
+     * position past the frames queued. Never blocks.
+     *
+     * @return the frames queued, fewer than remaining if the ring buffer
+     * is full.
+     */
+    fun write(buffer: ByteBuffer): Int {
+        val frames = buffer.remaining() / bytesPerFrame
+        if (frames == 0) {
+            return 0
+        }
+        val written = if (buffer.isDirect) {
+            write(outputRef, buffer, buffer.position(), frames)
+        } else {
+            write(outputRef, stage(buffer, frames), 0, frames)
+        }
+        buffer.position(buffer.position() + written * bytesPerFrame)
+        return written
+    }
+
+    private fun stage(buffer: ByteBuffer, frames: Int): ByteBuffer {
+        val size = frames * bytesPerFrame
+        if (stagingBuffer.capacity() < size) {
+            stagingBuffer = ByteBuffer.allocateDirect(size).order(ByteOrder.nativeOrder())
+        }
+        stagingBuffer.clear()
+        stagingBuffer.put(buffer.duplicate().limit(buffer.position() + size) as ByteBuffer)
+        stagingBuffer.flip()
+        return stagingBuffer
+    }
+
+    fun start(): Boolean = start(outputRef)
+
+    fun pause(): Boolean = pause(outputRef)
+
+    /**
+     * Drop the queued frames and restart [playedFrames].
+     */
+    fun flush() = flush(outputRef)
+
+    fun setVolume(volume: Float) = setVolume(outputRef, volume)
+
+    /**
+     * @return the current stats, null if the stream is not open.
+     */
+    fun stats(): OutputStats? = getStats(outputRef)
+
+    override fun close() {
+        if (outputRef == 0L) {
+            return
+        }
+        releaseOutput(outputRef)
+        outputRef = 0L
+    }
+
+    private external fun createOutput(
+        channels: Int,
+        sampleRate: Int,
+        floatEncoding: Boolean,
+        lowLatency: Boolean
+    ): Long
+
+    private external fun releaseOutput(outputRef: Long)
+
+    private external fun write(outputRef: Long, buffer: ByteBuffer, offset: Int, frames: Int): Int
+
+    private external fun start(outputRef: Long): Boolean
+
+    private external fun pause(outputRef: Long): Boolean
+
+    private external fun flush(outputRef: Long)
+
+    private external fun setVolume(outputRef: Long, volume: Float)
+
+    private external fun getQueuedFrames(outputRef: Long): Int
+
+    private external fun getPlayedFrames(outputRef: Long): Long
+
+    private external fun getStats(outputRef: Long): OutputStats?
+
+    companion object {
+        init {
+            System.loadLibrary("soundsource")
+        }
+    }
+}
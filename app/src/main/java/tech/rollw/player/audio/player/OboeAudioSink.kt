@@ -0,0 +1,383 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+package tech.rollw.player.audio.player
+
+import android.media.AudioTrack
+import android.util.Log
+import androidx.annotation.OptIn
+import androidx.media3.common.AudioAttributes
+import androidx.media3.common.AuxEffectInfo
+import androidx.media3.common.C
+import androidx.media3.common.Format
+import androidx.media3.common.MimeTypes
+import androidx.media3.common.PlaybackParameters
+import androidx.media3.common.audio.AudioProcessingPipeline
+import androidx.media3.common.audio.AudioProcessor
+import androidx.media3.common.audio.AudioProcessor.AudioFormat
+import androidx.media3.common.audio.AudioProcessor.UnhandledAudioFormatException
+import androidx.media3.common.util.UnstableApi
+import androidx.media3.exoplayer.audio.AudioSink
+import com.google.common.collect.ImmutableList
+import java.nio.ByteBuffer
+import kotlin.math.abs
+
+/**
+ * [AudioSink] playing 16-bit and float PCM through an
+ * [OboeAudioOutput], with the given [audioProcessors] applied before.
+ *
+ * Playback speed, silence skipping and tunneling are not supported.
+ *
+ * @author RollW
+ */
+@OptIn(UnstableApi::class)
+class OboeAudioSink(
+    private val audioProcessors: List<AudioProcessor>,
+    private val lowLatency: Boolean = false
+) : AudioSink {
+    private var listener: AudioSink.Listener? = null
+    private var audioAttributes: AudioAttributes = AudioAttributes.DEFAULT
+    private var volume = 1f
+    private var playing = false
+
+    private var configuration: Configuration? = null
+    private var pendingConfiguration: Configuration? = null
+    private var output: OboeAudioOutput? = null
+
+    private var pendingOutput: ByteBuffer? = null
+    private var drainingPipeline = false
+    private var handledEndOfStream = false
+
+    /**
+     * Output frames queued since the last flush.
+     */
+    private var writtenFrames = 0L
+    private var startMediaTimeUs = 0L
+    private var startMediaTimeNeedsSync = true
+    private var discontinuity = false
+
+    /**
+     * @return the stats of the output, null if there is no open output.
+     */
+    fun stats(): OutputStats? = output?.stats()
+
+    override fun setListener(listener: AudioSink.Listener) {
+        this.listener = listener
+    }
+
+    override fun supportsFormat(format: Format): Boolean =
+        getFormatSupport(format) != AudioSink.SINK_FORMAT_UNSUPPORTED
+
+    override fun getFormatSupport(format: Format): Int {
+        if (format.sampleMimeType != MimeTypes.AUDIO_RAW) {
+            return AudioSink.SINK_FORMAT_UNSUPPORTED
+        }
+        return when (format.pcmEncoding) {
+            C.ENCODING_PCM_16BIT, C.ENCODING_PCM_FLOAT -> AudioSink.SINK_FORMAT_SUPPORTED_DIRECTLY
+            else -> AudioSink.SINK_FORMAT_UNSUPPORTED
+        }
+    }
+
+    override fun getCurrentPositionUs(sourceEnded: Boolean): Long {
+        val output = output ?: return AudioSink.CURRENT_POSITION_NOT_SET
+        if (startMediaTimeNeedsSync) {
+            return AudioSink.CURRENT_POSITION_NOT_SET
+        }
+        return startMediaTimeUs + framesToUs(output.playedFrames, output.sampleRate)
+    }
+
+    override fun configure(
+        inputFormat: Format,
+        specifiedBufferSize: Int,
+        outputChannels: IntArray?
+    ) {
+        if (getFormatSupport(inputFormat) == AudioSink.SINK_FORMAT_UNSUPPORTED) {
+            throw AudioSink.ConfigurationException("Unsupported format", inputFormat)
+        }
+        val pipeline = AudioProcessingPipeline(ImmutableList.copyOf(audioProcessors))
+        val inputAudioFormat = AudioFormat(
+            inputFormat.sampleRate,
+            inputFormat.channelCount,
+            inputFormat.pcmEncoding
+        )
+        val outputAudioFormat = try {
+            pipeline.configure(inputAudioFormat)
+        } catch (e: UnhandledAudioFormatException) {
+            throw AudioSink.ConfigurationException(e, inputFormat)
+        }
+        val newConfiguration = Configuration(inputFormat, pipeline, outputAudioFormat)
+        if (configuration == null) {
+            applyConfiguration(newConfiguration)
+        } else {
+            // the current audio plays out first, see handleBuffer
+            pendingConfiguration = newConfiguration
+        }
+    }
+
+    private fun applyConfiguration(newConfiguration: Configuration) {
+        configuration = newConfiguration
+        newConfiguration.pipeline.flush()
+        drainingPipeline = false
+    }
+
+    override fun play() {
+        playing = true
+        output?.start()
+    }
+
+    override fun handleDiscontinuity() {
+        discontinuity = true
+    }
+
+    override fun handleBuffer(
+        buffer: ByteBuffer,
+        presentationTimeUs: Long,
+        encodedAccessUnitCount: Int
+    ): Boolean {
+        pendingConfiguration?.let {
+            if (!drainToEndOfStream()) {
+                return false
+            }
+            val current = configuration!!
+            if (output != null && it.outputFormat != current.outputFormat) {
+                if (output!!.queuedFrames > 0) {
+                    return false
+                }
+                releaseOutput()
+            }
+            applyConfiguration(it)
+            pendingConfiguration = null
+        }
+        val output = output ?: openOutput()
+
+        if (startMediaTimeNeedsSync) {
+            startMediaTimeUs = maxOf(0L, presentationTimeUs)
+            startMediaTimeNeedsSync = false
+            discontinuity = false
+        } else if (discontinuity) {
+            discontinuity = false
+            // where the buffer starts by what was queued before it
+            val expectedUs = startMediaTimeUs + framesToUs(writtenFrames, output.sampleRate)
+            if (abs(expectedUs - presentationTimeUs) > MAX_DISCONTINUITY_US) {
+                startMediaTimeUs += presentationTimeUs - expectedUs
+                listener?.onPositionDiscontinuity()
+            }
+        }
+
+        return processBuffers(buffer, output)
+    }
+
+    /**
+     * Pass [input] through the pipeline into the output.
+     *
+     * @return true if the input is consumed and all output queued.
+     */
+    private fun processBuffers(input: ByteBuffer, output: OboeAudioOutput): Boolean {
+        val pipeline = configuration!!.pipeline
+        while (true) {
+            if (!writePendingOutput(output)) {
+                return false
+            }
+            if (!pipeline.isOperational) {
+                if (!input.hasRemaining()) {
+                    return true
+                }
+                pendingOutput = input
+                continue
+            }
+            val processed = pipeline.output
+            if (processed.hasRemaining()) {
+                pendingOutput = processed
+                continue
+            }
+            if (!input.hasRemaining()) {
+                return true
+            }
+            val position = input.position()
+            pipeline.queueInput(input)
+            if (input.position() == position && !pipeline.output.hasRemaining()) {
+                // the pipeline takes no more for now
+                return false
+            }
+        }
+    }
+
+    /**
+     * @return true if nothing is left to queue.
+     */
+    private fun writePendingOutput(output: OboeAudioOutput): Boolean {
+        val pending = pendingOutput ?: return true
+        writtenFrames += output.write(pending)
+        if (pending.remaining() >= output.bytesPerFrame) {
+            return false
+        }
+        pendingOutput = null
+        return true
+    }
+
+    /**
+     * Queue the end of stream into the pipeline and write out all it
+     * has left.
+     *
+     * @return true once the pipeline is drained.
+     */
+    private fun drainToEndOfStream(): Boolean {
+        val output = output ?: return true
+        val pipeline = configuration!!.pipeline
+        if (!pipeline.isOperational) {
+            return writePendingOutput(output)
+        }
+        if (!drainingPipeline) {
+            drainingPipeline = true
+            pipeline.queueEndOfStream()
+        }
+        while (true) {
+            if (!writePendingOutput(output)) {
+                return false
+            }
+            val processed = pipeline.output
+            if (!processed.hasRemaining()) {
+                return pipeline.isEnded
+            }
+            pendingOutput = processed
+        }
+    }
+
+    override fun playToEndOfStream() {
+        if (!handledEndOfStream && drainToEndOfStream()) {
+            handledEndOfStream = true
+        }
+    }
+
+    override fun isEnded(): Boolean =
+        output == null || (handledEndOfStream && !hasPendingData())
+
+    override fun hasPendingData(): Boolean {
+        val output = output ?: return false
+        return output.queuedFrames > 0 || output.playedFrames < writtenFrames
+    }
+
+    override fun setPlaybackParameters(playbackParameters: PlaybackParameters) = Unit
+
+    override fun getPlaybackParameters(): PlaybackParameters = PlaybackParameters.DEFAULT
+
+    override fun setSkipSilenceEnabled(skipSilenceEnabled: Boolean) = Unit
+
+    override fun getSkipSilenceEnabled(): Boolean = false
+
+    override fun setAudioAttributes(audioAttributes: AudioAttributes) {
+        this.audioAttributes = audioAttributes
+    }
+
+    override fun getAudioAttributes(): AudioAttributes = audioAttributes
+
+    override fun setAudioSessionId(audioSessionId: Int) = Unit
+
+    override fun setAuxEffectInfo(auxEffectInfo: AuxEffectInfo) = Unit
+
+    override fun enableTunnelingV21() = Unit
+
+    override fun disableTunneling() = Unit
+
+    override fun setVolume(volume: Float) {
+        this.volume = volume
+        output?.setVolume(volume)
+    }
+
+    override fun pause() {
+        playing = false
+        output?.pause()
+    }
+
+    override fun flush() {
+        output?.flush()
+        pendingOutput = null
+        writtenFrames = 0
+        startMediaTimeNeedsSync = true
+        discontinuity = false
+        handledEndOfStream = false
+        pendingConfiguration?.let {
+            // nothing of the old format is left to play
+            if (it.outputFormat != configuration?.outputFormat) {
+                releaseOutput()
+            }
+            configuration = it
+            pendingConfiguration = null
+        }
+        configuration?.pipeline?.flush()
+        drainingPipeline = false
+    }
+
+    override fun reset() {
+        flush()
+        releaseOutput()
+        configuration?.pipeline?.reset()
+        configuration = null
+        playing = false
+    }
+
+    private fun openOutput(): OboeAudioOutput {
+        val current = configuration!!
+        val format = current.outputFormat
+        val output = OboeAudioOutput(
+            format.channelCount,
+            format.sampleRate,
+            format.encoding == C.ENCODING_PCM_FLOAT,
+            lowLatency
+        )
+        if (!output.isValid) {
+            throw AudioSink.InitializationException(
+                AudioTrack.STATE_UNINITIALIZED,
+                format.sampleRate,
+                0,
+                0,
+                current.inputFormat,
+                /* isRecoverable = */ false,
+                null
+            )
+        }
+        output.setVolume(volume)
+        if (playing) {
+            output.start()
+        }
+        Log.d(TAG, "Opened output of $format")
+        this.output = output
+        return output
+    }
+
+    private fun releaseOutput() {
+        output?.close()
+        output = null
+        startMediaTimeNeedsSync = true
+        writtenFrames = 0
+    }
+
+    private fun framesToUs(frames: Long, sampleRate: Int): Long =
+        frames * C.MICROS_PER_SECOND / sampleRate
+
+    private data class Configuration(
+        val inputFormat: Format,
+        val pipeline: AudioProcessingPipeline,
+        val outputFormat: AudioFormat
+    )
+
+    companion object {
+        private const val TAG = "OboeAudioSink"
+
+        private const val MAX_DISCONTINUITY_US = 200_000L
+    }
+}
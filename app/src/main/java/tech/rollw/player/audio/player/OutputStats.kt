@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+package tech.rollw.player.audio.player
+
+import androidx.annotation.Keep
+
+/**
+ * Snapshot of the state of an [OboeAudioOutput].
+ *
+ * @author RollW
+ */
+@Keep
+class OutputStats(
+    /**
+     * Frames queued by the player since the output was opened.
+     */
+    val framesWritten: Long,
+    /**
+     * Frames played since the last flush.
+     */
+    val framesPlayed: Long,
+    /**
+     * Underruns reported by the device.
+     */
+    val xRunCount: Int,
+    /**
+     * Times the player did not queue audio in time.
+     */
+    val starvedCount: Int,
+    val bufferSizeFrames: Int,
+    val bufferCapacityFrames: Int,
+    val framesPerBurst: Int,
+    val sampleRate: Int,
+    /**
+     * Estimated output latency, 0 if unknown.
+     */
+    val latencyMillis: Double,
+    /**
+     * Callback durations, bucket i counts callbacks of 2^(i-1) to
+     * 2^i microseconds, the last bucket all longer ones.
+     */
+    val callbackHistogram: IntArray
+) {
+    val bufferSizeMillis: Double
+        get() = if (sampleRate == 0) 0.0
+        else bufferSizeFrames * 1000.0 / sampleRate
+}
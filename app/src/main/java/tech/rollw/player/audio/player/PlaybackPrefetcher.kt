@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+package tech.rollw.player.audio.player
+
+import android.content.Context
+import androidx.annotation.OptIn
+import androidx.media3.common.util.Log
+import androidx.media3.common.util.UnstableApi
+import tech.rollw.player.audio.AudioContent
+import tech.rollw.support.appcompat.openFileDescriptor
+import java.io.Closeable
+import java.util.concurrent.Executors
+
+/**
+ * Opens the next tracks of the play queue ahead of time: the file
+ * descriptor, the TagLib parse and the first [headMillis] of decoded
+ * audio, held natively within [budgetBytes].
+ *
+ * A track change then finds the file parsed and its first blocks in
+ * the page cache, where the player's extractor reads them from. The
+ * time from a track change to the player being ready is tracked for
+ * prefetched and cold tracks, see [meanTimeToReadyMillis].
+ *
+ * @param lookahead how many upcoming tracks to prefetch.
+ * @author RollW
+ */
+@OptIn(UnstableApi::class)
+class PlaybackPrefetcher(
+    private val context: Context,
+    val lookahead: Int = DEFAULT_LOOKAHEAD,
+    budgetBytes: Long = DEFAULT_BUDGET_BYTES,
+    private val headMillis: Int = DEFAULT_HEAD_MILLIS
+) : Closeable {
+    @Volatile
+    private var cacheRef = createCache(budgetBytes)
+
+    private val executor = Executors.newSingleThreadExecutor()
+
+    private val timeToReady = LongArray(4)
+
+    /**
+     * Set the upcoming tracks, most likely next first. Tracks that left
+     * the queue are dropped, new ones are opened in the background.
+     */
+    fun update(upcoming: List<AudioContent>) {
+        val ref = cacheRef
+        if (ref == 0L) {
+            return
+        }
+        val tracks = upcoming.filter { it.audio.id != null }.take(lookahead)
+        setQueue(ref, LongArray(tracks.size) { tracks[it].audio.id!! })
+        tracks.forEach { track ->
+            executor.execute { prefetch(track) }
+        }
+    }
+
+    private fun prefetch(track: AudioContent) {
+        val ref = cacheRef
+        if (ref == 0L) {
+            return
+        }
+        try {
+            val pfd = track.path.toUri().openFileDescriptor(context)
+            prefetch(ref, track.audio.id!!, pfd.detachFd(), headMillis)
+        } catch (e: Exception) {
+            Log.w(TAG, "Cannot prefetch ${track.path}: $e")
+        }
+    }
+
+    /**
+     * Take the prefetched state of the track that starts playing.
+     *
+     * @return whether the track was prefetched.
+     */
+    fun take(track: AudioContent): Boolean {
+        val ref = cacheRef
+        val id = track.audio.id
+        if (ref == 0L || id == null) {
+            return false
+        }
+        return take(ref, id) >= 0
+    }
+
+    /**
+     * Record the time from a track change to the player being ready.
+     */
+    @Synchronized
+    fun recordTimeToReady(prefetched: Boolean, millis: Long) {
+        val index = if (prefetched) 0 else 2
+        timeToReady[index]++
+        timeToReady[index + 1] += millis
+    }
+
+    /**
+     * @return the mean time to ready of prefetched or cold track
+     * changes, or -1 if there were none.
+     */
+    @Synchronized
+    fun meanTimeToReadyMillis(prefetched: Boolean): Long {
+        val index = if (prefetched) 0 else 2
+        if (timeToReady[index] == 0L) {
+            return -1
+        }
+        return timeToReady[index + 1] / timeToReady[index]
+    }
+
+    /**
+     * @return the current stats, null once closed.
+     */
+    fun stats(): PrefetchStats? = getStats(cacheRef)
+
+    override fun close() {
+        val ref = cacheRef
+        if (ref == 0L) {
+            return
+        }
+        cacheRef = 0L
+        // after a prefetch that may still run
+        executor.execute { releaseCache(ref) }
+        executor.shutdown()
+    }
+
+    private external fun createCache(budgetBytes: Long): Long
+
+    private external fun releaseCache(cacheRef: Long)
+
+    private external fun setQueue(cacheRef: Long, keys: LongArray)
+
+    private external fun prefetch(
+        cacheRef: Long,
+        key: Long,
+        fileDescriptor: Int,
+        headMillis: Int
+    ): Boolean
+
+    /**
+     * @return the nanoseconds the entry took to open, or -1 if the key
+     * was not prefetched.
+     */
+    private external fun take(cacheRef: Long, key: Long): Long
+
+    private external fun getStats(cacheRef: Long): PrefetchStats?
+
+    companion object {
+        private const val TAG = "PlaybackPrefetcher"
+
+        const val DEFAULT_LOOKAHEAD = 2
+        const val DEFAULT_BUDGET_BYTES = 8L * 1024 * 1024
+        const val DEFAULT_HEAD_MILLIS = 500
+
+        init {
+            System.loadLibrary("soundsource")
+        }
+    }
+}
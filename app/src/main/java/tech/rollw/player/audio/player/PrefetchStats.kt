@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+package tech.rollw.player.audio.player
+
+import androidx.annotation.Keep
+
+/**
+ * Snapshot of the state of a [PlaybackPrefetcher].
+ *
+ * @author RollW
+ */
+@Keep
+class PrefetchStats(
+    /**
+     * Track changes that found the track prefetched.
+     */
+    val hits: Long,
+    val misses: Long,
+    /**
+     * Entries dropped for the budget or because they left the queue.
+     */
+    val evictions: Long,
+    val entries: Int,
+    /**
+     * Bytes of decoded audio held.
+     */
+    val bytes: Long,
+    /**
+     * Mean time spent opening, parsing and decoding ahead of the hits,
+     * off the track change.
+     */
+    val meanSavedNanos: Long
+)
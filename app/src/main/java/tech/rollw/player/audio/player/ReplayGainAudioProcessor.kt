@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package tech.rollw.player.audio.player
+
+import androidx.annotation.OptIn
+import androidx.media3.common.C
+import androidx.media3.common.audio.AudioProcessor.AudioFormat
+import androidx.media3.common.audio.AudioProcessor.UnhandledAudioFormatException
+import androidx.media3.common.audio.BaseAudioProcessor
+import androidx.media3.common.util.UnstableApi
+import java.nio.ByteBuffer
+
+/**
+ * Applies the ReplayGain of the playing audio, with a native
+ * look-ahead peak limiter keeping positive gains from clipping.
+ *
+ * Accepts 16-bit and float PCM. The limiter stays in for the whole
+ * stream, so gain changes never restart it midway. Its look-ahead delay
+ * is primed with the head of the stream: the silence it starts with is
+ * dropped and the tail is drained at the end of stream, so the output
+ * has as many frames as the input, as gapless playback needs. At 0 dB
+ * the limiter holds off and the audio is copied through unchanged.
+ *
+ * The gain is bound to the stream the audio sink configures the
+ * processor for, not to the item the player reports as playing,
+ * which changes only once the previous stream has been played out.
+ * A configure with no audio queued since the last flush is for the
+ * item the player is positioned on (a start, a seek or a new
+ * playlist), any other one is for the next item of a gapless
+ * transition. Either way the gain takes effect on the flush that
+ * starts the stream.
+ *
+ * @author RollW
+ */
+@OptIn(UnstableApi::class)
+class ReplayGainAudioProcessor : BaseAudioProcessor() {
+    /**
+     * Turning ReplayGain on from [ReplayGainMode.OFF] takes effect
+     * from the next stream.
+     */
+    @Volatile
+    var mode: ReplayGainMode = ReplayGainMode.TRACK
+        set(value) {
+            field = value
+            updateGain()
+        }
+
+    /**
+     * Extra gain in dB applied on top of the ReplayGain.
+     */
+    @Volatile
+    var preamp: Double = 0.0
+        set(value) {
+            field = value
+            updateGain()
+        }
+
+    private class Gains(val trackGain: Double?, val albumGain: Double?)
+
+    @Volatile
+    private var currentGains: Gains? = null
+
+    @Volatile
+    private var nextGains: Gains? = null
+
+    // of the configured stream, applied at the next flush
+    private var pendingGains: Gains? = null
+
+    // of the playing stream
+    @Volatile
+    private var streamGains: Gains? = null
+
+    @Volatile
+    private var gain: Float = 0f
+
+    @Volatile
+    private var gainChanged = false
+
+    private var limiterEngaged = false
+    private var inputSinceFlush = false
+
+    // frames of the delay line silence still to drop from the output
+    private var primingFrames = 0
+
+    private var processorRef = 0L
+    private var processorFormat = AudioFormat.NOT_SET
+    private var floatEncoding = false
+
+    /**
+     * Set the ReplayGain values of the item the player is positioned
+     * on, called on every transition and seek.
+     */
+    fun setCurrentReplayGain(trackGain: Double?, albumGain: Double?) {
+        currentGains = Gains(trackGain, albumGain)
+    }
+
+    /**
+     * Set the ReplayGain values of the item played after the
+     * current one.
+     */
+    fun setNextReplayGain(trackGain: Double?, albumGain: Double?) {
+        nextGains = Gains(trackGain, albumGain)
+    }
+
+    private fun gainOf(gains: Gains?): Float {
+        val replayGain = when (mode) {
+            ReplayGainMode.OFF -> return 0f
+            ReplayGainMode.TRACK -> gains?.trackGain
+            ReplayGainMode.ALBUM -> gains?.albumGain ?: gains?.trackGain
+        }
+        return ((replayGain ?: 0.0) + preamp).toFloat()
+    }
+
+    private fun updateGain() {
+        gain = gainOf(streamGains)
+        gainChanged = true
+    }
+
+    override fun onConfigure(inputAudioFormat: AudioFormat): AudioFormat {
+        if (inputAudioFormat.encoding != C.ENCODING_PCM_16BIT &&
+            inputAudioFormat.encoding != C.ENCODING_PCM_FLOAT
+        ) {
+            throw UnhandledAudioFormatException(inputAudioFormat)
+        }
+        pendingGains = if (inputSinceFlush) nextGains else currentGains
+        if (mode == ReplayGainMode.OFF) {
+            return AudioFormat.NOT_SET
+        }
+        return inputAudioFormat
+    }
+
+    override fun queueInput(inputBuffer: ByteBuffer) {
+        val size = inputBuffer.remaining()
+        if (size == 0) {
+            return
+        }
+        inputSinceFlush = true
+        if (gainChanged) {
+            gainChanged = false
+            setGain(processorRef, gain)
+        }
+        val output = replaceOutputBuffer(size)
+        output.put(inputBuffer)
+        output.flip()
+        processPrimed(output)
+    }
+
+    override fun onQueueEndOfStream() {
+        if (!limiterEngaged) {
+            return
+        }
+        // push the tail out of the delay line with silence
+        val size = getLatencyFrames(processorRef) * inputAudioFormat.bytesPerFrame
+        if (size == 0) {
+            return
+        }
+        val output = replaceOutputBuffer(size)
+        repeat(size) { output.put(0) }
+        output.flip()
+        processPrimed(output)
+    }
+
+    /**
+     * Limit the frames of the buffer in place and skip the ones still
+     * holding the silence the delay line started with.
+     */
+    private fun processPrimed(output: ByteBuffer) {
+        val bytesPerFrame = inputAudioFormat.bytesPerFrame
+        val frames = output.remaining() / bytesPerFrame
+        process(processorRef, output, frames, floatEncoding)
+        val skipped = minOf(primingFrames, frames)
+        primingFrames -= skipped
+        output.position(skipped * bytesPerFrame)
+    }
+
+    override fun onFlush() {
+        inputSinceFlush = false
+        streamGains = pendingGains
+        gain = gainOf(streamGains)
+        gainChanged = false
+        limiterEngaged = false
+        if (isActive) {
+            engageLimiter()
+        }
+    }
+
+    private fun engageLimiter() {
+        floatEncoding = inputAudioFormat.encoding == C.ENCODING_PCM_FLOAT
+        if (processorRef == 0L || processorFormat != inputAudioFormat) {
+            if (processorRef != 0L) {
+                releaseProcessor(processorRef)
+            }
+            processorRef = createProcessor(
+                inputAudioFormat.channelCount,
+                inputAudioFormat.sampleRate
+            )
+            processorFormat = inputAudioFormat
+        }
+        setGain(processorRef, gain)
+        // after the gain, so the stream starts at it instead of ramping
+        resetProcessor(processorRef)
+        primingFrames = getLatencyFrames(processorRef)
+        limiterEngaged = true
+    }
+
+    override fun onReset() {
+        if (processorRef != 0L) {
+            releaseProcessor(processorRef)
+            processorRef = 0L
+        }
+        processorFormat = AudioFormat.NOT_SET
+        limiterEngaged = false
+        inputSinceFlush = false
+        primingFrames = 0
+    }
+
+    private external fun createProcessor(channels: Int, sampleRate: Int): Long
+
+    private external fun releaseProcessor(processorRef: Long)
+
+    private external fun setGain(processorRef: Long, gainDb: Float)
+
+    private external fun resetProcessor(processorRef: Long)
+
+    private external fun getLatencyFrames(processorRef: Long): Int
+
+    private external fun process(
+        processorRef: Long,
+        buffer: ByteBuffer,
+        frames: Int,
+        floatEncoding: Boolean
+    )
+
+    companion object {
+        init {
+            System.loadLibrary("soundsource")
+        }
+    }
+}
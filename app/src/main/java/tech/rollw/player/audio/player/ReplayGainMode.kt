@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package tech.rollw.player.audio.player
+
+/**
+ * Which ReplayGain value is applied on playback.
+ *
+ * @author RollW
+ */
+enum class ReplayGainMode(
+    /**
+     * The value stored by [tech.rollw.player.data.setting.AudioSettings.ReplayGainMode].
+     */
+    val value: String
+) {
+    OFF("off"),
+    TRACK("track"),
+
+    /**
+     * Album gain, falls back to the track gain if the
+     * album gain is not available.
+     */
+    ALBUM("album"),
+    ;
+
+    companion object {
+        fun fromValue(value: String?): ReplayGainMode =
+            entries.firstOrNull { it.value == value } ?: TRACK
+    }
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package tech.rollw.player.audio.player
+
+import androidx.annotation.OptIn
+import androidx.media3.common.C
+import androidx.media3.common.audio.AudioProcessor.AudioFormat
+import androidx.media3.common.audio.AudioProcessor.UnhandledAudioFormatException
+import androidx.media3.common.audio.BaseAudioProcessor
+import androidx.media3.common.util.UnstableApi
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Resamples the audio to the output sample rate of the device with a
+ * native polyphase FIR resampler, so the platform does not resample
+ * with its own fixed quality.
+ *
+ * Inactive if the input already has the output sample rate, or the
+ * ratio of the two rates is not supported.
+ *
+ * @param outputSampleRate the native sample rate of the output device,
+ * or 0 to disable resampling.
+ * @author RollW
+ */
+@OptIn(UnstableApi::class)
+class ResamplerAudioProcessor(
+    private val outputSampleRate: Int,
+    private val quality: ResamplerQuality = ResamplerQuality.HIGH
+) : BaseAudioProcessor() {
+    private var resamplerRef = 0L
+    private var floatEncoding = false
+    private var stagingBuffer: ByteBuffer = EMPTY_BUFFER
+
+    override fun onConfigure(inputAudioFormat: AudioFormat): AudioFormat {
+        if (inputAudioFormat.encoding != C.ENCODING_PCM_16BIT &&
+            inputAudioFormat.encoding != C.ENCODING_PCM_FLOAT
+        ) {
+            throw UnhandledAudioFormatException(inputAudioFormat)
+        }
+        if (outputSampleRate <= 0 || inputAudioFormat.sampleRate == outputSampleRate ||
+            !isSupported(inputAudioFormat.sampleRate, outputSampleRate)
+        ) {
+            return AudioFormat.NOT_SET
+        }
+        return AudioFormat(
+            outputSampleRate,
+            inputAudioFormat.channelCount,
+            inputAudioFormat.encoding
+        )
+    }
+
+    override fun queueInput(inputBuffer: ByteBuffer) {
+        val size = inputBuffer.remaining()
+        if (size == 0) {
+            return
+        }
+        val frames = size / inputAudioFormat.bytesPerFrame
+        val input = if (inputBuffer.isDirect) {
+            inputBuffer
+        } else {
+            stageInput(inputBuffer)
+        }
+        val output = replaceOutputBuffer(
+            getMaxOutputFrames(resamplerRef, frames) * outputAudioFormat.bytesPerFrame
+        )
+        val written = process(
+            resamplerRef, input, input.position(),
+            frames, output, floatEncoding
+        )
+        inputBuffer.position(inputBuffer.position() + frames * inputAudioFormat.bytesPerFrame)
+        output.position(written * outputAudioFormat.bytesPerFrame)
+        output.flip()
+    }
+
+    override fun onQueueEndOfStream() {
+        // push out the filter tail
+        val frames = getDelayFrames(resamplerRef)
+        if (frames == 0) {
+            return
+        }
+        val input = ByteBuffer.allocateDirect(frames * inputAudioFormat.bytesPerFrame)
+            .order(ByteOrder.nativeOrder())
+        val output = replaceOutputBuffer(
+            getMaxOutputFrames(resamplerRef, frames) * outputAudioFormat.bytesPerFrame
+        )
+        val written = process(resamplerRef, input, 0, frames, output, floatEncoding)
+        output.position(written * outputAudioFormat.bytesPerFrame)
+        output.flip()
+    }
+
+    override fun onFlush() {
+        if (resamplerRef != 0L) {
+            releaseResampler(resamplerRef)
+        }
+        floatEncoding = inputAudioFormat.encoding == C.ENCODING_PCM_FLOAT
+        resamplerRef = createResampler(
+            inputAudioFormat.channelCount,
+            inputAudioFormat.sampleRate,
+            outputSampleRate,
+            quality.ordinal
+        )
+    }
+
+    override fun onReset() {
+        if (resamplerRef != 0L) {
+            releaseResampler(resamplerRef)
+            resamplerRef = 0L
+        }
+        stagingBuffer = EMPTY_BUFFER
+    }
+
+    private fun stageInput(inputBuffer: ByteBuffer): ByteBuffer {
+        val size = inputBuffer.remaining()
+        if (stagingBuffer.capacity() < size) {
+            stagingBuffer = ByteBuffer.allocateDirect(size)
+                .order(ByteOrder.nativeOrder())
+        }
+        stagingBuffer.clear()
+        stagingBuffer.put(inputBuffer.duplicate())
+        stagingBuffer.flip()
+        return stagingBuffer
+    }
+
+    private external fun createResampler(
+        channels: Int,
+        inputRate: Int,
+        outputRate: Int,
+        quality: Int
+    ): Long
+
+    private external fun releaseResampler(resamplerRef: Long)
+
+    private external fun isSupported(inputRate: Int, outputRate: Int): Boolean
+
+    private external fun getMaxOutputFrames(resamplerRef: Long, frames: Int): Int
+
+    private external fun getDelayFrames(resamplerRef: Long): Int
+
+    private external fun process(
+        resamplerRef: Long,
+        input: ByteBuffer,
+        inputOffset: Int,
+        frames: Int,
+        output: ByteBuffer,
+        floatEncoding: Boolean
+    ): Int
+
+    companion object {
+        private val EMPTY_BUFFER: ByteBuffer = ByteBuffer.allocateDirect(0)
+
+        init {
+            System.loadLibrary("soundsource")
+        }
+    }
+}
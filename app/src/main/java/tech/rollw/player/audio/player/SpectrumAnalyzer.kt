@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+package tech.rollw.player.audio.player
+
+import androidx.annotation.OptIn
+import androidx.media3.common.C
+import androidx.media3.common.util.UnstableApi
+import androidx.media3.exoplayer.audio.TeeAudioProcessor
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Spectrum analyser tapping the audio after all other processors,
+ * through a [TeeAudioProcessor].
+ *
+ * The playback thread feeds it, the UI polls [read] once per frame;
+ * the levels are handed over lock-free so neither side ever waits
+ * for the other. Analysis is skipped while [enabled] is false.
+ *
+ * Levels are in dBFS from [FLOOR_DB] to 0, for [bandCount] bands
+ * spaced logarithmically from 20 Hz to 20 kHz.
+ *
+ * Only one thread may call [read]. The native analyzer lives as long
+ * as the process, share one instance as an application service.
+ *
+ * @author RollW
+ */
+@OptIn(UnstableApi::class)
+class SpectrumAnalyzer(
+    fftSize: Int = DEFAULT_FFT_SIZE,
+    bandCount: Int = DEFAULT_BAND_COUNT
+) : TeeAudioProcessor.AudioBufferSink {
+    private val analyzerRef = createAnalyzer(fftSize, bandCount)
+
+    /**
+     * The actual band count, at most a quarter of the FFT size.
+     */
+    val bandCount: Int = getBandCount(analyzerRef)
+
+    /**
+     * Whether the audio is analyzed, enable while the spectrum
+     * is shown.
+     */
+    @Volatile
+    var enabled = false
+
+    private var supported = false
+    private var floatEncoding = false
+    private var bytesPerFrame = 0
+    private var stagingBuffer: ByteBuffer = EMPTY_BUFFER
+
+    override fun flush(sampleRateHz: Int, channelCount: Int, encoding: Int) {
+        supported = encoding == C.ENCODING_PCM_16BIT || encoding == C.ENCODING_PCM_FLOAT
+        floatEncoding = encoding == C.ENCODING_PCM_FLOAT
+        bytesPerFrame = channelCount * if (floatEncoding) 4 else 2
+        configure(analyzerRef, channelCount, if (supported) sampleRateHz else 0)
+    }
+
+    override fun handleBuffer(buffer: ByteBuffer) {
+        if (!enabled || !supported) {
+            return
+        }
+        val frames = buffer.remaining() / bytesPerFrame
+        if (frames == 0) {
+            return
+        }
+        val input = if (buffer.isDirect) buffer else stageInput(buffer)
+        process(analyzerRef, input, input.position(), frames, floatEncoding)
+    }
+
+    /**
+     * Copy the latest levels, never blocks.
+     *
+     * @param bands receives [bandCount] levels in dBFS.
+     * @return true if the levels changed since the last call.
+     */
+    fun read(bands: FloatArray): Boolean = readBands(analyzerRef, bands)
+
+    private fun stageInput(buffer: ByteBuffer): ByteBuffer {
+        val size = buffer.remaining()
+        if (stagingBuffer.capacity() < size) {
+            stagingBuffer = ByteBuffer.allocateDirect(size)
+                .order(ByteOrder.nativeOrder())
+        }
+        stagingBuffer.clear()
+        stagingBuffer.put(buffer.duplicate())
+        stagingBuffer.flip()
+        return stagingBuffer
+    }
+
+    private external fun createAnalyzer(fftSize: Int, bandCount: Int): Long
+
+    private external fun getBandCount(analyzerRef: Long): Int
+
+    private external fun configure(analyzerRef: Long, channels: Int, sampleRate: Int)
+
+    private external fun process(
+        analyzerRef: Long,
+        buffer: ByteBuffer,
+        offset: Int,
+        frames: Int,
+        floatEncoding: Boolean
+    )
+
+    private external fun readBands(analyzerRef: Long, bands: FloatArray): Boolean
+
+    companion object {
+        const val DEFAULT_FFT_SIZE = 2048
+        const val DEFAULT_BAND_COUNT = 32
+
+        /**
+         * The lowest level reported for a band.
+         */
+        const val FLOOR_DB = -96f
+
+        private val EMPTY_BUFFER: ByteBuffer = ByteBuffer.allocateDirect(0)
+
+        init {
+            System.loadLibrary("soundsource")
+        }
+    }
+}
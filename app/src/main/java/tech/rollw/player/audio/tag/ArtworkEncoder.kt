@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+package tech.rollw.player.audio.tag
+
+import android.graphics.Bitmap
+import android.graphics.BitmapFactory
+import android.graphics.Canvas
+import android.graphics.Color
+import android.graphics.Matrix
+import android.media.ExifInterface
+import tech.rollw.player.util.ImageUtils
+import java.io.ByteArrayInputStream
+import java.io.ByteArrayOutputStream
+import java.io.IOException
+
+/**
+ * Caps the size of covers before they are embedded.
+ *
+ * The cover is identified natively from its header. Only a cover over
+ * [Limits.maxDimension] or [Limits.maxBytes] is decoded, turned upright
+ * by its EXIF orientation, downscaled by [ImageUtils.scale] and
+ * re-encoded to JPEG. While the JPEG is still over [Limits.maxBytes],
+ * the quality is lowered step by step down to [MIN_QUALITY], then the
+ * dimensions down to [MIN_DIMENSION].
+ *
+ * @author RollW
+ */
+object ArtworkEncoder {
+    const val DEFAULT_MAX_DIMENSION = 1200
+
+    const val DEFAULT_MAX_BYTES = 512 * 1024L
+
+    const val DEFAULT_QUALITY = 90
+
+    /**
+     * The lowest JPEG quality tried before the dimensions are reduced.
+     */
+    const val MIN_QUALITY = 60
+
+    /**
+     * The shortest side a cover is reduced to for the byte budget.
+     */
+    const val MIN_DIMENSION = 300
+
+    private const val QUALITY_STEP = 10
+
+    private const val DIMENSION_STEP = 0.8
+
+    /**
+     * @param maxDimension the longest side of an embedded cover,
+     * 0 for no limit.
+     * @param maxBytes the size of an embedded cover, 0 for no limit.
+     * @param quality the JPEG quality of re-encoded covers.
+     */
+    data class Limits(
+        val maxDimension: Int = DEFAULT_MAX_DIMENSION,
+        val maxBytes: Long = DEFAULT_MAX_BYTES,
+        val quality: Int = DEFAULT_QUALITY
+    )
+
+    /**
+     * Fit the cover in [limits].
+     *
+     * Blocks the calling thread while decoding and encoding, should be
+     * called from a worker thread.
+     *
+     * @return the re-encoded cover, or [artwork] itself if it is within
+     * the limits, or over [Limits.maxDimension] only and cannot be
+     * decoded.
+     * @throws IllegalArgumentException if the cover is over
+     * [Limits.maxBytes] and cannot be decoded, or does not fit even at
+     * [MIN_QUALITY] and [MIN_DIMENSION].
+     */
+    fun encode(artwork: ByteArray, limits: Limits = Limits()): ByteArray {
+        val target = ImageUtils.getArtworkTargetSize(
+            artwork, limits.maxDimension, limits.maxBytes
+        ) ?: return artwork
+        val overBudget = limits.maxBytes > 0 && artwork.size > limits.maxBytes
+        val decoded = decodeUpright(artwork, target[0], target[1])
+        if (decoded == null) {
+            if (overBudget) {
+                throw IllegalArgumentException("Cover cannot be decoded to fit ${limits.maxBytes} bytes.")
+            }
+            return artwork
+        }
+        var bitmap: Bitmap = decoded
+        if (decoded.hasAlpha()) {
+            // JPEG has no alpha, flatten onto white rather than black
+            bitmap = Bitmap.createBitmap(decoded.width, decoded.height, Bitmap.Config.ARGB_8888)
+            Canvas(bitmap).apply {
+                drawColor(Color.WHITE)
+                drawBitmap(decoded, 0f, 0f, null)
+            }
+            decoded.recycle()
+        }
+
+        var quality = limits.quality
+        var encoded = compress(bitmap, quality)
+        while (limits.maxBytes > 0 && encoded.size > limits.maxBytes) {
+            if (quality > MIN_QUALITY) {
+                quality = maxOf(quality - QUALITY_STEP, MIN_QUALITY)
+            } else {
+                val width = (bitmap.width * DIMENSION_STEP).toInt()
+                val height = (bitmap.height * DIMENSION_STEP).toInt()
+                if (minOf(width, height) < MIN_DIMENSION) {
+                    bitmap.recycle()
+                    throw IllegalArgumentException("Cover does not fit ${limits.maxBytes} bytes.")
+                }
+                bitmap = ImageUtils.scale(bitmap, width, height).also { bitmap.recycle() }
+            }
+            encoded = compress(bitmap, quality)
+        }
+        bitmap.recycle()
+        return encoded
+    }
+
+    /**
+     * Decode the cover, turned upright by its EXIF orientation and
+     * scaled to the target size, which is given in the stored
+     * orientation.
+     *
+     * @return null if the cover cannot be decoded.
+     */
+    private fun decodeUpright(artwork: ByteArray, width: Int, height: Int): Bitmap? {
+        val options = BitmapFactory.Options().apply {
+            inJustDecodeBounds = true
+        }
+        BitmapFactory.decodeByteArray(artwork, 0, artwork.size, options)
+        if (options.outWidth <= 0 || options.outHeight <= 0) {
+            return null
+        }
+        // let the decoder halve down to twice the target, which keeps
+        // the decoded bitmap small, the native filter does the rest
+        var sampleSize = 1
+        while (options.outWidth / (sampleSize * 2) >= width * 2 &&
+            options.outHeight / (sampleSize * 2) >= height * 2
+        ) {
+            sampleSize *= 2
+        }
+        options.inJustDecodeBounds = false
+        options.inSampleSize = sampleSize
+        options.inPreferredConfig = Bitmap.Config.ARGB_8888
+        val decoded = BitmapFactory.decodeByteArray(artwork, 0, artwork.size, options)
+            ?: return null
+
+        // orient before scaling, the target then only swaps its sides
+        val orientation = readOrientation(artwork)
+        val matrix = orientationMatrix(orientation)
+        val upright = if (matrix == null) {
+            decoded
+        } else {
+            Bitmap.createBitmap(decoded, 0, 0, decoded.width, decoded.height, matrix, true)
+                .also { if (it !== decoded) decoded.recycle() }
+        }
+        val transposed = orientation == ExifInterface.ORIENTATION_TRANSPOSE ||
+                orientation == ExifInterface.ORIENTATION_ROTATE_90 ||
+                orientation == ExifInterface.ORIENTATION_TRANSVERSE ||
+                orientation == ExifInterface.ORIENTATION_ROTATE_270
+        val targetWidth = if (transposed) height else width
+        val targetHeight = if (transposed) width else height
+        if (upright.width == targetWidth && upright.height == targetHeight) {
+            return upright
+        }
+        return ImageUtils.scale(upright, targetWidth, targetHeight).also { upright.recycle() }
+    }
+
+    private fun readOrientation(artwork: ByteArray): Int = try {
+        ExifInterface(ByteArrayInputStream(artwork)).getAttributeInt(
+            ExifInterface.TAG_ORIENTATION, ExifInterface.ORIENTATION_NORMAL
+        )
+    } catch (e: IOException) {
+        ExifInterface.ORIENTATION_NORMAL
+    }
+
+    private fun orientationMatrix(orientation: Int): Matrix? {
+        val matrix = Matrix()
+        when (orientation) {
+            ExifInterface.ORIENTATION_FLIP_HORIZONTAL -> matrix.setScale(-1f, 1f)
+            ExifInterface.ORIENTATION_ROTATE_180 -> matrix.setRotate(180f)
+            ExifInterface.ORIENTATION_FLIP_VERTICAL -> matrix.setScale(1f, -1f)
+            ExifInterface.ORIENTATION_TRANSPOSE -> {
+                matrix.setRotate(90f)
+                matrix.postScale(-1f, 1f)
+            }
+
+            ExifInterface.ORIENTATION_ROTATE_90 -> matrix.setRotate(90f)
+            ExifInterface.ORIENTATION_TRANSVERSE -> {
+                matrix.setRotate(-90f)
+                matrix.postScale(-1f, 1f)
+            }
+
+            ExifInterface.ORIENTATION_ROTATE_270 -> matrix.setRotate(-90f)
+            else -> return null
+        }
+        return matrix
+    }
+
+    private fun compress(bitmap: Bitmap, quality: Int): ByteArray =
+        ByteArrayOutputStream().use {
+            bitmap.compress(Bitmap.CompressFormat.JPEG, quality, it)
+            it.toByteArray()
+        }
+}
@@ -64,6 +64,10 @@ interface AudioTag : Closeable {
     /**
      * After called [setTagField], the tag will not
      * be saved until [save] is called.
+     *
+     * All changes since the last save are written at once, with a
+     * single write to the file. Closing the tag without saving drops
+     * them.
      */
     fun save()
 
@@ -26,6 +26,7 @@ enum class AudioTagField {
     ARTIST,
     ARRANGER,
     BPM,
+    INITIAL_KEY("INITIALKEY"),
     COMPOSER,
     CONDUCTOR,
     LYRICIST,
@@ -38,6 +39,10 @@ enum class AudioTagField {
     COPYRIGHT,
     LABEL,
     LANGUAGE,
+    REPLAYGAIN_TRACK_GAIN,
+    REPLAYGAIN_TRACK_PEAK,
+    REPLAYGAIN_ALBUM_GAIN,
+    REPLAYGAIN_ALBUM_PEAK,
     ;
 
     val value: String
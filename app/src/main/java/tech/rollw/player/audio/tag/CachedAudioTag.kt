@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package tech.rollw.player.audio.tag
+
+import tech.rollw.player.audio.AudioFormatType
+
+/**
+ * Read-only [AudioTag] of fields read ahead, from a [ScanCache]
+ * entry or by [ScanStringTable.readFields]. Has no artwork.
+ *
+ * @author RollW
+ */
+class CachedAudioTag(
+    override val audioFormatType: AudioFormatType,
+    private val fields: Map<AudioTagField, String?>,
+    private val audioProperties: AudioProperties,
+    private val size: Long,
+    private val lastModified: Long
+) : AudioTag {
+    override fun getTagField(field: AudioTagField): String? = fields[field]
+
+    override fun getArtwork(includeData: Boolean): Artwork? = null
+
+    override fun getAudioProperties(): AudioProperties = audioProperties
+
+    override fun getLastModified(): Long = lastModified
+
+    override fun getSize(): Long = size
+
+    override fun setTagField(field: AudioTagField, value: String?) {
+        throw UnsupportedOperationException("Cached tags are read-only.")
+    }
+
+    override fun setArtwork(artwork: ByteArray?) {
+        throw UnsupportedOperationException("Cached tags are read-only.")
+    }
+
+    override fun save() {
+        throw UnsupportedOperationException("Cached tags are read-only.")
+    }
+
+    override fun close() {
+    }
+}
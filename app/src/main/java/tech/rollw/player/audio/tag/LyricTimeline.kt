@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package tech.rollw.player.audio.tag
+
+import androidx.annotation.Keep
+
+/**
+ * Flat timeline of timed lyrics, built by [NativeLyricParser].
+ *
+ * Lines are sorted by timestamp, lines without a timestamp
+ * ([LyricRow.INVALID_TIMESTAMP]) first, so the line at a playback
+ * position is a binary search away. Enhanced LRC word timings are
+ * kept per line for karaoke highlighting.
+ *
+ * @author RollW
+ */
+@Keep
+class LyricTimeline(
+    /**
+     * Timestamp of each line in milliseconds, with the offset applied.
+     */
+    val timestamps: LongArray,
+    val texts: Array<String>,
+    /**
+     * Index of the first word of each line, lines repeated at several
+     * timestamps share their words.
+     */
+    private val firstWords: IntArray,
+    private val wordCounts: IntArray,
+    private val wordTimestamps: LongArray,
+    /**
+     * Start of each word in the text of its line, a word runs to the
+     * start of the next one.
+     */
+    private val wordOffsets: IntArray,
+    /**
+     * ID tags, id and value one after another.
+     */
+    private val tags: Array<String>,
+    /**
+     * The offset of the lyrics in milliseconds.
+     */
+    val offset: Long
+) {
+    val size: Int
+        get() = timestamps.size
+
+    /**
+     * Get the line shown at the position.
+     *
+     * @return the index of the last line starting at or before the
+     * position, -1 if none has started.
+     */
+    fun lineAt(position: Long): Int {
+        var low = 0
+        var high = timestamps.size - 1
+        while (low <= high) {
+            val mid = (low + high) ushr 1
+            if (timestamps[mid] <= position) {
+                low = mid + 1
+            } else {
+                high = mid - 1
+            }
+        }
+        if (high < 0 || timestamps[high] == LyricRow.INVALID_TIMESTAMP) {
+            return -1
+        }
+        return high
+    }
+
+    /**
+     * Get the range of the line's text sung at the position.
+     *
+     * @return the range in [texts] of the line, null if the line
+     * has no word timings or none has started.
+     */
+    fun wordAt(line: Int, position: Long): IntRange? {
+        if (line !in timestamps.indices) {
+            return null
+        }
+        val first = firstWords[line]
+        val end = first + wordCounts[line]
+        // the words of a line are sorted by timestamp
+        var low = first
+        var high = end - 1
+        while (low <= high) {
+            val mid = (low + high) ushr 1
+            if (wordTimestamps[mid] <= position) {
+                low = mid + 1
+            } else {
+                high = mid - 1
+            }
+        }
+        if (high < first) {
+            return null
+        }
+        val word = high
+        val next = if (word + 1 < end) wordOffsets[word + 1] else texts[line].length
+        return wordOffsets[word] until next
+    }
+
+    /**
+     * Convert to [Lyric], lines of the same timestamp become one row.
+     */
+    fun toLyric(): Lyric {
+        val header = (tags.indices step 2).map { LyricTag(tags[it], tags[it + 1]) }
+        val rows = mutableListOf<LyricRow>()
+        timestamps.forEachIndexed { index, timestamp ->
+            val last = rows.lastOrNull()
+            if (last != null && timestamp != LyricRow.INVALID_TIMESTAMP &&
+                last.timestamp == timestamp
+            ) {
+                last += texts[index]
+            } else {
+                rows.add(LyricRow(texts[index], timestamp, texts[index]))
+            }
+        }
+        return Lyric(header, rows)
+    }
+}
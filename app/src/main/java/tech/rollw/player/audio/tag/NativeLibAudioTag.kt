@@ -21,17 +21,21 @@ import tech.rollw.support.io.ImageFormatType
 import java.io.IOException
 
 /**
+ * @param windowed read the file through large buffered windows, which
+ * saves the many small reads of parsing tags. Only applies to [readonly]
+ * tags, suited to scans.
  * @author RollW
  */
 class NativeLibAudioTag(
     private val fileDescriptor: Int,
     override val audioFormatType: AudioFormatType,
-    val readonly: Boolean = false
+    val readonly: Boolean = false,
+    windowed: Boolean = false
 ) : AudioTag {
     /**
      * Native reference to the tag.
      */
-    private val accessorRef: Long = openFileCheck(fileDescriptor, readonly)
+    internal val accessorRef: Long = openFileCheck(fileDescriptor, readonly, windowed)
 
     private var closed = false
     private lateinit var audioProperties: AudioProperties
@@ -77,6 +81,7 @@ class NativeLibAudioTag(
         return getSize(accessorRef)
     }
 
+    @Throws(IOException::class)
     override fun save() {
         return saveFile(accessorRef)
     }
@@ -90,8 +95,8 @@ class NativeLibAudioTag(
     }
 
     @Throws(IOException::class)
-    private fun openFileCheck(fileDescriptor: Int, readonly: Boolean): Long {
-        val fileRef = openFile(fileDescriptor, readonly)
+    private fun openFileCheck(fileDescriptor: Int, readonly: Boolean, windowed: Boolean): Long {
+        val fileRef = openFile(fileDescriptor, readonly, windowed, audioFormatType.ordinal)
         if (fileRef == 0L) {
             throw IOException("Cannot open file.")
         }
@@ -122,7 +127,12 @@ class NativeLibAudioTag(
     }
 
     @Throws(IOException::class)
-    private external fun openFile(accessorRef: Int, readonly: Boolean): Long
+    private external fun openFile(
+        accessorRef: Int,
+        readonly: Boolean,
+        windowed: Boolean,
+        formatType: Int
+    ): Long
 
     private external fun closeFile(accessorRef: Long)
 
@@ -141,6 +151,7 @@ class NativeLibAudioTag(
 
     private external fun setArtwork(accessorRef: Long, artwork: ByteArray?)
 
+    @Throws(IOException::class)
     private external fun saveFile(accessorRef: Long)
 
     private external fun getAudioProperties(accessorRef: Long): AudioProperties
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package tech.rollw.player.audio.tag
+
+import androidx.annotation.Keep
+
+/**
+ * Native single pass LRC parser, handles ID tags, the offset and
+ * enhanced LRC word timings.
+ *
+ * @author RollW
+ */
+@Keep
+object NativeLyricParser {
+    init {
+        System.loadLibrary("soundsource")
+    }
+
+    /**
+     * Parse LRC text. Lines that are not LRC are kept as lines
+     * without a timestamp, so plain lyrics parse too.
+     */
+    fun parse(lyric: String): LyricTimeline = parseLyric(lyric)!!
+
+    /**
+     * Read the lyrics embedded in the tag straight from its frames:
+     * ID3v2 SYLT (with their timings) and USLT, Xiph and APE LYRICS,
+     * MP4 ©lyr and WM/Lyrics, without going through the properties
+     * of the tag.
+     *
+     * @return the lyrics, or null if the tag has none.
+     */
+    fun read(audioTag: NativeLibAudioTag): LyricTimeline? =
+        readLyric(audioTag.accessorRef)
+
+    private external fun parseLyric(lyric: String): LyricTimeline?
+
+    private external fun readLyric(accessorRef: Long): LyricTimeline?
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package tech.rollw.player.audio.tag
+
+import android.content.Context
+import tech.rollw.player.audio.AudioFormatType
+import java.io.Closeable
+import java.io.File
+
+/**
+ * Tags and audio properties of the files seen by the last scan, keyed
+ * by the audio identifier, size and last modified time, so a rescan
+ * only parses files that changed.
+ *
+ * The previous cache is mapped read-only for [validate] and [read];
+ * entries of this scan are collected with [put] and [keep] and written
+ * as the new cache by [save], so files that disappeared drop out.
+ * All methods but [save] and [close] may be called concurrently.
+ *
+ * Strings go through the [ScanStringTable] of the scan, which must
+ * be created with [FIELDS] and outlive the cache.
+ *
+ * @author RollW
+ */
+class ScanCache private constructor(
+    private val file: File,
+    private val stringTable: ScanStringTable
+) : Closeable {
+    private val cacheRef: Long = openCache(file.path, KEYS)
+    private val writerRef: Long = createWriter(KEYS, stringTable.tableRef)
+
+    private var closed = false
+
+    /**
+     * Check the files against the cache with one native call.
+     *
+     * @param fileDescriptors open descriptors of the files, in the
+     * order of the identifiers.
+     * @return the last modified time of every unchanged file, -1 for
+     * files that changed or are not cached.
+     */
+    fun validate(identifiers: Array<String>, fileDescriptors: IntArray): LongArray {
+        return validate(cacheRef, identifiers, fileDescriptors)
+            ?: LongArray(identifiers.size) { -1 }
+    }
+
+    /**
+     * Check the files against the cache by the size and last modified
+     * time their document provider reports, without opening them.
+     * A provider may round the time differently from the file system,
+     * so files that do not match are checked again by [validate] with
+     * their descriptors.
+     *
+     * @return the last modified time of every matching file, -1 for
+     * the others.
+     */
+    fun validate(identifiers: Array<String>, sizes: LongArray, lastModified: LongArray): LongArray {
+        return validateStats(cacheRef, identifiers, sizes, lastModified)
+            ?: LongArray(identifiers.size) { -1 }
+    }
+
+    /**
+     * Read the cached tag of the file, see [validate] for whether it
+     * is still up to date.
+     */
+    fun read(identifier: String, audioFormatType: AudioFormatType): AudioTag? {
+        val entry = readEntry(cacheRef, stringTable.tableRef, identifier) ?: return null
+        return stringTable.toAudioTag(
+            entry.values,
+            audioFormatType,
+            entry.properties,
+            entry.size,
+            entry.lastModified
+        )
+    }
+
+    /**
+     * Add the parsed tag of the file to the new cache.
+     *
+     * @param fieldIds the values of [FIELDS] read by
+     * [ScanStringTable.readFields].
+     */
+    fun put(identifier: String, audioTag: NativeLibAudioTag, fieldIds: IntArray): Boolean {
+        return put(writerRef, identifier, audioTag.accessorRef, fieldIds)
+    }
+
+    /**
+     * Carry the entry of an unchanged file over to the new cache.
+     */
+    fun keep(identifier: String): Boolean {
+        return keep(writerRef, cacheRef, identifier)
+    }
+
+    /**
+     * Replace the cache file with the entries of this scan.
+     */
+    fun save(): Boolean {
+        file.parentFile?.mkdirs()
+        return write(writerRef, file.path)
+    }
+
+    override fun close() {
+        if (closed) {
+            return
+        }
+        closed = true
+        releaseCache(cacheRef)
+        releaseWriter(writerRef)
+    }
+
+    internal data class Entry(
+        val values: IntArray,
+        val properties: AudioProperties,
+        val size: Long,
+        val lastModified: Long
+    ) {
+        override fun equals(other: Any?): Boolean {
+            if (this === other) return true
+            if (other !is Entry) return false
+            return values.contentEquals(other.values) &&
+                    properties == other.properties &&
+                    size == other.size &&
+                    lastModified == other.lastModified
+        }
+
+        override fun hashCode(): Int {
+            var result = values.contentHashCode()
+            result = 31 * result + properties.hashCode()
+            result = 31 * result + size.hashCode()
+            result = 31 * result + lastModified.hashCode()
+            return result
+        }
+    }
+
+    private external fun openCache(path: String, fieldKeys: Array<String>): Long
+
+    private external fun releaseCache(cacheRef: Long)
+
+    private external fun createWriter(fieldKeys: Array<String>, tableRef: Long): Long
+
+    private external fun releaseWriter(writerRef: Long)
+
+    private external fun validate(
+        cacheRef: Long,
+        identifiers: Array<String>,
+        fileDescriptors: IntArray
+    ): LongArray?
+
+    private external fun validateStats(
+        cacheRef: Long,
+        identifiers: Array<String>,
+        sizes: LongArray,
+        lastModified: LongArray
+    ): LongArray?
+
+    private external fun readEntry(cacheRef: Long, tableRef: Long, identifier: String): Entry?
+
+    private external fun put(
+        writerRef: Long,
+        identifier: String,
+        accessorRef: Long,
+        fieldIds: IntArray
+    ): Boolean
+
+    private external fun keep(writerRef: Long, cacheRef: Long, identifier: String): Boolean
+
+    private external fun write(writerRef: Long, path: String): Boolean
+
+    companion object {
+        init {
+            System.loadLibrary("soundsource")
+        }
+
+        /**
+         * Fields kept in the cache, those a scanned
+         * [tech.rollw.player.audio.Audio] is built from.
+         */
+        val FIELDS = listOf(
+            AudioTagField.TITLE,
+            AudioTagField.ARTIST,
+            AudioTagField.ALBUM,
+            AudioTagField.ALBUM_ARTIST,
+            AudioTagField.COMPOSER,
+            AudioTagField.LYRICIST,
+            AudioTagField.ARRANGER,
+            AudioTagField.TRACK_NUMBER,
+            AudioTagField.DISC_NUMBER,
+            AudioTagField.COPYRIGHT,
+            AudioTagField.DATE,
+            AudioTagField.GENRE,
+            AudioTagField.REPLAYGAIN_TRACK_GAIN,
+            AudioTagField.REPLAYGAIN_TRACK_PEAK,
+            AudioTagField.REPLAYGAIN_ALBUM_GAIN,
+            AudioTagField.REPLAYGAIN_ALBUM_PEAK,
+            AudioTagField.BPM,
+            AudioTagField.INITIAL_KEY,
+        )
+
+        private val KEYS = FIELDS.map { it.value }.toTypedArray()
+
+        /**
+         * Open the cache of audio scans.
+         */
+        fun open(context: Context, stringTable: ScanStringTable) =
+            ScanCache(File(context.cacheDir, "scan_cache.sssc"), stringTable)
+    }
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package tech.rollw.player.audio.tag
+
+import tech.rollw.player.audio.AudioFormatType
+import java.io.Closeable
+
+/**
+ * Native string table of a scan session. Tags are read as ids of
+ * the table, and each distinct string (an artist, album or genre
+ * shared by thousands of files) crosses JNI once and is then shared
+ * by every [AudioTag] that has it.
+ *
+ * Thread safe.
+ *
+ * @param fields the fields [readFields] reads.
+ * @author RollW
+ */
+class ScanStringTable(
+    val fields: List<AudioTagField>
+) : Closeable {
+    internal val tableRef: Long = createTable()
+    private val keyIds: IntArray = intern(tableRef, fields.map { it.value }.toTypedArray())
+
+    /**
+     * Strings handed over so far, by id.
+     */
+    private val strings = ArrayList<String>()
+
+    private var closed = false
+
+    /**
+     * Read the [fields] of the tag with one property map lookup.
+     *
+     * @return the string ids of the values, [NO_STRING] if absent.
+     */
+    fun readFields(audioTag: NativeLibAudioTag): IntArray {
+        return readFields(tableRef, audioTag.accessorRef, keyIds)
+            ?: IntArray(fields.size) { NO_STRING }
+    }
+
+    /**
+     * Get the strings of the ids, fetching the strings interned since
+     * the last call in one batch.
+     */
+    fun resolve(ids: IntArray): List<String?> {
+        val maxId = ids.maxOrNull() ?: return emptyList()
+        synchronized(strings) {
+            if (maxId >= strings.size) {
+                strings(tableRef, strings.size)?.let { strings.addAll(it) }
+            }
+            return ids.map { if (it < 0) null else strings.getOrNull(it) }
+        }
+    }
+
+    /**
+     * Build a read-only tag of field values read by [readFields].
+     */
+    fun toAudioTag(
+        ids: IntArray,
+        audioFormatType: AudioFormatType,
+        properties: AudioProperties,
+        size: Long,
+        lastModified: Long
+    ): AudioTag = CachedAudioTag(
+        audioFormatType,
+        fields.zip(resolve(ids)).toMap(),
+        properties,
+        size,
+        lastModified
+    )
+
+    /**
+     * Count of strings handed over.
+     */
+    val size: Int
+        get() = synchronized(strings) { strings.size }
+
+    override fun close() {
+        if (closed) {
+            return
+        }
+        closed = true
+        releaseTable(tableRef)
+    }
+
+    private external fun createTable(): Long
+
+    private external fun releaseTable(tableRef: Long)
+
+    private external fun intern(tableRef: Long, values: Array<String>): IntArray
+
+    private external fun readFields(tableRef: Long, accessorRef: Long, keyIds: IntArray): IntArray?
+
+    private external fun strings(tableRef: Long, from: Int): Array<String>?
+
+    companion object {
+        init {
+            System.loadLibrary("soundsource")
+        }
+
+        /**
+         * Id of an absent value.
+         */
+        const val NO_STRING = -1
+    }
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+package tech.rollw.player.audio.tag
+
+import androidx.annotation.Keep
+import tech.rollw.player.audio.AudioFormatType
+
+/**
+ * Applies the same tag changes to many files at once, on a small pool
+ * of native worker threads. Every file is saved with a single write,
+ * see [AudioTag.save].
+ *
+ * @author RollW
+ */
+@Keep
+object TagBatchEditor {
+    /**
+     * Files edited at the same time. The edits are small writes, more
+     * only queue up on the storage.
+     */
+    const val DEFAULT_CONCURRENCY = 2
+
+    init {
+        System.loadLibrary("soundsource")
+    }
+
+    /**
+     * Outcome of editing one file.
+     */
+    enum class Result {
+        SAVED,
+        OPEN_FAILED,
+        SAVE_FAILED,
+    }
+
+    /**
+     * A file to edit.
+     *
+     * @param fileDescriptor a read-write descriptor, owned and closed
+     * by the editor as with [NativeLibAudioTag].
+     */
+    data class Target(
+        val fileDescriptor: Int,
+        val audioFormatType: AudioFormatType
+    )
+
+    /**
+     * The changes made to every file, in the order given.
+     */
+    class Script {
+        internal val fields = mutableListOf<Pair<AudioTagField, String?>>()
+        internal var artwork: ByteArray? = null
+        internal var deleteArtwork = false
+
+        /**
+         * Set the field, or remove it if [value] is null.
+         */
+        fun setTagField(field: AudioTagField, value: String?) = apply {
+            fields.add(field to value)
+        }
+
+        /**
+         * Set the front cover of every file, or remove the pictures
+         * if [artwork] is null. The bytes are passed to native once
+         * and shared by all files.
+         *
+         * @param limits if not null, the cover is fitted in the limits
+         * by [ArtworkEncoder] here, once for the whole batch.
+         * @throws IllegalArgumentException if the cover cannot be
+         * fitted in [limits], see [ArtworkEncoder.encode].
+         */
+        fun setArtwork(
+            artwork: ByteArray?,
+            limits: ArtworkEncoder.Limits? = null
+        ) = apply {
+            this.artwork = if (artwork != null && limits != null) {
+                ArtworkEncoder.encode(artwork, limits)
+            } else {
+                artwork
+            }
+            deleteArtwork = artwork == null
+        }
+    }
+
+    fun interface ProgressListener {
+        /**
+         * Called once per file in the order the files finish.
+         *
+         * @param index the index of the file in the targets.
+         * @param completed the files finished so far, including this one.
+         */
+        fun onProgress(index: Int, result: Result, completed: Int, total: Int)
+    }
+
+    /**
+     * Apply [script] to all [targets].
+     *
+     * Blocks the calling thread until every file is done and calls
+     * [listener] on it, should be called from a worker thread. If the
+     * listener throws, the remaining files are still edited and closed
+     * before the exception is rethrown.
+     *
+     * @return the count of files saved.
+     */
+    fun edit(
+        targets: List<Target>,
+        script: Script,
+        concurrency: Int = DEFAULT_CONCURRENCY,
+        listener: ProgressListener? = null
+    ): Int {
+        if (targets.isEmpty()) {
+            return 0
+        }
+        return applyBatch(
+            IntArray(targets.size) { targets[it].fileDescriptor },
+            IntArray(targets.size) { targets[it].audioFormatType.ordinal },
+            Array(script.fields.size) { script.fields[it].first.value },
+            Array(script.fields.size) { script.fields[it].second },
+            script.artwork,
+            script.deleteArtwork,
+            concurrency,
+            Callback(listener, targets.size)
+        )
+    }
+
+    @Keep
+    private class Callback(
+        private val listener: ProgressListener?,
+        private val total: Int
+    ) {
+        private var completed = 0
+
+        @Keep
+        fun onFileDone(index: Int, result: Int) {
+            completed++
+            listener?.onProgress(index, Result.entries[result], completed, total)
+        }
+    }
+
+    private external fun applyBatch(
+        fileDescriptors: IntArray,
+        formats: IntArray,
+        fields: Array<String>,
+        values: Array<String?>,
+        artwork: ByteArray?,
+        deleteArtwork: Boolean,
+        concurrency: Int,
+        callback: Callback
+    ): Int
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+package tech.rollw.player.data.database
+
+import androidx.room.migration.Migration
+import androidx.sqlite.db.SupportSQLiteDatabase
+
+/**
+ * Schema migrations of [PlayerDatabase]. The versions so far only add
+ * columns to `audio`, nullable or with a default, existing rows keep
+ * their values and read the default until they are analyzed.
+ *
+ * @author RollW
+ */
+internal object DatabaseMigrations {
+    /**
+     * ReplayGain track and album gain and peak.
+     */
+    val MIGRATION_1_2 = object : Migration(1, 2) {
+        override fun migrate(db: SupportSQLiteDatabase) {
+            db.execSQL("ALTER TABLE `audio` ADD COLUMN `track_gain` REAL")
+            db.execSQL("ALTER TABLE `audio` ADD COLUMN `track_peak` REAL")
+            db.execSQL("ALTER TABLE `audio` ADD COLUMN `album_gain` REAL")
+            db.execSQL("ALTER TABLE `audio` ADD COLUMN `album_peak` REAL")
+        }
+    }
+
+    /**
+     * The audio a track was found to duplicate.
+     */
+    val MIGRATION_2_3 = object : Migration(2, 3) {
+        override fun migrate(db: SupportSQLiteDatabase) {
+            db.execSQL("ALTER TABLE `audio` ADD COLUMN `duplicate_of` INTEGER")
+        }
+    }
+
+    /**
+     * Tempo and musical key.
+     */
+    val MIGRATION_3_4 = object : Migration(3, 4) {
+        override fun migrate(db: SupportSQLiteDatabase) {
+            db.execSQL("ALTER TABLE `audio` ADD COLUMN `bpm` REAL")
+            db.execSQL("ALTER TABLE `audio` ADD COLUMN `musical_key` TEXT")
+        }
+    }
+
+    /**
+     * Marker of failed loudness analysis.
+     */
+    val MIGRATION_4_5 = object : Migration(4, 5) {
+        override fun migrate(db: SupportSQLiteDatabase) {
+            db.execSQL(
+                "ALTER TABLE `audio` ADD COLUMN `loudness_failed` INTEGER NOT NULL DEFAULT 0"
+            )
+        }
+    }
+
+    val ALL = arrayOf(MIGRATION_1_2, MIGRATION_2_3, MIGRATION_3_4, MIGRATION_4_5)
+}
@@ -47,7 +47,7 @@ import kotlin.concurrent.Volatile
         AudioStatistics::class,
         Statistics::class, DateStatistics::class
     ],
-    version = 1
+    version = 5
 )
 @TypeConverters(DataConverter::class)
 abstract class PlayerDatabase : RoomDatabase() {
@@ -79,6 +79,7 @@ abstract class PlayerDatabase : RoomDatabase() {
                             DATABASE_NAME
                         ).allowMainThreadQueries()
                             .enableMultiInstanceInvalidation()
+                            .addMigrations(*DatabaseMigrations.ALL)
                             .fallbackToDestructiveMigration()
                             .build()
                     }
@@ -104,8 +104,28 @@ object MediaStoreSettings : SettingSpecs {
 }
 
 object AudioSettings : SettingSpecs {
+    /**
+     * Which ReplayGain value is applied on playback, one of the
+     * values of [tech.rollw.player.audio.player.ReplayGainMode].
+     */
+    val ReplayGainMode = SettingSpec(
+        SettingKey("setting:audio:replay_gain_mode", SettingType.STRING),
+        1, CommonValues.OFF, "track", "album"
+    )
+
+    /**
+     * Extra gain in dB applied on top of the ReplayGain.
+     */
+    val ReplayGainPreamp = SettingSpec(
+        SettingKey("setting:audio:replay_gain_preamp", SettingType.DOUBLE),
+        default = 0.0
+    )
+
     override val specs: List<SettingSpec<*, *>>
-        get() = listOf()
+        get() = listOf(
+            ReplayGainMode,
+            ReplayGainPreamp
+        )
 }
 
 object UserSettings : SettingSpecs {
@@ -142,11 +162,22 @@ object DebugSettings : SettingSpecs {
         default = false
     )
 
+    /**
+     * Play through the native Oboe output, which tunes its buffer size
+     * by the underruns of the device, instead of AudioTrack. Takes
+     * effect when the player service starts.
+     */
+    val NativeAudioOutput = SettingSpec.boolean(
+        "setting:debug:native_audio_output",
+        default = false
+    )
+
     override val specs: List<SettingSpec<*, *>>
         get() = listOf(
             BackgroundImageEnabled,
             BackgroundGradientMask,
             BackgroundGradientEnabled,
-            AlwaysShowSetup
+            AlwaysShowSetup,
+            NativeAudioOutput
         )
 }
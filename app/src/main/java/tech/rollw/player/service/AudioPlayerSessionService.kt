@@ -18,23 +18,48 @@ package tech.rollw.player.service
 
 import android.content.Context
 import android.content.Intent
+import android.media.AudioManager
 import android.os.Bundle
 import android.util.Log
 import androidx.annotation.OptIn
 import androidx.core.app.NotificationManagerCompat
 import androidx.media3.common.AudioAttributes
 import androidx.media3.common.C
+import androidx.media3.common.MediaItem
 import androidx.media3.common.Player
 import androidx.media3.common.util.UnstableApi
+import androidx.media3.exoplayer.DefaultRenderersFactory
 import androidx.media3.exoplayer.ExoPlayer
+import androidx.media3.exoplayer.audio.AudioSink
+import androidx.media3.exoplayer.audio.DefaultAudioSink
+import androidx.media3.exoplayer.audio.TeeAudioProcessor
 import androidx.media3.session.CommandButton
 import androidx.media3.session.MediaNotification
 import androidx.media3.session.MediaSession
 import androidx.media3.session.MediaSessionService
 import androidx.media3.session.SessionCommand
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.cancel
+import kotlinx.coroutines.flow.launchIn
+import kotlinx.coroutines.flow.onEach
 import tech.rollw.player.R
+import tech.rollw.player.audio.EXTRA_ALBUM_GAIN
+import tech.rollw.player.audio.EXTRA_TRACK_GAIN
 import tech.rollw.player.audio.player.AudioPlaylistProvider
+import tech.rollw.player.audio.player.OboeAudioSink
+import tech.rollw.player.audio.player.OutputStats
+import tech.rollw.player.audio.player.PlaybackPrefetcher
+import tech.rollw.player.audio.player.PrefetchStats
+import tech.rollw.player.audio.player.ReplayGainAudioProcessor
+import tech.rollw.player.audio.player.ReplayGainMode
+import tech.rollw.player.audio.player.ResamplerAudioProcessor
+import tech.rollw.player.audio.player.SpectrumAnalyzer
 import tech.rollw.player.audio.player.withAudioPlaylistProvider
+import tech.rollw.player.data.setting.AudioSettings
+import tech.rollw.player.data.setting.DebugSettings
+import tech.rollw.player.data.setting.SettingValue
 import tech.rollw.player.ui.applicationService
 
 /**
@@ -48,6 +73,17 @@ class AudioPlayerSessionService : MediaSessionService() {
     private lateinit var notificationManager: NotificationManagerCompat
 
     private val audioPlaylistProvider by applicationService<AudioPlaylistProvider>()
+    private val spectrumAnalyzer by applicationService<SpectrumAnalyzer>()
+    private val replayGainProcessor = ReplayGainAudioProcessor()
+    private val replayGainModeValue = SettingValue(AudioSettings.ReplayGainMode, this)
+    private val replayGainPreampValue = SettingValue(AudioSettings.ReplayGainPreamp, this)
+
+    private val serviceScope = CoroutineScope(SupervisorJob() + Dispatchers.Main)
+
+    @Volatile
+    private var oboeAudioSink: OboeAudioSink? = null
+
+    private var prefetcher: PlaybackPrefetcher? = null
 
     companion object {
         private const val TAG = "AudioPlayerSessionService"
@@ -69,6 +105,20 @@ class AudioPlayerSessionService : MediaSessionService() {
             }
         }
 
+        /**
+         * @return the stats of the native output, null if the service
+         * is not running or plays through AudioTrack.
+         */
+        fun getOutputStats(): OutputStats? =
+            instance?.oboeAudioSink?.stats()
+
+        /**
+         * @return the stats of the track prefetcher, null if the
+         * service is not running.
+         */
+        fun getPrefetchStats(): PrefetchStats? =
+            instance?.prefetcher?.stats()
+
         fun startAudioPlayerSessionService(context: Context) {
             if (isServiceCreated()) {
                 return
@@ -106,7 +156,35 @@ class AudioPlayerSessionService : MediaSessionService() {
 
         val callback = SessionCallback()
 
-        val player = ExoPlayer.Builder(this)
+        // resample before the gain stage, which then runs at the output rate
+        val resamplerProcessor = ResamplerAudioProcessor(getOutputSampleRate())
+        val nativeAudioOutput by SettingValue(DebugSettings.NativeAudioOutput, this)
+        val renderersFactory = object : DefaultRenderersFactory(this) {
+            override fun buildAudioSink(
+                context: Context,
+                enableFloatOutput: Boolean,
+                enableAudioTrackPlaybackParams: Boolean
+            ): AudioSink {
+                val audioProcessors = arrayOf(
+                    resamplerProcessor,
+                    replayGainProcessor,
+                    // the spectrum shows what is actually played
+                    TeeAudioProcessor(spectrumAnalyzer)
+                )
+                if (nativeAudioOutput == true) {
+                    return OboeAudioSink(audioProcessors.asList()).also {
+                        oboeAudioSink = it
+                    }
+                }
+                return DefaultAudioSink.Builder(context)
+                    .setAudioProcessors(audioProcessors)
+                    .setEnableFloatOutput(enableFloatOutput)
+                    .setEnableAudioTrackPlaybackParams(enableAudioTrackPlaybackParams)
+                    .build()
+            }
+        }
+
+        val exoPlayer = ExoPlayer.Builder(this, renderersFactory)
             .setAudioAttributes(
                 AudioAttributes.Builder()
                     .setContentType(C.AUDIO_CONTENT_TYPE_MUSIC)
@@ -116,7 +194,17 @@ class AudioPlayerSessionService : MediaSessionService() {
             )
             .setWakeMode(C.WAKE_MODE_LOCAL)
             .build()
-            .withAudioPlaylistProvider(audioPlaylistProvider)
+        exoPlayer.addListener(ReplayGainListener())
+        replayGainModeValue.asFlow()
+            .onEach { replayGainProcessor.mode = ReplayGainMode.fromValue(it) }
+            .launchIn(serviceScope)
+        replayGainPreampValue.asFlow()
+            .onEach { replayGainProcessor.preamp = it ?: 0.0 }
+            .launchIn(serviceScope)
+        val prefetcher = PlaybackPrefetcher(this).also {
+            this.prefetcher = it
+        }
+        val player = exoPlayer.withAudioPlaylistProvider(audioPlaylistProvider, prefetcher)
         mediaSession = MediaSession.Builder(this, player)
             .setCallback(callback)
             .build()
@@ -132,6 +220,10 @@ class AudioPlayerSessionService : MediaSessionService() {
             release()
             mediaSession = null
         }
+        oboeAudioSink = null
+        prefetcher?.close()
+        prefetcher = null
+        serviceScope.cancel()
         instance = null
         super.onDestroy()
     }
@@ -148,6 +240,51 @@ class AudioPlayerSessionService : MediaSessionService() {
         setMediaNotificationProvider(notificationProvider)
     }
 
+    private fun getOutputSampleRate(): Int {
+        val audioManager = getSystemService(AUDIO_SERVICE) as AudioManager
+        return audioManager.getProperty(AudioManager.PROPERTY_OUTPUT_SAMPLE_RATE)
+            ?.toIntOrNull() ?: 0
+    }
+
+    /**
+     * Keeps the processor informed of the current and the next item,
+     * it picks the one the stream it is configured for belongs to.
+     */
+    private inner class ReplayGainListener : Player.Listener {
+        override fun onMediaItemTransition(mediaItem: MediaItem?, reason: Int) {
+            val extras = mediaItem?.mediaMetadata?.extras
+            replayGainProcessor.setCurrentReplayGain(
+                trackGain = extras?.getDoubleOrNull(EXTRA_TRACK_GAIN),
+                albumGain = extras?.getDoubleOrNull(EXTRA_ALBUM_GAIN)
+            )
+        }
+
+        override fun onEvents(player: Player, events: Player.Events) {
+            if (!events.containsAny(
+                    Player.EVENT_MEDIA_ITEM_TRANSITION,
+                    Player.EVENT_TIMELINE_CHANGED,
+                    Player.EVENT_SHUFFLE_MODE_ENABLED_CHANGED,
+                    Player.EVENT_REPEAT_MODE_CHANGED
+                )
+            ) {
+                return
+            }
+            val nextIndex = player.nextMediaItemIndex
+            val extras = if (nextIndex == C.INDEX_UNSET) {
+                null
+            } else {
+                player.getMediaItemAt(nextIndex).mediaMetadata.extras
+            }
+            replayGainProcessor.setNextReplayGain(
+                trackGain = extras?.getDoubleOrNull(EXTRA_TRACK_GAIN),
+                albumGain = extras?.getDoubleOrNull(EXTRA_ALBUM_GAIN)
+            )
+        }
+
+        private fun Bundle.getDoubleOrNull(key: String): Double? =
+            if (containsKey(key)) getDouble(key) else null
+    }
+
     private class SessionCallback : MediaSession.Callback {
         override fun onConnect(
             session: MediaSession,
@@ -20,6 +20,7 @@ import android.content.Context
 import tech.rollw.player.R
 import tech.rollw.player.service.scanner.AudioClassificationWorker
 import tech.rollw.player.service.scanner.AudioScanWorker
+import tech.rollw.player.service.scanner.WaveformWorker
 
 /**
  * @author RollW
@@ -38,6 +39,7 @@ object WorkerDefaults {
 
     const val TAG_AUDIO_SCAN_WORKER = "AudioScanWorker"
     const val TAG_AUDIO_CLASSIFICATION_WORKER = "AudioClassificationWorker"
+    const val TAG_WAVEFORM_WORKER = "WaveformWorker"
 
     val AudioScanWorkerSpec: WorkerSpec = ResourceWorkerSpec(
         TAG_AUDIO_SCAN_WORKER,
@@ -51,9 +53,16 @@ object WorkerDefaults {
         "Audio Classification Process"
     )
 
+    val WaveformWorkerSpec: WorkerSpec = ResourceWorkerSpec(
+        TAG_WAVEFORM_WORKER,
+        WaveformWorker::class.java.name,
+        R.string.task_waveform_title
+    )
+
     fun getWorkerSpec(tags: Set<String>): WorkerSpec? = when {
         AudioScanWorkerSpec.isAnyOf(tags) -> AudioScanWorkerSpec
         AudioClassificationWorkerSpec.isAnyOf(tags) -> AudioClassificationWorkerSpec
+        WaveformWorkerSpec.isAnyOf(tags) -> WaveformWorkerSpec
         else -> null
     }
 }
@@ -25,23 +25,37 @@ import androidx.work.OneTimeWorkRequestBuilder
 import androidx.work.Operation
 import androidx.work.WorkManager
 import androidx.work.WorkerParameters
+import androidx.work.workDataOf
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.async
+import kotlinx.coroutines.awaitAll
 import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.sync.Semaphore
+import kotlinx.coroutines.sync.withPermit
 import kotlinx.coroutines.withContext
 import tech.rollw.player.audio.Audio
+import tech.rollw.player.audio.AudioFormatType
+import tech.rollw.player.audio.AudioPath
+import tech.rollw.player.audio.analysis.FingerprintExtractor
+import tech.rollw.player.audio.analysis.MusicAnalyzer
+import tech.rollw.player.audio.analysis.SidecarStore
 import tech.rollw.player.audio.list.Playlist
 import tech.rollw.player.audio.list.PlaylistItem
 import tech.rollw.player.audio.list.PlaylistType
+import tech.rollw.player.audio.tag.AudioTagField
+import tech.rollw.player.audio.tag.NativeLibAudioTag
 import tech.rollw.player.data.database.repository.AudioPathRepository
 import tech.rollw.player.data.database.repository.AudioRepository
 import tech.rollw.player.data.database.repository.PlaylistItemRepository
 import tech.rollw.player.data.database.repository.PlaylistRepository
 import tech.rollw.player.service.WorkerDefaults
 import tech.rollw.player.ui.applicationService
+import tech.rollw.player.util.NativeStats
 import tech.rollw.support.analytics.Analytics
 import tech.rollw.support.analytics.AnalyticsEvent
+import tech.rollw.support.appcompat.openFileDescriptor
 import tech.rollw.support.io.ContentPath
+import kotlin.math.roundToInt
 
 /**
  * @author RollW
@@ -94,6 +108,15 @@ class AudioClassificationWorker(
             saveAlbumArtistsJob.await()
         }
 
+        val saveTime = System.currentTimeMillis()
+        val analyzed = if (inputData.getBoolean(KEY_ANALYZE_MUSIC, false)) {
+            analyzeMusic(audios, inputData.getBoolean(KEY_WRITE_MUSIC_TAGS, false))
+        } else emptyMap()
+
+        val analyzeTime = System.currentTimeMillis()
+        // on top of the analyzed audios, so neither update drops the other
+        val duplicates = markDuplicates(audios.map { analyzed[it.id] ?: it })
+
         val endTime = System.currentTimeMillis()
 
         analytics.logEvent(
@@ -103,78 +126,278 @@ class AudioClassificationWorker(
                     AnalyticsEvent.Param("audios", audios.size.toString()),
                     AnalyticsEvent.Param("exist_playlist_items", playlistItems.size.toString()),
                     AnalyticsEvent.Param("query_time", (queryTime - startTime).toString()),
-                    AnalyticsEvent.Param("save_time", (endTime - queryTime).toString()),
+                    AnalyticsEvent.Param("save_time", (saveTime - queryTime).toString()),
+                    AnalyticsEvent.Param("music_analyzed", analyzed.size.toString()),
+                    AnalyticsEvent.Param("music_time", (analyzeTime - saveTime).toString()),
+                    AnalyticsEvent.Param("duplicates", duplicates.toString()),
+                    AnalyticsEvent.Param("duplicate_time", (endTime - analyzeTime).toString()),
                     AnalyticsEvent.Param("total_time", (endTime - startTime).toString()),
-                )
+                ) + nativeStatsParams()
             )
         )
 
         return Result.success()
     }
 
+    /**
+     * Per format numbers of the native tag library, since the process
+     * started, which covers the scan before this worker.
+     */
+    private fun nativeStatsParams(): List<AnalyticsEvent.Param> {
+        val stats = NativeStats.snapshot()
+        return AudioFormatType.entries.flatMap { format ->
+            val opened = stats.counter(NativeStats.Counter.OPENED, format)
+            if (opened == 0L) {
+                return@flatMap emptyList()
+            }
+            val name = format.extension
+            val open = stats.histogram(NativeStats.Histogram.OPEN_TIME, format)
+            val parse = stats.histogram(NativeStats.Histogram.PARSE_TIME, format)
+            val artworkSize = stats.histogram(NativeStats.Histogram.ARTWORK_SIZE, format)
+            listOf(
+                AnalyticsEvent.Param("${name}_opened", opened.toString()),
+                AnalyticsEvent.Param(
+                    "${name}_parse_failed",
+                    stats.counter(NativeStats.Counter.PARSE_FAILED, format).toString()
+                ),
+                AnalyticsEvent.Param(
+                    "${name}_bytes_read",
+                    stats.counter(NativeStats.Counter.BYTES_READ, format).toString()
+                ),
+                AnalyticsEvent.Param("${name}_open_p50_us", open.percentile(50.0).toString()),
+                AnalyticsEvent.Param("${name}_open_p95_us", open.percentile(95.0).toString()),
+                AnalyticsEvent.Param("${name}_parse_p50_us", parse.percentile(50.0).toString()),
+                AnalyticsEvent.Param("${name}_parse_p95_us", parse.percentile(95.0).toString()),
+                AnalyticsEvent.Param("${name}_artworks", artworkSize.count.toString()),
+                AnalyticsEvent.Param("${name}_artwork_mean_bytes", artworkSize.mean.toString()),
+            )
+        }
+    }
+
     private val emptyList = listOf("")
 
-    private suspend fun saveAlbums(
+    /**
+     * Estimate tempo and key of the audios missing either of them,
+     * saving them batch by batch so a stopped work keeps what it has
+     * done.
+     *
+     * @return the updated audios by id.
+     */
+    private suspend fun analyzeMusic(
         audios: Collection<Audio>,
+        writeTags: Boolean
+    ): Map<Long, Audio> {
+        val pathsById = audioPathRepository.get().groupBy { it.id }
+        val pending = audios.filter { it.bpm == null || it.key == null }
+        val analyzed = hashMapOf<Long, Audio>()
+        var done = 0
+        // decoding is CPU bound, one analysis per core
+        val permits = Semaphore(PARALLELISM)
+        pending.chunked(MUSIC_BATCH_SIZE).forEach { batch ->
+            if (isStopped) {
+                return analyzed
+            }
+            val updated = coroutineScope {
+                batch.map { audio ->
+                    async {
+                        permits.withPermit {
+                            val paths = pathsById[audio.id] ?: return@withPermit null
+                            analyzeMusic(audio, paths, writeTags)
+                        }
+                    }
+                }.awaitAll().filterNotNull()
+            }
+            audioRepository.update(updated)
+            updated.forEach { analyzed[it.id!!] = it }
+            done += batch.size
+            setProgress(
+                workDataOf(
+                    WorkerDefaults.KEY_PROGRESS to done * 100 / pending.size
+                )
+            )
+        }
+        return analyzed
+    }
+
+    /**
+     * @return the audio with tempo and key filled in, or null if it
+     * cannot be analyzed or nothing was found.
+     */
+    private fun analyzeMusic(
+        audio: Audio,
+        paths: List<AudioPath>,
+        writeTags: Boolean
+    ): Audio? {
+        for (audioPath in paths) {
+            val uri = audioPath.path.toUri()
+            val pfd = try {
+                uri.openFileDescriptor(context, "r")
+            } catch (e: Exception) {
+                continue
+            }
+            val features = try {
+                NativeLibAudioTag(pfd.detachFd(), audio.type, readonly = true, windowed = true).use {
+                    MusicAnalyzer.analyze(it)
+                } ?: return null
+            } catch (e: Exception) {
+                Log.w(TAG, "Failed to analyze music: ${audioPath.identifier}", e)
+                return null
+            }
+            // tagged values win over the estimates
+            val bpm = audio.bpm ?: features.tempo
+            val key = audio.key ?: features.key
+            if (bpm == audio.bpm && key == audio.key) {
+                return null
+            }
+            val analyzed = audio.copy(bpm = bpm, key = key)
+            if (writeTags) {
+                try {
+                    writeMusicTags(audio, analyzed, audioPath)
+                } catch (e: Exception) {
+                    Log.w(TAG, "Failed to write music tags: ${audioPath.identifier}", e)
+                }
+            }
+            return analyzed
+        }
+        return null
+    }
+
+    private fun writeMusicTags(original: Audio, analyzed: Audio, audioPath: AudioPath) {
+        val pfd = audioPath.path.toUri().openFileDescriptor(context, "rw")
+        NativeLibAudioTag(pfd.detachFd(), analyzed.type).use { tag ->
+            if (original.bpm == null) {
+                analyzed.bpm?.let {
+                    tag.setTagField(AudioTagField.BPM, it.roundToInt().toString())
+                }
+            }
+            if (original.key == null) {
+                analyzed.key?.let {
+                    tag.setTagField(AudioTagField.INITIAL_KEY, it)
+                }
+            }
+            tag.save()
+        }
+    }
+
+    /**
+     * Flag the audios whose fingerprints match another audio, the one
+     * of the highest bit rate in a group of matches is kept as the
+     * original. Audios without a fingerprint are left out.
+     *
+     * @return the count of duplicates.
+     */
+    private fun markDuplicates(audios: Collection<Audio>): Int {
+        val store = SidecarStore.fingerprints(context)
+        val pathsById = audioPathRepository.get().groupBy { it.id }
+        val matches = FingerprintExtractor.Index().use { index ->
+            audios.forEach { audio ->
+                val identifier = pathsById[audio.id]?.firstOrNull()?.identifier
+                    ?: return@forEach
+                val fingerprint = store.read(identifier, audio.lastModified)
+                    ?: return@forEach
+                index.add(audio.id!!, audio.duration, fingerprint)
+            }
+            index.findDuplicates()
+        }
+
+        // union the matches into groups
+        val parents = hashMapOf<Long, Long>()
+        fun rootOf(id: Long): Long {
+            var current = id
+            while (true) {
+                current = parents[current] ?: return current
+            }
+        }
+        matches.forEach {
+            val root = rootOf(it.audioId)
+            val otherRoot = rootOf(it.duplicateAudioId)
+            if (root != otherRoot) {
+                parents[root] = otherRoot
+            }
+        }
+
+        val audiosById = audios.associateBy { it.id!! }
+        val originals = hashMapOf<Long, Long>()
+        (parents.keys + parents.values).groupBy { rootOf(it) }.values.forEach { ids ->
+            val original = ids.maxWith(
+                compareBy<Long> { audiosById[it]?.bitRate ?: 0 }.thenByDescending { it }
+            )
+            ids.filter { it != original }.forEach { originals[it] = original }
+        }
+
+        val updated = audios.mapNotNull { audio ->
+            val duplicateOf = originals[audio.id]
+            if (audio.duplicateOf == duplicateOf) null
+            else audio.copy(duplicateOf = duplicateOf)
+        }
+        audioRepository.update(updated)
+        return originals.size
+    }
+
+    private suspend fun saveAlbums(
+        audios: List<Audio>,
         playlistItems: Collection<PlaylistItem>
     ) {
-        val audiosByAlbum = audios.groupBy { it.album ?: "" }
-        val albums = audiosByAlbum.keys
-
-        saveAndReducePlaylists(albums, playlistItems, audios, PlaylistType.ALBUM) {
+        val albums = audios.map {
             if (it.album == null) emptyList
             else listOf(it.album)
         }
+        saveAndReducePlaylists(albums, playlistItems, audios, PlaylistType.ALBUM)
     }
 
     private suspend fun saveArtists(
-        audios: Collection<Audio>,
+        audios: List<Audio>,
         playlistItems: Collection<PlaylistItem>
     ) {
-        val audiosByArtist = audios.groupByMany {
-            if (it.artist == null) emptyList
-            else it.artist.split("/")
-        }
-        val artists = audiosByArtist.keys
-
-        saveAndReducePlaylists(artists, playlistItems, audios, PlaylistType.ARTIST) {
-            if (it.artist == null) emptyList
-            else it.artist.split("/")
-        }
+        val artists = splitNames(audios) { it.artist }
+        saveAndReducePlaylists(artists, playlistItems, audios, PlaylistType.ARTIST)
     }
 
     private suspend fun saveAlbumArtists(
-        audios: Collection<Audio>,
+        audios: List<Audio>,
         playlistItems: Collection<PlaylistItem>
     ) {
-        val audiosByArtist = audios.groupByMany {
-            if (it.albumArtist == null) emptyList
-            else it.albumArtist.split("/")
-        }
-        val albumArtists = audiosByArtist.keys
+        val albumArtists = splitNames(audios) { it.albumArtist }
+        saveAndReducePlaylists(albumArtists, playlistItems, audios, PlaylistType.ALBUM_ARTIST)
+    }
 
-        saveAndReducePlaylists(albumArtists, playlistItems, audios, PlaylistType.ALBUM_ARTIST) {
-            if (it.albumArtist == null) emptyList
-            else it.albumArtist.split("/")
+    /**
+     * Split the "/" separated names of every audio, once. A name
+     * shared by many audios is kept as a single instance, so its hash
+     * is computed once and lookups of it compare by identity.
+     *
+     * @return the names of each audio, in the order of [audios].
+     */
+    private fun splitNames(
+        audios: List<Audio>,
+        names: (Audio) -> String?
+    ): List<List<String>> {
+        val interned = hashMapOf<String, String>()
+        val splits = hashMapOf<String, List<String>>()
+        return audios.map { audio ->
+            val value = names(audio) ?: return@map emptyList
+            splits.getOrPut(value) {
+                value.split("/").map { interned.getOrPut(it) { it } }
+            }
         }
     }
 
     /**
      * Save and reduce the playlists.
      *
-     * @param playlistNames the names of the playlists in the given [type]
+     * @param audioKeys the names of the playlists of each audio in the
+     * given [type], in the order of [audios]
      * @param playlistItems existing playlist items
      * @param audios all audios
      * @param type the type of the playlist
-     * @param keyExtractor the key extractor to get the keys from the audio
      */
     private suspend fun saveAndReducePlaylists(
-        playlistNames: Collection<String>,
+        audioKeys: List<List<String>>,
         playlistItems: Collection<PlaylistItem>,
-        audios: Collection<Audio>,
-        type: PlaylistType,
-        keyExtractor: (Audio) -> Iterable<String>
+        audios: List<Audio>,
+        type: PlaylistType
     ): Int {
+        val playlistNames = audioKeys.flatMapTo(hashSetOf()) { it }
         val existPlaylists = findPlaylists(playlistNames, type)
 
         // find the playlists & playlistItems that does not exist in the given names
@@ -186,7 +409,7 @@ class AudioClassificationWorker(
         }.toSet()
 
         // find the distinct playlist names that need to be created
-        val distinct = playlistNames - existPlaylists.keys - playlistsToDelete.keys
+        val distinct = (playlistNames - existPlaylists.keys - playlistsToDelete.keys).toList()
         val newPlaylists = createPlaylists(distinct, type)
 
         playlistItemRepository.delete(playlistItemsToDelete)
@@ -207,8 +430,8 @@ class AudioClassificationWorker(
             .filter { it.playlistId in playlistIds }
             .groupBy { it.audioId }
 
-        val newPlaylistItems = audios.mapNotNull { audio ->
-            keyExtractor(audio).map { it ->
+        val newPlaylistItems = audios.mapIndexedNotNull { index, audio ->
+            audioKeys[index].map { it ->
                 val playlistId = allPlaylists[it]?.id ?: return@mapNotNull null
                 val audioPlaylistItems = existedPlaylistItems[audio.id]
 
@@ -283,10 +506,11 @@ class AudioClassificationWorker(
         audios: Collection<Audio>
     ): List<Playlist> {
         val playlistDatas = playlists.associate { it.id!! to PlaylistData() }
+        val audiosById = audios.associateBy { it.id }
 
         playlistItems.forEach { item ->
             val data = playlistDatas[item.playlistId] ?: return@forEach
-            val audio = audios.firstOrNull { it.id == item.audioId } ?: return@forEach
+            val audio = audiosById[item.audioId] ?: return@forEach
 
             data.count++
             data.duration += audio.duration
@@ -327,12 +551,43 @@ class AudioClassificationWorker(
 
         val WORKER_SPEC = WorkerDefaults.AudioClassificationWorkerSpec
 
+        private val PARALLELISM = Runtime.getRuntime().availableProcessors()
+            .coerceIn(1, 4)
+
+        /**
+         * Audios analyzed between two saves.
+         */
+        private const val MUSIC_BATCH_SIZE = 32
+
+        /**
+         * Whether to estimate tempo and key of audios missing them.
+         *
+         * The value is [Boolean] type, defaults to false.
+         */
+        private const val KEY_ANALYZE_MUSIC = "analyze_music"
+
+        /**
+         * Whether to write the estimated tempo and key into BPM and
+         * INITIALKEY tags of the files.
+         *
+         * The value is [Boolean] type, defaults to false.
+         */
+        private const val KEY_WRITE_MUSIC_TAGS = "write_music_tags"
+
         @JvmStatic
         fun submitWork(
-            context: Context
+            context: Context,
+            analyzeMusic: Boolean = false,
+            writeMusicTags: Boolean = false
         ): Operation {
             val workRequest = OneTimeWorkRequestBuilder<AudioClassificationWorker>()
                 .addTag(TAG)
+                .setInputData(
+                    workDataOf(
+                        KEY_ANALYZE_MUSIC to analyzeMusic,
+                        KEY_WRITE_MUSIC_TAGS to writeMusicTags
+                    )
+                )
                 .build()
             return WorkManager.getInstance(context)
                 .beginUniqueWork(TAG, ExistingWorkPolicy.KEEP, workRequest)
@@ -23,11 +23,11 @@ import android.content.Intent
 import android.content.pm.PackageManager
 import android.net.Uri
 import android.os.ParcelFileDescriptor
+import android.provider.DocumentsContract
 import android.util.Log
 import androidx.core.app.ActivityCompat
 import androidx.core.app.NotificationCompat
 import androidx.core.app.NotificationManagerCompat
-import androidx.documentfile.provider.DocumentFile
 import androidx.work.CoroutineWorker
 import androidx.work.ExistingWorkPolicy
 import androidx.work.ForegroundInfo
@@ -45,7 +45,15 @@ import tech.rollw.player.R
 import tech.rollw.player.audio.Audio
 import tech.rollw.player.audio.AudioFormatType
 import tech.rollw.player.audio.AudioPath
+import tech.rollw.player.audio.analysis.LoudnessScanSession
+import tech.rollw.player.audio.analysis.ReplayGain
+import tech.rollw.player.audio.analysis.FingerprintExtractor
+import tech.rollw.player.audio.analysis.SeekIndexBuilder
+import tech.rollw.player.audio.analysis.SidecarStore
+import tech.rollw.player.audio.tag.AudioTagField
 import tech.rollw.player.audio.tag.NativeLibAudioTag
+import tech.rollw.player.audio.tag.ScanCache
+import tech.rollw.player.audio.tag.ScanStringTable
 import tech.rollw.player.audio.toAudio
 import tech.rollw.player.audio.toAudioPath
 import tech.rollw.player.data.database.repository.AudioPathRepository
@@ -61,6 +69,7 @@ import tech.rollw.support.analytics.AnalyticsEvent
 import tech.rollw.support.appcompat.openFileDescriptor
 import tech.rollw.support.io.ContentPath.Companion.toContentPath
 import tech.rollw.support.io.PathType
+import java.util.concurrent.ConcurrentHashMap
 import java.util.concurrent.atomic.AtomicInteger
 import java.util.concurrent.atomic.AtomicLong
 
@@ -82,6 +91,36 @@ class AudioScanWorker(
     private val audioPathRepository by context.applicationService<AudioPathRepository>()
     private val analytics by context.applicationService<Analytics>()
 
+    /**
+     * Not null if loudness analysis is enabled for this scan.
+     */
+    private var loudnessSession: LoudnessScanSession? = null
+
+    /**
+     * Not null if seek indexes are built in this scan.
+     */
+    private var seekIndexStore: SidecarStore? = null
+    private var fingerprintStore: SidecarStore? = null
+
+    /**
+     * Tags of the last scan, files unchanged since are not parsed again.
+     */
+    private var scanCache: ScanCache? = null
+
+    /**
+     * Strings of the tags read in this scan, shared by every audio
+     * that has them.
+     */
+    private var stringTable: ScanStringTable? = null
+    private val cachedCounter = AtomicInteger(0)
+
+    /**
+     * Size and last modified time of the collected files as their
+     * document provider reports them, checked against the cache
+     * before any file is opened.
+     */
+    private val documentStats = ConcurrentHashMap<Uri, DocumentStat>()
+
     override suspend fun doWork(): Result {
         return withContext(Dispatchers.IO) {
             NotificationChannels.createChannel(
@@ -137,8 +176,41 @@ class AudioScanWorker(
 
         val existedPaths = audioPathRepository.get()
 
+        if (inputData.getBoolean(KEY_ANALYZE_LOUDNESS, false)) {
+            loudnessSession = LoudnessScanSession()
+        }
+        if (inputData.getBoolean(KEY_BUILD_SEEK_INDEX, false)) {
+            seekIndexStore = SidecarStore.seekIndexes(context)
+        }
+        if (inputData.getBoolean(KEY_COMPUTE_FINGERPRINT, false)) {
+            fingerprintStore = SidecarStore.fingerprints(context)
+        }
+
+        val stringTable = ScanStringTable(ScanCache.FIELDS)
+        this.stringTable = stringTable
+        scanCache = ScanCache.open(context, stringTable)
+
         setScanProgress(20)
-        val audios = scanAudioTags(audioPaths)
+        var stringCount = 0
+        val audios = try {
+            val scanned = scanAudioTags(audioPaths)
+            loudnessSession?.let {
+                saveAlbumLoudness(
+                    it, scanned.filterNotNull(),
+                    inputData.getBoolean(KEY_WRITE_REPLAY_GAIN, false)
+                )
+            }
+            scanCache?.save()
+            stringCount = stringTable.size
+            scanned
+        } finally {
+            loudnessSession?.close()
+            loudnessSession = null
+            scanCache?.close()
+            scanCache = null
+            stringTable.close()
+            this.stringTable = null
+        }
         setScanProgress(90)
 
         val nonExistedPaths = selectNonExistedPaths(audioPaths, existedPaths)
@@ -155,6 +227,8 @@ class AudioScanWorker(
                 listOf(
                     AnalyticsEvent.Param("collect_count", audioPaths.size.toString()),
                     AnalyticsEvent.Param("audio_count", audios.size.toString()),
+                    AnalyticsEvent.Param("cached_count", cachedCounter.get().toString()),
+                    AnalyticsEvent.Param("string_count", stringCount.toString()),
                     AnalyticsEvent.Param("collect_time", (collectTime - start).toString()),
                     AnalyticsEvent.Param("scan_time", (end - collectTime).toString())
                 )
@@ -169,6 +243,43 @@ class AudioScanWorker(
         )
     }
 
+    private fun saveAlbumLoudness(
+        session: LoudnessScanSession,
+        scanned: List<Audio>,
+        writeTags: Boolean
+    ) {
+        val analyzed = session.finish(scanned)
+        audioRepository.update(analyzed.map { it.audio })
+        if (!writeTags) {
+            return
+        }
+        analyzed.forEach {
+            try {
+                writeReplayGainTags(it.audio, it.uri)
+            } catch (e: Exception) {
+                Log.w(TAG, "Failed to write ReplayGain tags: ${it.uri}", e)
+            }
+        }
+    }
+
+    private fun writeReplayGainTags(audio: Audio, uri: Uri) {
+        val trackGain = audio.trackGain ?: return
+        val pfd = uri.openFileDescriptor(context, "rw")
+        NativeLibAudioTag(pfd.detachFd(), audio.type).use { tag ->
+            tag.setTagField(AudioTagField.REPLAYGAIN_TRACK_GAIN, ReplayGain.formatGain(trackGain))
+            audio.trackPeak?.let {
+                tag.setTagField(AudioTagField.REPLAYGAIN_TRACK_PEAK, ReplayGain.formatPeak(it))
+            }
+            audio.albumGain?.let {
+                tag.setTagField(AudioTagField.REPLAYGAIN_ALBUM_GAIN, ReplayGain.formatGain(it))
+            }
+            audio.albumPeak?.let {
+                tag.setTagField(AudioTagField.REPLAYGAIN_ALBUM_PEAK, ReplayGain.formatPeak(it))
+            }
+            tag.save()
+        }
+    }
+
     private fun selectNonExistedPaths(
         audioPaths: Map<String, List<Uri>>,
         existedPaths: List<AudioPath>
@@ -191,74 +302,211 @@ class AudioScanWorker(
     private suspend fun collectUris(uris: List<Uri>): Map<String, List<Uri>> {
         val audioPaths = mutableMapOf<String, MutableList<Uri>>()
 
-        suspend fun addPathIfAudio(file: DocumentFile) {
-            if (file.isDirectory) {
-                val files = file.listFiles()
-                coroutineScope {
-                    files.map {
-                        async {
-                            addPathIfAudio(it)
-                        }
-                    }.awaitAll()
+        // one query per directory, which also brings the size and
+        // last modified time of every file
+        suspend fun addPathsOf(treeUri: Uri, documentId: String) {
+            val directories = mutableListOf<String>()
+            queryChildren(treeUri, documentId).forEach { child ->
+                if (child.mimeType == DocumentsContract.Document.MIME_TYPE_DIR) {
+                    directories.add(child.documentId)
+                    return@forEach
+                }
+                val uri = DocumentsContract.buildDocumentUriUsingTree(treeUri, child.documentId)
+                val identifier = getIdentifier(uri)
+                val suffix = identifier.getSuffix()
+                // check if it's an audio file by its extension
+                AudioFormatType.fromExtensionOrNull(suffix) ?: return@forEach
+                synchronized(audioPaths) {
+                    audioPaths.getOrPut(identifier) { mutableListOf() }.add(uri)
+                }
+                if (child.size >= 0 && child.lastModified > 0) {
+                    documentStats[uri] = DocumentStat(child.size, child.lastModified)
                 }
-                return
             }
-
-            val identifier = getIdentifier(file.uri)
-            val suffix = identifier.getSuffix()
-            // check if it's an audio file by its extension
-            AudioFormatType.fromExtensionOrNull(suffix) ?: return
-            val list = audioPaths.getOrPut(identifier) { mutableListOf() }
-            list.add(file.uri)
+            coroutineScope {
+                directories.map {
+                    async {
+                        addPathsOf(treeUri, it)
+                    }
+                }.awaitAll()
+            }
         }
 
         coroutineScope {
             uris.map {
                 async {
-                    val file = DocumentFile.fromTreeUri(context, it) ?: return@async
-                    addPathIfAudio(file)
+                    val documentId = treeDocumentIdOf(it) ?: return@async
+                    addPathsOf(it, documentId)
                 }
             }.awaitAll()
         }
         return audioPaths
     }
 
+    private fun treeDocumentIdOf(treeUri: Uri): String? =
+        try {
+            if (DocumentsContract.isDocumentUri(context, treeUri)) {
+                DocumentsContract.getDocumentId(treeUri)
+            } else {
+                DocumentsContract.getTreeDocumentId(treeUri)
+            }
+        } catch (e: IllegalArgumentException) {
+            Log.w(TAG, "Not a document tree: $treeUri", e)
+            null
+        }
+
+    private fun queryChildren(treeUri: Uri, documentId: String): List<DocumentRow> {
+        val childrenUri = DocumentsContract.buildChildDocumentsUriUsingTree(treeUri, documentId)
+        return try {
+            context.contentResolver.query(
+                childrenUri, DOCUMENT_COLUMNS, null, null, null
+            )?.use { cursor ->
+                val rows = ArrayList<DocumentRow>(cursor.count)
+                while (cursor.moveToNext()) {
+                    rows.add(
+                        DocumentRow(
+                            documentId = cursor.getString(0),
+                            mimeType = cursor.getString(1),
+                            size = if (cursor.isNull(2)) -1 else cursor.getLong(2),
+                            lastModified = if (cursor.isNull(3)) -1 else cursor.getLong(3)
+                        )
+                    )
+                }
+                rows
+            } ?: emptyList()
+        } catch (e: Exception) {
+            Log.w(TAG, "Failed to list documents: $childrenUri", e)
+            emptyList()
+        }
+    }
+
     private suspend fun scanAudioTags(
         audioPaths: Map<String, List<Uri>>,
         onScan: (Audio?) -> Unit = {}
     ) = coroutineScope {
-        audioPaths.mapNotNull { (identifier, uris) ->
+        val targets = audioPaths.mapNotNull { (identifier, uris) ->
             val audioFormatType = AudioFormatType
                 .fromExtensionOrNull(identifier.getSuffix())
                 ?: return@mapNotNull null
-            async {
-                val audio = scanAudioTag(
-                    uris,
-                    identifier,
-                    audioFormatType
-                )
-                onScan(audio)
-                audio
+            ScanTarget(identifier, uris, audioFormatType)
+        }
+        // files are checked against the cache a batch at a time with
+        // one native call before any tag is parsed
+        targets.chunked(VALIDATE_BATCH_SIZE).flatMap { batch ->
+            val files = validateCached(batch)
+            batch.mapIndexed { index, target ->
+                async {
+                    val audio = scanAudioTag(target, files[index])
+                    onScan(audio)
+                    audio
+                }
+            }.awaitAll()
+        }//.filterNotNull()
+    }
+
+    private fun openFirstValid(uris: List<Uri>): Pair<Uri, ParcelFileDescriptor>? =
+        uris.firstNotNullOfOrNull { uri ->
+            tryOpenFileDescriptorOf(uri)?.let { uri to it }
+        }
+
+    /**
+     * Check the batch against the cache by the document columns
+     * first. Only the files those do not show unchanged are opened,
+     * and their descriptors checked with one more native call.
+     *
+     * @return the file to read of every target of the batch, null
+     * if none of its uris can be opened.
+     */
+    private fun validateCached(batch: List<ScanTarget>): List<BatchFile?> {
+        val files = arrayOfNulls<BatchFile>(batch.size)
+        val cache = scanCache
+        if (cache != null) {
+            val known = batch.indices.mapNotNull { index ->
+                batch[index].uris.firstNotNullOfOrNull { uri ->
+                    documentStats[uri]?.let { index to (uri to it) }
+                }
             }
-        }.awaitAll()//.filterNotNull()
+            val lastModified = cache.validate(
+                Array(known.size) { batch[known[it].first].identifier },
+                LongArray(known.size) { known[it].second.second.size },
+                LongArray(known.size) { known[it].second.second.lastModified }
+            )
+            known.forEachIndexed { i, (index, document) ->
+                if (lastModified[i] >= 0) {
+                    files[index] = BatchFile(document.first, null, lastModified[i])
+                }
+            }
+        }
+
+        val indexes = batch.indices.filter { files[it] == null }
+        val opened = indexes.map { openFirstValid(batch[it].uris) }
+        val cachedModified = validateOpened(cache, indexes.map { batch[it] }, opened)
+        indexes.forEachIndexed { i, index ->
+            files[index] = opened[i]?.let { (uri, pfd) ->
+                BatchFile(uri, pfd, cachedModified[i])
+            }
+        }
+        return files.asList()
+    }
+
+    /**
+     * @return the cached last modified time of every unchanged file
+     * of the targets, -1 for the others.
+     */
+    private fun validateOpened(
+        cache: ScanCache?,
+        targets: List<ScanTarget>,
+        opened: List<Pair<Uri, ParcelFileDescriptor>?>
+    ): LongArray {
+        val result = LongArray(targets.size) { -1 }
+        if (cache == null) {
+            return result
+        }
+        val indexes = opened.indices.filter { opened[it] != null }
+        if (indexes.isEmpty()) {
+            return result
+        }
+        val lastModified = cache.validate(
+            Array(indexes.size) { targets[indexes[it]].identifier },
+            IntArray(indexes.size) { opened[indexes[it]]!!.second.fd }
+        )
+        indexes.forEachIndexed { i, index ->
+            result[index] = lastModified[i]
+        }
+        return result
     }
 
     private fun scanAudioTag(
-        uris: List<Uri>, identifier: String,
-        audioFormatType: AudioFormatType
+        target: ScanTarget,
+        file: BatchFile?
     ): Audio? {
+        val (identifier, uris, audioFormatType) = target
         if (uris.isEmpty()) {
             return null
         }
+        if (file == null) {
+            Log.w(
+                TAG,
+                "Failed to open file descriptor: $identifier. None of the uris is valid."
+            )
+            return null
+        }
         val scanResult = readAudioFile(
             uris,
             identifier,
-            audioFormatType
+            audioFormatType,
+            file.uri,
+            file.pfd,
+            file.cachedModified
         )
         if (scanResult.audio == null) {
             return null
         }
-        return updateAudioByResult(scanResult, identifier)
+        val audio = updateAudioByResult(scanResult, identifier)
+        if (audio != null && scanResult.analyzedUri != null) {
+            loudnessSession?.onSaved(audio, scanResult.analyzedUri)
+        }
+        return audio
     }
 
     private fun updateAudioByResult(
@@ -295,22 +543,21 @@ class AudioScanWorker(
         return audioPathRepository.getByIdentifier(identifier)
     }
 
+    /**
+     * @param pfd the opened file of [uri], closed or handed
+     * over to the tag. Null if the cache showed the file unchanged
+     * without opening it, it is then opened only to be parsed.
+     * @param cachedModified the last modified time of the file if
+     * it is unchanged since the cached scan, -1 otherwise.
+     */
     private fun readAudioFile(
         uris: List<Uri>,
         identifier: String,
-        audioFormatType: AudioFormatType
+        audioFormatType: AudioFormatType,
+        uri: Uri,
+        pfd: ParcelFileDescriptor?,
+        cachedModified: Long
     ): AudioReadResult {
-        val validUris = collectValidUris(uris)
-        val pfd = validUris.firstNotNullOfOrNull {
-            tryOpenFileDescriptorOf(it)
-        }
-        if (pfd == null) {
-            Log.w(
-                TAG,
-                "Failed to open file descriptor: $identifier. None of the uris is valid."
-            )
-            return AudioReadResult.EMPTY
-        }
         val existPaths = getAudioPathsByIdentifier(identifier)
         val existId = existPaths.firstOrNull()?.id
 
@@ -320,17 +567,62 @@ class AudioScanWorker(
             null
         }
 
-        val fd = pfd.detachFd()
-        val audioTag = NativeLibAudioTag(
+        if (cachedModified >= 0) {
+            val cached = readCachedAudio(
+                uris, uri, identifier, audioFormatType,
+                cachedModified, existAudio
+            )
+            if (cached != null) {
+                pfd?.close()
+                cachedCounter.incrementAndGet()
+                return cached
+            }
+        }
+
+        val opened = pfd ?: tryOpenFileDescriptorOf(uri)
+        if (opened == null) {
+            Log.w(TAG, "Failed to open file descriptor: $identifier, $uri")
+            return AudioReadResult.EMPTY
+        }
+        val validUris = collectValidUris(uris)
+        val fd = opened.detachFd()
+        // the tag owns the descriptor and its windows, both are
+        // released when leaving the scope
+        return NativeLibAudioTag(
             fd,
             audioFormatType = audioFormatType,
-            readonly = true
-        )
+            readonly = true,
+            windowed = true
+        ).use { audioTag ->
+            readAudioTag(
+                audioTag, validUris, identifier, audioFormatType,
+                uri, existPaths, existAudio
+            )
+        }
+    }
+
+    private fun readAudioTag(
+        audioTag: NativeLibAudioTag,
+        validUris: List<Uri>,
+        identifier: String,
+        audioFormatType: AudioFormatType,
+        uri: Uri,
+        existPaths: List<AudioPath>,
+        existAudio: Audio?
+    ): AudioReadResult {
+        val existId = existPaths.firstOrNull()?.id
+        val stringTable = stringTable!!
+        val fieldIds = stringTable.readFields(audioTag)
+        scanCache?.put(identifier, audioTag, fieldIds)
         val timestamp = System.currentTimeMillis()
         val lastModified = audioTag.getLastModified()
+        val loudnessSession = loudnessSession
+        buildSeekIndex(audioTag, audioFormatType, identifier, lastModified)
+        computeFingerprint(audioTag, identifier, lastModified)
 
         if (existAudio != null &&
-            lastModified == existAudio.lastModified
+            lastModified == existAudio.lastModified &&
+            (loudnessSession == null || !existAudio.needsLoudness())
         ) {
             return AudioReadResult(existAudio, validUris)
         }
@@ -342,15 +634,130 @@ class AudioScanWorker(
             existPath == null
         }
 
-        val audio = audioTag.toAudio(existId, timestamp)
+        val parsedAudio = stringTable.toAudioTag(
+            fieldIds,
+            audioFormatType,
+            audioTag.getAudioProperties(),
+            audioTag.getSize(),
+            lastModified
+        ).toAudio(existId, timestamp)
+        val analyze = loudnessSession != null && parsedAudio.trackGain == null
+        val audio = if (analyze) {
+            loudnessSession!!.analyze(audioTag, parsedAudio)
+        } else parsedAudio
         return AudioReadResult(
             audio, newUris,
             policy = if (existAudio != null)
                 POLICY_UPDATE
-            else POLICY_INSERT
+            else POLICY_INSERT,
+            analyzedUri = if (analyze) uri else null
+        )
+    }
+
+    /**
+     * Read the audio from the scan cache, if nothing needs the
+     * file itself.
+     *
+     * @return null if the tags have to be parsed.
+     */
+    private fun readCachedAudio(
+        uris: List<Uri>,
+        uri: Uri,
+        identifier: String,
+        audioFormatType: AudioFormatType,
+        lastModified: Long,
+        existAudio: Audio?
+    ): AudioReadResult? {
+        val cache = scanCache ?: return null
+        if (needsAnalysis(identifier, audioFormatType, lastModified, existAudio)) {
+            return null
+        }
+        if (existAudio != null) {
+            if (existAudio.lastModified != lastModified || !cache.keep(identifier)) {
+                return null
+            }
+            return AudioReadResult(existAudio, listOf(uri))
+        }
+        val cachedTag = cache.read(identifier, audioFormatType) ?: return null
+        if (!cache.keep(identifier)) {
+            return null
+        }
+        return AudioReadResult(
+            cachedTag.toAudio(null, System.currentTimeMillis()),
+            collectValidUris(uris),
+            policy = POLICY_INSERT
         )
     }
 
+    /**
+     * @return true if loudness, seek index or fingerprint of the
+     * file are still missing.
+     */
+    private fun needsAnalysis(
+        identifier: String,
+        audioFormatType: AudioFormatType,
+        lastModified: Long,
+        existAudio: Audio?
+    ): Boolean {
+        if (loudnessSession != null && (existAudio == null || existAudio.needsLoudness())) {
+            return true
+        }
+        val seekIndexes = seekIndexStore
+        if (seekIndexes != null &&
+            (audioFormatType == AudioFormatType.MP3 || audioFormatType == AudioFormatType.FLAC) &&
+            !seekIndexes.contains(identifier, lastModified)
+        ) {
+            return true
+        }
+        val fingerprints = fingerprintStore
+        return fingerprints != null && !fingerprints.contains(identifier, lastModified)
+    }
+
+    /**
+     * Neither tagged nor measured, and not failed to measure before.
+     */
+    private fun Audio.needsLoudness() = trackGain == null && !loudnessFailed
+
+    private fun buildSeekIndex(
+        audioTag: NativeLibAudioTag,
+        audioFormatType: AudioFormatType,
+        identifier: String,
+        lastModified: Long
+    ) {
+        val store = seekIndexStore ?: return
+        if (audioFormatType != AudioFormatType.MP3 &&
+            audioFormatType != AudioFormatType.FLAC
+        ) {
+            return
+        }
+        if (store.contains(identifier, lastModified)) {
+            return
+        }
+        try {
+            val index = SeekIndexBuilder.build(audioTag) ?: return
+            store.write(identifier, lastModified, index)
+        } catch (e: Exception) {
+            Log.w(TAG, "Failed to build seek index: $identifier", e)
+        }
+    }
+
+    private fun computeFingerprint(
+        audioTag: NativeLibAudioTag,
+        identifier: String,
+        lastModified: Long
+    ) {
+        val store = fingerprintStore ?: return
+        if (store.contains(identifier, lastModified)) {
+            return
+        }
+        try {
+            val fingerprint = FingerprintExtractor.extract(audioTag) ?: return
+            store.write(identifier, lastModified, fingerprint)
+        } catch (e: Exception) {
+            Log.w(TAG, "Failed to compute fingerprint: $identifier", e)
+        }
+    }
+
     private fun collectValidUris(
         uris: List<Uri>
     ): List<Uri> {
@@ -366,11 +773,44 @@ class AudioScanWorker(
         }
     }
 
+    private data class ScanTarget(
+        val identifier: String,
+        val uris: List<Uri>,
+        val audioFormatType: AudioFormatType
+    )
+
+    private data class DocumentStat(
+        val size: Long,
+        val lastModified: Long
+    )
+
+    private class DocumentRow(
+        val documentId: String,
+        val mimeType: String?,
+        val size: Long,
+        val lastModified: Long
+    )
+
+    /**
+     * The file of a [ScanTarget] to read, [pfd] is null if the cache
+     * showed it unchanged without opening it.
+     */
+    private class BatchFile(
+        val uri: Uri,
+        val pfd: ParcelFileDescriptor?,
+        val cachedModified: Long
+    )
+
     private data class AudioReadResult(
         val audio: Audio?,
         val validUris: List<Uri>,
         val invalidPaths: List<AudioPath> = emptyList(),
-        val policy: Int = POLICY_NONE
+        val policy: Int = POLICY_NONE,
+        /**
+         * The uri the loudness was measured from, null if
+         * the audio was not analyzed.
+         */
+        val analyzedUri: Uri? = null
     ) {
         companion object {
             val EMPTY = AudioReadResult(null, emptyList())
@@ -441,6 +881,31 @@ class AudioScanWorker(
          */
         private const val KEY_AUDIO_LENGTH_THRESHOLD = "audio_length_threshold"
 
+        /**
+         * Whether to measure the loudness of audios without ReplayGain
+         * tags. The value is [Boolean] type.
+         */
+        private const val KEY_ANALYZE_LOUDNESS = "analyze_loudness"
+
+        /**
+         * Whether to write the measured ReplayGain values into the tags
+         * of the files. Only takes effect with [KEY_ANALYZE_LOUDNESS].
+         */
+        private const val KEY_WRITE_REPLAY_GAIN = "write_replay_gain"
+
+        /**
+         * Whether to build seek indexes of MP3 and FLAC files, see
+         * [SeekIndexBuilder]. The value is [Boolean] type.
+         */
+        private const val KEY_BUILD_SEEK_INDEX = "build_seek_index"
+
+        /**
+         * Whether to compute acoustic fingerprints of audios, which
+         * [AudioClassificationWorker] uses to flag duplicates, see
+         * [FingerprintExtractor]. The value is [Boolean] type.
+         */
+        private const val KEY_COMPUTE_FINGERPRINT = "compute_fingerprint"
+
         /**
          * Submit work with default parameters.
          *
@@ -459,14 +924,22 @@ class AudioScanWorker(
         fun submitWork(
             context: Context, uris: List<Uri>,
             filterPaths: List<String> = emptyList(),
-            audioLengthThreshold: Long = 0
+            audioLengthThreshold: Long = 0,
+            analyzeLoudness: Boolean = false,
+            writeReplayGain: Boolean = false,
+            buildSeekIndex: Boolean = false,
+            computeFingerprint: Boolean = false
         ): Operation {
             val uriStrings = uris.map { it.toString() }
 
             val data = workDataOf(
                 KEY_URIS to uriStrings.toTypedArray(),
                 KEY_FILTER_PATHS to filterPaths.toTypedArray(),
-                KEY_AUDIO_LENGTH_THRESHOLD to audioLengthThreshold
+                KEY_AUDIO_LENGTH_THRESHOLD to audioLengthThreshold,
+                KEY_ANALYZE_LOUDNESS to analyzeLoudness,
+                KEY_WRITE_REPLAY_GAIN to writeReplayGain,
+                KEY_BUILD_SEEK_INDEX to buildSeekIndex,
+                KEY_COMPUTE_FINGERPRINT to computeFingerprint
             )
             val workRequest = OneTimeWorkRequestBuilder<AudioScanWorker>()
                 .addTag(TAG)
@@ -483,6 +956,15 @@ class AudioScanWorker(
                 .enqueue()
         }
 
+        private const val VALIDATE_BATCH_SIZE = 128
+
+        private val DOCUMENT_COLUMNS = arrayOf(
+            DocumentsContract.Document.COLUMN_DOCUMENT_ID,
+            DocumentsContract.Document.COLUMN_MIME_TYPE,
+            DocumentsContract.Document.COLUMN_SIZE,
+            DocumentsContract.Document.COLUMN_LAST_MODIFIED
+        )
+
         private const val POLICY_NONE = 0
         private const val POLICY_UPDATE = 1
         private const val POLICY_INSERT = 2
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+package tech.rollw.player.service.scanner
+
+import android.content.Context
+import android.util.Log
+import androidx.work.CoroutineWorker
+import androidx.work.Data
+import androidx.work.ExistingWorkPolicy
+import androidx.work.OneTimeWorkRequestBuilder
+import androidx.work.Operation
+import androidx.work.WorkManager
+import androidx.work.WorkerParameters
+import androidx.work.workDataOf
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.async
+import kotlinx.coroutines.awaitAll
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.sync.Semaphore
+import kotlinx.coroutines.sync.withPermit
+import kotlinx.coroutines.withContext
+import tech.rollw.player.audio.Audio
+import tech.rollw.player.audio.AudioPath
+import tech.rollw.player.audio.analysis.SidecarStore
+import tech.rollw.player.audio.analysis.WaveformExtractor
+import tech.rollw.player.audio.tag.NativeLibAudioTag
+import tech.rollw.player.data.database.repository.AudioPathRepository
+import tech.rollw.player.data.database.repository.AudioRepository
+import tech.rollw.player.service.WorkerDefaults
+import tech.rollw.player.ui.applicationService
+import tech.rollw.support.analytics.Analytics
+import tech.rollw.support.analytics.AnalyticsEvent
+import tech.rollw.support.appcompat.openFileDescriptor
+import java.util.concurrent.atomic.AtomicInteger
+
+/**
+ * Extracts the waveforms of all audios in the library that have
+ * none for their current version yet, see [WaveformExtractor].
+ *
+ * @author RollW
+ */
+class WaveformWorker(
+    private val context: Context,
+    private val workerParams: WorkerParameters
+) : CoroutineWorker(context, workerParams) {
+
+    private val analytics by context.applicationService<Analytics>()
+
+    private val audioRepository by context.applicationService<AudioRepository>()
+    private val audioPathRepository by context.applicationService<AudioPathRepository>()
+
+    private val waveformStore = SidecarStore.waveforms(context)
+
+    override suspend fun doWork(): Result {
+        return withContext(Dispatchers.IO) {
+            return@withContext try {
+                executeWork()
+            } catch (e: Exception) {
+                Log.e(TAG, "Failed to extract waveforms", e)
+                Result.failure(
+                    Data.Builder()
+                        .putString("error", e.message)
+                        .build()
+                )
+            }
+        }
+    }
+
+    private suspend fun executeWork(): Result {
+        val startTime = System.currentTimeMillis()
+        val bucketCount = inputData.getInt(
+            KEY_BUCKET_COUNT,
+            WaveformExtractor.DEFAULT_BUCKET_COUNT
+        )
+        val pathsById = audioPathRepository.get().groupBy { it.id }
+        val pending = audioRepository.get().mapNotNull { audio ->
+            val paths = pathsById[audio.id] ?: return@mapNotNull null
+            val identifier = paths.first().identifier
+            if (waveformStore.contains(identifier, audio.lastModified)) {
+                return@mapNotNull null
+            }
+            audio to paths
+        }
+
+        val extracted = AtomicInteger()
+        val failed = AtomicInteger()
+        val done = AtomicInteger()
+        // decoding is CPU bound, one extraction per core
+        val permits = Semaphore(PARALLELISM)
+        coroutineScope {
+            pending.map { (audio, paths) ->
+                async {
+                    permits.withPermit {
+                        if (isStopped) {
+                            return@withPermit
+                        }
+                        if (extract(audio, paths, bucketCount)) {
+                            extracted.incrementAndGet()
+                        } else {
+                            failed.incrementAndGet()
+                        }
+                        setProgress(
+                            workDataOf(
+                                WorkerDefaults.KEY_PROGRESS to
+                                        done.incrementAndGet() * 100 / pending.size
+                            )
+                        )
+                    }
+                }
+            }.awaitAll()
+        }
+
+        val endTime = System.currentTimeMillis()
+        val totalTime = (endTime - startTime).coerceAtLeast(1)
+
+        analytics.logEvent(
+            AnalyticsEvent(
+                type = "waveform_extract",
+                extras = listOf(
+                    AnalyticsEvent.Param("pending", pending.size.toString()),
+                    AnalyticsEvent.Param("extracted", extracted.get().toString()),
+                    AnalyticsEvent.Param("failed", failed.get().toString()),
+                    AnalyticsEvent.Param("total_time", totalTime.toString()),
+                    AnalyticsEvent.Param(
+                        "tracks_per_minute",
+                        (extracted.get() * 60_000L / totalTime).toString()
+                    ),
+                )
+            )
+        )
+
+        return Result.success()
+    }
+
+    private fun extract(
+        audio: Audio,
+        paths: List<AudioPath>,
+        bucketCount: Int
+    ): Boolean {
+        val path = paths.first()
+        for (audioPath in paths) {
+            val pfd = try {
+                audioPath.path.toUri().openFileDescriptor(context, "r")
+            } catch (e: Exception) {
+                continue
+            }
+            return try {
+                NativeLibAudioTag(pfd.detachFd(), audio.type, readonly = true, windowed = true).use {
+                    val waveform = WaveformExtractor.extract(it, bucketCount)
+                        ?: return false
+                    waveformStore.write(path.identifier, audio.lastModified, waveform)
+                    true
+                }
+            } catch (e: Exception) {
+                Log.w(TAG, "Failed to extract waveform: ${path.identifier}", e)
+                false
+            }
+        }
+        return false
+    }
+
+    companion object {
+        private const val TAG = WorkerDefaults.TAG_WAVEFORM_WORKER
+
+        val WORKER_SPEC = WorkerDefaults.WaveformWorkerSpec
+
+        private val PARALLELISM = Runtime.getRuntime().availableProcessors()
+            .coerceIn(1, 4)
+
+        /**
+         * The count of buckets of each waveform.
+         *
+         * The value is [Int] type, defaults to
+         * [WaveformExtractor.DEFAULT_BUCKET_COUNT].
+         */
+        private const val KEY_BUCKET_COUNT = "bucket_count"
+
+        @JvmStatic
+        fun submitWork(
+            context: Context,
+            bucketCount: Int = WaveformExtractor.DEFAULT_BUCKET_COUNT
+        ): Operation {
+            val workRequest = OneTimeWorkRequestBuilder<WaveformWorker>()
+                .addTag(TAG)
+                .setInputData(workDataOf(KEY_BUCKET_COUNT to bucketCount))
+                .build()
+            return WorkManager.getInstance(context)
+                .beginUniqueWork(TAG, ExistingWorkPolicy.KEEP, workRequest)
+                .enqueue()
+        }
+    }
+}
@@ -72,4 +72,46 @@ object ImageUtils {
      * Note: it will modify the given bitmap.
      */
     private external fun blurBitmap(bitmap: Bitmap, radius: Int)
+
+    /**
+     * Resample the bitmap to the given size with a native filter,
+     * suited to large reductions.
+     *
+     * @return a new [Bitmap.Config.ARGB_8888] bitmap.
+     */
+    fun scale(bitmap: Bitmap, width: Int, height: Int): Bitmap {
+        if (width <= 0 || height <= 0) {
+            throw IllegalArgumentException("Size must be positive.")
+        }
+        val source = if (bitmap.config == Bitmap.Config.ARGB_8888) {
+            bitmap
+        } else {
+            bitmap.copy(Bitmap.Config.ARGB_8888, false)
+                ?: throw IllegalArgumentException("Failed to copy bitmap.")
+        }
+        val scaled = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888)
+        scaled.setHasAlpha(source.hasAlpha())
+        val success = scaleBitmap(source, scaled)
+        if (source !== bitmap) {
+            source.recycle()
+        }
+        if (!success) {
+            scaled.recycle()
+            throw IllegalArgumentException("Failed to scale bitmap.")
+        }
+        return scaled
+    }
+
+    private external fun scaleBitmap(source: Bitmap, target: Bitmap): Boolean
+
+    /**
+     * Inspect the encoded image and decide the size to re-encode it to
+     * for embedding.
+     *
+     * @param maxDimension the longest side allowed, 0 for no limit.
+     * @param maxBytes the encoded size allowed, 0 for no limit.
+     * @return width and height, or null if the image can be embedded
+     * as it is or cannot be identified.
+     */
+    external fun getArtworkTargetSize(image: ByteArray, maxDimension: Int, maxBytes: Long): IntArray?
 }
\ No newline at end of file
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package tech.rollw.player.util
+
+import androidx.annotation.Keep
+import tech.rollw.player.audio.AudioFormatType
+
+/**
+ * Counters and histograms of the native library, summed over its
+ * threads since it was loaded.
+ *
+ * @author RollW
+ */
+@Keep
+object NativeStats {
+    init {
+        System.loadLibrary("soundsource")
+    }
+
+    /**
+     * Counters, in the order of Metrics::Counter.
+     */
+    enum class Counter {
+        OPENED,
+        PARSE_FAILED,
+        BYTES_READ,
+        ARTWORK_READ,
+    }
+
+    /**
+     * Histograms, in the order of Metrics::Histogram. Durations are in
+     * microseconds, sizes in bytes.
+     */
+    enum class Histogram {
+        OPEN_TIME,
+        PARSE_TIME,
+        ARTWORK_TIME,
+        BLUR_TIME,
+        ARTWORK_SIZE,
+    }
+
+    fun snapshot(): Snapshot = Snapshot(snapshotStats())
+
+    class Snapshot internal constructor(private val values: LongArray) {
+        private val formats = values[1].toInt()
+        private val counters = values[2].toInt()
+        private val buckets = values[4].toInt()
+        private val histogramSize = 2 + buckets
+
+        /**
+         * @param format null for work not tied to an audio file.
+         */
+        fun counter(counter: Counter, format: AudioFormatType?): Long =
+            values[HEADER_SIZE + counter.ordinal * formats + formatIndex(format)]
+
+        fun histogram(histogram: Histogram, format: AudioFormatType?): HistogramSnapshot {
+            val start = HEADER_SIZE + counters * formats +
+                    (histogram.ordinal * formats + formatIndex(format)) * histogramSize
+            return HistogramSnapshot(
+                count = values[start],
+                sum = values[start + 1],
+                buckets = values.copyOfRange(start + 2, start + histogramSize)
+            )
+        }
+
+        private fun formatIndex(format: AudioFormatType?) =
+            format?.ordinal ?: (formats - 1)
+    }
+
+    class HistogramSnapshot(
+        val count: Long,
+        val sum: Long,
+        private val buckets: LongArray
+    ) {
+        val mean: Long
+            get() = if (count == 0L) 0 else sum / count
+
+        /**
+         * @param percentile 0 - 100.
+         * @return the lower bound of the bucket of the percentile, 0 if
+         * nothing was recorded.
+         */
+        fun percentile(percentile: Double): Long {
+            if (count == 0L) {
+                return 0
+            }
+            val rank = (count * percentile / 100).toLong().coerceIn(1, count)
+            var seen = 0L
+            buckets.forEachIndexed { bucket, bucketCount ->
+                seen += bucketCount
+                if (seen >= rank) {
+                    return lowerBound(bucket)
+                }
+            }
+            return lowerBound(buckets.size - 1)
+        }
+
+        private fun lowerBound(bucket: Int): Long {
+            if (bucket < SUB_BUCKETS) {
+                return bucket.toLong()
+            }
+            val exponent = bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1
+            val sub = (bucket % SUB_BUCKETS).toLong()
+            return (SUB_BUCKETS + sub) shl (exponent - SUB_BUCKET_BITS)
+        }
+    }
+
+    private const val HEADER_SIZE = 5
+    private const val SUB_BUCKET_BITS = 2
+    private const val SUB_BUCKETS = 1 shl SUB_BUCKET_BITS
+
+    private external fun snapshotStats(): LongArray
+}
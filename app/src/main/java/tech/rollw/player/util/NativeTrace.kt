@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2024 RollW
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package tech.rollw.player.util
+
+import androidx.annotation.Keep
+
+/**
+ * Switch for the trace sections of the native library, which show up
+ * in system traces (Perfetto, systrace) of the app while enabled.
+ *
+ * Off by default, a disabled section costs a single branch.
+ *
+ * @author RollW
+ */
+@Keep
+object NativeTrace {
+    init {
+        System.loadLibrary("soundsource")
+    }
+
+    external fun setEnabled(enabled: Boolean)
+
+    external fun isEnabled(): Boolean
+}